@@ -22,6 +22,12 @@ const {
 } = require("./world_interaction_bridge.ts");
 const { analyzeContainmentChainViaSimCore, analyzeContainmentChainsBatchViaSimCore } = require("./world_assoc_chain_bridge.ts");
 const { selectWorldObjectsViaSimCore } = require("./world_objects_query_bridge.ts");
+const {
+  selectWorldObjectsViaBridgeDaemon,
+  analyzeContainmentChainViaBridgeDaemon,
+  analyzeContainmentChainsBatchViaBridgeDaemon,
+  invokeWorldInteractViaBridgeDaemon
+} = require("./sim_core_bridge_daemon_client.ts");
 
 const HOST = process.env.VM_NET_HOST || "127.0.0.1";
 const PORT = Number.parseInt(process.env.VM_NET_PORT || "8081", 10);
@@ -595,6 +601,26 @@ function compareLegacyWorldObjectOrder(a, b) {
   return String(a.object_key || "").localeCompare(String(b.object_key || ""));
 }
 
+function repositionWorldObject(ordered, obj) {
+  /* `ordered` is sorted except for `obj`; re-slot it instead of re-sorting the list. */
+  const from = ordered.indexOf(obj);
+  if (from < 0) {
+    return;
+  }
+  ordered.splice(from, 1);
+  let lo = 0;
+  let hi = ordered.length;
+  while (lo < hi) {
+    const mid = (lo + hi) >>> 1;
+    if (compareLegacyWorldObjectOrder(ordered[mid], obj) <= 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  ordered.splice(lo, 0, obj);
+}
+
 function buildWorldObjectState(runtimeDir, rawDeltas) {
   const baseline = loadWorldObjectBaseline(runtimeDir);
   const tileFlags = loadTileFlagMap(runtimeDir);
@@ -648,6 +674,14 @@ function worldObjectMeta(state) {
   };
 }
 
+let worldInteractionTail = Promise.resolve();
+
+function runWorldInteractionTurn(fn) {
+  const run = worldInteractionTail.then(fn, fn);
+  worldInteractionTail = run.catch(() => {});
+  return run;
+}
+
 function findActiveObjectByKey(state, objectKey) {
   const key = String(objectKey || "");
   if (!key) {
@@ -1845,7 +1879,7 @@ const server = http.createServer(async (req, res) => {
       : "anchor";
     const includeFootprint = String(url.searchParams.get("include_footprint") || "").trim().toLowerCase();
     const withFootprint = includeFootprint === "1" || includeFootprint === "true" || includeFootprint === "on";
-    const selection = selectWorldObjectsViaSimCore({
+    const selectionInput = {
       objects: state.worldObjects.active,
       tileFlags: state.worldObjects.tileFlags,
       hasX,
@@ -1857,7 +1891,11 @@ const server = http.createServer(async (req, res) => {
       radius,
       projection,
       limit
-    });
+    };
+    let selection = await selectWorldObjectsViaBridgeDaemon(selectionInput);
+    if (!selection.ok) {
+      selection = selectWorldObjectsViaSimCore(selectionInput);
+    }
     if (!selection.ok) {
       sendError(res, 500, "world_query_bridge_failed", String(selection.message || "world query bridge failed"));
       return;
@@ -1868,7 +1906,10 @@ const server = http.createServer(async (req, res) => {
       if (key) byKey.set(key, obj);
     }
     const selected = selection.keys.map((k) => byKey.get(String(k))).filter(Boolean);
-    const diagResult = analyzeContainmentChainsBatchViaSimCore(state.worldObjects.active, selected);
+    let diagResult = await analyzeContainmentChainsBatchViaBridgeDaemon(state.worldObjects.active, selected);
+    if (!diagResult.ok) {
+      diagResult = analyzeContainmentChainsBatchViaSimCore(state.worldObjects.active, selected);
+    }
     if (!diagResult.ok) {
       sendError(res, 500, "assoc_batch_bridge_failed", String(diagResult.message || "assoc-chain batch bridge failed"));
       return;
@@ -1928,120 +1969,138 @@ const server = http.createServer(async (req, res) => {
     const actorX = Number.isFinite(Number(body && body.actor_x)) ? (Number(body.actor_x) | 0) : null;
     const actorY = Number.isFinite(Number(body && body.actor_y)) ? (Number(body.actor_y) | 0) : null;
     const actorZ = Number.isFinite(Number(body && body.actor_z)) ? (Number(body.actor_z) | 0) : null;
-    const target = findActiveObjectByKey(state, targetKey);
-    if (!target) {
-      sendError(res, 404, "object_not_found", "target_key not found");
-      return;
-    }
+    // The daemon calls below yield; keep check-then-apply atomic against other interactions.
+    await runWorldInteractionTurn(async () => {
+      const target = findActiveObjectByKey(state, targetKey);
+      if (!target) {
+        sendError(res, 404, "object_not_found", "target_key not found");
+        return;
+      }
 
-    const actorPos = {
-      x: actorX === null ? (target.x | 0) : actorX,
-      y: actorY === null ? (target.y | 0) : actorY,
-      z: actorZ === null ? (target.z | 0) : actorZ
-    };
+      const actorPos = {
+        x: actorX === null ? (target.x | 0) : actorX,
+        y: actorY === null ? (target.y | 0) : actorY,
+        z: actorZ === null ? (target.z | 0) : actorZ
+      };
 
-    const container = containerKey ? findActiveObjectByKey(state, containerKey) : null;
-    if (verb === "put" && !container) {
-      sendError(res, 404, "container_not_found", "container_key not found");
-      return;
-    }
+      const container = containerKey ? findActiveObjectByKey(state, containerKey) : null;
+      if (verb === "put" && !container) {
+        sendError(res, 404, "container_not_found", "container_key not found");
+        return;
+      }
 
-    const targetChainResult = analyzeContainmentChainViaSimCore(state.worldObjects.active, target);
-    if (!targetChainResult.ok) {
-      sendError(res, 500, "assoc_bridge_failed", String(targetChainResult.message || "assoc-chain bridge failed"));
-      return;
-    }
-    const targetChain = targetChainResult.value;
-    let containerCycle = false;
-    let containerChain = null;
-    if (verb === "put" && container) {
-      const containerChainResult = analyzeContainmentChainViaSimCore(state.worldObjects.active, container);
-      if (!containerChainResult.ok) {
-        sendError(res, 500, "assoc_bridge_failed", String(containerChainResult.message || "assoc-chain bridge failed"));
+      let targetChainResult = await analyzeContainmentChainViaBridgeDaemon(state.worldObjects.active, target);
+      if (!targetChainResult.ok) {
+        targetChainResult = analyzeContainmentChainViaSimCore(state.worldObjects.active, target);
+      }
+      if (!targetChainResult.ok) {
+        sendError(res, 500, "assoc_bridge_failed", String(targetChainResult.message || "assoc-chain bridge failed"));
         return;
       }
-      containerChain = containerChainResult.value;
-      containerCycle = String(container.object_key || "") === String(target.object_key || "")
-        || (containerChain.assoc_chain || []).includes(String(target.object_key || ""));
-    }
-
-    const applied = applyCanonicalWorldInteractionCommand({
-      verb,
-      target,
-      container,
-      actorId,
-      actorPos,
-      chainAccessible: targetChain.chain_accessible,
-      containerCycle
-    });
-    if (!applied.ok) {
-      if (applied.code === "interaction_container_blocked") {
-        sendJson(res, 409, {
-          error: {
-            code: "interaction_container_blocked",
-            message: String(applied.message || "contained object chain is not accessible"),
-            blocked_by: String(targetChain.blocked_by || "")
-          }
-        });
+      const targetChain = targetChainResult.value;
+      let containerCycle = false;
+      let containerChain = null;
+      if (verb === "put" && container) {
+        let containerChainResult = await analyzeContainmentChainViaBridgeDaemon(state.worldObjects.active, container);
+        if (!containerChainResult.ok) {
+          containerChainResult = analyzeContainmentChainViaSimCore(state.worldObjects.active, container);
+        }
+        if (!containerChainResult.ok) {
+          sendError(res, 500, "assoc_bridge_failed", String(containerChainResult.message || "assoc-chain bridge failed"));
+          return;
+        }
+        containerChain = containerChainResult.value;
+        containerCycle = String(container.object_key || "") === String(target.object_key || "")
+          || (containerChain.assoc_chain || []).includes(String(target.object_key || ""));
+      }
+
+      const interactionInput = {
+        verb,
+        target,
+        container,
+        actorId,
+        actorPos,
+        chainAccessible: targetChain.chain_accessible,
+        containerCycle
+      };
+      const applied = applyCanonicalWorldInteractionCommand(
+        interactionInput,
+        await invokeWorldInteractViaBridgeDaemon(interactionInput)
+      );
+      if (findActiveObjectByKey(state, targetKey) !== target
+        || (container && findActiveObjectByKey(state, containerKey) !== container)) {
+        sendError(res, 409, "world_objects_changed", "world objects changed during interaction; retry");
         return;
       }
-      if (applied.code === "interaction_container_cycle") {
-        sendJson(res, 409, {
-          error: {
-            code: "interaction_container_cycle",
-            message: String(applied.message || "cannot create containment cycle"),
-            blocked_by: String(containerChain?.blocked_by || "")
-          }
-        });
+      if (!applied.ok) {
+        if (applied.code === "interaction_container_blocked") {
+          sendJson(res, 409, {
+            error: {
+              code: "interaction_container_blocked",
+              message: String(applied.message || "contained object chain is not accessible"),
+              blocked_by: String(targetChain.blocked_by || "")
+            }
+          });
+          return;
+        }
+        if (applied.code === "interaction_container_cycle") {
+          sendJson(res, 409, {
+            error: {
+              code: "interaction_container_cycle",
+              message: String(applied.message || "cannot create containment cycle"),
+              blocked_by: String(containerChain?.blocked_by || "")
+            }
+          });
+          return;
+        }
+        sendError(res, Number(applied.http) || 409, applied.code, String(applied.message || "interaction failed"));
         return;
       }
-      sendError(res, Number(applied.http) || 409, applied.code, String(applied.message || "interaction failed"));
-      return;
-    }
 
-    Object.assign(target, applied.patch || {});
-    persistPatchedObject(state, target);
-    const event = recordWorldInteractionEvent(state, {
-      verb,
-      actor_id: actorId,
-      target_key: String(target.object_key || ""),
-      container_key: String(container?.object_key || ""),
-      status: Number(target.status) & 0xff,
-      x: target.x | 0,
-      y: target.y | 0,
-      z: target.z | 0,
-      holder_kind: String(target.holder_kind || "none"),
-      holder_id: String(target.holder_id || ""),
-      holder_key: String(target.holder_key || ""),
-      runtime_profile: runtimeContract.profile,
-      runtime_extensions: runtimeContract.extensions
-    });
-
-    state.worldObjects.active.sort(compareLegacyWorldObjectOrder);
-    persistState(state);
-    sendJson(res, 200, {
-      ok: true,
-      verb,
-      target: {
-        object_key: String(target.object_key || ""),
+      Object.assign(target, applied.patch || {});
+      persistPatchedObject(state, target);
+      const event = recordWorldInteractionEvent(state, {
+        verb,
+        actor_id: actorId,
+        target_key: String(target.object_key || ""),
+        container_key: String(container?.object_key || ""),
         status: Number(target.status) & 0xff,
-        coord_use: coordUseOfStatus(target.status),
-        holder_kind: String(target.holder_kind || "none"),
-        holder_id: String(target.holder_id || ""),
-        holder_key: String(target.holder_key || ""),
         x: target.x | 0,
         y: target.y | 0,
         z: target.z | 0,
-        assoc_chain: targetChain.assoc_chain,
-        root_anchor_key: targetChain.root_anchor_key,
-        blocked_by: targetChain.blocked_by
-      },
-      interaction_checkpoint: {
-        seq: Number(state.worldInteractionLog?.seq || event.seq || 0) >>> 0,
-        hash: String(state.worldInteractionLog?.checkpoint_hash || "")
-      },
-      runtime_contract: runtimeContract,
-      meta: worldObjectMeta(state)
+        holder_kind: String(target.holder_kind || "none"),
+        holder_id: String(target.holder_id || ""),
+        holder_key: String(target.holder_key || ""),
+        runtime_profile: runtimeContract.profile,
+        runtime_extensions: runtimeContract.extensions
+      });
+
+      repositionWorldObject(state.worldObjects.active, target);
+      persistState(state);
+      sendJson(res, 200, {
+        ok: true,
+        verb,
+        target: {
+          object_key: String(target.object_key || ""),
+          status: Number(target.status) & 0xff,
+          coord_use: coordUseOfStatus(target.status),
+          holder_kind: String(target.holder_kind || "none"),
+          holder_id: String(target.holder_id || ""),
+          holder_key: String(target.holder_key || ""),
+          x: target.x | 0,
+          y: target.y | 0,
+          z: target.z | 0,
+          assoc_chain: targetChain.assoc_chain,
+          root_anchor_key: targetChain.root_anchor_key,
+          blocked_by: targetChain.blocked_by
+        },
+        interaction_checkpoint: {
+          seq: Number(state.worldInteractionLog?.seq || event.seq || 0) >>> 0,
+          hash: String(state.worldInteractionLog?.checkpoint_hash || "")
+        },
+        runtime_contract: runtimeContract,
+        meta: worldObjectMeta(state)
+      });
     });
     return;
   }
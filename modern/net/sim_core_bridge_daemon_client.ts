@@ -0,0 +1,416 @@
+"use strict";
+
+const fs = require("node:fs");
+const path = require("node:path");
+const { spawn } = require("node:child_process");
+const { diagnosticsFromParsed } = require("./world_assoc_chain_bridge.ts");
+const { loadSimCoreAddon } = require("./sim_core_native_addon.ts");
+
+// Client for sim_core_bridge_daemon: one resident process that keeps the
+// world object table loaded and answers length-prefixed binary frames (see
+// modern/sim-core/include/u6_bridge_proto.h). The table is synced by diff
+// against what the daemon already holds, so a query costs one encode pass
+// over the objects instead of a process spawn with every object on argv.
+// When the sim_core N-API addon is built, the same frames are handled
+// in-process against an addon-owned table instead of going through the
+// daemon. Every helper resolves { ok: false } when neither is available or
+// the call fails; callers fall back to the spawnSync bridges.
+
+const OP_LOAD = 2;
+const OP_UPSERT = 3;
+const OP_REMOVE = 4;
+const OP_QUERY = 5;
+const OP_ASSOC = 6;
+const OP_INTERACT = 7;
+
+const KEY_MAX = 39;
+const RECORD_FIXED_SIZE = 28;
+const RESTART_BACKOFF_MS = 5000;
+
+const ASSOC_ACCESSIBLE = 1;
+const ASSOC_CYCLE = 2;
+const ASSOC_MISSING_PARENT = 4;
+const ASSOC_PARENT_OWNED = 8;
+
+const DAEMON_ENABLED = String(process.env.VM_SIM_CORE_BRIDGE_DAEMON || "on").trim().toLowerCase() !== "off";
+
+function daemonBinPath() {
+  if (process.env.VM_SIM_CORE_BRIDGE_DAEMON_BIN) {
+    return String(process.env.VM_SIM_CORE_BRIDGE_DAEMON_BIN);
+  }
+  return path.join(__dirname, "..", "..", "build", "modern", "sim-core", "sim_core_bridge_daemon");
+}
+
+let daemon = null;
+let retryAtMs = 0;
+
+function failPending(d, err) {
+  const pending = d.pending.splice(0);
+  for (const p of pending) {
+    clearTimeout(p.timer);
+    p.reject(err);
+  }
+}
+
+function stopDaemon(d, err) {
+  if (daemon === d) {
+    daemon = null;
+    retryAtMs = Date.now() + RESTART_BACKOFF_MS;
+  }
+  failPending(d, err);
+  try {
+    d.proc.kill();
+  } catch (_err) {
+    // already gone
+  }
+}
+
+function onDaemonData(d, chunk) {
+  d.buffer = d.buffer.length ? Buffer.concat([d.buffer, chunk]) : chunk;
+  while (d.buffer.length >= 4) {
+    const len = d.buffer.readUInt32LE(0);
+    if (d.buffer.length < 4 + len) {
+      break;
+    }
+    const frame = d.buffer.subarray(4, 4 + len);
+    d.buffer = d.buffer.subarray(4 + len);
+    const p = d.pending.shift();
+    if (!p || len < 5) {
+      stopDaemon(d, new Error("unexpected bridge daemon frame"));
+      return;
+    }
+    clearTimeout(p.timer);
+    p.resolve({ op: frame[0], status: frame.readInt32LE(1), payload: frame.subarray(5) });
+  }
+}
+
+function ensureDaemon() {
+  if (daemon) {
+    return daemon;
+  }
+  const addon = loadSimCoreAddon();
+  if (addon) {
+    daemon = { addon, world: addon.createWorld(), resident: null, tileFlags: null };
+    return daemon;
+  }
+  if (!DAEMON_ENABLED || Date.now() < retryAtMs) {
+    return null;
+  }
+  const bin = daemonBinPath();
+  try {
+    fs.accessSync(bin, fs.constants.X_OK);
+  } catch (_err) {
+    retryAtMs = Date.now() + RESTART_BACKOFF_MS;
+    return null;
+  }
+  const proc = spawn(bin, [], { stdio: ["pipe", "pipe", "ignore"] });
+  const d = { proc, pending: [], buffer: Buffer.alloc(0), resident: null, tileFlags: null };
+  proc.stdout.on("data", (chunk) => onDaemonData(d, chunk));
+  proc.stdin.on("error", (err) => stopDaemon(d, err));
+  proc.on("error", (err) => stopDaemon(d, err));
+  proc.on("exit", () => stopDaemon(d, new Error("bridge daemon exited")));
+  daemon = d;
+  return d;
+}
+
+function request(d, body, timeoutMs) {
+  if (d.addon) {
+    try {
+      const frame = d.addon.handle(d.world, body);
+      const view = Buffer.from(frame.buffer, frame.byteOffset, frame.byteLength);
+      return Promise.resolve({ op: view[4], status: view.readInt32LE(5), payload: view.subarray(9) });
+    } catch (err) {
+      return Promise.reject(err);
+    }
+  }
+  return new Promise((resolve, reject) => {
+    const prefix = Buffer.alloc(4);
+    prefix.writeUInt32LE(body.length, 0);
+    const timer = setTimeout(() => stopDaemon(d, new Error("bridge daemon timed out")), timeoutMs);
+    d.pending.push({ resolve, reject, timer });
+    d.proc.stdin.write(Buffer.concat([prefix, body]));
+  });
+}
+
+function holderKindCode(name) {
+  const k = String(name || "").toLowerCase();
+  if (k === "object") return 1;
+  if (k === "npc") return 2;
+  return 0;
+}
+
+function encodeKey(key) {
+  const bytes = Buffer.from(String(key), "utf8");
+  if (bytes.length === 0 || bytes.length > KEY_MAX || bytes.includes(0)) {
+    return null;
+  }
+  return Buffer.concat([Buffer.from([bytes.length]), bytes]);
+}
+
+// Same field derivation as the spawn bridges' argv (query + assoc node).
+function encodeRecord(obj, tileFlags) {
+  const key = encodeKey(String(obj?.object_key || ""));
+  if (!key) {
+    return null;
+  }
+  const tileId = Number(obj?.tile_id) & 0xffff;
+  const fixed = Buffer.alloc(RECORD_FIXED_SIZE);
+  fixed.writeInt32LE(Number(obj?.x) | 0, 0);
+  fixed.writeInt32LE(Number(obj?.y) | 0, 4);
+  fixed.writeInt32LE(Number(obj?.z) | 0, 8);
+  fixed[12] = Number(obj?.status) & 0xff;
+  fixed[13] = tileFlags ? (Number(tileFlags[tileId & 0x07ff]) & 0xff) : 0;
+  fixed[14] = holderKindCode(obj?.holder_kind);
+  fixed.writeInt32LE(Number.parseInt(String(obj?.holder_key || obj?.holder_id || "0"), 10) | 0, 16);
+  fixed.writeInt32LE(Number(obj?.source_area) | 0, 20);
+  fixed.writeInt32LE(Number(obj?.source_index) | 0, 24);
+  return Buffer.concat([key, fixed]);
+}
+
+function countedFrame(op, items) {
+  const head = Buffer.alloc(5);
+  head[0] = op;
+  head.writeUInt32LE(items.length, 1);
+  return Buffer.concat([head, ...items]);
+}
+
+// Brings the daemon's table in line with objects: LOAD on first use (or
+// after a failure), UPSERT/REMOVE diffs after that. The resident map is
+// updated before the responses arrive; frames are handled in order, so a
+// concurrent caller can diff against it straight away. Assoc callers have
+// no tile flags; they reuse the last ones seen so records do not churn.
+async function syncWorld(d, objects, tileFlagsOrNull, timeoutMs) {
+  const tileFlags = tileFlagsOrNull || d.tileFlags;
+  const next = new Map();
+  d.tileFlags = tileFlags;
+  for (const obj of objects) {
+    const key = String(obj?.object_key || "");
+    const rec = encodeRecord(obj, tileFlags);
+    if (!rec || next.has(key)) {
+      // Keys the binary protocol cannot hold stay on the spawn bridges.
+      return false;
+    }
+    next.set(key, rec);
+  }
+  const sends = [];
+  if (!d.resident) {
+    sends.push(request(d, countedFrame(OP_LOAD, Array.from(next.values())), timeoutMs));
+  } else {
+    const upserts = [];
+    const removes = [];
+    for (const [key, rec] of next) {
+      const prev = d.resident.get(key);
+      if (!prev || !prev.equals(rec)) upserts.push(rec);
+    }
+    for (const key of d.resident.keys()) {
+      if (!next.has(key)) removes.push(encodeKey(key));
+    }
+    if (upserts.length) sends.push(request(d, countedFrame(OP_UPSERT, upserts), timeoutMs));
+    if (removes.length) sends.push(request(d, countedFrame(OP_REMOVE, removes), timeoutMs));
+  }
+  d.resident = next;
+  const replies = await Promise.all(sends);
+  if (replies.some((r) => r.status !== 0)) {
+    d.resident = null;
+    return false;
+  }
+  return true;
+}
+
+function unavailable() {
+  return { ok: false, code: "bridge_daemon_unavailable", message: "sim-core bridge daemon unavailable" };
+}
+
+function failed(err) {
+  return { ok: false, code: "bridge_daemon_failed", message: `sim-core bridge daemon failed: ${String(err?.message || err)}` };
+}
+
+async function selectWorldObjectsViaBridgeDaemon(input) {
+  const objects = Array.isArray(input?.objects) ? input.objects : [];
+  const d = ensureDaemon();
+  if (!d) {
+    return unavailable();
+  }
+  try {
+    if (!(await syncWorld(d, objects, input?.tileFlags || null, 8000))) {
+      return unavailable();
+    }
+    const body = Buffer.alloc(25);
+    body[0] = OP_QUERY;
+    body[1] = input?.hasX ? 1 : 0;
+    body[2] = input?.hasY ? 1 : 0;
+    body[3] = input?.hasZ ? 1 : 0;
+    body[4] = input?.projection === "footprint" ? 1 : 0;
+    body.writeInt32LE(Number(input?.x) | 0, 5);
+    body.writeInt32LE(Number(input?.y) | 0, 9);
+    body.writeInt32LE(Number(input?.z) | 0, 13);
+    body.writeInt32LE(Number(input?.radius) | 0, 17);
+    body.writeInt32LE(Math.max(1, Number(input?.limit) | 0), 21);
+    const reply = await request(d, body, 8000);
+    if (reply.status !== 0) {
+      return failed(`status ${reply.status}`);
+    }
+    const p = reply.payload;
+    const count = p.readUInt32LE(0);
+    const keys = [];
+    let off = 4;
+    for (let i = 0; i < count; i++) {
+      const len = p[off];
+      keys.push(p.toString("utf8", off + 1, off + 1 + len));
+      off += 1 + len;
+    }
+    return { ok: true, keys };
+  } catch (err) {
+    return failed(err);
+  }
+}
+
+function parseAssocReply(p) {
+  const byTarget = new Map();
+  const count = p.readUInt32LE(0);
+  let off = 4;
+  for (let i = 0; i < count; i++) {
+    const flags = p[off + 16];
+    const chainLen = p[off + 17];
+    const chain = [];
+    for (let j = 0; j < chainLen; j++) {
+      const key = p.readInt32LE(off + 18 + 4 * j);
+      if (key !== 0) chain.push(String(key));
+    }
+    byTarget.set(String(p.readInt32LE(off)), {
+      code: p.readInt32LE(off + 4),
+      root_anchor_key: p.readInt32LE(off + 8),
+      blocked_by_key: p.readInt32LE(off + 12),
+      chain_accessible: (flags & ASSOC_ACCESSIBLE) !== 0,
+      cycle_detected: (flags & ASSOC_CYCLE) !== 0,
+      missing_parent: (flags & ASSOC_MISSING_PARENT) !== 0,
+      parent_owned: (flags & ASSOC_PARENT_OWNED) !== 0,
+      assoc_chain: chain
+    });
+    off += 18 + 4 * chainLen;
+  }
+  return byTarget;
+}
+
+async function assocViaBridgeDaemon(objects, targetKeys) {
+  const d = ensureDaemon();
+  if (!d) {
+    return unavailable();
+  }
+  try {
+    if (!(await syncWorld(d, objects, null, 8000))) {
+      return unavailable();
+    }
+    const body = Buffer.alloc(5 + 4 * targetKeys.length);
+    body[0] = OP_ASSOC;
+    body.writeUInt32LE(targetKeys.length, 1);
+    targetKeys.forEach((key, i) => body.writeInt32LE(key, 5 + 4 * i));
+    const reply = await request(d, body, 8000);
+    if (reply.status !== 0) {
+      return failed(`status ${reply.status}`);
+    }
+    return { ok: true, byTarget: parseAssocReply(reply.payload) };
+  } catch (err) {
+    return failed(err);
+  }
+}
+
+async function analyzeContainmentChainsBatchViaBridgeDaemon(objects, targetObjects) {
+  if (!Array.isArray(objects) || objects.length === 0) {
+    return { ok: false, code: "empty-world-objects", message: "no world objects provided for assoc-chain analysis" };
+  }
+  if (!Array.isArray(targetObjects) || targetObjects.length === 0) {
+    return { ok: true, byKey: new Map() };
+  }
+  const targetKeys = targetObjects
+    .map((o) => Number.parseInt(String(o?.object_key || "0"), 10) | 0)
+    .filter((k) => k !== 0);
+  if (targetKeys.length === 0) {
+    return { ok: false, code: "invalid-targets", message: "no valid target keys" };
+  }
+  const result = await assocViaBridgeDaemon(objects, targetKeys);
+  if (!result.ok) {
+    return result;
+  }
+  const byKey = new Map();
+  for (const obj of targetObjects) {
+    const key = String(obj?.object_key || "");
+    if (!key) continue;
+    byKey.set(key, diagnosticsFromParsed(obj, result.byTarget.get(key)));
+  }
+  return { ok: true, byKey };
+}
+
+async function analyzeContainmentChainViaBridgeDaemon(objects, targetObject) {
+  const targetKey = Number.parseInt(String(targetObject?.object_key || "0"), 10) | 0;
+  if (!targetObject || targetKey === 0) {
+    return { ok: false, code: "invalid-object", message: "invalid target object" };
+  }
+  if (!Array.isArray(objects) || objects.length === 0) {
+    return { ok: false, code: "empty-world-objects", message: "no world objects provided for assoc-chain analysis" };
+  }
+  const result = await assocViaBridgeDaemon(objects, [targetKey]);
+  if (!result.ok) {
+    return result;
+  }
+  return { ok: true, value: diagnosticsFromParsed(targetObject, result.byTarget.get(String(targetKey))) };
+}
+
+const VERB_CODES = { take: 1, drop: 2, equip: 3, put: 4 };
+const HOLDER_KIND_NAMES = ["none", "object", "npc"];
+
+// Resolves the same { ok, parsed } the interaction bridge's spawn call does.
+async function invokeWorldInteractViaBridgeDaemon(input) {
+  const d = ensureDaemon();
+  if (!d) {
+    return unavailable();
+  }
+  const verb = String(input?.verb || "").trim().toLowerCase();
+  const target = input?.target || {};
+  const actorId = String(input?.actorId || "");
+  const body = Buffer.alloc(8);
+  body[0] = OP_INTERACT;
+  body[1] = Object.prototype.hasOwnProperty.call(VERB_CODES, verb) ? VERB_CODES[verb] : 0;
+  body[2] = Number(target.status) & 0xff;
+  body[3] = holderKindCode(target.holder_kind);
+  body[4] = String(target.holder_kind || "") === "npc" && String(target.holder_id || "") === actorId ? 1 : 0;
+  body[5] = input?.container ? 1 : 0;
+  body[6] = input?.chainAccessible ? 1 : 0;
+  body[7] = input?.containerCycle ? 1 : 0;
+  try {
+    const reply = await request(d, body, 3000);
+    if (reply.status !== 0) {
+      return failed(`status ${reply.status}`);
+    }
+    return {
+      ok: true,
+      parsed: {
+        code: reply.payload.readInt32LE(0),
+        status: reply.payload[4],
+        holder_kind: HOLDER_KIND_NAMES[reply.payload[5]] || "none"
+      }
+    };
+  } catch (err) {
+    return failed(err);
+  }
+}
+
+function shutdownBridgeDaemon() {
+  const d = daemon;
+  if (d) {
+    daemon = null;
+    if (d.addon) {
+      return;
+    }
+    failPending(d, new Error("bridge daemon shut down"));
+    d.proc.stdin.end();
+  }
+}
+
+module.exports = {
+  selectWorldObjectsViaBridgeDaemon,
+  analyzeContainmentChainViaBridgeDaemon,
+  analyzeContainmentChainsBatchViaBridgeDaemon,
+  invokeWorldInteractViaBridgeDaemon,
+  shutdownBridgeDaemon
+};
@@ -0,0 +1,46 @@
+"use strict";
+
+const fs = require("node:fs");
+const path = require("node:path");
+
+// Loader for the optional sim_core N-API addon (CMake option
+// SIM_CORE_BUILD_NODE_ADDON). Returns null when it is disabled, not built or
+// fails to load, so callers keep using the daemon/spawn bridges.
+
+function addonPath() {
+  if (process.env.VM_SIM_CORE_NODE_ADDON) {
+    return String(process.env.VM_SIM_CORE_NODE_ADDON);
+  }
+  return path.join(__dirname, "..", "..", "build", "modern", "sim-core", "sim_core_node.node");
+}
+
+const ADDON_ENABLED = String(process.env.VM_SIM_CORE_NATIVE || "on").trim().toLowerCase() !== "off";
+
+let loaded = undefined;
+
+function loadSimCoreAddon() {
+  if (loaded !== undefined) {
+    return loaded;
+  }
+  loaded = null;
+  if (!ADDON_ENABLED) {
+    return loaded;
+  }
+  const file = addonPath();
+  if (!fs.existsSync(file)) {
+    return loaded;
+  }
+  try {
+    const addon = require(file);
+    if (typeof addon?.createWorld === "function" && typeof addon?.handle === "function") {
+      loaded = addon;
+    }
+  } catch (_err) {
+    loaded = null;
+  }
+  return loaded;
+}
+
+module.exports = {
+  loadSimCoreAddon
+};
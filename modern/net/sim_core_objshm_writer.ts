@@ -0,0 +1,248 @@
+"use strict";
+
+const fs = require("node:fs");
+
+// Writer for the shared-memory world object table read by sim-core
+// (modern/sim-core/include/u6_objshm.h). The table lives in a file, normally
+// under /dev/shm; rows are updated in place with positioned writes between
+// an odd and an even seqlock `seq`, so mapped readers never copy or see a
+// half-applied delta. Rows stay dense: a removal moves the last row into the
+// hole. Outgrowing the capacity writes a larger file, renames it over the
+// path and marks the old one retired so readers reopen.
+
+const SHM_MAGIC = "U6SH";
+const SHM_VERSION = 1;
+const SHM_HEADER_SIZE = 64;
+const SHM_KEY_SIZE = 40;
+const SHM_KEY_MAX = SHM_KEY_SIZE - 1;
+const SHM_MIN_CAPACITY = 256;
+
+const OFF_SEQ = 8;
+const OFF_CAPACITY = 12;
+const OFF_COUNT = 16;
+const OFF_GENERATION = 20;
+const OFF_RETIRED = 24;
+
+// Column order and widths match u6_objshm.c layout().
+const COLUMN_WIDTHS = [4, 4, 4, 4, 4, 4, 1, 1, 1, SHM_KEY_SIZE];
+const COL_X = 0;
+const COL_SOURCE_INDEX = 5;
+const COL_STATUS = 6;
+const COL_TILE_FLAG = 7;
+const COL_HOLDER_KIND = 8;
+const COL_KEY = 9;
+
+function align64(v) {
+  return (v + 63) & ~63;
+}
+
+function shmLayout(capacity) {
+  const offsets = [];
+  let off = SHM_HEADER_SIZE;
+  for (const width of COLUMN_WIDTHS) {
+    offsets.push(off);
+    off = align64(off + width * capacity);
+  }
+  return { offsets, size: off };
+}
+
+function rowFromObject(obj, tileFlags) {
+  const key = String(obj?.object_key || "");
+  const keyLen = Buffer.byteLength(key, "utf8");
+  if (keyLen === 0 || keyLen > SHM_KEY_MAX || key.includes("\0")) {
+    return null;
+  }
+  const tileId = Number(obj?.tile_id) & 0xffff;
+  return {
+    key,
+    ints: [
+      Number(obj?.x) | 0,
+      Number(obj?.y) | 0,
+      Number(obj?.z) | 0,
+      0,
+      Number(obj?.source_area) | 0,
+      Number(obj?.source_index) | 0
+    ],
+    bytes: [
+      Number(obj?.status) & 0xff,
+      tileFlags ? (Number(tileFlags[tileId & 0x07ff]) & 0xff) : 0,
+      0
+    ]
+  };
+}
+
+function rowFingerprint(row) {
+  return `${row.ints.join(":")}:${row.bytes.join(":")}`;
+}
+
+// Encodes one row's cells into a whole-file image laid out by `layout`.
+function encodeRow(buf, layout, rowIndex, row) {
+  const o = layout.offsets;
+  for (let c = COL_X; c <= COL_SOURCE_INDEX; c++) {
+    buf.writeInt32LE(row.ints[c], o[c] + rowIndex * 4);
+  }
+  buf[o[COL_STATUS] + rowIndex] = row.bytes[0];
+  buf[o[COL_TILE_FLAG] + rowIndex] = row.bytes[1];
+  buf[o[COL_HOLDER_KIND] + rowIndex] = row.bytes[2];
+  const keyAt = o[COL_KEY] + rowIndex * SHM_KEY_SIZE;
+  buf.fill(0, keyAt, keyAt + SHM_KEY_SIZE);
+  buf.write(row.key, keyAt, "utf8");
+}
+
+function writeU32(fd, value, position) {
+  const b = Buffer.alloc(4);
+  b.writeUInt32LE(value >>> 0, 0);
+  fs.writeSync(fd, b, 0, 4, position);
+}
+
+function createObjectShmWriter(filePath) {
+  return {
+    path: String(filePath),
+    fd: -1,
+    capacity: 0,
+    layout: null,
+    seq: 0,
+    generation: 0,
+    lastCount: 0,
+    rowOf: new Map(),
+    rows: []
+  };
+}
+
+// Builds the whole table in memory and swaps it in under the path.
+function rebuild(writer, rows) {
+  let capacity = Math.max(SHM_MIN_CAPACITY, writer.capacity);
+  while (capacity < rows.length) {
+    capacity *= 2;
+  }
+  const layout = shmLayout(capacity);
+  const image = Buffer.alloc(layout.size);
+  image.write(SHM_MAGIC, 0, "latin1");
+  image.writeUInt32LE(SHM_VERSION, 4);
+  image.writeUInt32LE(0, OFF_SEQ);
+  image.writeUInt32LE(capacity, OFF_CAPACITY);
+  image.writeUInt32LE(rows.length, OFF_COUNT);
+  image.writeUInt32LE(1, OFF_GENERATION);
+  for (let i = 0; i < rows.length; i++) {
+    encodeRow(image, layout, i, rows[i]);
+  }
+  const tmpPath = `${writer.path}.${process.pid}.tmp`;
+  const fd = fs.openSync(tmpPath, "w+", 0o644);
+  try {
+    fs.writeSync(fd, image, 0, image.length, 0);
+    fs.renameSync(tmpPath, writer.path);
+  } catch (err) {
+    fs.closeSync(fd);
+    try {
+      fs.unlinkSync(tmpPath);
+    } catch (_unlinkErr) {
+      // already gone
+    }
+    throw err;
+  }
+  if (writer.fd >= 0) {
+    writeU32(writer.fd, 1, OFF_RETIRED);
+    fs.closeSync(writer.fd);
+  }
+  writer.fd = fd;
+  writer.capacity = capacity;
+  writer.layout = layout;
+  writer.seq = 0;
+  writer.generation = 1;
+  writer.lastCount = rows.length;
+  writer.rows = rows.map((row) => ({ key: row.key, fingerprint: rowFingerprint(row) }));
+  writer.rowOf = new Map(rows.map((row, i) => [row.key, i]));
+}
+
+// Brings the shared table in line with `objects`, one row per object_key.
+// Returns false, leaving the table as it was, when a key cannot be stored
+// (empty, over 39 bytes or containing NUL) or appears twice: rows are keyed,
+// and the argv/packed bridge paths keep duplicates, so callers fall back.
+function syncObjectShm(writer, objects, tileFlags) {
+  const next = new Map();
+  for (const obj of Array.isArray(objects) ? objects : []) {
+    const row = rowFromObject(obj, tileFlags);
+    if (!row || next.has(row.key)) {
+      return false;
+    }
+    next.set(row.key, row);
+  }
+  if (writer.fd < 0 || next.size > writer.capacity) {
+    rebuild(writer, [...next.values()]);
+    return true;
+  }
+
+  const rows = writer.rows;
+  const dirty = new Set();
+  for (let i = rows.length - 1; i >= 0; i--) {
+    if (next.has(rows[i].key)) {
+      continue;
+    }
+    const last = rows.length - 1;
+    writer.rowOf.delete(rows[i].key);
+    if (i !== last) {
+      rows[i] = rows[last];
+      writer.rowOf.set(rows[i].key, i);
+      dirty.add(i);
+    }
+    rows.pop();
+    dirty.delete(last);
+  }
+  for (const row of next.values()) {
+    const fingerprint = rowFingerprint(row);
+    let i = writer.rowOf.get(row.key);
+    if (i === undefined) {
+      i = rows.length;
+      rows.push({ key: row.key, fingerprint: "" });
+      writer.rowOf.set(row.key, i);
+    }
+    if (rows[i].fingerprint !== fingerprint) {
+      rows[i].fingerprint = fingerprint;
+      dirty.add(i);
+    }
+  }
+  if (dirty.size === 0 && rows.length === writer.lastCount) {
+    return true;
+  }
+
+  const o = writer.layout.offsets;
+  const cell = Buffer.alloc(SHM_KEY_SIZE);
+  writer.seq = (writer.seq + 1) >>> 0;
+  writeU32(writer.fd, writer.seq, OFF_SEQ);
+  for (const i of dirty) {
+    const row = next.get(rows[i].key);
+    for (let c = COL_X; c <= COL_SOURCE_INDEX; c++) {
+      cell.writeInt32LE(row.ints[c], 0);
+      fs.writeSync(writer.fd, cell, 0, 4, o[c] + i * 4);
+    }
+    cell[0] = row.bytes[0];
+    cell[1] = row.bytes[1];
+    cell[2] = row.bytes[2];
+    fs.writeSync(writer.fd, cell, 0, 1, o[COL_STATUS] + i);
+    fs.writeSync(writer.fd, cell, 1, 1, o[COL_TILE_FLAG] + i);
+    fs.writeSync(writer.fd, cell, 2, 1, o[COL_HOLDER_KIND] + i);
+    cell.fill(0);
+    cell.write(row.key, 0, "utf8");
+    fs.writeSync(writer.fd, cell, 0, SHM_KEY_SIZE, o[COL_KEY] + i * SHM_KEY_SIZE);
+  }
+  writeU32(writer.fd, rows.length, OFF_COUNT);
+  writer.generation = (writer.generation + 1) >>> 0;
+  writeU32(writer.fd, writer.generation, OFF_GENERATION);
+  writer.seq = (writer.seq + 1) >>> 0;
+  writeU32(writer.fd, writer.seq, OFF_SEQ);
+  writer.lastCount = rows.length;
+  return true;
+}
+
+function closeObjectShmWriter(writer) {
+  if (writer && writer.fd >= 0) {
+    fs.closeSync(writer.fd);
+    writer.fd = -1;
+  }
+}
+
+module.exports = {
+  createObjectShmWriter,
+  syncObjectShm,
+  closeObjectShmWriter
+};
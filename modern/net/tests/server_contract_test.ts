@@ -10,6 +10,7 @@ const SIM_CORE_INTERACT_BIN = path.join(ROOT, "build", "modern", "sim-core", "si
 const SIM_CORE_ASSOC_BIN = path.join(ROOT, "build", "modern", "sim-core", "sim_core_assoc_chain_bridge");
 const SIM_CORE_ASSOC_BATCH_BIN = path.join(ROOT, "build", "modern", "sim-core", "sim_core_assoc_chain_batch_bridge");
 const SIM_CORE_WORLD_QUERY_BIN = path.join(ROOT, "build", "modern", "sim-core", "sim_core_world_objects_query_bridge");
+const SIM_CORE_BRIDGE_DAEMON_BIN = path.join(ROOT, "build", "modern", "sim-core", "sim_core_bridge_daemon");
 const ROOM_HOTSPOT_FIXTURES = path.join(ROOT, "modern", "net", "tests", "fixtures", "room_hotspots.level0.json");
 
 function sleep(ms) {
@@ -120,6 +121,7 @@ async function main() {
       VM_SIM_CORE_ASSOC_BIN: SIM_CORE_ASSOC_BIN,
       VM_SIM_CORE_ASSOC_BATCH_BIN: SIM_CORE_ASSOC_BATCH_BIN,
       VM_SIM_CORE_WORLD_QUERY_BIN: SIM_CORE_WORLD_QUERY_BIN,
+      VM_SIM_CORE_BRIDGE_DAEMON_BIN: SIM_CORE_BRIDGE_DAEMON_BIN,
       VM_EMAIL_MODE: "log"
     },
     stdio: ["ignore", "pipe", "pipe"]
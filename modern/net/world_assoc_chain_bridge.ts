@@ -230,6 +230,7 @@ function analyzeContainmentChainsBatchViaSimCore(objects, targetObjects) {
 }
 
 module.exports = {
+  diagnosticsFromParsed,
   analyzeContainmentChainViaSimCore,
   analyzeContainmentChainsBatchViaSimCore
 };
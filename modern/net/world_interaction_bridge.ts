@@ -110,7 +110,9 @@ function invokeSimCoreBridge(input) {
   return { ok: true, parsed };
 }
 
-function applyCanonicalWorldInteractionCommand(input) {
+// call: an already-resolved { ok, parsed } (e.g. from the bridge daemon);
+// the spawn bridge is invoked when it is omitted.
+function applyCanonicalWorldInteractionCommand(input, call = null) {
   const verb = String(input?.verb || "").trim().toLowerCase();
   const target = input?.target || null;
   const container = input?.container || null;
@@ -120,7 +122,9 @@ function applyCanonicalWorldInteractionCommand(input) {
     return { ok: false, code: "bad_input", http: 400, message: "target and actor are required" };
   }
 
-  const call = invokeSimCoreBridge(input);
+  if (!call || !call.ok) {
+    call = invokeSimCoreBridge(input);
+  }
   if (!call.ok) {
     return {
       ok: false,
@@ -3,6 +3,7 @@
 const fs = require("node:fs");
 const path = require("node:path");
 const { spawnSync } = require("node:child_process");
+const { createObjectShmWriter, syncObjectShm, closeObjectShmWriter } = require("./sim_core_objshm_writer.ts");
 
 function queryBinPath() {
   if (process.env.VM_SIM_CORE_WORLD_QUERY_BIN) {
@@ -49,6 +50,82 @@ function objectArg(obj, tileFlags) {
   ].join(":");
 }
 
+// Packed "U6OT" table (modern/sim-core/include/u6_objpack.h): 16-byte header,
+// 32-byte records, then NUL-terminated keys stored once each. Returns null
+// when a key cannot be packed (empty or over 39 bytes); those worlds keep
+// the argv records.
+const PACK_HEADER_SIZE = 16;
+const PACK_RECORD_SIZE = 32;
+const PACK_KEY_MAX = 39;
+
+function packObjectTable(objects, tileFlags) {
+  const keyOffsets = new Map();
+  const keyChunks = [];
+  let keyBytes = 0;
+  const records = Buffer.alloc(objects.length * PACK_RECORD_SIZE);
+  for (let i = 0; i < objects.length; i++) {
+    const obj = objects[i];
+    const key = String(obj?.object_key || "");
+    let offset = keyOffsets.get(key);
+    const keyLen = Buffer.byteLength(key, "utf8");
+    if (keyLen === 0 || keyLen > PACK_KEY_MAX || key.includes("\0")) {
+      return null;
+    }
+    if (offset === undefined) {
+      offset = keyBytes;
+      keyOffsets.set(key, offset);
+      keyChunks.push(Buffer.from(`${key}\0`, "utf8"));
+      keyBytes += keyLen + 1;
+    }
+    const tileId = Number(obj?.tile_id) & 0xffff;
+    const r = i * PACK_RECORD_SIZE;
+    records.writeUInt32LE(offset, r);
+    records[r + 4] = keyLen;
+    records[r + 5] = Number(obj?.status) & 0xff;
+    records[r + 6] = tileFlags ? (Number(tileFlags[tileId & 0x07ff]) & 0xff) : 0;
+    records[r + 7] = 0;
+    records.writeInt32LE(Number(obj?.x) | 0, r + 8);
+    records.writeInt32LE(Number(obj?.y) | 0, r + 12);
+    records.writeInt32LE(Number(obj?.z) | 0, r + 16);
+    records.writeInt32LE(0, r + 20);
+    records.writeInt32LE(Number(obj?.source_area) | 0, r + 24);
+    records.writeInt32LE(Number(obj?.source_index) | 0, r + 28);
+  }
+  const header = Buffer.alloc(PACK_HEADER_SIZE);
+  header.write("U6OT", 0, "latin1");
+  header.writeUInt16LE(1, 4);
+  header.writeUInt16LE(PACK_RECORD_SIZE, 6);
+  header.writeUInt32LE(objects.length, 8);
+  header.writeUInt32LE(keyBytes, 12);
+  return Buffer.concat([header, records, ...keyChunks]);
+}
+
+// Optional shared-memory table (VM_SIM_CORE_WORLD_SHM, e.g. under /dev/shm):
+// each query writes only the rows that changed since the last one and the
+// bridge reads the live table in place instead of receiving it on stdin.
+const SHM_PATH = String(process.env.VM_SIM_CORE_WORLD_SHM || "").trim();
+let shmWriter = null;
+
+function syncSharedTable(objects, tileFlags) {
+  if (!SHM_PATH) {
+    return false;
+  }
+  try {
+    if (!shmWriter) {
+      shmWriter = createObjectShmWriter(SHM_PATH);
+    }
+    return syncObjectShm(shmWriter, objects, tileFlags);
+  } catch (_err) {
+    try {
+      closeObjectShmWriter(shmWriter);
+    } catch (_closeErr) {
+      // fd already unusable; dropping the writer is all that is left
+    }
+    shmWriter = null;
+    return false;
+  }
+}
+
 function parseKeysOutput(stdout) {
   const text = String(stdout || "").trim();
   const m = /^keys=(.*)$/i.exec(text);
@@ -68,6 +145,8 @@ function selectWorldObjectsViaSimCore(input) {
   if (!QUERY_BIN) {
     return { ok: false, code: "world_query_bridge_unavailable", message: "sim-core world query bridge unavailable" };
   }
+  const shared = syncSharedTable(objects, tileFlags);
+  const table = shared ? null : packObjectTable(objects, tileFlags);
   const args = [
     input?.hasX ? "1" : "0",
     String(Number(input?.x) | 0),
@@ -78,9 +157,16 @@ function selectWorldObjectsViaSimCore(input) {
     String(Number(input?.radius) | 0),
     String(input?.projection === "footprint" ? "footprint" : "anchor"),
     String(Math.max(1, Number(input?.limit) | 0)),
-    ...objects.map((obj) => objectArg(obj, tileFlags))
+    ...(shared
+      ? ["--shm", SHM_PATH]
+      : table ? ["--table", "-"] : objects.map((obj) => objectArg(obj, tileFlags)))
   ];
-  const proc = spawnSync(QUERY_BIN, args, { encoding: "utf8", timeout: 8000, maxBuffer: 16 * 1024 * 1024 });
+  const proc = spawnSync(QUERY_BIN, args, {
+    encoding: "utf8",
+    timeout: 8000,
+    maxBuffer: 16 * 1024 * 1024,
+    ...(table ? { input: table } : {})
+  });
   if (proc.error || (proc.status | 0) !== 0) {
     return { ok: false, code: "world_query_bridge_failed", message: "sim-core world query bridge execution failed" };
   }
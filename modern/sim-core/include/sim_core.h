@@ -74,6 +74,12 @@ int sim_step_ticks(SimState *state,
                    SimStepResult *out_result);
 
 uint64_t sim_state_hash(const SimState *state);
+/*
+ * sim_state_hash folded with a companion-state hash (e.g. u6_entities_hash,
+ * optionally combined with u6_objblk_store_hash) so divergence in entity or
+ * object state shows up in the same checkpoint value.
+ */
+uint64_t sim_world_hash(const SimState *state, uint64_t companion_hash);
 
 size_t sim_command_wire_size(void);
 int sim_command_serialize(const SimCommand *cmd, uint8_t *out, size_t out_size);
@@ -98,4 +104,20 @@ int sim_write_replay_checkpoints(const SimState *initial_state,
                                  uint32_t checkpoint_interval,
                                  const char *path);
 
+/*
+ * Checkpoint hook: brings companion state up to state->tick and returns its
+ * hash. Called once per checkpoint row, after the sim has been stepped.
+ */
+typedef uint64_t (*SimCompanionHashFn)(const SimState *state, void *user);
+
+/* Same rows as sim_write_replay_checkpoints plus a world_hash column. */
+int sim_write_replay_checkpoints_world(const SimState *initial_state,
+                                       const SimCommand *commands,
+                                       size_t command_count,
+                                       uint32_t total_ticks,
+                                       uint32_t checkpoint_interval,
+                                       SimCompanionHashFn companion_hash,
+                                       void *user,
+                                       const char *path);
+
 #endif
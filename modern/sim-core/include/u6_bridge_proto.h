@@ -0,0 +1,155 @@
+#ifndef U6M_U6_BRIDGE_PROTO_H
+#define U6M_U6_BRIDGE_PROTO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "u6_assoc_chain.h"
+
+/*
+ * Resident world object table and the length-prefixed binary protocol that
+ * sim_core_bridge_daemon serves to the net server, replacing one process
+ * spawn (with the whole object list on argv) per query/assoc/interaction.
+ *
+ * Framing, all integers little-endian:
+ *   request  = u32 body_len, body = u8 op, payload
+ *   response = u32 body_len, body = u8 op, i32 status, payload
+ * A response echoes the request op; status < 0 means the payload is empty.
+ *
+ * Object record = u8 key_len (1..U6_BRIDGE_KEY_MAX), key bytes,
+ *   i32 x, i32 y, i32 z, u8 status, u8 tile_flag, u8 holder_kind,
+ *   u8 reserved, i32 holder_key, i32 source_area, i32 source_index
+ * Key string = u8 len, bytes.
+ *
+ * Ops:
+ *   HELLO     -> u32 protocol version, u32 object count, u32 generation
+ *   LOAD      u32 n, n records (replaces the table)  -> u32 object count
+ *   UPSERT    u32 n, n records (insert or replace by key; applies all or
+ *             nothing) -> u32 object count
+ *   REMOVE    u32 n, n key strings -> u32 removed
+ *   QUERY     u8 has_x, u8 has_y, u8 has_z, u8 footprint, i32 x, i32 y,
+ *             i32 z, i32 radius, i32 limit -> u32 n, n key strings
+ *   ASSOC     u32 n, n i32 target keys -> u32 n, then per target: i32 target,
+ *             i32 code, i32 root_anchor_key, i32 blocked_by_key,
+ *             u8 flags (U6_BRIDGE_ASSOC_*), u8 chain_len, chain_len i32 keys
+ *   INTERACT  u8 verb, status, holder_kind, owner_matches_actor,
+ *             has_container, chain_accessible, container_cycle
+ *             -> i32 code, u8 status, u8 holder_kind
+ *   SNAPSHOT  -> u32 n, n records (a LOAD payload that restores the table)
+ *
+ * QUERY orders and filters exactly like sim_core_world_objects_query_bridge
+ * (the comparator below is shared). ASSOC analyzes against the resident
+ * table with the numeric value of each key; objects whose key is not a
+ * non-zero number take no part in chains.
+ */
+#define U6_BRIDGE_PROTOCOL_VERSION 1u
+#define U6_BRIDGE_KEY_MAX 39u
+#define U6_BRIDGE_MAX_FRAME (64u * 1024u * 1024u)
+#define U6_BRIDGE_RECORD_FIXED_SIZE 28u
+
+enum {
+  U6_BRIDGE_OP_HELLO = 1,
+  U6_BRIDGE_OP_LOAD = 2,
+  U6_BRIDGE_OP_UPSERT = 3,
+  U6_BRIDGE_OP_REMOVE = 4,
+  U6_BRIDGE_OP_QUERY = 5,
+  U6_BRIDGE_OP_ASSOC = 6,
+  U6_BRIDGE_OP_INTERACT = 7,
+  U6_BRIDGE_OP_SNAPSHOT = 8
+};
+
+enum {
+  U6_BRIDGE_OK = 0,
+  U6_BRIDGE_ERR_NULL = -1,
+  U6_BRIDGE_ERR_FRAME = -2,
+  U6_BRIDGE_ERR_OP = -3,
+  U6_BRIDGE_ERR_RECORD = -4,
+  U6_BRIDGE_ERR_ALLOC = -5
+};
+
+enum {
+  U6_BRIDGE_ASSOC_ACCESSIBLE = 1u << 0,
+  U6_BRIDGE_ASSOC_CYCLE = 1u << 1,
+  U6_BRIDGE_ASSOC_MISSING_PARENT = 1u << 2,
+  U6_BRIDGE_ASSOC_PARENT_OWNED = 1u << 3
+};
+
+typedef struct U6BridgeObject {
+  char key[U6_BRIDGE_KEY_MAX + 1u];
+  int x;
+  int y;
+  int z;
+  uint8_t status;
+  uint8_t tile_flag;
+  uint8_t holder_kind;
+  int holder_key;
+  int source_area;
+  int source_index;
+} U6BridgeObject;
+
+typedef struct U6BridgeQuery {
+  int has_x;
+  int x;
+  int has_y;
+  int y;
+  int has_z;
+  int z;
+  int radius;
+  int projection_footprint;
+  int limit;
+} U6BridgeQuery;
+
+/* Render order used by the world object query (locxyz last, then y, x, z desc, ...). */
+int u6_bridge_object_cmp(const U6BridgeObject *a, const U6BridgeObject *b);
+/* z filter, then an anchor box or footprint hit around (x, y) when both are given. */
+int u6_bridge_object_matches(const U6BridgeObject *o, const U6BridgeQuery *q);
+
+/*
+ * Objects live in a dense array with a chained key hash (swap-remove keeps
+ * it dense). The render-ordered index and the assoc node array are rebuilt
+ * lazily after a change, so repeated queries against an unchanged table
+ * skip the sort.
+ */
+typedef struct U6BridgeWorld {
+  U6BridgeObject *objects;
+  uint32_t *next;    /* hash chain per object (index + 1, 0 = end) */
+  uint32_t *buckets; /* bucket_count heads (index + 1) */
+  const U6BridgeObject **order; /* render order, valid when order_valid */
+  U6AssocChainNode *nodes; /* one per object, valid when nodes_valid */
+  size_t count;
+  size_t capacity;
+  size_t bucket_count;
+  size_t node_count;
+  uint32_t generation;
+  uint8_t order_valid;
+  uint8_t nodes_valid;
+} U6BridgeWorld;
+
+typedef struct U6BridgeBuffer {
+  uint8_t *data;
+  size_t size;
+  size_t capacity;
+} U6BridgeBuffer;
+
+void u6_bridge_world_init(U6BridgeWorld *world);
+void u6_bridge_world_free(U6BridgeWorld *world);
+int u6_bridge_world_upsert(U6BridgeWorld *world, const U6BridgeObject *object);
+/* 1 if the key was present, 0 otherwise. */
+int u6_bridge_world_remove(U6BridgeWorld *world, const char *key);
+const U6BridgeObject *u6_bridge_world_find(const U6BridgeWorld *world, const char *key);
+/* Writes up to out_capacity object indexes in render order; returns the match count (<= limit). */
+size_t u6_bridge_world_query(U6BridgeWorld *world, const U6BridgeQuery *q, uint32_t *out_indexes, size_t out_capacity);
+
+void u6_bridge_buffer_free(U6BridgeBuffer *buffer);
+
+/*
+ * Handles one request body (op + payload, without the length prefix) and
+ * replaces out with the complete response frame. Protocol errors become a
+ * response status; the return value is < 0 only when no response could be
+ * built (out of memory).
+ */
+int u6_bridge_handle(U6BridgeWorld *world, const uint8_t *body, size_t body_len, U6BridgeBuffer *out);
+/* Same, with the op passed separately (payload need not follow an op byte). */
+int u6_bridge_handle_op(U6BridgeWorld *world, uint8_t op, const uint8_t *payload, size_t payload_len, U6BridgeBuffer *out);
+
+#endif
@@ -5,13 +5,29 @@
 #include <stdint.h>
 
 enum {
-  U6M_MAX_OBJECTS = 256,
-  U6M_MAX_NPCS = 64,
+  U6M_OBJECT_PAGE_SIZE = 256,
+  U6M_NPC_PAGE_SIZE = 64,
+  U6M_OBJECT_PAGES = 255,
+  U6M_NPC_PAGES = 4,
+  /* Page 0 of each pool is inline; later pages come from the arena. */
+  U6M_INLINE_OBJECTS = U6M_OBJECT_PAGE_SIZE,
+  U6M_INLINE_NPCS = U6M_NPC_PAGE_SIZE,
+  U6M_MAX_OBJECTS = U6M_OBJECT_PAGE_SIZE * U6M_OBJECT_PAGES,
+  U6M_MAX_NPCS = U6M_NPC_PAGE_SIZE * U6M_NPC_PAGES,
+  U6M_OBJECT_INDEX_SLOTS = 512,
+  U6M_NPC_INDEX_SLOTS = 512,
   U6M_ENTITY_MAGIC = 0x4e453655u, /* U6EN */
-  U6M_ENTITY_VERSION = 2,
-  U6M_ENTITY_HEADER_SIZE = 12,
+  U6M_ENTITY_VERSION = 3,
+  U6M_ENTITY_HEADER_SIZE = 16,
+  U6M_ENTITY_HEADER_SIZE_V2 = 12,
   U6M_ENTITY_OBJECT_SIZE = 16,
-  U6M_ENTITY_NPC_SIZE = 13
+  U6M_ENTITY_NPC_SIZE = 13,
+  U6M_ENTITY_DELTA_MAGIC = 0x44453655u, /* U6ED */
+  U6M_ENTITY_DELTA_VERSION = 1,
+  U6M_ENTITY_DELTA_HEADER_SIZE = 32,
+  U6M_ENTITY_TOMBSTONES = 256,
+  U6M_NPC_CELL_SHIFT = 3, /* 8x8-tile chunks */
+  U6M_NPC_CELL_BUCKETS = 512
 };
 
 typedef enum U6ObjectType {
@@ -63,26 +79,265 @@ typedef struct U6NpcState {
   uint8_t flags;
 } U6NpcState;
 
+/*
+ * Caller-supplied bump arena. Entity pools carve pages and grown id indexes
+ * out of it, so adds never call malloc; nothing is returned to it until the
+ * caller rewinds or discards the buffer.
+ */
+typedef struct U6EntityArena {
+  uint8_t *base;
+  size_t size;
+  size_t used;
+} U6EntityArena;
+
+/*
+ * Generation is odd while the slot is live and bumps on every add/remove,
+ * so a handle ((generation << 16) | slot) goes stale once its entity is
+ * removed. next_free is the free-list link (slot + 1, 0 = end). version is
+ * the state version of the slot's last change (see delta serialization);
+ * hash is the record hash last folded into the state hash (0 when free).
+ */
+typedef struct U6EntitySlotMeta {
+  uint16_t generation;
+  uint16_t next_free;
+  uint32_t version;
+  uint64_t hash;
+} U6EntitySlotMeta;
+
+typedef struct U6EntityTombstone {
+  uint32_t version;
+  uint16_t id;
+  uint8_t kind; /* U6_OBJECT_HOLDER_OBJECT or U6_OBJECT_HOLDER_NPC */
+} U6EntityTombstone;
+
+typedef uint32_t U6EntityHandle;
+#define U6M_ENTITY_HANDLE_NONE 0u
+
+/*
+ * Containment tree, first-child/next-sibling with back links (all slot + 1,
+ * 0 = none). parent_kind is the holder kind the object was linked for; with
+ * parent 0 it marks an orphan whose holder is not (yet) present.
+ */
+typedef struct U6ObjectLinks {
+  uint16_t parent;
+  uint16_t first_child;
+  uint16_t next_sibling;
+  uint16_t prev_sibling;
+  uint8_t parent_kind;
+} U6ObjectLinks;
+
+/*
+ * NPC chunk-bucket link: cell is the packed chunk key + 1 (0 = unlinked),
+ * next/prev chain the bucket (slot + 1, 0 = end).
+ */
+typedef struct U6NpcCellLink {
+  uint32_t cell;
+  uint16_t next;
+  uint16_t prev;
+} U6NpcCellLink;
+
+typedef struct U6ObjectPage {
+  U6ObjectState items[U6M_OBJECT_PAGE_SIZE];
+  U6EntitySlotMeta meta[U6M_OBJECT_PAGE_SIZE];
+  U6ObjectLinks links[U6M_OBJECT_PAGE_SIZE];
+} U6ObjectPage;
+
+typedef struct U6NpcPage {
+  U6NpcState items[U6M_NPC_PAGE_SIZE];
+  U6EntitySlotMeta meta[U6M_NPC_PAGE_SIZE];
+  uint16_t first_child[U6M_NPC_PAGE_SIZE];
+  U6NpcCellLink cell[U6M_NPC_PAGE_SIZE];
+} U6NpcPage;
+
+/*
+ * Pooled entity storage. Slots never move: removal pushes the slot on a free
+ * list and later adds reuse it, so pointers and handles stay valid until the
+ * entity is removed. objects[]/npcs[] are the inline first pages (slots
+ * 0..255/0..63 need no arena); iterate all pages with u6_entities_*_slots
+ * and u6_entities_*_at, which return NULL for free slots. Without an arena
+ * the pools are capped at the inline page. States hold arena pointers, so
+ * copy them with serialize/deserialize, not by value.
+ *
+ * The id indexes map id -> slot via linear probing; each entry packs
+ * (id << 16) | (slot + 1), 0 = empty. The object index doubles into the
+ * arena as pages are added. Mutators keep the indexes in sync; code that
+ * rewrites ids directly must call u6_entities_reindex.
+ *
+ * Holder links form the containment tree. add/remove/set_holder maintain
+ * it in place; reindex, deserialize and adding an entity while orphans
+ * exist mark it stale, and the next containment query rebuilds it. Direct
+ * edits of holder_kind/holder_id need u6_entities_reindex as well.
+ *
+ * Change tracking: every mutator stamps the slot with ++version and raises
+ * its page's version, so a delta scan skips untouched pages. Removals also
+ * log a tombstone in a ring of U6M_ENTITY_TOMBSTONES; tombstone_floor is
+ * the newest version the ring has overwritten. Code that edits entities in
+ * place through a pointer must call u6_entities_touch_object/_npc.
+ *
+ * content_hash is the wrapping sum of per-entity record hashes as of
+ * hash_version; u6_entities_hash folds in only slots stamped since then.
+ *
+ * NPCs are also bucketed by 8x8 chunk (z included) in a hashed table of
+ * U6M_NPC_CELL_BUCKETS chains; every NPC stamp re-buckets the NPC if its
+ * chunk changed, so the same touch rule keeps proximity queries current.
+ */
 typedef struct U6EntityState {
   size_t object_count;
   size_t npc_count;
-  U6ObjectState objects[U6M_MAX_OBJECTS];
-  U6NpcState npcs[U6M_MAX_NPCS];
+  size_t object_slots;
+  size_t npc_slots;
+  uint32_t object_free;
+  uint32_t npc_free;
+  U6EntityArena *arena;
+  U6ObjectState objects[U6M_INLINE_OBJECTS];
+  U6NpcState npcs[U6M_INLINE_NPCS];
+  U6EntitySlotMeta object_meta[U6M_INLINE_OBJECTS];
+  U6EntitySlotMeta npc_meta[U6M_INLINE_NPCS];
+  U6ObjectLinks object_links[U6M_INLINE_OBJECTS];
+  uint16_t npc_first_child[U6M_INLINE_NPCS];
+  U6NpcCellLink npc_cell[U6M_INLINE_NPCS];
+  uint16_t npc_cell_head[U6M_NPC_CELL_BUCKETS];
+  size_t containment_orphans;
+  uint8_t containment_stale;
+  uint32_t version;
+  uint32_t object_page_version[U6M_OBJECT_PAGES];
+  uint32_t npc_page_version[U6M_NPC_PAGES];
+  U6EntityTombstone tombstones[U6M_ENTITY_TOMBSTONES];
+  uint32_t tombstone_next;
+  uint32_t tombstone_floor;
+  uint64_t content_hash;
+  uint32_t hash_version;
+  U6ObjectPage *object_pages[U6M_OBJECT_PAGES];
+  U6NpcPage *npc_pages[U6M_NPC_PAGES];
+  uint32_t *object_index_ext; /* NULL = object_index */
+  uint32_t object_index_mask;
+  uint32_t object_index[U6M_OBJECT_INDEX_SLOTS];
+  uint32_t npc_index[U6M_NPC_INDEX_SLOTS];
 } U6EntityState;
 
+void u6_entity_arena_init(U6EntityArena *arena, void *buffer, size_t size);
+/* Arena bytes needed for pools holding max_objects/max_npcs (inline pages included). */
+size_t u6_entities_arena_bytes(size_t max_objects, size_t max_npcs);
+
 int u6_entities_init(U6EntityState *state);
+/* arena may be NULL (inline pages only); it must outlive the state. */
+int u6_entities_init_arena(U6EntityState *state, U6EntityArena *arena);
+/* Adds return -2 when the pool (or arena) is full, -3 if the id is already present. */
 int u6_entities_add_object(U6EntityState *state, const U6ObjectState *object_state);
 int u6_entities_add_npc(U6EntityState *state, const U6NpcState *npc_state);
 U6ObjectState *u6_entities_find_object(U6EntityState *state, uint16_t object_id);
 U6NpcState *u6_entities_find_npc(U6EntityState *state, uint16_t npc_id);
+/* Removal frees the slot for reuse; other entities stay put (-2 if the id is unknown). */
+int u6_entities_remove_object(U6EntityState *state, uint16_t object_id);
+int u6_entities_remove_npc(U6EntityState *state, uint16_t npc_id);
+
+/* Slot iteration: slots is the high-water mark, *_at is NULL for free slots. */
+size_t u6_entities_object_slots(const U6EntityState *state);
+size_t u6_entities_npc_slots(const U6EntityState *state);
+U6ObjectState *u6_entities_object_at(const U6EntityState *state, size_t slot);
+U6NpcState *u6_entities_npc_at(const U6EntityState *state, size_t slot);
+
+/* Generational handles; U6M_ENTITY_HANDLE_NONE if absent, NULL once stale. */
+U6EntityHandle u6_entities_object_handle(const U6EntityState *state, uint16_t object_id);
+U6EntityHandle u6_entities_npc_handle(const U6EntityState *state, uint16_t npc_id);
+U6ObjectState *u6_entities_object_from_handle(const U6EntityState *state, U6EntityHandle handle);
+U6NpcState *u6_entities_npc_from_handle(const U6EntityState *state, U6EntityHandle handle);
+
+/*
+ * Containment. set_holder moves an object under an object/NPC holder (or
+ * U6_OBJECT_HOLDER_NONE) and updates holder_kind/holder_id; -2 unknown
+ * object, -4 if the move would put a container inside itself. Status and
+ * coordinates are left to the caller.
+ *
+ * children lists direct children, contents the whole subtree in pre-order
+ * (out_depths, optional, is 1 for direct children); both return the total
+ * and write at most out_capacity ids. contents_totals sums count and
+ * quantity over the subtree (-2 unknown holder).
+ */
+int u6_entities_set_holder(U6EntityState *state, uint16_t object_id, uint8_t holder_kind, uint16_t holder_id);
+size_t u6_entities_children(U6EntityState *state,
+                            uint8_t holder_kind,
+                            uint16_t holder_id,
+                            uint16_t *out_ids,
+                            size_t out_capacity);
+size_t u6_entities_contents(U6EntityState *state,
+                            uint8_t holder_kind,
+                            uint16_t holder_id,
+                            uint16_t *out_ids,
+                            uint8_t *out_depths,
+                            size_t out_capacity);
+int u6_entities_contents_totals(U6EntityState *state,
+                                uint8_t holder_kind,
+                                uint16_t holder_id,
+                                uint32_t *out_count,
+                                uint32_t *out_quantity);
+
+/* Rebuilds both id indexes from the live slots; -3 on a duplicate id. */
+int u6_entities_reindex(U6EntityState *state);
 int u6_entities_move_npc(U6EntityState *state, uint16_t npc_id, int16_t x, int16_t y, int16_t z);
+/*
+ * NPCs on level z within Chebyshev distance radius of (x, y), visiting only
+ * the chunks the box covers. Writes up to out_capacity ids in ascending id
+ * order and returns the total; callers narrow further (e.g. talk range).
+ */
+size_t u6_entities_npcs_near(U6EntityState *state,
+                             int16_t x,
+                             int16_t y,
+                             int16_t z,
+                             int16_t radius,
+                             uint16_t *out_ids,
+                             size_t out_capacity);
 int u6_entities_step(U6EntityState *state, uint32_t tick);
+/* Same rule as step, limited to the listed NPC slots (e.g. a scheduler run list). */
+int u6_entities_step_slots(U6EntityState *state, const uint16_t *slots, size_t count, uint32_t tick);
+
+/* Current change version; 0 right after init or deserialize. */
+uint32_t u6_entities_version(const U6EntityState *state);
+/* Marks an entity edited in place as changed (-2 if the id is unknown). */
+int u6_entities_touch_object(U6EntityState *state, uint16_t object_id);
+int u6_entities_touch_npc(U6EntityState *state, uint16_t npc_id);
+/*
+ * Order-independent hash of every live object and NPC record: equal for
+ * states with the same entities regardless of slot layout. Cost is the
+ * slots changed since the previous call (a full pass only in deserialize).
+ */
+uint64_t u6_entities_hash(U6EntityState *state);
 
 size_t u6_entities_serialized_size(const U6EntityState *state);
 int u6_entities_serialize(const U6EntityState *state,
                           uint8_t *out,
                           size_t out_size,
                           size_t *out_written);
+/*
+ * Serialize writes version 3 (u32 counts, live entities in slot order);
+ * deserialize also accepts version 2 blobs. -7 if the blob repeats an object
+ * or NPC id, -8 if the arena cannot hold the counts. deserialize initializes
+ * the state without an arena; the _arena form attaches one first.
+ */
 int u6_entities_deserialize(U6EntityState *state, const uint8_t *in, size_t in_size);
+int u6_entities_deserialize_arena(U6EntityState *state,
+                                  U6EntityArena *arena,
+                                  const uint8_t *in,
+                                  size_t in_size);
+
+/*
+ * Delta since base_version: removed ids (tombstones), then the current
+ * records of every entity changed after base, in the full format's record
+ * layout. The header carries base and the state's version, which the
+ * receiver passes as the next base. Costs O(pages + changed pages) rather
+ * than O(entities). -5 if base is newer than the state or older than the
+ * tombstone ring retains: send a full serialize instead.
+ *
+ * apply_delta removes tombstoned ids, then upserts records (stamping them
+ * locally). Error codes follow deserialize (-8 = pool full); on -8 the
+ * records before the failing one stay applied.
+ */
+int u6_entities_delta_size(const U6EntityState *state, uint32_t base_version, size_t *out_size);
+int u6_entities_serialize_delta(const U6EntityState *state,
+                                uint32_t base_version,
+                                uint8_t *out,
+                                size_t out_size,
+                                size_t *out_written);
+int u6_entities_apply_delta(U6EntityState *state, const uint8_t *in, size_t in_size);
 
 #endif
@@ -0,0 +1,81 @@
+#ifndef U6M_U6_ENTITY_SNAPSHOT_H
+#define U6M_U6_ENTITY_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "u6_entities.h"
+
+/*
+ * Copy-on-write entity snapshots. A snapshot holds the object/NPC records
+ * of a state in refcounted pages that mirror the state's slot pages. Capture
+ * against an earlier snapshot of the same state shares every page whose page
+ * version has not moved since that snapshot and copies only the rest, so a
+ * history of snapshots costs one page per page actually modified. Fork
+ * shares all pages of an existing snapshot (no record copies).
+ *
+ * Restore writes a snapshot back through the normal mutators: the state's
+ * version keeps moving forward, so delta consumers, the content hash and the
+ * NPC cell index all stay valid across a rollback. Restoring into the state
+ * a snapshot was captured from only visits slots stamped since the capture;
+ * any other state is reconciled in full.
+ *
+ * Like a delta base, a snapshot's version is only meaningful for its source
+ * state until that state is re-initialized or deserialized; release (or
+ * stop using as base) snapshots taken before that. Refcounts are not atomic:
+ * snapshots that share pages belong to one thread.
+ */
+enum {
+  U6_ENTITY_SNAPSHOT_OK = 0,
+  U6_ENTITY_SNAPSHOT_ERR_NULL = -1,
+  U6_ENTITY_SNAPSHOT_ERR_FULL = -2,
+  U6_ENTITY_SNAPSHOT_ERR_ALLOC = -4
+};
+
+/* generation mirrors the slot meta: odd = live. */
+typedef struct U6ObjectSnapPage {
+  uint32_t refs;
+  U6ObjectState items[U6M_OBJECT_PAGE_SIZE];
+  uint16_t generation[U6M_OBJECT_PAGE_SIZE];
+} U6ObjectSnapPage;
+
+typedef struct U6NpcSnapPage {
+  uint32_t refs;
+  U6NpcState items[U6M_NPC_PAGE_SIZE];
+  uint16_t generation[U6M_NPC_PAGE_SIZE];
+} U6NpcSnapPage;
+
+typedef struct U6EntitySnapshot {
+  const U6EntityState *source;
+  uint32_t version;
+  size_t object_count;
+  size_t npc_count;
+  size_t object_slots;
+  size_t npc_slots;
+  U6ObjectSnapPage *object_pages[U6M_OBJECT_PAGES];
+  U6NpcSnapPage *npc_pages[U6M_NPC_PAGES];
+} U6EntitySnapshot;
+
+/*
+ * base (optional) must be an earlier snapshot of the same state; pages the
+ * state has not touched since base are shared with it. out must not alias
+ * base and is overwritten (release it first if it held pages).
+ */
+int u6_entity_snapshot_capture(U6EntitySnapshot *out, const U6EntityState *state, const U6EntitySnapshot *base);
+/* out shares every page of snapshot; either may be released first. */
+int u6_entity_snapshot_fork(U6EntitySnapshot *out, const U6EntitySnapshot *snapshot);
+void u6_entity_snapshot_release(U6EntitySnapshot *snapshot);
+
+/* Read-only slot access, NULL for free slots (same slot numbers as the source state). */
+const U6ObjectState *u6_entity_snapshot_object_at(const U6EntitySnapshot *snapshot, size_t slot);
+const U6NpcState *u6_entity_snapshot_npc_at(const U6EntitySnapshot *snapshot, size_t slot);
+
+/*
+ * Makes state hold exactly the snapshot's entities (slots may differ).
+ * Returns the number of entities added, updated or removed, or < 0
+ * (U6_ENTITY_SNAPSHOT_ERR_FULL if the state's pools cannot hold them; the
+ * state is then partially restored).
+ */
+int u6_entity_snapshot_restore(U6EntityState *state, const U6EntitySnapshot *snapshot);
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef U6M_U6_INTERACTION_H
 #define U6M_U6_INTERACTION_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "u6_entities.h"
@@ -53,4 +54,38 @@ int u6_interaction_apply(U6EntityState *state,
                          const U6InteractionRequest *request,
                          U6InteractionResult *out_result);
 
+/*
+ * One journal line per successful request, in apply order. version is the
+ * entity state version right after the request (equal to the previous
+ * line's for events that change nothing, e.g. TALK), so a consumer can pair
+ * events with serialize_delta bases. count is the total; at most capacity
+ * entries are written.
+ */
+typedef struct U6InteractionJournalEntry {
+  uint32_t request_index;
+  U6InteractionEvent event;
+  uint16_t actor_npc_id;
+  uint16_t affected_id;
+  uint32_t version;
+} U6InteractionJournalEntry;
+
+typedef struct U6InteractionJournal {
+  U6InteractionJournalEntry *entries;
+  size_t capacity;
+  size_t count;
+} U6InteractionJournal;
+
+/*
+ * Applies requests[0..count) in order with the same rules and results as
+ * calling u6_interaction_apply on each, so later requests see earlier ones'
+ * effects. Actor and target lookups are resolved once per request (actors
+ * once per batch). journal may be NULL. Returns the number of requests that
+ * succeeded, or U6_INTERACT_ERR_NULL.
+ */
+int u6_interaction_apply_batch(U6EntityState *state,
+                               const U6InteractionRequest *requests,
+                               size_t count,
+                               U6InteractionResult *results,
+                               U6InteractionJournal *journal);
+
 #endif
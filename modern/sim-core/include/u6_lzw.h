@@ -0,0 +1,102 @@
+#ifndef U6M_U6_LZW_H
+#define U6M_U6_LZW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Legacy U6 LZW (lzobjblk, lzdngblk, conversation archives): 9..12-bit codes
+ * packed LSB-first, 256 = clear, 257 = end, width grows when the next free
+ * code reaches 512/1024/2048. Decoding stops quietly on an invalid code or a
+ * short final code, matching decompressU6Lzw in the TS client/tools.
+ */
+#define U6_LZW_DICT_SIZE 4096u
+#define U6_LZW_CODE_CLEAR 256u
+#define U6_LZW_CODE_END 257u
+#define U6_LZW_FIRST_FREE 258u
+#define U6_LZW_HEADER_SIZE 4u
+
+enum {
+  U6_LZW_OK = 0,
+  U6_LZW_OUTPUT_FULL = 1,
+  U6_LZW_STOPPED = 2,
+  U6_LZW_ERR_NULL = -1,
+  U6_LZW_ERR_HEADER = -2,
+  U6_LZW_ERR_CAPACITY = -3,
+  U6_LZW_ERR_TRUNCATED = -4,
+  U6_LZW_ERR_ALLOC = -5
+};
+
+/*
+ * Streaming decoder. The dictionary is a fixed prefix/suffix table, so a
+ * decoder never allocates; strings are unwound into `stack` and drained into
+ * caller output across calls when the output buffer is short.
+ */
+typedef struct U6LzwDecoder {
+  uint16_t prefix[U6_LZW_DICT_SIZE];
+  uint16_t length[U6_LZW_DICT_SIZE];
+  uint8_t suffix[U6_LZW_DICT_SIZE];
+  uint8_t first[U6_LZW_DICT_SIZE];
+  uint8_t stack[U6_LZW_DICT_SIZE];
+  uint16_t stack_pos;
+  uint16_t stack_len;
+  uint32_t bit_buffer;
+  uint8_t bit_count;
+  uint8_t code_size;
+  uint16_t next_code;
+  uint16_t prev_code;
+  uint8_t has_prev;
+  uint8_t stopped;
+} U6LzwDecoder;
+
+void u6_lzw_decoder_init(U6LzwDecoder *dec);
+
+/*
+ * Consumes input and writes up to out_capacity bytes. Returns U6_LZW_OK when
+ * all input was consumed (feed more), U6_LZW_OUTPUT_FULL when out is full
+ * (call again, unconsumed input is reported via *in_used), or U6_LZW_STOPPED
+ * once an end/invalid code was seen; later calls only drain pending bytes.
+ */
+int u6_lzw_decoder_feed(U6LzwDecoder *dec,
+                        const uint8_t *in,
+                        size_t in_size,
+                        size_t *in_used,
+                        uint8_t *out,
+                        size_t out_capacity,
+                        size_t *out_written);
+
+/* Reads the 32-bit little-endian decoded length; 0 is rejected as -2. */
+int u6_lzw_decoded_size(const uint8_t *src, size_t src_size, size_t *out_size);
+
+/*
+ * One-shot decode of a length-prefixed stream. *out_size receives the bytes
+ * produced; -4 means the stream ended before the header length (the partial
+ * output is still valid, as the TS tools keep it).
+ */
+int u6_lzw_decompress(const uint8_t *src,
+                      size_t src_size,
+                      uint8_t *out,
+                      size_t out_capacity,
+                      size_t *out_size);
+
+/* Same, for archives that store the decoded length outside the payload. */
+int u6_lzw_decompress_known_length(const uint8_t *payload,
+                                   size_t payload_size,
+                                   size_t decoded_size,
+                                   uint8_t *out,
+                                   size_t out_capacity,
+                                   size_t *out_size);
+
+/*
+ * Encoder producing streams the decoder (and the TS decoders) accept: header,
+ * codes, END. No CLEAR is emitted; once the dictionary fills, codes stay at
+ * 12 bits. Used by tests/benchmarks and tools that write legacy archives.
+ */
+size_t u6_lzw_compress_bound(size_t src_size);
+int u6_lzw_compress(const uint8_t *src,
+                    size_t src_size,
+                    uint8_t *out,
+                    size_t out_capacity,
+                    size_t *out_size);
+
+#endif
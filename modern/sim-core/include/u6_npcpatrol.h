@@ -0,0 +1,49 @@
+#ifndef U6M_U6_NPCPATROL_H
+#define U6M_U6_NPCPATROL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "u6_entities.h"
+
+/*
+ * Struct-of-arrays NPC patrol table. load gathers live NPCs from an entity
+ * state (slot order), step advances them with the same rule as
+ * u6_entities_step (every 4th tick; ACTIVE|PATROL NPCs add dx/dy, reverse
+ * on leaving 0..1023, clamp), and store writes positions and directions
+ * back, touching the NPCs that changed. Columns are padded to U6_NPCPATROL_LANES rows with inactive NPCs so
+ * the kernel never needs a scalar tail. AVX2 (SIM_CORE_ENABLE_AVX2), SSE2
+ * and scalar kernels give identical results; step_scalar is the reference.
+ */
+#define U6_NPCPATROL_LANES 16u
+
+enum {
+  U6_NPCPATROL_OK = 0,
+  U6_NPCPATROL_ERR_NULL = -1,
+  U6_NPCPATROL_ERR_FULL = -2,
+  U6_NPCPATROL_ERR_ALLOC = -3
+};
+
+typedef struct U6NpcPatrolTable {
+  int16_t *x;
+  int16_t *y;
+  int8_t *dx;
+  int8_t *dy;
+  uint8_t *flags;
+  uint16_t *npc_slot;
+  size_t count;
+  size_t capacity;
+} U6NpcPatrolTable;
+
+int u6_npcpatrol_init(U6NpcPatrolTable *table, size_t capacity);
+void u6_npcpatrol_free(U6NpcPatrolTable *table);
+int u6_npcpatrol_append(U6NpcPatrolTable *table, const U6NpcState *npc, uint16_t npc_slot);
+int u6_npcpatrol_load(U6NpcPatrolTable *table, const U6EntityState *state);
+/* Rows whose slot no longer holds a live NPC are skipped. */
+int u6_npcpatrol_store(const U6NpcPatrolTable *table, U6EntityState *state);
+
+void u6_npcpatrol_step(U6NpcPatrolTable *table, uint32_t tick);
+void u6_npcpatrol_step_scalar(U6NpcPatrolTable *table, uint32_t tick);
+const char *u6_npcpatrol_kernel_name(void);
+
+#endif
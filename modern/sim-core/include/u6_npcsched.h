@@ -0,0 +1,64 @@
+#ifndef U6M_U6_NPCSCHED_H
+#define U6M_U6_NPCSCHED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "u6_entities.h"
+
+/*
+ * Active-set NPC scheduler keyed by NPC slot. Slots with pending behaviour
+ * sit in a dense run list (position-tracked, so add/remove is O(1)); slots
+ * waiting for a future tick sit in a 256-bucket timer wheel of intrusive
+ * doubly linked lists and move to the run list when advance reaches their
+ * tick. Everything else is idle and costs nothing per tick.
+ */
+#define U6_NPCSCHED_WHEEL_SLOTS 256u
+
+enum {
+  U6_NPCSCHED_OK = 0,
+  U6_NPCSCHED_ERR_NULL = -1,
+  U6_NPCSCHED_ERR_RANGE = -2,
+  U6_NPCSCHED_ERR_ALLOC = -3
+};
+
+enum {
+  U6_NPCSCHED_IDLE = 0,
+  U6_NPCSCHED_RUNNING = 1,
+  U6_NPCSCHED_SLEEPING = 2
+};
+
+typedef struct U6NpcScheduler {
+  uint16_t *run;
+  uint16_t *run_pos;
+  uint32_t *wake_tick;
+  uint16_t *wheel_next; /* slot + 1, 0 = end */
+  uint16_t *wheel_prev;
+  uint8_t *mode;
+  uint16_t wheel_head[U6_NPCSCHED_WHEEL_SLOTS];
+  size_t capacity;
+  size_t run_count;
+  size_t sleeping;
+  uint32_t now;
+} U6NpcScheduler;
+
+int u6_npcsched_init(U6NpcScheduler *sched, size_t capacity, uint32_t now);
+void u6_npcsched_free(U6NpcScheduler *sched);
+
+int u6_npcsched_activate(U6NpcScheduler *sched, uint16_t slot);
+int u6_npcsched_deactivate(U6NpcScheduler *sched, uint16_t slot);
+/* A wake tick at or before now activates immediately. */
+int u6_npcsched_sleep_until(U6NpcScheduler *sched, uint16_t slot, uint32_t wake_tick);
+int u6_npcsched_mode(const U6NpcScheduler *sched, uint16_t slot);
+
+/*
+ * Moves the clock to tick and wakes every sleeper due by then; cost is the
+ * buckets crossed (at most one wheel turn) plus the entries in them.
+ * Returns the run-list length.
+ */
+size_t u6_npcsched_advance(U6NpcScheduler *sched, uint32_t tick);
+
+/* Runs live ACTIVE|PATROL NPCs and idles the rest (after bulk flag edits). */
+int u6_npcsched_sync_patrol(U6NpcScheduler *sched, const U6EntityState *state);
+
+#endif
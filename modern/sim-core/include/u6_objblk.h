@@ -6,6 +6,10 @@
 
 #define U6_OBJBLK_MAX_RECORDS 0x0c00u
 #define U6_OBJBLK_RECORD_SIZE 8u
+#define U6_OBJBLK_OUTDOOR_AREAS 64u
+#define U6_OBJBLK_MAX_LOAD_WORKERS 16u
+#define U6_OBJBLK_KEY_MAX_XY 0x03ffu
+#define U6_OBJBLK_KEY_MAX_Z 0x0fu
 
 typedef struct U6ObjBlkRecord {
   uint8_t status;
@@ -20,6 +24,34 @@ typedef struct U6ObjBlkRecord {
   uint16_t source_index;
 } U6ObjBlkRecord;
 
+/*
+ * Lazy view over packed 8-byte records (file header already skipped). Records
+ * are decoded on access; the backing bytes must outlive the view.
+ */
+typedef struct U6ObjBlkView {
+  const uint8_t *records;
+  size_t count;
+  uint16_t source_area;
+} U6ObjBlkView;
+
+/*
+ * One objblk image inside a decoded lzobjblk stream: 64 back-to-back
+ * `u16 count + count * 8` blocks whose file order is not the area order.
+ */
+typedef struct U6ObjBlkSegment {
+  size_t offset;
+  size_t size;
+  uint16_t count;
+  uint16_t area_id;
+} U6ObjBlkSegment;
+
+typedef struct U6ObjBlkMappedFile {
+  const uint8_t *bytes;
+  size_t size;
+  void *map_base;
+  int loaded;
+} U6ObjBlkMappedFile;
+
 int u6_objblk_is_locxyz(uint8_t status);
 uint16_t u6_objblk_shape_type_get_type(uint16_t shape_type);
 uint16_t u6_objblk_shape_type_get_frame(uint16_t shape_type);
@@ -30,12 +62,91 @@ int u6_objblk_parse_records(const uint8_t *bytes,
                             size_t out_capacity,
                             size_t *out_count);
 
+/*
+ * Single-pass LOCXYZ filter+decode straight from packed bytes (mapped file or
+ * caller buffer). Appends at *io_count with source_area/source_index set; on
+ * -3 (capacity) *io_count reflects the records written so far.
+ */
+int u6_objblk_parse_locxyz(const uint8_t *bytes,
+                           size_t bytes_size,
+                           uint16_t area_id,
+                           U6ObjBlkRecord *out_records,
+                           size_t out_capacity,
+                           size_t *io_count);
+
+int u6_objblk_view_init(U6ObjBlkView *view, const uint8_t *bytes, size_t bytes_size);
+uint8_t u6_objblk_view_status(const U6ObjBlkView *view, size_t index);
+int u6_objblk_view_get(const U6ObjBlkView *view, size_t index, U6ObjBlkRecord *out_record);
+
+/*
+ * Re-encodes records into the packed file image (u16 count + 8-byte records).
+ * Shape is rebuilt from obj_type/obj_frame, so edits to those fields win over
+ * a stale shape_type. -3 capacity, -4 a field does not fit its packed width.
+ */
+size_t u6_objblk_encoded_size(size_t count);
+int u6_objblk_encode_records(const U6ObjBlkRecord *records,
+                             size_t count,
+                             uint8_t *out_bytes,
+                             size_t out_capacity,
+                             size_t *out_size);
+
+/*
+ * Order-sensitive hash of the persisted fields (status, xyz, type, frame,
+ * amount); source_area/source_index and a stale shape_type are ignored.
+ */
+uint64_t u6_objblk_records_hash(const U6ObjBlkRecord *records, size_t count);
+
+/* Encodes into `<path>.tmp`, fsyncs, then renames over path. */
+int u6_objblk_write_file(const char *path, const U6ObjBlkRecord *records, size_t count);
+
+/* Missing files return 0 with loaded == 0, matching the loader contract. */
+int u6_objblk_map_file(const char *path, U6ObjBlkMappedFile *out);
+void u6_objblk_unmap_file(U6ObjBlkMappedFile *mapped);
+
 int u6_objblk_load_outdoor_savegame(const char *savegame_dir,
                                     U6ObjBlkRecord *out_records,
                                     size_t out_capacity,
                                     size_t *out_count,
                                     size_t *out_files_loaded);
 
+/*
+ * Same contract and output order as u6_objblk_load_outdoor_savegame, but the
+ * 64 area files are read/parsed on up to worker_count threads (0 = one per
+ * online CPU, capped at U6_OBJBLK_MAX_LOAD_WORKERS).
+ */
+int u6_objblk_load_outdoor_savegame_parallel(const char *savegame_dir,
+                                             U6ObjBlkRecord *out_records,
+                                             size_t out_capacity,
+                                             size_t *out_count,
+                                             size_t *out_files_loaded,
+                                             unsigned worker_count);
+
+/*
+ * Splits a decoded lzobjblk stream into its 64 segments and assigns each an
+ * outdoor area id like tools/extract_lzobjblk_savegame.ts: segments claim the
+ * area holding most of their LOCXYZ records (largest claims first), the rest
+ * take the unclaimed areas in ascending order. -2 truncated, -3 bad count,
+ * -4 trailing bytes.
+ */
+int u6_objblk_split_lzobjblk(const uint8_t *decoded,
+                             size_t decoded_size,
+                             U6ObjBlkSegment out_segments[U6_OBJBLK_OUTDOOR_AREAS]);
+
+/*
+ * Render order (legacy comparator C_1184_29C4 plus deterministic tie-breaks).
+ * u6_objblk_render_key packs the same order into a 64-bit unsigned key for
+ * records whose x/y/z fit the on-disk coordinate widths.
+ */
+int u6_objblk_compare_render_order(const U6ObjBlkRecord *a, const U6ObjBlkRecord *b);
+int u6_objblk_render_key_fits(const U6ObjBlkRecord *record);
+uint64_t u6_objblk_render_key(const U6ObjBlkRecord *record);
+
+/*
+ * Stable LSD radix sort on render keys; falls back to qsort for small inputs
+ * or out-of-range coordinates. u6_objblk_sort_for_render_qsort is the plain
+ * comparator path, kept for parity checks and benchmarks.
+ */
 void u6_objblk_sort_for_render(U6ObjBlkRecord *records, size_t count);
+void u6_objblk_sort_for_render_qsort(U6ObjBlkRecord *records, size_t count);
 
 #endif
@@ -0,0 +1,110 @@
+#ifndef U6M_U6_OBJBLK_STORE_H
+#define U6M_U6_OBJBLK_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "u6_objblk.h"
+
+/*
+ * Area-keyed object store over savegame objblk files. Area ids 0..63 are the
+ * outdoor 8x8 grid (objblk[a-h][a-h], id = (ay << 3) | ax); 64..68 are the
+ * dungeon levels z=1..5 (objblk[a-e]i, one file per level). Areas load on
+ * first access with every record kept (not just LOCXYZ) and, when a resident
+ * limit is set, the least recently used other area is evicted. Edited areas
+ * are marked dirty, pinned against eviction, and rewritten by save.
+ */
+#define U6_OBJBLK_DUNGEON_LEVELS 5u
+#define U6_OBJBLK_DUNGEON_AREA_BASE U6_OBJBLK_OUTDOOR_AREAS
+#define U6_OBJBLK_STORE_AREAS (U6_OBJBLK_OUTDOOR_AREAS + U6_OBJBLK_DUNGEON_LEVELS)
+#define U6_OBJBLK_STORE_NO_AREA 0xffffu
+#define U6_OBJBLK_STORE_PATH_MAX 512u
+
+enum {
+  U6_OBJBLK_AREA_UNLOADED = 0,
+  U6_OBJBLK_AREA_RESIDENT = 1,
+  U6_OBJBLK_AREA_MISSING = 2
+};
+
+typedef struct U6ObjBlkStoreArea {
+  U6ObjBlkRecord *records;
+  size_t count;
+  uint64_t last_access;
+  uint64_t hash;
+  uint8_t state;
+  uint8_t dirty;
+  uint8_t hash_valid;        /* hash matches the area's file (or clean records) */
+} U6ObjBlkStoreArea;
+
+typedef struct U6ObjBlkStore {
+  char savegame_dir[U6_OBJBLK_STORE_PATH_MAX];
+  U6ObjBlkStoreArea areas[U6_OBJBLK_STORE_AREAS];
+  size_t max_resident;      /* 0 = never evict */
+  size_t resident_areas;
+  size_t resident_records;
+  size_t dirty_areas;
+  uint64_t access_clock;
+  uint32_t loads;
+  uint32_t evictions;
+} U6ObjBlkStore;
+
+int u6_objblk_store_init(U6ObjBlkStore *store, const char *savegame_dir, size_t max_resident_areas);
+void u6_objblk_store_free(U6ObjBlkStore *store);
+
+/* z=0 maps through the outdoor grid, z=1..5 to a dungeon level. */
+uint16_t u6_objblk_store_area_for_position(uint16_t x, uint16_t y, uint8_t z);
+int u6_objblk_store_area_path(const char *savegame_dir, uint16_t area_id, char *out, size_t out_size);
+
+/*
+ * Returns the area's records (source_area/source_index set), loading it on
+ * first access; a missing file is an empty area. The pointer stays valid
+ * until a later store call evicts or reloads that area.
+ */
+int u6_objblk_store_get(U6ObjBlkStore *store,
+                        uint16_t area_id,
+                        const U6ObjBlkRecord **out_records,
+                        size_t *out_count);
+int u6_objblk_store_get_at(U6ObjBlkStore *store,
+                           uint16_t x,
+                           uint16_t y,
+                           uint8_t z,
+                           const U6ObjBlkRecord **out_records,
+                           size_t *out_count);
+
+/*
+ * Edits. get_mutable marks the area dirty for in-place field changes;
+ * replace swaps in a new record list (insert/remove), renumbering
+ * source_index to file order. -4 if count exceeds U6_OBJBLK_MAX_RECORDS.
+ */
+int u6_objblk_store_get_mutable(U6ObjBlkStore *store,
+                                uint16_t area_id,
+                                U6ObjBlkRecord **out_records,
+                                size_t *out_count);
+int u6_objblk_store_replace(U6ObjBlkStore *store,
+                            uint16_t area_id,
+                            const U6ObjBlkRecord *records,
+                            size_t count);
+int u6_objblk_store_is_dirty(const U6ObjBlkStore *store, uint16_t area_id);
+
+/*
+ * Rewrites only dirty areas, each via temp file + rename, clearing the flag
+ * per area as it lands. Stops at the first failing area; areas not yet
+ * written stay dirty.
+ */
+int u6_objblk_store_save(U6ObjBlkStore *store, size_t *out_files_written);
+
+int u6_objblk_store_is_resident(const U6ObjBlkStore *store, uint16_t area_id);
+/*
+ * Sum over every area of its record hash keyed by area id, independent of
+ * which areas are resident: areas never loaded (or evicted) are hashed from
+ * their files once and cached, dirty areas are rehashed on every call, and
+ * empty or missing areas contribute nothing.
+ */
+uint64_t u6_objblk_store_hash(U6ObjBlkStore *store);
+
+/* -3 for a dirty area: save it first. */
+int u6_objblk_store_evict(U6ObjBlkStore *store, uint16_t area_id);
+/* Drops every area, discarding unsaved edits. */
+void u6_objblk_store_evict_all(U6ObjBlkStore *store);
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef U6M_U6_OBJGRID_H
+#define U6M_U6_OBJGRID_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "u6_entities.h"
+#include "u6_objblk.h"
+
+/*
+ * Uniform-grid spatial index over world positions: one bucket per 8x8 chunk
+ * per z level (1024x1024 map, z 0..15). Items whose tile flags mark a double
+ * width (0x80) or double height (0x40) footprint are linked into every bucket
+ * their footprint cells touch. Positions outside the grid go to an overflow
+ * list that every query scans, so results never depend on range assumptions.
+ */
+enum {
+  U6_OBJGRID_CHUNK_SHIFT = 3,
+  U6_OBJGRID_CHUNKS_PER_AXIS = 128,
+  U6_OBJGRID_Z_LEVELS = 16,
+  U6_OBJGRID_BUCKETS = U6_OBJGRID_CHUNKS_PER_AXIS * U6_OBJGRID_CHUNKS_PER_AXIS * U6_OBJGRID_Z_LEVELS,
+  U6_OBJGRID_MAX_LINKS = 4,
+  U6_OBJGRID_ENTITY_AREA = 0xffff
+};
+
+#define U6_OBJGRID_TILE_DOUBLE_WIDTH 0x80u
+#define U6_OBJGRID_TILE_DOUBLE_HEIGHT 0x40u
+
+enum {
+  U6_OBJGRID_OK = 0,
+  U6_OBJGRID_ERR_NULL = -1,
+  U6_OBJGRID_ERR_REF = -2,
+  U6_OBJGRID_ERR_IN_USE = -3,
+  U6_OBJGRID_ERR_NOT_FOUND = -4,
+  U6_OBJGRID_ERR_ALLOC = -5
+};
+
+typedef enum U6ObjGridMatch {
+  U6_OBJGRID_MATCH_ANCHOR = 0,
+  U6_OBJGRID_MATCH_FOOTPRINT = 1
+} U6ObjGridMatch;
+
+typedef struct U6ObjGridItem {
+  uint64_t order_key;
+  int32_t x;
+  int32_t y;
+  int32_t z;
+  uint8_t tile_flags;
+  uint8_t in_use;
+  uint8_t link_count;
+  uint32_t link_bucket[U6_OBJGRID_MAX_LINKS];
+} U6ObjGridItem;
+
+typedef struct U6ObjGridHit {
+  uint64_t order_key;
+  uint32_t ref;
+} U6ObjGridHit;
+
+typedef struct U6ObjGrid {
+  U6ObjGridItem *items;     /* indexed by caller ref */
+  size_t capacity;
+  size_t count;
+  uint32_t *bucket_head;    /* U6_OBJGRID_BUCKETS + 1 (overflow), entry + 1 */
+  uint32_t *entry_next;     /* capacity * U6_OBJGRID_MAX_LINKS, entry + 1 */
+  uint32_t *entry_prev;
+  uint32_t *seen_stamp;     /* per ref, dedupes multi-bucket items */
+  uint32_t stamp;
+  U6ObjGridHit *scratch;
+} U6ObjGrid;
+
+int u6_objgrid_init(U6ObjGrid *grid, size_t capacity);
+void u6_objgrid_free(U6ObjGrid *grid);
+void u6_objgrid_clear(U6ObjGrid *grid);
+
+int u6_objgrid_insert(U6ObjGrid *grid,
+                      uint32_t ref,
+                      int32_t x,
+                      int32_t y,
+                      int32_t z,
+                      uint8_t tile_flags,
+                      uint64_t order_key);
+int u6_objgrid_remove(U6ObjGrid *grid, uint32_t ref);
+int u6_objgrid_move(U6ObjGrid *grid, uint32_t ref, int32_t x, int32_t y, int32_t z, uint64_t order_key);
+
+/*
+ * Bulk helpers. objblk refs are record indexes (tile_flags may be NULL);
+ * entity refs are ref_base + slot with render keys built from a synthetic
+ * record in area U6_OBJGRID_ENTITY_AREA. Only LOCXYZ objects are indexed.
+ */
+int u6_objgrid_insert_objblk(U6ObjGrid *grid,
+                             const U6ObjBlkRecord *records,
+                             const uint8_t *tile_flags,
+                             size_t count);
+int u6_objgrid_insert_entity_objects(U6ObjGrid *grid, const U6EntityState *state, uint32_t ref_base);
+int u6_objgrid_insert_entity_npcs(U6ObjGrid *grid, const U6EntityState *state, uint32_t ref_base);
+
+/*
+ * Queries write refs in render order (order_key, then ref) and return the
+ * total number of matches; at most out_capacity refs are written. Rects are
+ * inclusive. The radius form is the Chebyshev box used by the net query.
+ */
+size_t u6_objgrid_query_rect(U6ObjGrid *grid,
+                             int32_t x0,
+                             int32_t y0,
+                             int32_t x1,
+                             int32_t y1,
+                             int has_z,
+                             int32_t z,
+                             U6ObjGridMatch match,
+                             uint32_t *out_refs,
+                             size_t out_capacity);
+size_t u6_objgrid_query_radius(U6ObjGrid *grid,
+                               int32_t cx,
+                               int32_t cy,
+                               int32_t radius,
+                               int has_z,
+                               int32_t z,
+                               U6ObjGridMatch match,
+                               uint32_t *out_refs,
+                               size_t out_capacity);
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef U6M_U6_OBJORDER_H
+#define U6M_U6_OBJORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "u6_objblk.h"
+
+/*
+ * Ordered object index keyed by u6_objblk_render_key. Backed by a skip list
+ * over a fixed node pool so insert/remove/move are O(log n) without
+ * re-sorting the whole object set after each interaction.
+ */
+enum {
+  U6_OBJORDER_MAX_LEVEL = 12,
+  U6_OBJORDER_NIL = 0
+};
+
+enum {
+  U6_OBJORDER_OK = 0,
+  U6_OBJORDER_ERR_NULL = -1,
+  U6_OBJORDER_ERR_KEY_RANGE = -2,
+  U6_OBJORDER_ERR_FULL = -3,
+  U6_OBJORDER_ERR_DUPLICATE = -4,
+  U6_OBJORDER_ERR_NOT_FOUND = -5,
+  U6_OBJORDER_ERR_ALLOC = -6
+};
+
+typedef struct U6ObjOrderNode {
+  uint64_t key;
+  U6ObjBlkRecord record;
+  uint32_t next[U6_OBJORDER_MAX_LEVEL];
+  uint8_t level;
+} U6ObjOrderNode;
+
+typedef struct U6ObjOrderIndex {
+  U6ObjOrderNode *nodes; /* nodes[0] is the head sentinel */
+  size_t capacity;
+  size_t count;
+  uint32_t free_head;
+  uint32_t rng_state;
+  uint8_t level;
+} U6ObjOrderIndex;
+
+typedef struct U6ObjOrderCursor {
+  const U6ObjOrderIndex *index;
+  uint32_t node;
+} U6ObjOrderCursor;
+
+/* Render-ordered walk over records with y_min <= y <= y_max. */
+typedef struct U6ObjOrderRange {
+  const U6ObjOrderIndex *index;
+  uint32_t node;
+  uint16_t y_min;
+  uint16_t y_max;
+  uint8_t phase;
+} U6ObjOrderRange;
+
+int u6_objorder_init(U6ObjOrderIndex *index, size_t capacity);
+void u6_objorder_free(U6ObjOrderIndex *index);
+void u6_objorder_clear(U6ObjOrderIndex *index);
+
+int u6_objorder_insert(U6ObjOrderIndex *index, const U6ObjBlkRecord *record);
+int u6_objorder_remove(U6ObjOrderIndex *index, const U6ObjBlkRecord *record);
+int u6_objorder_move(U6ObjOrderIndex *index, const U6ObjBlkRecord *from, const U6ObjBlkRecord *to);
+int u6_objorder_build(U6ObjOrderIndex *index, const U6ObjBlkRecord *records, size_t count);
+
+const U6ObjBlkRecord *u6_objorder_first(const U6ObjOrderIndex *index, U6ObjOrderCursor *cursor);
+const U6ObjBlkRecord *u6_objorder_next(U6ObjOrderCursor *cursor);
+
+void u6_objorder_range_begin(const U6ObjOrderIndex *index,
+                             U6ObjOrderRange *range,
+                             uint16_t y_min,
+                             uint16_t y_max);
+const U6ObjBlkRecord *u6_objorder_range_next(U6ObjOrderRange *range);
+
+#endif
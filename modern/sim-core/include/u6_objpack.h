@@ -0,0 +1,56 @@
+#ifndef U6M_U6_OBJPACK_H
+#define U6M_U6_OBJPACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "u6_bridge_proto.h"
+
+/*
+ * Packed world object table shared by the net server and the sim-core
+ * bridges (replaces one `key:x:y:...` argv string per object). All integers
+ * little-endian:
+ *
+ *   header  char magic[4] "U6OT", u16 version, u16 record_size,
+ *           u32 count, u32 key_bytes
+ *   records count x U6_OBJPACK_RECORD_SIZE:
+ *           u32 key_offset, u8 key_len, u8 status, u8 tile_flag,
+ *           u8 holder_kind, i32 x, i32 y, i32 z, i32 holder_key,
+ *           i32 source_area, i32 source_index
+ *   keys    key_bytes of NUL-terminated strings; equal keys are stored once
+ *           and records point at them by offset.
+ *
+ * A view validates the whole buffer once (bounds, terminators, key length)
+ * and then reads records in place, so a mapped file or a buffer read from
+ * stdin is used without copying or parsing text.
+ */
+#define U6_OBJPACK_VERSION 1u
+#define U6_OBJPACK_HEADER_SIZE 16u
+#define U6_OBJPACK_RECORD_SIZE 32u
+
+enum {
+  U6_OBJPACK_OK = 0,
+  U6_OBJPACK_ERR_NULL = -1,
+  U6_OBJPACK_ERR_HEADER = -2,
+  U6_OBJPACK_ERR_BOUNDS = -3,
+  U6_OBJPACK_ERR_KEY = -4,
+  U6_OBJPACK_ERR_ALLOC = -5
+};
+
+typedef struct U6ObjPackView {
+  const uint8_t *records;
+  const char *keys;
+  size_t count;
+  size_t key_bytes;
+} U6ObjPackView;
+
+int u6_objpack_view(U6ObjPackView *view, const uint8_t *data, size_t size);
+/* Key of record index, NUL-terminated, pointing into the buffer. */
+const char *u6_objpack_key(const U6ObjPackView *view, size_t index);
+/* Decodes record index (key copied); index must be < view->count. */
+void u6_objpack_get(const U6ObjPackView *view, size_t index, U6BridgeObject *out);
+
+/* Replaces out with the packed table for objects (keys interned). */
+int u6_objpack_encode(const U6BridgeObject *objects, size_t count, U6BridgeBuffer *out);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef U6M_U6_OBJSELECT_H
+#define U6M_U6_OBJSELECT_H
+
+#include <stddef.h>
+
+#include "u6_bridge_proto.h"
+
+/*
+ * Top-K selection for world object queries: objects that pass the query
+ * filter are pushed into a bounded max-heap (root = the worst kept object
+ * under u6_bridge_object_cmp), so only the first `limit` matches in render
+ * order are ever kept and sorted. The result is exactly the prefix that
+ * sort-everything-then-filter produces.
+ */
+enum {
+  U6_OBJSELECT_OK = 0,
+  U6_OBJSELECT_ERR_NULL = -1,
+  U6_OBJSELECT_ERR_ALLOC = -2
+};
+
+typedef struct U6ObjSelect {
+  U6BridgeObject *items; /* heap order until finish, render order after */
+  size_t count;
+  size_t capacity;
+  size_t limit;
+} U6ObjSelect;
+
+/* limit 0 is treated as 1, matching the query bridge. */
+void u6_objselect_init(U6ObjSelect *s, size_t limit);
+void u6_objselect_free(U6ObjSelect *s);
+/* Empties the selection, keeping its storage and limit. */
+void u6_objselect_reset(U6ObjSelect *s);
+
+/* Offers one (already matching) object; storage grows up to the limit. */
+int u6_objselect_push(U6ObjSelect *s, const U6BridgeObject *object);
+/* Sorts the kept objects into render order in place (once; reset before
+ * pushing again); returns the count. */
+size_t u6_objselect_finish(U6ObjSelect *s);
+/* finish, then hands items (malloc'd, may be NULL when empty) to the caller. */
+U6BridgeObject *u6_objselect_take(U6ObjSelect *s, size_t *out_count);
+
+/* Filter-then-select over an object array; s->items holds the result. */
+int u6_objselect_query(U6ObjSelect *s, const U6BridgeObject *objects, size_t count, const U6BridgeQuery *q);
+
+#endif
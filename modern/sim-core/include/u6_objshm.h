@@ -0,0 +1,106 @@
+#ifndef U6M_U6_OBJSHM_H
+#define U6M_U6_OBJSHM_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "u6_bridge_proto.h"
+
+/*
+ * Shared-memory columnar world object table. One writer (the net server,
+ * or a C producer) keeps a file - typically under /dev/shm - current with
+ * row deltas; any number of reader processes map it read-only and query
+ * the live table in place.
+ *
+ * Layout (host byte order, which must be little-endian; version doubles
+ * as the byte-order check):
+ *   header  64 bytes: char magic[4] "U6SH", u32 version, u32 seq,
+ *           u32 capacity, u32 count, u32 generation, u32 retired, reserved
+ *   columns each starting on a 64-byte boundary, capacity entries each:
+ *           i32 x, y, z, holder_key, source_area, source_index;
+ *           u8 status, tile_flag, holder_kind; char key[40] (NUL-padded)
+ * Rows 0..count-1 are live (the writer keeps them dense).
+ *
+ * seq is a seqlock: the writer makes it odd, writes rows and count, then
+ * makes it even and bumps generation. A reader that sees the same even seq
+ * before and after its reads has a consistent table; otherwise it retries.
+ * A writer that needs more capacity builds a new file, renames it over the
+ * path and sets retired in the old one; readers then reopen the path.
+ */
+#define U6_OBJSHM_VERSION 1u
+#define U6_OBJSHM_HEADER_SIZE 64u
+#define U6_OBJSHM_KEY_SIZE 40u
+
+enum {
+  U6_OBJSHM_OK = 0,
+  U6_OBJSHM_ERR_NULL = -1,
+  U6_OBJSHM_ERR_IO = -2,
+  U6_OBJSHM_ERR_FORMAT = -3,
+  U6_OBJSHM_ERR_BUSY = -4,
+  U6_OBJSHM_ERR_RETIRED = -5,
+  U6_OBJSHM_ERR_ALLOC = -6
+};
+
+typedef struct U6ObjShmHeader {
+  char magic[4];
+  uint32_t version;
+  atomic_uint seq;
+  uint32_t capacity;
+  atomic_uint count;
+  atomic_uint generation;
+  atomic_uint retired;
+  uint32_t reserved[9];
+} U6ObjShmHeader;
+
+typedef struct U6ObjShm {
+  U6ObjShmHeader *header;
+  int32_t *x;
+  int32_t *y;
+  int32_t *z;
+  int32_t *holder_key;
+  int32_t *source_area;
+  int32_t *source_index;
+  uint8_t *status;
+  uint8_t *tile_flag;
+  uint8_t *holder_kind;
+  char (*keys)[U6_OBJSHM_KEY_SIZE];
+  uint32_t capacity;
+  void *map_base;
+  size_t map_size;
+} U6ObjShm;
+
+/* Segment bytes for capacity rows (header plus aligned columns). */
+size_t u6_objshm_size(uint32_t capacity);
+
+/* Creates (or truncates) path as an empty table and maps it read-write. */
+int u6_objshm_create(U6ObjShm *shm, const char *path, uint32_t capacity);
+/* Maps an existing table read-only. */
+int u6_objshm_open(U6ObjShm *shm, const char *path);
+void u6_objshm_close(U6ObjShm *shm);
+
+/* Writer side: rows written between begin and end publish together. */
+void u6_objshm_write_begin(U6ObjShm *shm);
+void u6_objshm_write_row(U6ObjShm *shm, uint32_t row, const U6BridgeObject *object);
+void u6_objshm_write_end(U6ObjShm *shm, uint32_t count);
+/* Marks a replaced segment so its readers reopen the path. */
+void u6_objshm_retire(U6ObjShm *shm);
+
+/*
+ * Reader side. read_begin waits out an in-progress write (bounded spin,
+ * U6_OBJSHM_ERR_BUSY past it) and returns the row count, clamped to the
+ * capacity; read_valid says whether nothing was published since.
+ */
+int u6_objshm_read_begin(const U6ObjShm *shm, uint32_t *out_seq);
+int u6_objshm_read_valid(const U6ObjShm *shm, uint32_t seq);
+/* Decodes row (key always NUL-terminated, even from a torn read). */
+void u6_objshm_row(const U6ObjShm *shm, uint32_t row, U6BridgeObject *out);
+
+/*
+ * Consistent world object query against the live table: filters rows in
+ * place, copies out only the matches, and orders/limits them exactly like
+ * the query bridge. *out (malloc'd, caller frees) holds *out_count objects.
+ */
+int u6_objshm_query(const U6ObjShm *shm, const U6BridgeQuery *q, U6BridgeObject **out, size_t *out_count);
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef U6M_U6_OBJTABLE_H
+#define U6M_U6_OBJTABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "u6_objblk.h"
+
+/*
+ * Columnar (struct-of-arrays) object table. Columns are 32-byte aligned and
+ * zero-padded to a multiple of 64 rows, so predicate kernels work a 64-row
+ * block at a time and emit one 64-bit selection word per block.
+ *
+ * Selections are caller-owned bitmaps of u6_objtable_selection_words(count)
+ * words, bit (i & 63) of word (i >> 6) = row i. Filters AND their predicate
+ * into the selection, so chained calls intersect. Kernels use AVX2 when the
+ * build enables it (SIM_CORE_ENABLE_AVX2), SSE2 on other x86-64 builds, and
+ * scalar code elsewhere; the *_scalar entry points are the reference path.
+ */
+#define U6_OBJTABLE_BLOCK_ROWS 64u
+
+enum {
+  U6_OBJTABLE_OK = 0,
+  U6_OBJTABLE_ERR_NULL = -1,
+  U6_OBJTABLE_ERR_FULL = -2,
+  U6_OBJTABLE_ERR_ALLOC = -3,
+  U6_OBJTABLE_ERR_RANGE = -4
+};
+
+typedef struct U6ObjTable {
+  uint16_t *x;
+  uint16_t *y;
+  uint8_t *z;
+  uint8_t *status;
+  uint16_t *obj_type;
+  uint8_t *obj_frame;
+  uint16_t *amount;
+  uint16_t *source_area;
+  uint16_t *source_index;
+  size_t count;
+  size_t capacity;
+} U6ObjTable;
+
+int u6_objtable_init(U6ObjTable *table, size_t capacity);
+void u6_objtable_free(U6ObjTable *table);
+void u6_objtable_clear(U6ObjTable *table);
+int u6_objtable_append(U6ObjTable *table, const U6ObjBlkRecord *records, size_t count);
+int u6_objtable_get(const U6ObjTable *table, size_t row, U6ObjBlkRecord *out_record);
+
+size_t u6_objtable_selection_words(size_t count);
+/* Selects rows 0..count-1 (tail bits stay clear). */
+void u6_objtable_select_all(const U6ObjTable *table, uint64_t *sel);
+size_t u6_objtable_selection_count(const U6ObjTable *table, const uint64_t *sel);
+/* Writes selected row indexes in ascending order; returns the total selected. */
+size_t u6_objtable_selection_rows(const U6ObjTable *table,
+                                  const uint64_t *sel,
+                                  uint32_t *out_rows,
+                                  size_t out_capacity);
+
+const char *u6_objtable_kernel_name(void);
+
+/* Inclusive rect; x0 > x1 or y0 > y1 selects nothing. */
+void u6_objtable_filter_rect(const U6ObjTable *table, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint64_t *sel);
+void u6_objtable_filter_z(const U6ObjTable *table, uint8_t z, uint64_t *sel);
+/* coord_use is one of the U6_OBJ_COORD_USE_* values (status & 0x18). */
+void u6_objtable_filter_coord_use(const U6ObjTable *table, uint8_t coord_use, uint64_t *sel);
+void u6_objtable_filter_types(const U6ObjTable *table, const uint16_t *types, size_t type_count, uint64_t *sel);
+
+void u6_objtable_filter_rect_scalar(const U6ObjTable *table,
+                                    uint16_t x0,
+                                    uint16_t y0,
+                                    uint16_t x1,
+                                    uint16_t y1,
+                                    uint64_t *sel);
+void u6_objtable_filter_z_scalar(const U6ObjTable *table, uint8_t z, uint64_t *sel);
+void u6_objtable_filter_coord_use_scalar(const U6ObjTable *table, uint8_t coord_use, uint64_t *sel);
+void u6_objtable_filter_types_scalar(const U6ObjTable *table,
+                                     const uint16_t *types,
+                                     size_t type_count,
+                                     uint64_t *sel);
+
+#endif
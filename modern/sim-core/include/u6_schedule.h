@@ -0,0 +1,111 @@
+#ifndef U6M_U6_SCHEDULE_H
+#define U6M_U6_SCHEDULE_H
+
+#include "sim_core.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "u6_entities.h"
+
+/*
+ * Legacy gamedata schedule file: 256 u16 LE first-entry indexes (one per
+ * actor), a u16 LE entry total, then 5-byte entries. Actor i owns entries
+ * [offset[i], offset[i + 1]) (the last actor runs to the total). Entry bytes:
+ * b0 = hour (low 5 bits) | day_of_week << 5 (0 = every day), b1 = worktype,
+ * b2..b4 = x/y/z packed as in objblk records.
+ */
+#define U6_SCHEDULE_ACTORS 256u
+#define U6_SCHEDULE_ENTRY_SIZE 5u
+#define U6_SCHEDULE_HEADER_SIZE (U6_SCHEDULE_ACTORS * 2u + 2u)
+#define U6_SCHEDULE_DAYS_PER_WEEK 7u
+#define U6_SCHEDULE_WEEK_HOURS (U6_SCHEDULE_DAYS_PER_WEEK * 24u)
+#define U6_SCHEDULE_NO_ENTRY 0xffffu
+
+enum {
+  U6_SCHEDULE_OK = 0,
+  U6_SCHEDULE_ERR_NULL = -1,
+  U6_SCHEDULE_ERR_SIZE = -2,
+  U6_SCHEDULE_ERR_FORMAT = -3,
+  U6_SCHEDULE_ERR_ALLOC = -4,
+  U6_SCHEDULE_ERR_RANGE = -5,
+  U6_SCHEDULE_ERR_IO = -6
+};
+
+typedef struct U6ScheduleEntry {
+  uint16_t x;
+  uint16_t y;
+  uint8_t z;
+  uint8_t hour;
+  uint8_t day_of_week;
+  uint8_t worktype;
+} U6ScheduleEntry;
+
+typedef struct U6ScheduleTable {
+  U6ScheduleEntry *entries;
+  size_t entry_count;
+  uint16_t first[U6_SCHEDULE_ACTORS];
+  uint16_t count[U6_SCHEDULE_ACTORS];
+} U6ScheduleTable;
+
+int u6_schedule_parse(const uint8_t *bytes, size_t size, U6ScheduleTable *out_table);
+int u6_schedule_load_file(const char *path, U6ScheduleTable *out_table);
+void u6_schedule_free(U6ScheduleTable *table);
+
+/* 1..7, weeks aligned to the 28-day month. */
+uint8_t u6_schedule_day_of_week(const SimWorldState *world);
+/* Hours since the calendar epoch; differences give hours crossed. */
+uint32_t u6_schedule_world_hours(const SimWorldState *world);
+
+/*
+ * Legacy selection: scanning the actor's entries in order, the first one
+ * that starts later (day_of_week > day or hour > hour) ends the search and
+ * the entry before it is active; if the very first entry starts later the
+ * last entry (yesterday's final one) still holds. Returns the table-wide
+ * entry index or U6_SCHEDULE_NO_ENTRY for an actor without entries.
+ */
+uint16_t u6_schedule_active_entry(const U6ScheduleTable *table, uint8_t actor, uint8_t day_of_week, uint8_t hour);
+
+/*
+ * Schedule engine. Each actor's active entry is evaluated once per week hour
+ * at init, and every change becomes an event in a 168-bucket queue indexed
+ * by week hour, so a sync only visits the buckets the clock crossed. Syncing
+ * within the same hour is O(1); fast-forwarding keeps the last event per
+ * actor and moves each NPC once to its final entry. A week or more (or a
+ * clock that went backwards) resolves every bound actor directly.
+ */
+typedef struct U6ScheduleEvent {
+  uint16_t entry;
+  uint8_t actor;
+  uint8_t reserved;
+} U6ScheduleEvent;
+
+typedef struct U6ScheduleEngine {
+  const U6ScheduleTable *table;
+  U6ScheduleEvent *events;
+  size_t event_count;
+  uint32_t bucket_start[U6_SCHEDULE_WEEK_HOURS + 1u];
+  uint16_t npc_id[U6_SCHEDULE_ACTORS]; /* 0 = unbound */
+  uint16_t current[U6_SCHEDULE_ACTORS];  /* entry the NPC was last placed at */
+  uint16_t unplaced[U6_SCHEDULE_ACTORS]; /* entry whose move failed, retried each sync */
+  uint32_t unplaced_count;
+  uint32_t hour_clock;
+  uint32_t moves;
+  uint8_t synced;
+} U6ScheduleEngine;
+
+/* The table must outlive the engine. */
+int u6_schedule_engine_init(U6ScheduleEngine *engine, const U6ScheduleTable *table);
+void u6_schedule_engine_free(U6ScheduleEngine *engine);
+/* npc_id 0 unbinds. Binding forces a full resolve on the next sync. */
+int u6_schedule_engine_bind(U6ScheduleEngine *engine, uint8_t actor, uint16_t npc_id);
+/* Binds actor n to npc_id n for every scheduled actor present in state. */
+size_t u6_schedule_engine_bind_matching(U6ScheduleEngine *engine, const U6EntityState *state);
+/*
+ * Applies the transitions crossed since the last sync and retries moves that
+ * failed earlier (e.g. the NPC was not loaded yet), even within the same
+ * hour; returns NPCs moved or < 0.
+ */
+int u6_schedule_engine_sync(U6ScheduleEngine *engine, U6EntityState *state, const SimWorldState *world);
+
+#endif
@@ -0,0 +1,194 @@
+#define NAPI_VERSION 6
+#include <node_api.h>
+
+#include "u6_bridge_proto.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * In-process sim-core for the net server: the bridge protocol of
+ * u6_bridge_proto.h without the daemon pipe. A world is an external handle
+ * owning a U6BridgeWorld; inputs are Uint8Array views of the protocol
+ * payloads (packed object records, query/assoc/interact params), read in
+ * place.
+ *
+ *   createWorld()                 -> world
+ *   handle(world, body)           -> Uint8Array response frame (body = op + payload)
+ *   load|upsert|remove|query|assoc|interact(world, payload) -> Uint8Array payload
+ *   snapshot(world)               -> Uint8Array LOAD payload
+ *
+ * The per-op functions throw on a negative status (err.code = status).
+ */
+
+typedef struct AddonWorld {
+  U6BridgeWorld world;
+  U6BridgeBuffer out;
+} AddonWorld;
+
+static void finalize_world(napi_env env, void *data, void *hint) {
+  AddonWorld *w = (AddonWorld *)data;
+  (void)env;
+  (void)hint;
+  u6_bridge_world_free(&w->world);
+  u6_bridge_buffer_free(&w->out);
+  free(w);
+}
+
+static napi_value throw_error(napi_env env, const char *code, const char *message) {
+  napi_throw_error(env, code, message);
+  return NULL;
+}
+
+static napi_value create_world(napi_env env, napi_callback_info info) {
+  AddonWorld *w = (AddonWorld *)calloc(1, sizeof(AddonWorld));
+  napi_value handle;
+  (void)info;
+
+  if (w == NULL) {
+    return throw_error(env, NULL, "sim-core world allocation failed");
+  }
+  u6_bridge_world_init(&w->world);
+  if (napi_create_external(env, w, finalize_world, NULL, &handle) != napi_ok) {
+    finalize_world(env, w, NULL);
+    return throw_error(env, NULL, "sim-core world handle creation failed");
+  }
+  return handle;
+}
+
+static AddonWorld *world_arg(napi_env env, napi_value value) {
+  void *data = NULL;
+  napi_valuetype type;
+
+  if (napi_typeof(env, value, &type) != napi_ok || type != napi_external ||
+      napi_get_value_external(env, value, &data) != napi_ok || data == NULL) {
+    throw_error(env, NULL, "expected a sim-core world handle");
+    return NULL;
+  }
+  return (AddonWorld *)data;
+}
+
+/* Any TypedArray is accepted; its bytes are read in place. */
+static int bytes_arg(napi_env env, napi_value value, const uint8_t **data, size_t *len) {
+  napi_typedarray_type type;
+  size_t length;
+  void *ptr;
+  size_t offset;
+  napi_value buffer;
+  bool is_typedarray = false;
+  static const size_t element_size[] = {1, 1, 1, 2, 2, 4, 4, 4, 8, 8, 8};
+
+  if (napi_is_typedarray(env, value, &is_typedarray) != napi_ok || !is_typedarray ||
+      napi_get_typedarray_info(env, value, &type, &length, &ptr, &buffer, &offset) != napi_ok ||
+      (size_t)type >= sizeof(element_size) / sizeof(element_size[0])) {
+    throw_error(env, NULL, "expected a TypedArray payload");
+    return 0;
+  }
+  *data = (const uint8_t *)ptr;
+  *len = length * element_size[type];
+  return 1;
+}
+
+static napi_value copy_out(napi_env env, const uint8_t *data, size_t len) {
+  napi_value arraybuffer;
+  napi_value result;
+  void *dst = NULL;
+
+  if (napi_create_arraybuffer(env, len, &dst, &arraybuffer) != napi_ok ||
+      napi_create_typedarray(env, napi_uint8_array, len, arraybuffer, 0, &result) != napi_ok) {
+    return throw_error(env, NULL, "sim-core result allocation failed");
+  }
+  if (len > 0u) {
+    memcpy(dst, data, len);
+  }
+  return result;
+}
+
+static napi_value handle(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2];
+  AddonWorld *w;
+  const uint8_t *body = NULL;
+  size_t body_len = 0;
+
+  if (napi_get_cb_info(env, info, &argc, argv, NULL, NULL) != napi_ok || argc < 2) {
+    return throw_error(env, NULL, "handle(world, body) takes two arguments");
+  }
+  if ((w = world_arg(env, argv[0])) == NULL || !bytes_arg(env, argv[1], &body, &body_len)) {
+    return NULL;
+  }
+  if (u6_bridge_handle(&w->world, body, body_len, &w->out) != U6_BRIDGE_OK) {
+    return throw_error(env, NULL, "sim-core bridge out of memory");
+  }
+  return copy_out(env, w->out.data, w->out.size);
+}
+
+/* Shared body of the per-op exports; the op code is the function's data. */
+static napi_value handle_bound_op(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2];
+  void *data = NULL;
+  AddonWorld *w;
+  const uint8_t *payload = NULL;
+  size_t payload_len = 0;
+  int32_t status;
+
+  if (napi_get_cb_info(env, info, &argc, argv, NULL, &data) != napi_ok || argc < 1) {
+    return throw_error(env, NULL, "expected (world[, payload])");
+  }
+  if ((w = world_arg(env, argv[0])) == NULL) {
+    return NULL;
+  }
+  if (argc >= 2 && !bytes_arg(env, argv[1], &payload, &payload_len)) {
+    return NULL;
+  }
+  if (u6_bridge_handle_op(&w->world, (uint8_t)(uintptr_t)data, payload, payload_len, &w->out) != U6_BRIDGE_OK) {
+    return throw_error(env, NULL, "sim-core bridge out of memory");
+  }
+  status = (int32_t)((uint32_t)w->out.data[5] | ((uint32_t)w->out.data[6] << 8) |
+                     ((uint32_t)w->out.data[7] << 16) | ((uint32_t)w->out.data[8] << 24));
+  if (status < 0) {
+    char code[16];
+    snprintf(code, sizeof(code), "%d", (int)status);
+    return throw_error(env, code, "sim-core bridge rejected the request");
+  }
+  return copy_out(env, w->out.data + 9u, w->out.size - 9u);
+}
+
+static napi_value init(napi_env env, napi_value exports) {
+  static const struct {
+    const char *name;
+    uint8_t op;
+  } ops[] = {
+    {"load", U6_BRIDGE_OP_LOAD},
+    {"upsert", U6_BRIDGE_OP_UPSERT},
+    {"remove", U6_BRIDGE_OP_REMOVE},
+    {"query", U6_BRIDGE_OP_QUERY},
+    {"assoc", U6_BRIDGE_OP_ASSOC},
+    {"interact", U6_BRIDGE_OP_INTERACT},
+    {"snapshot", U6_BRIDGE_OP_SNAPSHOT}
+  };
+  napi_property_descriptor props[2 + sizeof(ops) / sizeof(ops[0])];
+  size_t n = 0;
+
+  memset(props, 0, sizeof(props));
+  props[n].utf8name = "createWorld";
+  props[n].method = create_world;
+  props[n++].attributes = napi_enumerable;
+  props[n].utf8name = "handle";
+  props[n].method = handle;
+  props[n++].attributes = napi_enumerable;
+  for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+    props[n].utf8name = ops[i].name;
+    props[n].method = handle_bound_op;
+    props[n].data = (void *)(uintptr_t)ops[i].op;
+    props[n++].attributes = napi_enumerable;
+  }
+  if (napi_define_properties(env, exports, n, props) != napi_ok) {
+    return NULL;
+  }
+  return exports;
+}
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, init)
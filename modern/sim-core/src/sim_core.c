@@ -375,6 +375,14 @@ uint64_t sim_state_hash(const SimState *state) {
   return h;
 }
 
+uint64_t sim_world_hash(const SimState *state, uint64_t companion_hash) {
+  uint64_t h = sim_state_hash(state);
+
+  h = hash_mix_u32(h, (uint32_t)companion_hash);
+  h = hash_mix_u32(h, (uint32_t)(companion_hash >> 32));
+  return h;
+}
+
 size_t sim_command_wire_size(void) {
   return U6M_COMMAND_WIRE_SIZE;
 }
@@ -450,12 +458,14 @@ int sim_command_stream_deserialize(SimCommand *out,
   return 0;
 }
 
-int sim_write_replay_checkpoints(const SimState *initial_state,
-                                 const SimCommand *commands,
-                                 size_t command_count,
-                                 uint32_t total_ticks,
-                                 uint32_t checkpoint_interval,
-                                 const char *path) {
+static int write_checkpoints(const SimState *initial_state,
+                             const SimCommand *commands,
+                             size_t command_count,
+                             uint32_t total_ticks,
+                             uint32_t checkpoint_interval,
+                             SimCompanionHashFn companion_hash,
+                             void *user,
+                             const char *path) {
   SimState s;
   FILE *fp;
   uint32_t advanced = 0;
@@ -470,7 +480,7 @@ int sim_write_replay_checkpoints(const SimState *initial_state,
     return -2;
   }
 
-  fprintf(fp, "tick,hash\n");
+  fprintf(fp, companion_hash != NULL ? "tick,hash,world_hash\n" : "tick,hash\n");
   while (advanced < total_ticks) {
     SimStepResult res;
     uint32_t step = checkpoint_interval;
@@ -482,9 +492,47 @@ int sim_write_replay_checkpoints(const SimState *initial_state,
       return -3;
     }
     advanced += step;
-    fprintf(fp, "%u,%016llx\n", s.tick, (unsigned long long)res.state_hash);
+    if (companion_hash != NULL) {
+      fprintf(fp,
+              "%u,%016llx,%016llx\n",
+              s.tick,
+              (unsigned long long)res.state_hash,
+              (unsigned long long)sim_world_hash(&s, companion_hash(&s, user)));
+    } else {
+      fprintf(fp, "%u,%016llx\n", s.tick, (unsigned long long)res.state_hash);
+    }
   }
 
   fclose(fp);
   return 0;
 }
+
+int sim_write_replay_checkpoints(const SimState *initial_state,
+                                 const SimCommand *commands,
+                                 size_t command_count,
+                                 uint32_t total_ticks,
+                                 uint32_t checkpoint_interval,
+                                 const char *path) {
+  return write_checkpoints(initial_state, commands, command_count, total_ticks, checkpoint_interval, NULL, NULL, path);
+}
+
+int sim_write_replay_checkpoints_world(const SimState *initial_state,
+                                       const SimCommand *commands,
+                                       size_t command_count,
+                                       uint32_t total_ticks,
+                                       uint32_t checkpoint_interval,
+                                       SimCompanionHashFn companion_hash,
+                                       void *user,
+                                       const char *path) {
+  if (companion_hash == NULL) {
+    return -1;
+  }
+  return write_checkpoints(initial_state,
+                           commands,
+                           command_count,
+                           total_ticks,
+                           checkpoint_interval,
+                           companion_hash,
+                           user,
+                           path);
+}
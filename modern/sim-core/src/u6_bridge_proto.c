@@ -0,0 +1,717 @@
+#include "u6_bridge_proto.h"
+#include "u6_objstatus.h"
+#include "u6_world_interact_bridge.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int is_status_0010(int status) {
+  return (status & 0x10) != 0;
+}
+
+int u6_bridge_object_cmp(const U6BridgeObject *a, const U6BridgeObject *b) {
+  const int a_use = u6_obj_status_coord_use(a->status);
+  const int b_use = u6_obj_status_coord_use(b->status);
+  if (a_use != 0 && b_use == 0) return -1;
+  if (b_use != 0 && a_use == 0) return 1;
+  if (a->y != b->y) return a->y - b->y;
+  if (a->x != b->x) return a->x - b->x;
+  if (a->z != b->z) return b->z - a->z;
+  if (is_status_0010(a->status) != is_status_0010(b->status)) {
+    return is_status_0010(a->status) ? -1 : 1;
+  }
+  if (a->source_area != b->source_area) return a->source_area - b->source_area;
+  if (a->source_index != b->source_index) return a->source_index - b->source_index;
+  return strcmp(a->key, b->key);
+}
+
+static int in_box(int x, int y, const U6BridgeQuery *q) {
+  return abs(x - q->x) <= q->radius && abs(y - q->y) <= q->radius;
+}
+
+static int footprint_hits(const U6BridgeObject *o, const U6BridgeQuery *q) {
+  if (in_box(o->x, o->y, q)) {
+    return 1;
+  }
+  if ((o->tile_flag & 0x80) && in_box(o->x - 1, o->y, q)) {
+    return 1;
+  }
+  if ((o->tile_flag & 0x40) && in_box(o->x, o->y - 1, q)) {
+    return 1;
+  }
+  if ((o->tile_flag & 0xc0) == 0xc0 && in_box(o->x - 1, o->y - 1, q)) {
+    return 1;
+  }
+  return 0;
+}
+
+int u6_bridge_object_matches(const U6BridgeObject *o, const U6BridgeQuery *q) {
+  if (q->has_z && o->z != q->z) return 0;
+  if (q->has_x && q->has_y) {
+    if (q->projection_footprint) {
+      return footprint_hits(o, q);
+    }
+    return in_box(o->x, o->y, q);
+  }
+  return 1;
+}
+
+/* ---- resident table ---- */
+
+static uint32_t key_hash(const char *key) {
+  uint32_t h = 2166136261u;
+  for (; *key != '\0'; key++) {
+    h = (h ^ (uint8_t)*key) * 16777619u;
+  }
+  return h;
+}
+
+static void invalidate(U6BridgeWorld *world) {
+  world->order_valid = 0u;
+  world->nodes_valid = 0u;
+  world->generation++;
+}
+
+void u6_bridge_world_init(U6BridgeWorld *world) {
+  if (world != NULL) {
+    memset(world, 0, sizeof(*world));
+  }
+}
+
+void u6_bridge_world_free(U6BridgeWorld *world) {
+  if (world == NULL) {
+    return;
+  }
+  free(world->objects);
+  free(world->next);
+  free(world->buckets);
+  free((void *)world->order);
+  free(world->nodes);
+  memset(world, 0, sizeof(*world));
+}
+
+static void link_object(U6BridgeWorld *world, size_t index) {
+  size_t b = key_hash(world->objects[index].key) & (world->bucket_count - 1u);
+  world->next[index] = world->buckets[b];
+  world->buckets[b] = (uint32_t)index + 1u;
+}
+
+static void unlink_object(U6BridgeWorld *world, size_t index) {
+  uint32_t *link = &world->buckets[key_hash(world->objects[index].key) & (world->bucket_count - 1u)];
+  while (*link != 0u && *link != index + 1u) {
+    link = &world->next[*link - 1u];
+  }
+  if (*link != 0u) {
+    *link = world->next[index];
+  }
+}
+
+/* Doubles storage (and the bucket table, kept at capacity) and relinks. */
+static int grow(U6BridgeWorld *world) {
+  size_t capacity = world->capacity == 0u ? 256u : world->capacity * 2u;
+  uint32_t *buckets = (uint32_t *)calloc(capacity, sizeof(uint32_t));
+  U6BridgeObject *objects;
+  uint32_t *next;
+  const U6BridgeObject **order;
+  U6AssocChainNode *nodes;
+
+  if (buckets == NULL) {
+    return U6_BRIDGE_ERR_ALLOC;
+  }
+  objects = (U6BridgeObject *)realloc(world->objects, capacity * sizeof(U6BridgeObject));
+  if (objects == NULL) {
+    free(buckets);
+    return U6_BRIDGE_ERR_ALLOC;
+  }
+  world->objects = objects;
+  next = (uint32_t *)realloc(world->next, capacity * sizeof(uint32_t));
+  if (next == NULL) {
+    free(buckets);
+    return U6_BRIDGE_ERR_ALLOC;
+  }
+  world->next = next;
+  order = (const U6BridgeObject **)realloc((void *)world->order, capacity * sizeof(*order));
+  if (order == NULL) {
+    free(buckets);
+    return U6_BRIDGE_ERR_ALLOC;
+  }
+  world->order = order;
+  nodes = (U6AssocChainNode *)realloc(world->nodes, capacity * sizeof(U6AssocChainNode));
+  if (nodes == NULL) {
+    free(buckets);
+    return U6_BRIDGE_ERR_ALLOC;
+  }
+  world->nodes = nodes;
+  free(world->buckets);
+  world->buckets = buckets;
+  world->bucket_count = capacity;
+  world->capacity = capacity;
+  for (size_t i = 0; i < world->count; i++) {
+    link_object(world, i);
+  }
+  world->order_valid = 0u;
+  world->nodes_valid = 0u;
+  return U6_BRIDGE_OK;
+}
+
+/* Grows until `needed` objects fit; a failure leaves the table as it was. */
+static int reserve(U6BridgeWorld *world, size_t needed) {
+  while (world->capacity < needed) {
+    int rc = grow(world);
+    if (rc != U6_BRIDGE_OK) {
+      return rc;
+    }
+  }
+  return U6_BRIDGE_OK;
+}
+
+static int find_index(const U6BridgeWorld *world, const char *key) {
+  uint32_t link;
+
+  if (world->bucket_count == 0u) {
+    return -1;
+  }
+  link = world->buckets[key_hash(key) & (world->bucket_count - 1u)];
+  while (link != 0u) {
+    if (strcmp(world->objects[link - 1u].key, key) == 0) {
+      return (int)(link - 1u);
+    }
+    link = world->next[link - 1u];
+  }
+  return -1;
+}
+
+const U6BridgeObject *u6_bridge_world_find(const U6BridgeWorld *world, const char *key) {
+  int index;
+
+  if (world == NULL || key == NULL) {
+    return NULL;
+  }
+  index = find_index(world, key);
+  return index >= 0 ? &world->objects[index] : NULL;
+}
+
+int u6_bridge_world_upsert(U6BridgeWorld *world, const U6BridgeObject *object) {
+  int index;
+
+  if (world == NULL || object == NULL) {
+    return U6_BRIDGE_ERR_NULL;
+  }
+  if (object->key[0] == '\0' || memchr(object->key, '\0', sizeof(object->key)) == NULL) {
+    return U6_BRIDGE_ERR_RECORD;
+  }
+  index = find_index(world, object->key);
+  if (index >= 0) {
+    world->objects[index] = *object;
+    invalidate(world);
+    return U6_BRIDGE_OK;
+  }
+  if (world->count == world->capacity && grow(world) != U6_BRIDGE_OK) {
+    return U6_BRIDGE_ERR_ALLOC;
+  }
+  world->objects[world->count] = *object;
+  link_object(world, world->count);
+  world->count++;
+  invalidate(world);
+  return U6_BRIDGE_OK;
+}
+
+int u6_bridge_world_remove(U6BridgeWorld *world, const char *key) {
+  int index;
+  size_t last;
+
+  if (world == NULL || key == NULL) {
+    return 0;
+  }
+  index = find_index(world, key);
+  if (index < 0) {
+    return 0;
+  }
+  last = world->count - 1u;
+  unlink_object(world, (size_t)index);
+  if ((size_t)index != last) {
+    unlink_object(world, last);
+    world->objects[index] = world->objects[last];
+    link_object(world, (size_t)index);
+  }
+  world->count--;
+  invalidate(world);
+  return 1;
+}
+
+static int cmp_order(const void *va, const void *vb) {
+  return u6_bridge_object_cmp(*(const U6BridgeObject *const *)va, *(const U6BridgeObject *const *)vb);
+}
+
+static void ensure_order(U6BridgeWorld *world) {
+  if (world->order_valid) {
+    return;
+  }
+  for (size_t i = 0; i < world->count; i++) {
+    world->order[i] = &world->objects[i];
+  }
+  qsort((void *)world->order, world->count, sizeof(*world->order), cmp_order);
+  world->order_valid = 1u;
+}
+
+static void ensure_nodes(U6BridgeWorld *world) {
+  if (world->nodes_valid) {
+    return;
+  }
+  world->node_count = 0u;
+  for (size_t i = 0; i < world->count; i++) {
+    const U6BridgeObject *o = &world->objects[i];
+    int key = (int)strtol(o->key, NULL, 10);
+    U6AssocChainNode *node;
+    if (key == 0) {
+      continue;
+    }
+    node = &world->nodes[world->node_count++];
+    node->key = key;
+    node->status = o->status;
+    node->holder_kind = o->holder_kind;
+    node->holder_key = o->holder_key;
+  }
+  world->nodes_valid = 1u;
+}
+
+size_t u6_bridge_world_query(U6BridgeWorld *world, const U6BridgeQuery *q, uint32_t *out_indexes, size_t out_capacity) {
+  size_t emitted = 0;
+  size_t limit;
+
+  if (world == NULL || q == NULL) {
+    return 0;
+  }
+  limit = q->limit > 0 ? (size_t)q->limit : 1u;
+  ensure_order(world);
+  for (size_t i = 0; i < world->count && emitted < limit; i++) {
+    if (!u6_bridge_object_matches(world->order[i], q)) {
+      continue;
+    }
+    if (emitted < out_capacity) {
+      out_indexes[emitted] = (uint32_t)(world->order[i] - world->objects);
+    }
+    emitted++;
+  }
+  return emitted;
+}
+
+/* ---- wire format ---- */
+
+typedef struct Reader {
+  const uint8_t *p;
+  size_t size;
+  size_t off;
+  int bad;
+} Reader;
+
+static const uint8_t *take(Reader *r, size_t n) {
+  const uint8_t *p;
+  if (r->bad || r->size - r->off < n) {
+    r->bad = 1;
+    return NULL;
+  }
+  p = r->p + r->off;
+  r->off += n;
+  return p;
+}
+
+static uint8_t read_u8(Reader *r) {
+  const uint8_t *p = take(r, 1u);
+  return p != NULL ? p[0] : 0u;
+}
+
+static uint32_t read_u32(Reader *r) {
+  const uint8_t *p = take(r, 4u);
+  if (p == NULL) {
+    return 0u;
+  }
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int32_t read_i32(Reader *r) {
+  return (int32_t)read_u32(r);
+}
+
+/* Key strings: 1..U6_BRIDGE_KEY_MAX bytes, no NULs. */
+static int read_key(Reader *r, char out[U6_BRIDGE_KEY_MAX + 1u]) {
+  uint8_t len = read_u8(r);
+  const uint8_t *p = take(r, len);
+  if (p == NULL || len == 0u || len > U6_BRIDGE_KEY_MAX || memchr(p, '\0', len) != NULL) {
+    r->bad = 1;
+    return 0;
+  }
+  memcpy(out, p, len);
+  out[len] = '\0';
+  return 1;
+}
+
+static int read_record(Reader *r, U6BridgeObject *out) {
+  memset(out, 0, sizeof(*out));
+  if (!read_key(r, out->key)) {
+    return 0;
+  }
+  out->x = read_i32(r);
+  out->y = read_i32(r);
+  out->z = read_i32(r);
+  out->status = read_u8(r);
+  out->tile_flag = read_u8(r);
+  out->holder_kind = read_u8(r);
+  (void)read_u8(r);
+  out->holder_key = read_i32(r);
+  out->source_area = read_i32(r);
+  out->source_index = read_i32(r);
+  return !r->bad;
+}
+
+typedef struct Writer {
+  U6BridgeBuffer *buf;
+  int failed;
+} Writer;
+
+static uint8_t *put(Writer *w, size_t n) {
+  U6BridgeBuffer *b = w->buf;
+  uint8_t *p;
+
+  if (w->failed) {
+    return NULL;
+  }
+  if (b->capacity - b->size < n) {
+    size_t capacity = b->capacity == 0u ? 256u : b->capacity;
+    uint8_t *data;
+    while (capacity - b->size < n) {
+      capacity *= 2u;
+    }
+    data = (uint8_t *)realloc(b->data, capacity);
+    if (data == NULL) {
+      w->failed = 1;
+      return NULL;
+    }
+    b->data = data;
+    b->capacity = capacity;
+  }
+  p = b->data + b->size;
+  b->size += n;
+  return p;
+}
+
+static void write_u8(Writer *w, uint8_t v) {
+  uint8_t *p = put(w, 1u);
+  if (p != NULL) {
+    p[0] = v;
+  }
+}
+
+static void write_u32(Writer *w, uint32_t v) {
+  uint8_t *p = put(w, 4u);
+  if (p != NULL) {
+    p[0] = (uint8_t)(v & 0xffu);
+    p[1] = (uint8_t)((v >> 8) & 0xffu);
+    p[2] = (uint8_t)((v >> 16) & 0xffu);
+    p[3] = (uint8_t)(v >> 24);
+  }
+}
+
+static void write_i32(Writer *w, int32_t v) {
+  write_u32(w, (uint32_t)v);
+}
+
+static void write_key(Writer *w, const char *key) {
+  size_t len = strlen(key);
+  uint8_t *p;
+  write_u8(w, (uint8_t)len);
+  p = put(w, len);
+  if (p != NULL) {
+    memcpy(p, key, len);
+  }
+}
+
+static void write_record(Writer *w, const U6BridgeObject *o) {
+  write_key(w, o->key);
+  write_i32(w, o->x);
+  write_i32(w, o->y);
+  write_i32(w, o->z);
+  write_u8(w, o->status);
+  write_u8(w, o->tile_flag);
+  write_u8(w, o->holder_kind);
+  write_u8(w, 0u);
+  write_i32(w, o->holder_key);
+  write_i32(w, o->source_area);
+  write_i32(w, o->source_index);
+}
+
+static int handle_records(U6BridgeWorld *world, Reader *r, int replace, Writer *w) {
+  uint32_t n = read_u32(r);
+  U6BridgeObject object;
+
+  /* Every record is at least the fixed part plus one key byte. */
+  if (r->bad || (size_t)n > (r->size - r->off) / (U6_BRIDGE_RECORD_FIXED_SIZE + 2u)) {
+    return U6_BRIDGE_ERR_FRAME;
+  }
+  if (replace) {
+    U6BridgeWorld fresh;
+    u6_bridge_world_init(&fresh);
+    for (uint32_t i = 0; i < n; i++) {
+      int rc;
+      if (!read_record(r, &object)) {
+        u6_bridge_world_free(&fresh);
+        return U6_BRIDGE_ERR_RECORD;
+      }
+      rc = u6_bridge_world_upsert(&fresh, &object);
+      if (rc != U6_BRIDGE_OK) {
+        u6_bridge_world_free(&fresh);
+        return rc;
+      }
+    }
+    fresh.generation = world->generation + 1u;
+    u6_bridge_world_free(world);
+    *world = fresh;
+  } else {
+    /*
+     * Validate the whole frame and reserve room for every new key first, so
+     * a bad record or a failed allocation applies nothing.
+     */
+    size_t start = r->off;
+    size_t added = 0;
+    int rc;
+    for (uint32_t i = 0; i < n; i++) {
+      if (!read_record(r, &object)) {
+        return U6_BRIDGE_ERR_RECORD;
+      }
+      if (find_index(world, object.key) < 0) {
+        added++;
+      }
+    }
+    rc = reserve(world, world->count + added);
+    if (rc != U6_BRIDGE_OK) {
+      return rc;
+    }
+    r->off = start;
+    for (uint32_t i = 0; i < n; i++) {
+      read_record(r, &object);
+      rc = u6_bridge_world_upsert(world, &object);
+      if (rc != U6_BRIDGE_OK) {
+        return rc;
+      }
+    }
+  }
+  write_u32(w, (uint32_t)world->count);
+  return U6_BRIDGE_OK;
+}
+
+static int handle_remove(U6BridgeWorld *world, Reader *r, Writer *w) {
+  uint32_t n = read_u32(r);
+  uint32_t removed = 0;
+  size_t start = r->off;
+  char key[U6_BRIDGE_KEY_MAX + 1u];
+
+  if (r->bad || (size_t)n > (r->size - r->off) / 2u) {
+    return U6_BRIDGE_ERR_FRAME;
+  }
+  for (uint32_t i = 0; i < n; i++) {
+    if (!read_key(r, key)) {
+      return U6_BRIDGE_ERR_RECORD;
+    }
+  }
+  r->off = start;
+  for (uint32_t i = 0; i < n; i++) {
+    read_key(r, key);
+    removed += (uint32_t)u6_bridge_world_remove(world, key);
+  }
+  write_u32(w, removed);
+  return U6_BRIDGE_OK;
+}
+
+static int handle_query(U6BridgeWorld *world, Reader *r, Writer *w) {
+  U6BridgeQuery q;
+  size_t emitted = 0;
+  size_t limit;
+
+  memset(&q, 0, sizeof(q));
+  q.has_x = read_u8(r) != 0u;
+  q.has_y = read_u8(r) != 0u;
+  q.has_z = read_u8(r) != 0u;
+  q.projection_footprint = read_u8(r) != 0u;
+  q.x = read_i32(r);
+  q.y = read_i32(r);
+  q.z = read_i32(r);
+  q.radius = read_i32(r);
+  q.limit = read_i32(r);
+  if (r->bad) {
+    return U6_BRIDGE_ERR_FRAME;
+  }
+  /* Stream straight from the render order instead of staging indexes. */
+  limit = q.limit > 0 ? (size_t)q.limit : 1u;
+  ensure_order(world);
+  write_u32(w, 0u);
+  for (size_t i = 0; i < world->count && emitted < limit; i++) {
+    const U6BridgeObject *o = world->order[i];
+    if (u6_bridge_object_matches(o, &q)) {
+      write_key(w, o->key);
+      emitted++;
+    }
+  }
+  if (!w->failed) {
+    uint8_t *count = w->buf->data + 4u + 1u + 4u;
+    count[0] = (uint8_t)(emitted & 0xffu);
+    count[1] = (uint8_t)((emitted >> 8) & 0xffu);
+    count[2] = (uint8_t)((emitted >> 16) & 0xffu);
+    count[3] = (uint8_t)((emitted >> 24) & 0xffu);
+  }
+  return U6_BRIDGE_OK;
+}
+
+static int handle_assoc(U6BridgeWorld *world, Reader *r, Writer *w) {
+  uint32_t n = read_u32(r);
+
+  if (r->bad || (size_t)n > (r->size - r->off) / 4u) {
+    return U6_BRIDGE_ERR_FRAME;
+  }
+  ensure_nodes(world);
+  write_u32(w, n);
+  for (uint32_t i = 0; i < n; i++) {
+    U6AssocChainResult out;
+    int32_t target = read_i32(r);
+    int code;
+    uint8_t flags = 0u;
+
+    memset(&out, 0, sizeof(out));
+    code = u6_assoc_chain_analyze(world->nodes, world->node_count, target, &out);
+    flags |= out.chain_accessible ? U6_BRIDGE_ASSOC_ACCESSIBLE : 0u;
+    flags |= out.cycle_detected ? U6_BRIDGE_ASSOC_CYCLE : 0u;
+    flags |= out.missing_parent ? U6_BRIDGE_ASSOC_MISSING_PARENT : 0u;
+    flags |= out.parent_owned ? U6_BRIDGE_ASSOC_PARENT_OWNED : 0u;
+    write_i32(w, target);
+    write_i32(w, code);
+    write_i32(w, out.root_anchor_key);
+    write_i32(w, out.blocked_by_key);
+    write_u8(w, flags);
+    write_u8(w, (uint8_t)out.chain_len);
+    for (size_t j = 0; j < out.chain_len; j++) {
+      write_i32(w, out.chain_keys[j]);
+    }
+  }
+  return U6_BRIDGE_OK;
+}
+
+static int handle_interact(Reader *r, Writer *w) {
+  U6WorldInteractInput in;
+  U6WorldInteractResult out;
+
+  in.verb = read_u8(r);
+  in.status = read_u8(r);
+  in.holder_kind = read_u8(r);
+  in.owner_matches_actor = read_u8(r) != 0u;
+  in.has_container = read_u8(r) != 0u;
+  in.chain_accessible = read_u8(r) != 0u;
+  in.container_cycle = read_u8(r) != 0u;
+  if (r->bad) {
+    return U6_BRIDGE_ERR_FRAME;
+  }
+  out.code = U6_WORLD_INTERACT_ERR_BAD_VERB;
+  out.status = in.status;
+  out.holder_kind = in.holder_kind;
+  (void)u6_world_interact_apply(&in, &out);
+  write_i32(w, out.code);
+  write_u8(w, out.status);
+  write_u8(w, out.holder_kind);
+  return U6_BRIDGE_OK;
+}
+
+void u6_bridge_buffer_free(U6BridgeBuffer *buffer) {
+  if (buffer == NULL) {
+    return;
+  }
+  free(buffer->data);
+  memset(buffer, 0, sizeof(*buffer));
+}
+
+static void patch_u32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v & 0xffu);
+  p[1] = (uint8_t)((v >> 8) & 0xffu);
+  p[2] = (uint8_t)((v >> 16) & 0xffu);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+int u6_bridge_handle_op(U6BridgeWorld *world, uint8_t op, const uint8_t *payload, size_t payload_len, U6BridgeBuffer *out) {
+  Reader r;
+  Writer w;
+  int status;
+
+  if (world == NULL || out == NULL || (payload == NULL && payload_len > 0u)) {
+    return U6_BRIDGE_ERR_NULL;
+  }
+  r.p = payload;
+  r.size = payload_len;
+  r.off = 0u;
+  r.bad = 0;
+  w.buf = out;
+  w.failed = 0;
+  out->size = 0u;
+  write_u32(&w, 0u); /* length, patched below */
+  write_u8(&w, op);
+  write_i32(&w, 0);  /* status, patched below */
+
+  switch (op) {
+    case U6_BRIDGE_OP_HELLO:
+      write_u32(&w, U6_BRIDGE_PROTOCOL_VERSION);
+      write_u32(&w, (uint32_t)world->count);
+      write_u32(&w, world->generation);
+      status = U6_BRIDGE_OK;
+      break;
+    case U6_BRIDGE_OP_LOAD:
+      status = handle_records(world, &r, 1, &w);
+      break;
+    case U6_BRIDGE_OP_UPSERT:
+      status = handle_records(world, &r, 0, &w);
+      break;
+    case U6_BRIDGE_OP_REMOVE:
+      status = handle_remove(world, &r, &w);
+      break;
+    case U6_BRIDGE_OP_QUERY:
+      status = handle_query(world, &r, &w);
+      break;
+    case U6_BRIDGE_OP_ASSOC:
+      status = handle_assoc(world, &r, &w);
+      break;
+    case U6_BRIDGE_OP_INTERACT:
+      status = handle_interact(&r, &w);
+      break;
+    case U6_BRIDGE_OP_SNAPSHOT:
+      write_u32(&w, (uint32_t)world->count);
+      for (size_t i = 0; i < world->count; i++) {
+        write_record(&w, &world->objects[i]);
+      }
+      status = U6_BRIDGE_OK;
+      break;
+    default:
+      status = U6_BRIDGE_ERR_OP;
+      break;
+  }
+  if (w.failed) {
+    return U6_BRIDGE_ERR_ALLOC;
+  }
+  if (status != U6_BRIDGE_OK) {
+    out->size = 9u; /* drop any partial payload */
+  }
+  patch_u32(out->data, (uint32_t)(out->size - 4u));
+  patch_u32(out->data + 5u, (uint32_t)status);
+  return U6_BRIDGE_OK;
+}
+
+int u6_bridge_handle(U6BridgeWorld *world, const uint8_t *body, size_t body_len, U6BridgeBuffer *out) {
+  int rc;
+
+  if (body == NULL && body_len > 0u) {
+    return U6_BRIDGE_ERR_NULL;
+  }
+  if (body_len > 0u) {
+    return u6_bridge_handle_op(world, body[0], body + 1, body_len - 1u, out);
+  }
+  /* No op byte: answer as a frame error for op 0. */
+  rc = u6_bridge_handle_op(world, 0u, NULL, 0u, out);
+  if (rc == U6_BRIDGE_OK) {
+    patch_u32(out->data + 5u, (uint32_t)U6_BRIDGE_ERR_FRAME);
+  }
+  return rc;
+}
@@ -1,6 +1,7 @@
 #include "u6_entities.h"
 #include "u6_objstatus.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 static int16_t clamp_map_xy(int32_t v) {
@@ -51,83 +52,964 @@ static void write_u32_le(uint8_t *p, uint32_t v) {
   p[3] = (uint8_t)((v >> 24) & 0xffu);
 }
 
-int u6_entities_init(U6EntityState *state) {
+#define NPC_INDEX_MASK ((uint32_t)U6M_NPC_INDEX_SLOTS - 1u)
+#define ARENA_ALIGN ((size_t)16u)
+
+static uint32_t index_home(uint16_t id, uint32_t mask) {
+  return (((uint32_t)id * 0x9e3779b1u) >> 16) & mask;
+}
+
+static int index_find(const uint32_t *index, uint32_t mask, uint16_t id) {
+  uint32_t pos = index_home(id, mask);
+
+  while (index[pos] != 0u) {
+    if ((uint16_t)(index[pos] >> 16) == id) {
+      return (int)(index[pos] & 0xffffu) - 1;
+    }
+    pos = (pos + 1u) & mask;
+  }
+  return -1;
+}
+
+static void index_put_entry(uint32_t *index, uint32_t mask, uint32_t entry) {
+  uint16_t id = (uint16_t)(entry >> 16);
+  uint32_t pos = index_home(id, mask);
+
+  while (index[pos] != 0u && (uint16_t)(index[pos] >> 16) != id) {
+    pos = (pos + 1u) & mask;
+  }
+  index[pos] = entry;
+}
+
+static void index_put(uint32_t *index, uint32_t mask, uint16_t id, size_t slot) {
+  index_put_entry(index, mask, ((uint32_t)id << 16) | (uint32_t)(slot + 1u));
+}
+
+/* Backward-shift deletion keeps probe chains intact without tombstones. */
+static void index_erase(uint32_t *index, uint32_t mask, uint16_t id) {
+  uint32_t pos = index_home(id, mask);
+  uint32_t next;
+
+  while (index[pos] != 0u && (uint16_t)(index[pos] >> 16) != id) {
+    pos = (pos + 1u) & mask;
+  }
+  if (index[pos] == 0u) {
+    return;
+  }
+  next = (pos + 1u) & mask;
+  while (index[next] != 0u) {
+    uint32_t home = index_home((uint16_t)(index[next] >> 16), mask);
+    if (((next - home) & mask) >= ((next - pos) & mask)) {
+      index[pos] = index[next];
+      pos = next;
+    }
+    next = (next + 1u) & mask;
+  }
+  index[pos] = 0u;
+}
+
+void u6_entity_arena_init(U6EntityArena *arena, void *buffer, size_t size) {
+  if (arena == NULL) {
+    return;
+  }
+  arena->base = (uint8_t *)buffer;
+  arena->size = buffer != NULL ? size : 0u;
+  arena->used = 0u;
+}
+
+static void *arena_alloc(U6EntityArena *arena, size_t size) {
+  size_t pad;
+
+  if (arena == NULL || arena->base == NULL) {
+    return NULL;
+  }
+  pad = (ARENA_ALIGN - (((uintptr_t)arena->base + arena->used) & (ARENA_ALIGN - 1u))) & (ARENA_ALIGN - 1u);
+  if (arena->used + pad > arena->size || size > arena->size - arena->used - pad) {
+    return NULL;
+  }
+  arena->used += pad;
+  arena->used += size;
+  return arena->base + arena->used - size;
+}
+
+static size_t extra_pages(size_t count, size_t page_size, size_t max_pages) {
+  size_t pages = (count + page_size - 1u) / page_size;
+
+  if (pages > max_pages) {
+    pages = max_pages;
+  }
+  return pages > 1u ? pages - 1u : 0u;
+}
+
+size_t u6_entities_arena_bytes(size_t max_objects, size_t max_npcs) {
+  size_t object_pages = extra_pages(max_objects, U6M_OBJECT_PAGE_SIZE, U6M_OBJECT_PAGES);
+  size_t npc_pages = extra_pages(max_npcs, U6M_NPC_PAGE_SIZE, U6M_NPC_PAGES);
+  size_t capacity = (object_pages + 1u) * U6M_OBJECT_PAGE_SIZE;
+  size_t bytes = object_pages * (sizeof(U6ObjectPage) + ARENA_ALIGN) + npc_pages * (sizeof(U6NpcPage) + ARENA_ALIGN);
+
+  /* Every outgrown index stays in the arena. */
+  for (size_t slots = U6M_OBJECT_INDEX_SLOTS; slots < capacity * 2u;) {
+    slots *= 2u;
+    bytes += slots * sizeof(uint32_t) + ARENA_ALIGN;
+  }
+  return bytes;
+}
+
+static uint32_t *object_index_table(const U6EntityState *state, uint32_t *out_mask) {
+  if (state->object_index_ext != NULL) {
+    *out_mask = state->object_index_mask;
+    return state->object_index_ext;
+  }
+  *out_mask = (uint32_t)U6M_OBJECT_INDEX_SLOTS - 1u;
+  return (uint32_t *)state->object_index;
+}
+
+/* Keeps the object index at least twice the slot capacity (load <= 0.5). */
+static int grow_object_index(U6EntityState *state, size_t capacity) {
+  uint32_t old_mask;
+  uint32_t *old_table = object_index_table(state, &old_mask);
+  size_t slots = (size_t)old_mask + 1u;
+  uint32_t *table;
+
+  if (capacity * 2u <= slots) {
+    return 0;
+  }
+  while (slots < capacity * 2u) {
+    slots *= 2u;
+  }
+  table = (uint32_t *)arena_alloc(state->arena, slots * sizeof(uint32_t));
+  if (table == NULL) {
+    return -1;
+  }
+  memset(table, 0, slots * sizeof(uint32_t));
+  for (uint32_t i = 0; i <= old_mask; i++) {
+    if (old_table[i] != 0u) {
+      index_put_entry(table, (uint32_t)(slots - 1u), old_table[i]);
+    }
+  }
+  state->object_index_ext = table;
+  state->object_index_mask = (uint32_t)(slots - 1u);
+  return 0;
+}
+
+static U6ObjectState *object_item(const U6EntityState *state, size_t slot) {
+  if (slot < U6M_INLINE_OBJECTS) {
+    return (U6ObjectState *)&state->objects[slot];
+  }
+  return &state->object_pages[slot / U6M_OBJECT_PAGE_SIZE]->items[slot % U6M_OBJECT_PAGE_SIZE];
+}
+
+static U6EntitySlotMeta *object_meta(const U6EntityState *state, size_t slot) {
+  if (slot < U6M_INLINE_OBJECTS) {
+    return (U6EntitySlotMeta *)&state->object_meta[slot];
+  }
+  return &state->object_pages[slot / U6M_OBJECT_PAGE_SIZE]->meta[slot % U6M_OBJECT_PAGE_SIZE];
+}
+
+static U6NpcState *npc_item(const U6EntityState *state, size_t slot) {
+  if (slot < U6M_INLINE_NPCS) {
+    return (U6NpcState *)&state->npcs[slot];
+  }
+  return &state->npc_pages[slot / U6M_NPC_PAGE_SIZE]->items[slot % U6M_NPC_PAGE_SIZE];
+}
+
+static U6EntitySlotMeta *npc_meta(const U6EntityState *state, size_t slot) {
+  if (slot < U6M_INLINE_NPCS) {
+    return (U6EntitySlotMeta *)&state->npc_meta[slot];
+  }
+  return &state->npc_pages[slot / U6M_NPC_PAGE_SIZE]->meta[slot % U6M_NPC_PAGE_SIZE];
+}
+
+static U6ObjectLinks *object_links(const U6EntityState *state, size_t slot) {
+  if (slot < U6M_INLINE_OBJECTS) {
+    return (U6ObjectLinks *)&state->object_links[slot];
+  }
+  return &state->object_pages[slot / U6M_OBJECT_PAGE_SIZE]->links[slot % U6M_OBJECT_PAGE_SIZE];
+}
+
+static uint16_t *npc_first_child(const U6EntityState *state, size_t slot) {
+  if (slot < U6M_INLINE_NPCS) {
+    return (uint16_t *)&state->npc_first_child[slot];
+  }
+  return &state->npc_pages[slot / U6M_NPC_PAGE_SIZE]->first_child[slot % U6M_NPC_PAGE_SIZE];
+}
+
+static U6NpcCellLink *npc_cell_link(const U6EntityState *state, size_t slot) {
+  if (slot < U6M_INLINE_NPCS) {
+    return (U6NpcCellLink *)&state->npc_cell[slot];
+  }
+  return &state->npc_pages[slot / U6M_NPC_PAGE_SIZE]->cell[slot % U6M_NPC_PAGE_SIZE];
+}
+
+/* Floor division, so negative coordinates land in their own chunks. */
+static int32_t chunk_of(int32_t v) {
+  return v >= 0 ? v >> U6M_NPC_CELL_SHIFT : -((-v + (1 << U6M_NPC_CELL_SHIFT) - 1) >> U6M_NPC_CELL_SHIFT);
+}
+
+static uint32_t npc_cell_key(int32_t cx, int32_t cy, int32_t z) {
+  return ((uint32_t)cx & 0x1fffu) | (((uint32_t)cy & 0x1fffu) << 13) | (((uint32_t)z & 0x1fu) << 26);
+}
+
+static uint32_t npc_cell_bucket(uint32_t key) {
+  return ((key * 0x9e3779b1u) >> 16) & (U6M_NPC_CELL_BUCKETS - 1u);
+}
+
+static void npc_cell_unlink(U6EntityState *state, size_t slot) {
+  U6NpcCellLink *link = npc_cell_link(state, slot);
+
+  if (link->cell == 0u) {
+    return;
+  }
+  if (link->prev != 0u) {
+    npc_cell_link(state, link->prev - 1u)->next = link->next;
+  } else {
+    state->npc_cell_head[npc_cell_bucket(link->cell - 1u)] = link->next;
+  }
+  if (link->next != 0u) {
+    npc_cell_link(state, link->next - 1u)->prev = link->prev;
+  }
+  memset(link, 0, sizeof(*link));
+}
+
+/* Moves a live NPC to its current chunk's bucket if it changed chunk. */
+static void npc_cell_update(U6EntityState *state, size_t slot) {
+  const U6NpcState *npc = npc_item(state, slot);
+  U6NpcCellLink *link = npc_cell_link(state, slot);
+  uint32_t key = npc_cell_key(chunk_of(npc->map_x), chunk_of(npc->map_y), npc->map_z);
+  uint16_t *head;
+
+  if (link->cell == key + 1u) {
+    return;
+  }
+  npc_cell_unlink(state, slot);
+  head = &state->npc_cell_head[npc_cell_bucket(key)];
+  link->cell = key + 1u;
+  link->prev = 0u;
+  link->next = *head;
+  if (*head != 0u) {
+    npc_cell_link(state, *head - 1u)->prev = (uint16_t)(slot + 1u);
+  }
+  *head = (uint16_t)(slot + 1u);
+}
+
+static void mark_object(U6EntityState *state, size_t slot) {
+  uint32_t v = ++state->version;
+  object_meta(state, slot)->version = v;
+  state->object_page_version[slot / U6M_OBJECT_PAGE_SIZE] = v;
+}
+
+static void mark_npc(U6EntityState *state, size_t slot) {
+  uint32_t v = ++state->version;
+  npc_meta(state, slot)->version = v;
+  state->npc_page_version[slot / U6M_NPC_PAGE_SIZE] = v;
+  if ((npc_meta(state, slot)->generation & 1u) != 0u) {
+    npc_cell_update(state, slot);
+  }
+}
+
+/* Logs a removal at the current version, overwriting the oldest entry. */
+static void push_tombstone(U6EntityState *state, uint8_t kind, uint16_t id) {
+  U6EntityTombstone *t = &state->tombstones[state->tombstone_next % U6M_ENTITY_TOMBSTONES];
+
+  if (t->version > state->tombstone_floor) {
+    state->tombstone_floor = t->version;
+  }
+  t->version = state->version;
+  t->id = id;
+  t->kind = kind;
+  state->tombstone_next++;
+}
+
+static int find_object_slot(const U6EntityState *state, uint16_t object_id) {
+  uint32_t mask;
+  const uint32_t *index = object_index_table(state, &mask);
+
+  return index_find(index, mask, object_id);
+}
+
+/* Child list head of a holder, NULL if the holder is not present. */
+static uint16_t *holder_head(const U6EntityState *state, uint8_t holder_kind, uint16_t holder_id, int *out_slot) {
+  int slot = -1;
+  uint16_t *head = NULL;
+
+  if (holder_kind == U6_OBJECT_HOLDER_OBJECT) {
+    slot = find_object_slot(state, holder_id);
+    if (slot >= 0) {
+      head = &object_links(state, (size_t)slot)->first_child;
+    }
+  } else if (holder_kind == U6_OBJECT_HOLDER_NPC) {
+    slot = index_find(state->npc_index, NPC_INDEX_MASK, holder_id);
+    if (slot >= 0) {
+      head = npc_first_child(state, (size_t)slot);
+    }
+  }
+  if (out_slot != NULL) {
+    *out_slot = slot;
+  }
+  return head;
+}
+
+/* True if object slot `ancestor` is parent_slot or one of its containers. */
+static int links_contain(const U6EntityState *state, size_t ancestor, size_t parent_slot) {
+  size_t p = parent_slot;
+
+  for (;;) {
+    const U6ObjectLinks *links;
+    if (p == ancestor) {
+      return 1;
+    }
+    links = object_links(state, p);
+    if (links->parent == 0u || links->parent_kind != U6_OBJECT_HOLDER_OBJECT) {
+      return 0;
+    }
+    p = links->parent - 1u;
+  }
+}
+
+static void link_object(U6EntityState *state, size_t slot) {
+  const U6ObjectState *obj = object_item(state, slot);
+  U6ObjectLinks *links = object_links(state, slot);
+  uint16_t *head;
+  int parent_slot;
+
+  links->parent_kind = obj->holder_kind;
+  if (obj->holder_kind != U6_OBJECT_HOLDER_OBJECT && obj->holder_kind != U6_OBJECT_HOLDER_NPC) {
+    links->parent_kind = U6_OBJECT_HOLDER_NONE;
+    return;
+  }
+  head = holder_head(state, obj->holder_kind, obj->holder_id, &parent_slot);
+  if (head == NULL
+      || (obj->holder_kind == U6_OBJECT_HOLDER_OBJECT && links_contain(state, slot, (size_t)parent_slot))) {
+    state->containment_orphans++;
+    return;
+  }
+  links->parent = (uint16_t)(parent_slot + 1);
+  links->prev_sibling = 0u;
+  links->next_sibling = *head;
+  if (*head != 0u) {
+    object_links(state, *head - 1u)->prev_sibling = (uint16_t)(slot + 1u);
+  }
+  *head = (uint16_t)(slot + 1u);
+}
+
+static void unlink_object(U6EntityState *state, size_t slot) {
+  U6ObjectLinks *links = object_links(state, slot);
+
+  if (links->parent != 0u) {
+    uint16_t *head = links->parent_kind == U6_OBJECT_HOLDER_OBJECT ? &object_links(state, links->parent - 1u)->first_child
+                                                                     : npc_first_child(state, links->parent - 1u);
+    if (links->prev_sibling != 0u) {
+      object_links(state, links->prev_sibling - 1u)->next_sibling = links->next_sibling;
+    } else {
+      *head = links->next_sibling;
+    }
+    if (links->next_sibling != 0u) {
+      object_links(state, links->next_sibling - 1u)->prev_sibling = links->prev_sibling;
+    }
+  } else if (links->parent_kind != U6_OBJECT_HOLDER_NONE) {
+    state->containment_orphans--;
+  }
+  links->parent = 0u;
+  links->next_sibling = 0u;
+  links->prev_sibling = 0u;
+  links->parent_kind = U6_OBJECT_HOLDER_NONE;
+}
+
+/* Detaches a removed holder's children; they stay orphans until it returns. */
+static void orphan_children(U6EntityState *state, uint16_t *head) {
+  uint16_t child = *head;
+
+  while (child != 0u) {
+    U6ObjectLinks *links = object_links(state, child - 1u);
+    child = links->next_sibling;
+    links->parent = 0u;
+    links->next_sibling = 0u;
+    links->prev_sibling = 0u;
+    state->containment_orphans++;
+  }
+  *head = 0u;
+}
+
+static void rebuild_containment(U6EntityState *state) {
+  for (size_t i = 0; i < state->object_slots; i++) {
+    memset(object_links(state, i), 0, sizeof(U6ObjectLinks));
+  }
+  for (size_t i = 0; i < state->npc_slots; i++) {
+    *npc_first_child(state, i) = 0u;
+  }
+  state->containment_orphans = 0u;
+  state->containment_stale = 0u;
+  for (size_t i = 0; i < state->object_slots; i++) {
+    if ((object_meta(state, i)->generation & 1u) != 0u) {
+      link_object(state, i);
+    }
+  }
+}
+
+static int alloc_object_slot(U6EntityState *state, size_t *out_slot) {
+  size_t slot = state->object_slots;
+
+  if (state->object_free != 0u) {
+    slot = state->object_free - 1u;
+    state->object_free = object_meta(state, slot)->next_free;
+  } else {
+    size_t page = slot / U6M_OBJECT_PAGE_SIZE;
+    if (slot >= U6M_MAX_OBJECTS) {
+      return -2;
+    }
+    if (page > 0u && state->object_pages[page] == NULL) {
+      U6ObjectPage *fresh;
+      if (grow_object_index(state, (page + 1u) * U6M_OBJECT_PAGE_SIZE) != 0) {
+        return -2;
+      }
+      fresh = (U6ObjectPage *)arena_alloc(state->arena, sizeof(U6ObjectPage));
+      if (fresh == NULL) {
+        return -2;
+      }
+      memset(fresh, 0, sizeof(*fresh));
+      state->object_pages[page] = fresh;
+    }
+    state->object_slots++;
+  }
+  object_meta(state, slot)->generation++;
+  object_meta(state, slot)->next_free = 0u;
+  state->object_count++;
+  *out_slot = slot;
+  return 0;
+}
+
+static int alloc_npc_slot(U6EntityState *state, size_t *out_slot) {
+  size_t slot = state->npc_slots;
+
+  if (state->npc_free != 0u) {
+    slot = state->npc_free - 1u;
+    state->npc_free = npc_meta(state, slot)->next_free;
+  } else {
+    size_t page = slot / U6M_NPC_PAGE_SIZE;
+    if (slot >= U6M_MAX_NPCS) {
+      return -2;
+    }
+    if (page > 0u && state->npc_pages[page] == NULL) {
+      U6NpcPage *fresh = (U6NpcPage *)arena_alloc(state->arena, sizeof(U6NpcPage));
+      if (fresh == NULL) {
+        return -2;
+      }
+      memset(fresh, 0, sizeof(*fresh));
+      state->npc_pages[page] = fresh;
+    }
+    state->npc_slots++;
+  }
+  npc_meta(state, slot)->generation++;
+  npc_meta(state, slot)->next_free = 0u;
+  state->npc_count++;
+  *out_slot = slot;
+  return 0;
+}
+
+int u6_entities_init_arena(U6EntityState *state, U6EntityArena *arena) {
   if (state == NULL) {
     return -1;
   }
   memset(state, 0, sizeof(*state));
+  state->arena = arena;
   return 0;
 }
 
+int u6_entities_init(U6EntityState *state) {
+  return u6_entities_init_arena(state, NULL);
+}
+
 int u6_entities_add_object(U6EntityState *state, const U6ObjectState *object_state) {
+  U6ObjectState *obj;
+  uint32_t mask;
+  uint32_t *index;
+  size_t slot;
+
   if (state == NULL || object_state == NULL) {
     return -1;
   }
-  if (state->object_count >= U6M_MAX_OBJECTS) {
+  index = object_index_table(state, &mask);
+  if (index_find(index, mask, object_state->object_id) >= 0) {
+    return -3;
+  }
+  if (alloc_object_slot(state, &slot) != 0) {
     return -2;
   }
-  state->objects[state->object_count] = *object_state;
-  if (state->objects[state->object_count].status == 0u
-      && state->objects[state->object_count].holder_kind == U6_OBJECT_HOLDER_NONE
-      && state->objects[state->object_count].holder_id == 0u) {
-    state->objects[state->object_count].status = u6_obj_status_to_locxyz(0u);
+  index = object_index_table(state, &mask);
+  index_put(index, mask, object_state->object_id, slot);
+  obj = object_item(state, slot);
+  *obj = *object_state;
+  if (obj->status == 0u && obj->holder_kind == U6_OBJECT_HOLDER_NONE && obj->holder_id == 0u) {
+    obj->status = u6_obj_status_to_locxyz(0u);
   }
-  state->object_count++;
+  if (state->containment_orphans > 0u) {
+    state->containment_stale = 1u;
+  } else if (!state->containment_stale) {
+    link_object(state, slot);
+  }
+  mark_object(state, slot);
   return 0;
 }
 
 int u6_entities_add_npc(U6EntityState *state, const U6NpcState *npc_state) {
+  size_t slot;
+
   if (state == NULL || npc_state == NULL) {
     return -1;
   }
-  if (state->npc_count >= U6M_MAX_NPCS) {
+  if (index_find(state->npc_index, NPC_INDEX_MASK, npc_state->npc_id) >= 0) {
+    return -3;
+  }
+  if (alloc_npc_slot(state, &slot) != 0) {
     return -2;
   }
-  state->npcs[state->npc_count] = *npc_state;
-  state->npc_count++;
+  index_put(state->npc_index, NPC_INDEX_MASK, npc_state->npc_id, slot);
+  *npc_item(state, slot) = *npc_state;
+  if (state->containment_orphans > 0u) {
+    state->containment_stale = 1u;
+  }
+  mark_npc(state, slot);
   return 0;
 }
 
 U6ObjectState *u6_entities_find_object(U6EntityState *state, uint16_t object_id) {
+  const uint32_t *index;
+  uint32_t mask;
+  int slot;
+
   if (state == NULL) {
     return NULL;
   }
-  for (size_t i = 0; i < state->object_count; i++) {
-    if (state->objects[i].object_id == object_id) {
-      return &state->objects[i];
-    }
-  }
-  return NULL;
+  index = object_index_table(state, &mask);
+  slot = index_find(index, mask, object_id);
+  return slot >= 0 ? object_item(state, (size_t)slot) : NULL;
 }
 
 U6NpcState *u6_entities_find_npc(U6EntityState *state, uint16_t npc_id) {
+  int slot;
+
+  if (state == NULL) {
+    return NULL;
+  }
+  slot = index_find(state->npc_index, NPC_INDEX_MASK, npc_id);
+  return slot >= 0 ? npc_item(state, (size_t)slot) : NULL;
+}
+
+int u6_entities_remove_object(U6EntityState *state, uint16_t object_id) {
+  U6EntitySlotMeta *meta;
+  uint32_t mask;
+  uint32_t *index;
+  int slot;
+
   if (state == NULL) {
+    return -1;
+  }
+  index = object_index_table(state, &mask);
+  slot = index_find(index, mask, object_id);
+  if (slot < 0) {
+    return -2;
+  }
+  index_erase(index, mask, object_id);
+  if (!state->containment_stale) {
+    orphan_children(state, &object_links(state, (size_t)slot)->first_child);
+    unlink_object(state, (size_t)slot);
+  }
+  memset(object_links(state, (size_t)slot), 0, sizeof(U6ObjectLinks));
+  memset(object_item(state, (size_t)slot), 0, sizeof(U6ObjectState));
+  meta = object_meta(state, (size_t)slot);
+  meta->generation++;
+  meta->next_free = (uint16_t)state->object_free;
+  state->object_free = (uint32_t)slot + 1u;
+  state->object_count--;
+  mark_object(state, (size_t)slot);
+  push_tombstone(state, U6_OBJECT_HOLDER_OBJECT, object_id);
+  return 0;
+}
+
+int u6_entities_remove_npc(U6EntityState *state, uint16_t npc_id) {
+  U6EntitySlotMeta *meta;
+  int slot;
+
+  if (state == NULL) {
+    return -1;
+  }
+  slot = index_find(state->npc_index, NPC_INDEX_MASK, npc_id);
+  if (slot < 0) {
+    return -2;
+  }
+  index_erase(state->npc_index, NPC_INDEX_MASK, npc_id);
+  if (!state->containment_stale) {
+    orphan_children(state, npc_first_child(state, (size_t)slot));
+  }
+  *npc_first_child(state, (size_t)slot) = 0u;
+  npc_cell_unlink(state, (size_t)slot);
+  memset(npc_item(state, (size_t)slot), 0, sizeof(U6NpcState));
+  meta = npc_meta(state, (size_t)slot);
+  meta->generation++;
+  meta->next_free = (uint16_t)state->npc_free;
+  state->npc_free = (uint32_t)slot + 1u;
+  state->npc_count--;
+  mark_npc(state, (size_t)slot);
+  push_tombstone(state, U6_OBJECT_HOLDER_NPC, npc_id);
+  return 0;
+}
+
+size_t u6_entities_object_slots(const U6EntityState *state) {
+  return state != NULL ? state->object_slots : 0u;
+}
+
+size_t u6_entities_npc_slots(const U6EntityState *state) {
+  return state != NULL ? state->npc_slots : 0u;
+}
+
+U6ObjectState *u6_entities_object_at(const U6EntityState *state, size_t slot) {
+  if (state == NULL || slot >= state->object_slots || (object_meta(state, slot)->generation & 1u) == 0u) {
     return NULL;
   }
-  for (size_t i = 0; i < state->npc_count; i++) {
-    if (state->npcs[i].npc_id == npc_id) {
-      return &state->npcs[i];
+  return object_item(state, slot);
+}
+
+U6NpcState *u6_entities_npc_at(const U6EntityState *state, size_t slot) {
+  if (state == NULL || slot >= state->npc_slots || (npc_meta(state, slot)->generation & 1u) == 0u) {
+    return NULL;
+  }
+  return npc_item(state, slot);
+}
+
+U6EntityHandle u6_entities_object_handle(const U6EntityState *state, uint16_t object_id) {
+  const uint32_t *index;
+  uint32_t mask;
+  int slot;
+
+  if (state == NULL) {
+    return U6M_ENTITY_HANDLE_NONE;
+  }
+  index = object_index_table(state, &mask);
+  slot = index_find(index, mask, object_id);
+  if (slot < 0) {
+    return U6M_ENTITY_HANDLE_NONE;
+  }
+  return ((U6EntityHandle)object_meta(state, (size_t)slot)->generation << 16) | (U6EntityHandle)slot;
+}
+
+U6EntityHandle u6_entities_npc_handle(const U6EntityState *state, uint16_t npc_id) {
+  int slot;
+
+  if (state == NULL) {
+    return U6M_ENTITY_HANDLE_NONE;
+  }
+  slot = index_find(state->npc_index, NPC_INDEX_MASK, npc_id);
+  if (slot < 0) {
+    return U6M_ENTITY_HANDLE_NONE;
+  }
+  return ((U6EntityHandle)npc_meta(state, (size_t)slot)->generation << 16) | (U6EntityHandle)slot;
+}
+
+U6ObjectState *u6_entities_object_from_handle(const U6EntityState *state, U6EntityHandle handle) {
+  size_t slot = handle & 0xffffu;
+  U6ObjectState *obj = u6_entities_object_at(state, slot);
+
+  if (obj == NULL || object_meta(state, slot)->generation != (uint16_t)(handle >> 16)) {
+    return NULL;
+  }
+  return obj;
+}
+
+U6NpcState *u6_entities_npc_from_handle(const U6EntityState *state, U6EntityHandle handle) {
+  size_t slot = handle & 0xffffu;
+  U6NpcState *npc = u6_entities_npc_at(state, slot);
+
+  if (npc == NULL || npc_meta(state, slot)->generation != (uint16_t)(handle >> 16)) {
+    return NULL;
+  }
+  return npc;
+}
+
+int u6_entities_reindex(U6EntityState *state) {
+  uint32_t mask;
+  uint32_t *index;
+
+  if (state == NULL) {
+    return -1;
+  }
+  index = object_index_table(state, &mask);
+  memset(index, 0, ((size_t)mask + 1u) * sizeof(uint32_t));
+  memset(state->npc_index, 0, sizeof(state->npc_index));
+  for (size_t i = 0; i < state->object_slots; i++) {
+    const U6ObjectState *obj = u6_entities_object_at(state, i);
+    if (obj == NULL) {
+      continue;
+    }
+    if (index_find(index, mask, obj->object_id) >= 0) {
+      return -3;
     }
+    index_put(index, mask, obj->object_id, i);
   }
-  return NULL;
+  for (size_t i = 0; i < state->npc_slots; i++) {
+    const U6NpcState *npc = u6_entities_npc_at(state, i);
+    if (npc == NULL) {
+      continue;
+    }
+    if (index_find(state->npc_index, NPC_INDEX_MASK, npc->npc_id) >= 0) {
+      return -3;
+    }
+    index_put(state->npc_index, NPC_INDEX_MASK, npc->npc_id, i);
+  }
+  state->containment_stale = 1u;
+  return 0;
+}
+
+int u6_entities_set_holder(U6EntityState *state, uint16_t object_id, uint8_t holder_kind, uint16_t holder_id) {
+  U6ObjectState *obj;
+  int slot;
+  int parent_slot;
+
+  if (state == NULL) {
+    return -1;
+  }
+  slot = find_object_slot(state, object_id);
+  if (slot < 0) {
+    return -2;
+  }
+  if (state->containment_stale) {
+    rebuild_containment(state);
+  }
+  if (holder_kind == U6_OBJECT_HOLDER_OBJECT && holder_head(state, holder_kind, holder_id, &parent_slot) != NULL
+      && links_contain(state, (size_t)slot, (size_t)parent_slot)) {
+    return -4;
+  }
+  obj = object_item(state, (size_t)slot);
+  unlink_object(state, (size_t)slot);
+  obj->holder_kind = holder_kind;
+  obj->holder_id = holder_kind == U6_OBJECT_HOLDER_NONE ? 0u : holder_id;
+  link_object(state, (size_t)slot);
+  mark_object(state, (size_t)slot);
+  return 0;
+}
+
+size_t u6_entities_children(U6EntityState *state,
+                            uint8_t holder_kind,
+                            uint16_t holder_id,
+                            uint16_t *out_ids,
+                            size_t out_capacity) {
+  const uint16_t *head;
+  size_t total = 0;
+
+  if (state == NULL) {
+    return 0;
+  }
+  if (state->containment_stale) {
+    rebuild_containment(state);
+  }
+  head = holder_head(state, holder_kind, holder_id, NULL);
+  for (uint16_t child = head != NULL ? *head : 0u; child != 0u; child = object_links(state, child - 1u)->next_sibling) {
+    if (out_ids != NULL && total < out_capacity) {
+      out_ids[total] = object_item(state, child - 1u)->object_id;
+    }
+    total++;
+  }
+  return total;
+}
+
+/* Pre-order walk over the links; the tree is acyclic by construction. */
+static size_t walk_contents(const U6EntityState *state,
+                            uint16_t first,
+                            uint16_t *out_ids,
+                            uint8_t *out_depths,
+                            size_t out_capacity,
+                            uint32_t *out_quantity) {
+  uint16_t node = first;
+  size_t depth = 1;
+  size_t total = 0;
+  uint32_t quantity = 0;
+
+  while (node != 0u) {
+    const U6ObjectLinks *links = object_links(state, node - 1u);
+    const U6ObjectState *obj = object_item(state, node - 1u);
+    if (total < out_capacity) {
+      if (out_ids != NULL) {
+        out_ids[total] = obj->object_id;
+      }
+      if (out_depths != NULL) {
+        out_depths[total] = (uint8_t)(depth > 0xffu ? 0xffu : depth);
+      }
+    }
+    total++;
+    quantity += obj->quantity;
+    if (links->first_child != 0u) {
+      node = links->first_child;
+      depth++;
+      continue;
+    }
+    /* Climb until a sibling remains; depth 0 means back at the holder. */
+    while (depth > 0u && object_links(state, node - 1u)->next_sibling == 0u) {
+      node = object_links(state, node - 1u)->parent;
+      depth--;
+    }
+    node = depth > 0u ? object_links(state, node - 1u)->next_sibling : 0u;
+  }
+  if (out_quantity != NULL) {
+    *out_quantity = quantity;
+  }
+  return total;
+}
+
+size_t u6_entities_contents(U6EntityState *state,
+                            uint8_t holder_kind,
+                            uint16_t holder_id,
+                            uint16_t *out_ids,
+                            uint8_t *out_depths,
+                            size_t out_capacity) {
+  const uint16_t *head;
+
+  if (state == NULL) {
+    return 0;
+  }
+  if (state->containment_stale) {
+    rebuild_containment(state);
+  }
+  head = holder_head(state, holder_kind, holder_id, NULL);
+  return head != NULL ? walk_contents(state, *head, out_ids, out_depths, out_capacity, NULL) : 0u;
+}
+
+int u6_entities_contents_totals(U6EntityState *state,
+                                uint8_t holder_kind,
+                                uint16_t holder_id,
+                                uint32_t *out_count,
+                                uint32_t *out_quantity) {
+  const uint16_t *head;
+
+  if (state == NULL || out_count == NULL || out_quantity == NULL) {
+    return -1;
+  }
+  if (state->containment_stale) {
+    rebuild_containment(state);
+  }
+  head = holder_head(state, holder_kind, holder_id, NULL);
+  if (head == NULL) {
+    return -2;
+  }
+  *out_count = (uint32_t)walk_contents(state, *head, NULL, NULL, 0u, out_quantity);
+  return 0;
 }
 
 int u6_entities_move_npc(U6EntityState *state, uint16_t npc_id, int16_t x, int16_t y, int16_t z) {
   U6NpcState *npc;
+  int slot;
 
   if (state == NULL) {
     return -1;
   }
-  npc = u6_entities_find_npc(state, npc_id);
-  if (npc == NULL) {
+  slot = index_find(state->npc_index, NPC_INDEX_MASK, npc_id);
+  if (slot < 0) {
     return -2;
   }
+  npc = npc_item(state, (size_t)slot);
   npc->map_x = clamp_map_xy(x);
   npc->map_y = clamp_map_xy(y);
   npc->map_z = clamp_map_z(z);
+  mark_npc(state, (size_t)slot);
   return 0;
 }
 
+static int npc_in_box(const U6NpcState *npc, int32_t x, int32_t y, int32_t z, int32_t radius) {
+  return npc->map_z == z && abs((int32_t)npc->map_x - x) <= radius && abs((int32_t)npc->map_y - y) <= radius;
+}
+
+size_t u6_entities_npcs_near(U6EntityState *state,
+                             int16_t x,
+                             int16_t y,
+                             int16_t z,
+                             int16_t radius,
+                             uint16_t *out_ids,
+                             size_t out_capacity) {
+  uint16_t found[U6M_MAX_NPCS];
+  size_t total = 0;
+  int32_t cx0;
+  int32_t cx1;
+  int32_t cy0;
+  int32_t cy1;
+  uint64_t chunks;
+
+  if (state == NULL || radius < 0) {
+    return 0;
+  }
+  cx0 = chunk_of((int32_t)x - radius);
+  cx1 = chunk_of((int32_t)x + radius);
+  cy0 = chunk_of((int32_t)y - radius);
+  cy1 = chunk_of((int32_t)y + radius);
+  chunks = (uint64_t)(cx1 - cx0 + 1) * (uint64_t)(cy1 - cy0 + 1);
+
+  if (chunks > state->npc_count) {
+    /* A box wider than the population is cheaper to answer by scanning. */
+    for (size_t i = 0; i < state->npc_slots; i++) {
+      const U6NpcState *npc = u6_entities_npc_at(state, i);
+      if (npc != NULL && npc_in_box(npc, x, y, z, radius)) {
+        found[total++] = npc->npc_id;
+      }
+    }
+  } else {
+    for (int32_t cy = cy0; cy <= cy1; cy++) {
+      for (int32_t cx = cx0; cx <= cx1; cx++) {
+        uint32_t cell = npc_cell_key(cx, cy, z) + 1u;
+        uint16_t next = state->npc_cell_head[npc_cell_bucket(cell - 1u)];
+        while (next != 0u) {
+          const U6NpcCellLink *link = npc_cell_link(state, next - 1u);
+          const U6NpcState *npc = npc_item(state, next - 1u);
+          if (link->cell == cell && npc_in_box(npc, x, y, z, radius)) {
+            found[total++] = npc->npc_id;
+          }
+          next = link->next;
+        }
+      }
+    }
+  }
+
+  for (size_t i = 1; i < total; i++) {
+    uint16_t id = found[i];
+    size_t j = i;
+    while (j > 0 && found[j - 1u] > id) {
+      found[j] = found[j - 1u];
+      j--;
+    }
+    found[j] = id;
+  }
+  if (out_ids != NULL) {
+    memcpy(out_ids, found, (total < out_capacity ? total : out_capacity) * sizeof(uint16_t));
+  }
+  return total;
+}
+
+/* Returns nonzero if the NPC moved or bounced. */
+static int step_patrol(U6NpcState *npc) {
+  int32_t next_x;
+  int32_t next_y;
+  int8_t old_dx = npc->patrol_dx;
+  int8_t old_dy = npc->patrol_dy;
+  int16_t old_x = npc->map_x;
+  int16_t old_y = npc->map_y;
+
+  if ((npc->flags & U6_NPC_FLAG_ACTIVE) == 0u || (npc->flags & U6_NPC_FLAG_PATROL) == 0u) {
+    return 0;
+  }
+
+  next_x = (int32_t)npc->map_x + npc->patrol_dx;
+  next_y = (int32_t)npc->map_y + npc->patrol_dy;
+
+  if (next_x < 0 || next_x > 1023) {
+    npc->patrol_dx = (int8_t)(-npc->patrol_dx);
+    next_x = (int32_t)npc->map_x + npc->patrol_dx;
+  }
+  if (next_y < 0 || next_y > 1023) {
+    npc->patrol_dy = (int8_t)(-npc->patrol_dy);
+    next_y = (int32_t)npc->map_y + npc->patrol_dy;
+  }
+
+  npc->map_x = clamp_map_xy(next_x);
+  npc->map_y = clamp_map_xy(next_y);
+  return npc->map_x != old_x || npc->map_y != old_y || npc->patrol_dx != old_dx || npc->patrol_dy != old_dy;
+}
+
 int u6_entities_step(U6EntityState *state, uint32_t tick) {
   if (state == NULL) {
     return -1;
@@ -137,34 +1019,202 @@ int u6_entities_step(U6EntityState *state, uint32_t tick) {
     return 0;
   }
 
-  for (size_t i = 0; i < state->npc_count; i++) {
-    U6NpcState *npc = &state->npcs[i];
-    int32_t next_x;
-    int32_t next_y;
-
-    if ((npc->flags & U6_NPC_FLAG_ACTIVE) == 0u || (npc->flags & U6_NPC_FLAG_PATROL) == 0u) {
-      continue;
+  for (size_t i = 0; i < state->npc_slots; i++) {
+    U6NpcState *npc = u6_entities_npc_at(state, i);
+    if (npc != NULL && step_patrol(npc)) {
+      mark_npc(state, i);
     }
+  }
 
-    next_x = (int32_t)npc->map_x + npc->patrol_dx;
-    next_y = (int32_t)npc->map_y + npc->patrol_dy;
+  return 0;
+}
 
-    if (next_x < 0 || next_x > 1023) {
-      npc->patrol_dx = (int8_t)(-npc->patrol_dx);
-      next_x = (int32_t)npc->map_x + npc->patrol_dx;
-    }
-    if (next_y < 0 || next_y > 1023) {
-      npc->patrol_dy = (int8_t)(-npc->patrol_dy);
-      next_y = (int32_t)npc->map_y + npc->patrol_dy;
+int u6_entities_step_slots(U6EntityState *state, const uint16_t *slots, size_t count, uint32_t tick) {
+  if (state == NULL || (slots == NULL && count > 0)) {
+    return -1;
+  }
+
+  if ((tick % 4u) != 0u) {
+    return 0;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    U6NpcState *npc = u6_entities_npc_at(state, slots[i]);
+    if (npc != NULL && step_patrol(npc)) {
+      mark_npc(state, slots[i]);
     }
+  }
+
+  return 0;
+}
+
+uint32_t u6_entities_version(const U6EntityState *state) {
+  return state != NULL ? state->version : 0u;
+}
+
+int u6_entities_touch_object(U6EntityState *state, uint16_t object_id) {
+  int slot;
 
-    npc->map_x = clamp_map_xy(next_x);
-    npc->map_y = clamp_map_xy(next_y);
+  if (state == NULL) {
+    return -1;
+  }
+  slot = find_object_slot(state, object_id);
+  if (slot < 0) {
+    return -2;
   }
+  mark_object(state, (size_t)slot);
+  return 0;
+}
+
+int u6_entities_touch_npc(U6EntityState *state, uint16_t npc_id) {
+  int slot;
 
+  if (state == NULL) {
+    return -1;
+  }
+  slot = index_find(state->npc_index, NPC_INDEX_MASK, npc_id);
+  if (slot < 0) {
+    return -2;
+  }
+  mark_npc(state, (size_t)slot);
   return 0;
 }
 
+static void write_object_record(uint8_t *p, const U6ObjectState *obj) {
+  write_u16_le(p + 0, obj->object_id);
+  write_u16_le(p + 2, obj->tile_id);
+  write_i16_le(p + 4, obj->map_x);
+  write_i16_le(p + 6, obj->map_y);
+  write_i16_le(p + 8, obj->map_z);
+  p[10] = obj->quantity;
+  p[11] = obj->flags;
+  p[12] = obj->status;
+  p[13] = obj->holder_kind;
+  write_u16_le(p + 14, obj->holder_id);
+}
+
+static void read_object_record(const uint8_t *p, U6ObjectState *obj) {
+  obj->object_id = read_u16_le(p + 0);
+  obj->tile_id = read_u16_le(p + 2);
+  obj->map_x = read_i16_le(p + 4);
+  obj->map_y = read_i16_le(p + 6);
+  obj->map_z = read_i16_le(p + 8);
+  obj->quantity = p[10];
+  obj->flags = p[11];
+  obj->status = p[12];
+  obj->holder_kind = p[13];
+  obj->holder_id = read_u16_le(p + 14);
+}
+
+static void write_npc_record(uint8_t *p, const U6NpcState *npc) {
+  write_u16_le(p + 0, npc->npc_id);
+  write_u16_le(p + 2, npc->body_tile);
+  write_i16_le(p + 4, npc->map_x);
+  write_i16_le(p + 6, npc->map_y);
+  write_i16_le(p + 8, npc->map_z);
+  p[10] = npc->flags;
+  p[11] = (uint8_t)npc->patrol_dx;
+  p[12] = (uint8_t)npc->patrol_dy;
+}
+
+static void read_npc_record(const uint8_t *p, U6NpcState *npc) {
+  npc->npc_id = read_u16_le(p + 0);
+  npc->body_tile = read_u16_le(p + 2);
+  npc->map_x = read_i16_le(p + 4);
+  npc->map_y = read_i16_le(p + 6);
+  npc->map_z = read_i16_le(p + 8);
+  npc->flags = p[10];
+  npc->patrol_dx = (int8_t)p[11];
+  npc->patrol_dy = (int8_t)p[12];
+}
+
+static uint64_t record_hash(const uint8_t *bytes, size_t size, uint64_t seed) {
+  uint64_t h = 1469598103934665603ull ^ seed;
+
+  for (size_t i = 0; i < size; i++) {
+    h ^= bytes[i];
+    h *= 1099511628211ull;
+  }
+  /* Finalize so the per-entity hashes sum without structure. */
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return h;
+}
+
+static uint64_t object_record_hash(const U6ObjectState *obj) {
+  uint8_t rec[U6M_ENTITY_OBJECT_SIZE];
+
+  write_object_record(rec, obj);
+  return record_hash(rec, sizeof(rec), 0x6f626a6563740000ull);
+}
+
+static uint64_t npc_record_hash(const U6NpcState *npc) {
+  uint8_t rec[U6M_ENTITY_NPC_SIZE];
+
+  write_npc_record(rec, npc);
+  return record_hash(rec, sizeof(rec), 0x6e70630000000000ull);
+}
+
+/* Refreshes slots stamped after since (all slots when force is set). */
+static void fold_hashes(U6EntityState *state, uint32_t since, int force) {
+  for (size_t page = 0; page * U6M_OBJECT_PAGE_SIZE < state->object_slots; page++) {
+    size_t end = (page + 1u) * U6M_OBJECT_PAGE_SIZE;
+    if (!force && state->object_page_version[page] <= since) {
+      continue;
+    }
+    if (end > state->object_slots) {
+      end = state->object_slots;
+    }
+    for (size_t slot = page * U6M_OBJECT_PAGE_SIZE; slot < end; slot++) {
+      U6EntitySlotMeta *meta = object_meta(state, slot);
+      const U6ObjectState *obj;
+      uint64_t h;
+      if (!force && meta->version <= since) {
+        continue;
+      }
+      obj = u6_entities_object_at(state, slot);
+      h = obj != NULL ? object_record_hash(obj) : 0u;
+      state->content_hash += h - meta->hash;
+      meta->hash = h;
+    }
+  }
+  for (size_t page = 0; page * U6M_NPC_PAGE_SIZE < state->npc_slots; page++) {
+    size_t end = (page + 1u) * U6M_NPC_PAGE_SIZE;
+    if (!force && state->npc_page_version[page] <= since) {
+      continue;
+    }
+    if (end > state->npc_slots) {
+      end = state->npc_slots;
+    }
+    for (size_t slot = page * U6M_NPC_PAGE_SIZE; slot < end; slot++) {
+      U6EntitySlotMeta *meta = npc_meta(state, slot);
+      const U6NpcState *npc;
+      uint64_t h;
+      if (!force && meta->version <= since) {
+        continue;
+      }
+      npc = u6_entities_npc_at(state, slot);
+      h = npc != NULL ? npc_record_hash(npc) : 0u;
+      state->content_hash += h - meta->hash;
+      meta->hash = h;
+    }
+  }
+}
+
+uint64_t u6_entities_hash(U6EntityState *state) {
+  if (state == NULL) {
+    return 0;
+  }
+  if (state->hash_version != state->version) {
+    fold_hashes(state, state->hash_version, 0);
+    state->hash_version = state->version;
+  }
+  return state->content_hash;
+}
+
 size_t u6_entities_serialized_size(const U6EntityState *state) {
   if (state == NULL) {
     return 0;
@@ -194,36 +1244,26 @@ int u6_entities_serialize(const U6EntityState *state,
 
   write_u32_le(out + 0, U6M_ENTITY_MAGIC);
   write_u16_le(out + 4, U6M_ENTITY_VERSION);
-  write_u16_le(out + 6, (uint16_t)state->object_count);
-  write_u16_le(out + 8, (uint16_t)state->npc_count);
-  write_u16_le(out + 10, 0u);
+  write_u16_le(out + 6, 0u);
+  write_u32_le(out + 8, (uint32_t)state->object_count);
+  write_u32_le(out + 12, (uint32_t)state->npc_count);
 
   off = U6M_ENTITY_HEADER_SIZE;
-  for (size_t i = 0; i < state->object_count; i++) {
-    const U6ObjectState *obj = &state->objects[i];
-    write_u16_le(out + off + 0, obj->object_id);
-    write_u16_le(out + off + 2, obj->tile_id);
-    write_i16_le(out + off + 4, obj->map_x);
-    write_i16_le(out + off + 6, obj->map_y);
-    write_i16_le(out + off + 8, obj->map_z);
-    out[off + 10] = obj->quantity;
-    out[off + 11] = obj->flags;
-    out[off + 12] = obj->status;
-    out[off + 13] = obj->holder_kind;
-    write_u16_le(out + off + 14, obj->holder_id);
+  for (size_t i = 0; i < state->object_slots; i++) {
+    const U6ObjectState *obj = u6_entities_object_at(state, i);
+    if (obj == NULL) {
+      continue;
+    }
+    write_object_record(out + off, obj);
     off += U6M_ENTITY_OBJECT_SIZE;
   }
 
-  for (size_t i = 0; i < state->npc_count; i++) {
-    const U6NpcState *npc = &state->npcs[i];
-    write_u16_le(out + off + 0, npc->npc_id);
-    write_u16_le(out + off + 2, npc->body_tile);
-    write_i16_le(out + off + 4, npc->map_x);
-    write_i16_le(out + off + 6, npc->map_y);
-    write_i16_le(out + off + 8, npc->map_z);
-    out[off + 10] = npc->flags;
-    out[off + 11] = (uint8_t)npc->patrol_dx;
-    out[off + 12] = (uint8_t)npc->patrol_dy;
+  for (size_t i = 0; i < state->npc_slots; i++) {
+    const U6NpcState *npc = u6_entities_npc_at(state, i);
+    if (npc == NULL) {
+      continue;
+    }
+    write_npc_record(out + off, npc);
     off += U6M_ENTITY_NPC_SIZE;
   }
 
@@ -232,70 +1272,283 @@ int u6_entities_serialize(const U6EntityState *state,
 }
 
 int u6_entities_deserialize(U6EntityState *state, const uint8_t *in, size_t in_size) {
+  return u6_entities_deserialize_arena(state, NULL, in, in_size);
+}
+
+int u6_entities_deserialize_arena(U6EntityState *state,
+                                  U6EntityArena *arena,
+                                  const uint8_t *in,
+                                  size_t in_size) {
   uint16_t version;
-  uint16_t object_count;
-  uint16_t npc_count;
+  uint32_t object_count;
+  uint32_t npc_count;
+  size_t header_size;
   size_t off;
   size_t need;
 
   if (state == NULL || in == NULL) {
     return -1;
   }
-  if (in_size < U6M_ENTITY_HEADER_SIZE) {
+  if (in_size < U6M_ENTITY_HEADER_SIZE_V2) {
     return -2;
   }
   if (read_u32_le(in + 0) != U6M_ENTITY_MAGIC) {
     return -3;
   }
   version = read_u16_le(in + 4);
-  if (version != U6M_ENTITY_VERSION) {
+  if (version == 2u) {
+    header_size = U6M_ENTITY_HEADER_SIZE_V2;
+    object_count = read_u16_le(in + 6);
+    npc_count = read_u16_le(in + 8);
+  } else if (version == U6M_ENTITY_VERSION) {
+    if (in_size < U6M_ENTITY_HEADER_SIZE) {
+      return -2;
+    }
+    header_size = U6M_ENTITY_HEADER_SIZE;
+    object_count = read_u32_le(in + 8);
+    npc_count = read_u32_le(in + 12);
+  } else {
     return -4;
   }
 
-  object_count = read_u16_le(in + 6);
-  npc_count = read_u16_le(in + 8);
   if (object_count > U6M_MAX_OBJECTS || npc_count > U6M_MAX_NPCS) {
     return -5;
   }
 
-  need = U6M_ENTITY_HEADER_SIZE + ((size_t)object_count * U6M_ENTITY_OBJECT_SIZE)
-         + ((size_t)npc_count * U6M_ENTITY_NPC_SIZE);
+  need = header_size + ((size_t)object_count * U6M_ENTITY_OBJECT_SIZE) + ((size_t)npc_count * U6M_ENTITY_NPC_SIZE);
   if (in_size < need) {
     return -6;
   }
 
-  memset(state, 0, sizeof(*state));
-  state->object_count = object_count;
-  state->npc_count = npc_count;
+  u6_entities_init_arena(state, arena);
 
-  off = U6M_ENTITY_HEADER_SIZE;
-  for (size_t i = 0; i < state->object_count; i++) {
-    U6ObjectState *obj = &state->objects[i];
-    obj->object_id = read_u16_le(in + off + 0);
-    obj->tile_id = read_u16_le(in + off + 2);
-    obj->map_x = read_i16_le(in + off + 4);
-    obj->map_y = read_i16_le(in + off + 6);
-    obj->map_z = read_i16_le(in + off + 8);
-    obj->quantity = in[off + 10];
-    obj->flags = in[off + 11];
-    obj->status = in[off + 12];
-    obj->holder_kind = in[off + 13];
-    obj->holder_id = read_u16_le(in + off + 14);
+  off = header_size;
+  for (uint32_t i = 0; i < object_count; i++) {
+    size_t slot;
+    if (alloc_object_slot(state, &slot) != 0) {
+      u6_entities_init_arena(state, arena);
+      return -8;
+    }
+    read_object_record(in + off, object_item(state, slot));
     off += U6M_ENTITY_OBJECT_SIZE;
   }
 
-  for (size_t i = 0; i < state->npc_count; i++) {
-    U6NpcState *npc = &state->npcs[i];
-    npc->npc_id = read_u16_le(in + off + 0);
-    npc->body_tile = read_u16_le(in + off + 2);
-    npc->map_x = read_i16_le(in + off + 4);
-    npc->map_y = read_i16_le(in + off + 6);
-    npc->map_z = read_i16_le(in + off + 8);
-    npc->flags = in[off + 10];
-    npc->patrol_dx = (int8_t)in[off + 11];
-    npc->patrol_dy = (int8_t)in[off + 12];
+  for (uint32_t i = 0; i < npc_count; i++) {
+    size_t slot;
+    if (alloc_npc_slot(state, &slot) != 0) {
+      u6_entities_init_arena(state, arena);
+      return -8;
+    }
+    read_npc_record(in + off, npc_item(state, slot));
     off += U6M_ENTITY_NPC_SIZE;
   }
 
+  if (u6_entities_reindex(state) != 0) {
+    u6_entities_init_arena(state, arena);
+    return -7;
+  }
+  fold_hashes(state, 0u, 1);
+  for (size_t i = 0; i < state->npc_slots; i++) {
+    npc_cell_update(state, i);
+  }
+  return 0;
+}
+
+static int delta_base_ok(const U6EntityState *state, uint32_t base_version) {
+  return base_version <= state->version && base_version >= state->tombstone_floor;
+}
+
+/*
+ * Walks the changes after base in output order; with out == NULL it only
+ * counts. counts: object tombstones, npc tombstones, object records, npc
+ * records. Returns the encoded size.
+ */
+static size_t walk_delta(const U6EntityState *state, uint32_t base_version, uint8_t *out, uint32_t counts[4]) {
+  size_t off = U6M_ENTITY_DELTA_HEADER_SIZE;
+
+  memset(counts, 0, 4u * sizeof(uint32_t));
+  for (uint8_t kind = U6_OBJECT_HOLDER_OBJECT; kind <= U6_OBJECT_HOLDER_NPC; kind++) {
+    for (size_t i = 0; i < U6M_ENTITY_TOMBSTONES; i++) {
+      const U6EntityTombstone *t = &state->tombstones[i];
+      if (t->version <= base_version || t->kind != kind) {
+        continue;
+      }
+      if (out != NULL) {
+        write_u16_le(out + off, t->id);
+      }
+      off += 2u;
+      counts[kind - U6_OBJECT_HOLDER_OBJECT]++;
+    }
+  }
+
+  for (size_t page = 0; page < U6M_OBJECT_PAGES; page++) {
+    size_t first = page * U6M_OBJECT_PAGE_SIZE;
+    size_t end = first + U6M_OBJECT_PAGE_SIZE;
+
+    if (first >= state->object_slots) {
+      break;
+    }
+    if (state->object_page_version[page] <= base_version) {
+      continue;
+    }
+    if (end > state->object_slots) {
+      end = state->object_slots;
+    }
+    for (size_t slot = first; slot < end; slot++) {
+      const U6ObjectState *obj = u6_entities_object_at(state, slot);
+      if (obj == NULL || object_meta(state, slot)->version <= base_version) {
+        continue;
+      }
+      if (out != NULL) {
+        write_object_record(out + off, obj);
+      }
+      off += U6M_ENTITY_OBJECT_SIZE;
+      counts[2]++;
+    }
+  }
+
+  for (size_t page = 0; page < U6M_NPC_PAGES; page++) {
+    size_t first = page * U6M_NPC_PAGE_SIZE;
+    size_t end = first + U6M_NPC_PAGE_SIZE;
+
+    if (first >= state->npc_slots) {
+      break;
+    }
+    if (state->npc_page_version[page] <= base_version) {
+      continue;
+    }
+    if (end > state->npc_slots) {
+      end = state->npc_slots;
+    }
+    for (size_t slot = first; slot < end; slot++) {
+      const U6NpcState *npc = u6_entities_npc_at(state, slot);
+      if (npc == NULL || npc_meta(state, slot)->version <= base_version) {
+        continue;
+      }
+      if (out != NULL) {
+        write_npc_record(out + off, npc);
+      }
+      off += U6M_ENTITY_NPC_SIZE;
+      counts[3]++;
+    }
+  }
+  return off;
+}
+
+int u6_entities_delta_size(const U6EntityState *state, uint32_t base_version, size_t *out_size) {
+  uint32_t counts[4];
+
+  if (state == NULL || out_size == NULL) {
+    return -1;
+  }
+  if (!delta_base_ok(state, base_version)) {
+    return -5;
+  }
+  *out_size = walk_delta(state, base_version, NULL, counts);
+  return 0;
+}
+
+int u6_entities_serialize_delta(const U6EntityState *state,
+                                uint32_t base_version,
+                                uint8_t *out,
+                                size_t out_size,
+                                size_t *out_written) {
+  uint32_t counts[4];
+  size_t need;
+
+  if (state == NULL || out == NULL || out_written == NULL) {
+    return -1;
+  }
+  if (!delta_base_ok(state, base_version)) {
+    return -5;
+  }
+  need = walk_delta(state, base_version, NULL, counts);
+  if (out_size < need) {
+    return -3;
+  }
+  walk_delta(state, base_version, out, counts);
+  write_u32_le(out + 0, U6M_ENTITY_DELTA_MAGIC);
+  write_u16_le(out + 4, U6M_ENTITY_DELTA_VERSION);
+  write_u16_le(out + 6, 0u);
+  write_u32_le(out + 8, base_version);
+  write_u32_le(out + 12, state->version);
+  for (size_t i = 0; i < 4u; i++) {
+    write_u32_le(out + 16 + i * 4u, counts[i]);
+  }
+  *out_written = need;
+  return 0;
+}
+
+int u6_entities_apply_delta(U6EntityState *state, const uint8_t *in, size_t in_size) {
+  uint32_t counts[4];
+  size_t need;
+  size_t off;
+
+  if (state == NULL || in == NULL) {
+    return -1;
+  }
+  if (in_size < U6M_ENTITY_DELTA_HEADER_SIZE) {
+    return -2;
+  }
+  if (read_u32_le(in + 0) != U6M_ENTITY_DELTA_MAGIC) {
+    return -3;
+  }
+  if (read_u16_le(in + 4) != U6M_ENTITY_DELTA_VERSION) {
+    return -4;
+  }
+  for (size_t i = 0; i < 4u; i++) {
+    counts[i] = read_u32_le(in + 16 + i * 4u);
+  }
+  need = U6M_ENTITY_DELTA_HEADER_SIZE + ((size_t)counts[0] + counts[1]) * 2u
+         + (size_t)counts[2] * U6M_ENTITY_OBJECT_SIZE + (size_t)counts[3] * U6M_ENTITY_NPC_SIZE;
+  if (in_size < need) {
+    return -6;
+  }
+
+  off = U6M_ENTITY_DELTA_HEADER_SIZE;
+  for (uint32_t i = 0; i < counts[0]; i++, off += 2u) {
+    u6_entities_remove_object(state, read_u16_le(in + off));
+  }
+  for (uint32_t i = 0; i < counts[1]; i++, off += 2u) {
+    u6_entities_remove_npc(state, read_u16_le(in + off));
+  }
+
+  for (uint32_t i = 0; i < counts[2]; i++, off += U6M_ENTITY_OBJECT_SIZE) {
+    U6ObjectState rec;
+    U6ObjectState *obj;
+    int slot;
+
+    read_object_record(in + off, &rec);
+    slot = find_object_slot(state, rec.object_id);
+    if (slot < 0) {
+      if (u6_entities_add_object(state, &rec) != 0) {
+        return -8;
+      }
+      slot = find_object_slot(state, rec.object_id);
+    }
+    obj = object_item(state, (size_t)slot);
+    /* Holders may arrive in any order; relink lazily instead of per record. */
+    if (obj->holder_kind != rec.holder_kind || obj->holder_id != rec.holder_id) {
+      state->containment_stale = 1u;
+    }
+    *obj = rec;
+    mark_object(state, (size_t)slot);
+  }
+
+  for (uint32_t i = 0; i < counts[3]; i++, off += U6M_ENTITY_NPC_SIZE) {
+    U6NpcState rec;
+    int slot;
+
+    read_npc_record(in + off, &rec);
+    slot = index_find(state->npc_index, NPC_INDEX_MASK, rec.npc_id);
+    if (slot < 0) {
+      if (u6_entities_add_npc(state, &rec) != 0) {
+        return -8;
+      }
+      continue;
+    }
+    *npc_item(state, (size_t)slot) = rec;
+    mark_npc(state, (size_t)slot);
+  }
   return 0;
 }
@@ -0,0 +1,334 @@
+#include "u6_entity_snapshot.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+enum { ID_BITMAP_BYTES = 65536 / 8 };
+
+static size_t page_count(size_t slots, size_t page_size) {
+  return (slots + page_size - 1u) / page_size;
+}
+
+static const U6ObjectState *state_object_items(const U6EntityState *state, size_t page) {
+  return page == 0u ? state->objects : state->object_pages[page]->items;
+}
+
+static const U6EntitySlotMeta *state_object_meta(const U6EntityState *state, size_t page) {
+  return page == 0u ? state->object_meta : state->object_pages[page]->meta;
+}
+
+static const U6NpcState *state_npc_items(const U6EntityState *state, size_t page) {
+  return page == 0u ? state->npcs : state->npc_pages[page]->items;
+}
+
+static const U6EntitySlotMeta *state_npc_meta(const U6EntityState *state, size_t page) {
+  return page == 0u ? state->npc_meta : state->npc_pages[page]->meta;
+}
+
+static U6ObjectSnapPage *copy_object_page(const U6EntityState *state, size_t page) {
+  const U6EntitySlotMeta *meta = state_object_meta(state, page);
+  U6ObjectSnapPage *out = (U6ObjectSnapPage *)malloc(sizeof(U6ObjectSnapPage));
+
+  if (out == NULL) {
+    return NULL;
+  }
+  out->refs = 1u;
+  memcpy(out->items, state_object_items(state, page), sizeof(out->items));
+  for (size_t i = 0; i < U6M_OBJECT_PAGE_SIZE; i++) {
+    out->generation[i] = meta[i].generation;
+  }
+  return out;
+}
+
+static U6NpcSnapPage *copy_npc_page(const U6EntityState *state, size_t page) {
+  const U6EntitySlotMeta *meta = state_npc_meta(state, page);
+  U6NpcSnapPage *out = (U6NpcSnapPage *)malloc(sizeof(U6NpcSnapPage));
+
+  if (out == NULL) {
+    return NULL;
+  }
+  out->refs = 1u;
+  memcpy(out->items, state_npc_items(state, page), sizeof(out->items));
+  for (size_t i = 0; i < U6M_NPC_PAGE_SIZE; i++) {
+    out->generation[i] = meta[i].generation;
+  }
+  return out;
+}
+
+int u6_entity_snapshot_capture(U6EntitySnapshot *out, const U6EntityState *state, const U6EntitySnapshot *base) {
+  U6EntitySnapshot snap;
+  int reuse;
+
+  if (out == NULL || state == NULL || out == base) {
+    return U6_ENTITY_SNAPSHOT_ERR_NULL;
+  }
+  memset(&snap, 0, sizeof(snap));
+  snap.source = state;
+  snap.version = state->version;
+  snap.object_count = state->object_count;
+  snap.npc_count = state->npc_count;
+  snap.object_slots = state->object_slots;
+  snap.npc_slots = state->npc_slots;
+  reuse = base != NULL && base->source == state && base->version <= state->version;
+
+  for (size_t p = 0; p < page_count(state->object_slots, U6M_OBJECT_PAGE_SIZE); p++) {
+    if (reuse && base->object_pages[p] != NULL && state->object_page_version[p] <= base->version) {
+      snap.object_pages[p] = base->object_pages[p];
+      snap.object_pages[p]->refs++;
+      continue;
+    }
+    snap.object_pages[p] = copy_object_page(state, p);
+    if (snap.object_pages[p] == NULL) {
+      u6_entity_snapshot_release(&snap);
+      return U6_ENTITY_SNAPSHOT_ERR_ALLOC;
+    }
+  }
+  for (size_t p = 0; p < page_count(state->npc_slots, U6M_NPC_PAGE_SIZE); p++) {
+    if (reuse && base->npc_pages[p] != NULL && state->npc_page_version[p] <= base->version) {
+      snap.npc_pages[p] = base->npc_pages[p];
+      snap.npc_pages[p]->refs++;
+      continue;
+    }
+    snap.npc_pages[p] = copy_npc_page(state, p);
+    if (snap.npc_pages[p] == NULL) {
+      u6_entity_snapshot_release(&snap);
+      return U6_ENTITY_SNAPSHOT_ERR_ALLOC;
+    }
+  }
+  *out = snap;
+  return U6_ENTITY_SNAPSHOT_OK;
+}
+
+int u6_entity_snapshot_fork(U6EntitySnapshot *out, const U6EntitySnapshot *snapshot) {
+  if (out == NULL || snapshot == NULL || out == snapshot) {
+    return U6_ENTITY_SNAPSHOT_ERR_NULL;
+  }
+  *out = *snapshot;
+  for (size_t p = 0; p < U6M_OBJECT_PAGES; p++) {
+    if (out->object_pages[p] != NULL) {
+      out->object_pages[p]->refs++;
+    }
+  }
+  for (size_t p = 0; p < U6M_NPC_PAGES; p++) {
+    if (out->npc_pages[p] != NULL) {
+      out->npc_pages[p]->refs++;
+    }
+  }
+  return U6_ENTITY_SNAPSHOT_OK;
+}
+
+void u6_entity_snapshot_release(U6EntitySnapshot *snapshot) {
+  if (snapshot == NULL) {
+    return;
+  }
+  for (size_t p = 0; p < U6M_OBJECT_PAGES; p++) {
+    if (snapshot->object_pages[p] != NULL && --snapshot->object_pages[p]->refs == 0u) {
+      free(snapshot->object_pages[p]);
+    }
+  }
+  for (size_t p = 0; p < U6M_NPC_PAGES; p++) {
+    if (snapshot->npc_pages[p] != NULL && --snapshot->npc_pages[p]->refs == 0u) {
+      free(snapshot->npc_pages[p]);
+    }
+  }
+  memset(snapshot, 0, sizeof(*snapshot));
+}
+
+const U6ObjectState *u6_entity_snapshot_object_at(const U6EntitySnapshot *snapshot, size_t slot) {
+  const U6ObjectSnapPage *page;
+
+  if (snapshot == NULL || slot >= snapshot->object_slots) {
+    return NULL;
+  }
+  page = snapshot->object_pages[slot / U6M_OBJECT_PAGE_SIZE];
+  slot %= U6M_OBJECT_PAGE_SIZE;
+  return (page->generation[slot] & 1u) != 0u ? &page->items[slot] : NULL;
+}
+
+const U6NpcState *u6_entity_snapshot_npc_at(const U6EntitySnapshot *snapshot, size_t slot) {
+  const U6NpcSnapPage *page;
+
+  if (snapshot == NULL || slot >= snapshot->npc_slots) {
+    return NULL;
+  }
+  page = snapshot->npc_pages[slot / U6M_NPC_PAGE_SIZE];
+  slot %= U6M_NPC_PAGE_SIZE;
+  return (page->generation[slot] & 1u) != 0u ? &page->items[slot] : NULL;
+}
+
+static int same_object(const U6ObjectState *a, const U6ObjectState *b) {
+  return a->object_id == b->object_id && a->tile_id == b->tile_id && a->map_x == b->map_x && a->map_y == b->map_y
+         && a->map_z == b->map_z && a->quantity == b->quantity && a->flags == b->flags && a->status == b->status
+         && a->holder_kind == b->holder_kind && a->holder_id == b->holder_id;
+}
+
+static int same_npc(const U6NpcState *a, const U6NpcState *b) {
+  return a->npc_id == b->npc_id && a->body_tile == b->body_tile && a->map_x == b->map_x && a->map_y == b->map_y
+         && a->map_z == b->map_z && a->patrol_dx == b->patrol_dx && a->patrol_dy == b->patrol_dy
+         && a->flags == b->flags;
+}
+
+/*
+ * Slots that can differ from the snapshot. For the source state that is
+ * every slot stamped after the capture (a removal or move stamps the slot it
+ * left, so both sides of any difference are covered); otherwise all slots.
+ */
+static int object_slot_changed(const U6EntityState *state, const U6EntitySnapshot *snap, size_t slot, int incremental) {
+  size_t page = slot / U6M_OBJECT_PAGE_SIZE;
+
+  if (!incremental || slot >= state->object_slots) {
+    return 1;
+  }
+  return state->object_page_version[page] > snap->version
+         && state_object_meta(state, page)[slot % U6M_OBJECT_PAGE_SIZE].version > snap->version;
+}
+
+static int npc_slot_changed(const U6EntityState *state, const U6EntitySnapshot *snap, size_t slot, int incremental) {
+  size_t page = slot / U6M_NPC_PAGE_SIZE;
+
+  if (!incremental || slot >= state->npc_slots) {
+    return 1;
+  }
+  return state->npc_page_version[page] > snap->version
+         && state_npc_meta(state, page)[slot % U6M_NPC_PAGE_SIZE].version > snap->version;
+}
+
+/* Next slot at or after slot worth visiting; whole unchanged pages are skipped. */
+static size_t next_object_slot(const U6EntityState *state, const U6EntitySnapshot *snap, size_t slot, int incremental) {
+  while (incremental && slot < state->object_slots
+         && state->object_page_version[slot / U6M_OBJECT_PAGE_SIZE] <= snap->version) {
+    slot = (slot / U6M_OBJECT_PAGE_SIZE + 1u) * U6M_OBJECT_PAGE_SIZE;
+  }
+  return slot;
+}
+
+static size_t next_npc_slot(const U6EntityState *state, const U6EntitySnapshot *snap, size_t slot, int incremental) {
+  while (incremental && slot < state->npc_slots && state->npc_page_version[slot / U6M_NPC_PAGE_SIZE] <= snap->version) {
+    slot = (slot / U6M_NPC_PAGE_SIZE + 1u) * U6M_NPC_PAGE_SIZE;
+  }
+  return slot;
+}
+
+static void bitmap_set(uint8_t *bits, uint16_t id) {
+  bits[id >> 3] = (uint8_t)(bits[id >> 3] | (1u << (id & 7u)));
+}
+
+static int bitmap_has(const uint8_t *bits, uint16_t id) {
+  return (bits[id >> 3] >> (id & 7u)) & 1u;
+}
+
+static int restore_objects(U6EntityState *state, const U6EntitySnapshot *snap, int incremental, uint8_t *seen) {
+  size_t end = state->object_slots > snap->object_slots ? state->object_slots : snap->object_slots;
+  int relink = 0;
+  int changes = 0;
+
+  memset(seen, 0, ID_BITMAP_BYTES);
+  for (size_t s = next_object_slot(state, snap, 0, incremental); s < end; s = next_object_slot(state, snap, s + 1u, incremental)) {
+    const U6ObjectState *rec = u6_entity_snapshot_object_at(snap, s);
+    if (rec != NULL && object_slot_changed(state, snap, s, incremental)) {
+      bitmap_set(seen, rec->object_id);
+    }
+  }
+  /* Removals first so the adds below find free slots. */
+  for (size_t s = next_object_slot(state, snap, 0, incremental); s < end; s = next_object_slot(state, snap, s + 1u, incremental)) {
+    const U6ObjectState *cur = u6_entities_object_at(state, s);
+    if (cur != NULL && object_slot_changed(state, snap, s, incremental) && !bitmap_has(seen, cur->object_id)) {
+      u6_entities_remove_object(state, cur->object_id);
+      changes++;
+    }
+  }
+  for (size_t s = next_object_slot(state, snap, 0, incremental); s < end; s = next_object_slot(state, snap, s + 1u, incremental)) {
+    const U6ObjectState *rec = u6_entity_snapshot_object_at(snap, s);
+    U6ObjectState *cur;
+
+    if (rec == NULL || !object_slot_changed(state, snap, s, incremental)) {
+      continue;
+    }
+    cur = u6_entities_find_object(state, rec->object_id);
+    if (cur == NULL) {
+      if (u6_entities_add_object(state, rec) != 0) {
+        return U6_ENTITY_SNAPSHOT_ERR_FULL;
+      }
+      changes++;
+      continue;
+    }
+    if (same_object(cur, rec)) {
+      continue;
+    }
+    if (cur->holder_kind != rec->holder_kind || cur->holder_id != rec->holder_id) {
+      relink = 1;
+    }
+    *cur = *rec;
+    u6_entities_touch_object(state, rec->object_id);
+    changes++;
+  }
+  /* Holders may be restored in any order; let the containment tree rebuild. */
+  if (relink) {
+    u6_entities_reindex(state);
+  }
+  return changes;
+}
+
+static int restore_npcs(U6EntityState *state, const U6EntitySnapshot *snap, int incremental, uint8_t *seen) {
+  size_t end = state->npc_slots > snap->npc_slots ? state->npc_slots : snap->npc_slots;
+  int changes = 0;
+
+  memset(seen, 0, ID_BITMAP_BYTES);
+  for (size_t s = next_npc_slot(state, snap, 0, incremental); s < end; s = next_npc_slot(state, snap, s + 1u, incremental)) {
+    const U6NpcState *rec = u6_entity_snapshot_npc_at(snap, s);
+    if (rec != NULL && npc_slot_changed(state, snap, s, incremental)) {
+      bitmap_set(seen, rec->npc_id);
+    }
+  }
+  for (size_t s = next_npc_slot(state, snap, 0, incremental); s < end; s = next_npc_slot(state, snap, s + 1u, incremental)) {
+    const U6NpcState *cur = u6_entities_npc_at(state, s);
+    if (cur != NULL && npc_slot_changed(state, snap, s, incremental) && !bitmap_has(seen, cur->npc_id)) {
+      u6_entities_remove_npc(state, cur->npc_id);
+      changes++;
+    }
+  }
+  for (size_t s = next_npc_slot(state, snap, 0, incremental); s < end; s = next_npc_slot(state, snap, s + 1u, incremental)) {
+    const U6NpcState *rec = u6_entity_snapshot_npc_at(snap, s);
+    U6NpcState *cur;
+
+    if (rec == NULL || !npc_slot_changed(state, snap, s, incremental)) {
+      continue;
+    }
+    cur = u6_entities_find_npc(state, rec->npc_id);
+    if (cur == NULL) {
+      if (u6_entities_add_npc(state, rec) != 0) {
+        return U6_ENTITY_SNAPSHOT_ERR_FULL;
+      }
+      changes++;
+      continue;
+    }
+    if (same_npc(cur, rec)) {
+      continue;
+    }
+    *cur = *rec;
+    u6_entities_touch_npc(state, rec->npc_id);
+    changes++;
+  }
+  return changes;
+}
+
+int u6_entity_snapshot_restore(U6EntityState *state, const U6EntitySnapshot *snapshot) {
+  uint8_t seen[ID_BITMAP_BYTES];
+  int incremental;
+  int objects;
+  int npcs;
+
+  if (state == NULL || snapshot == NULL) {
+    return U6_ENTITY_SNAPSHOT_ERR_NULL;
+  }
+  incremental = snapshot->source == state && snapshot->version <= state->version;
+  objects = restore_objects(state, snapshot, incremental, seen);
+  if (objects < 0) {
+    return objects;
+  }
+  npcs = restore_npcs(state, snapshot, incremental, seen);
+  if (npcs < 0) {
+    return npcs;
+  }
+  return objects + npcs;
+}
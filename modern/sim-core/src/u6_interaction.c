@@ -2,6 +2,7 @@
 #include "u6_objstatus.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 static int in_talk_range(const U6NpcState *a, const U6NpcState *b) {
   int dx;
@@ -54,27 +55,49 @@ static int container_allows_access(const U6ObjectState *container) {
   return (container->flags & U6_OBJECT_FLAG_OPEN) != 0u;
 }
 
-int u6_interaction_apply(U6EntityState *state,
-                         const U6InteractionRequest *request,
-                         U6InteractionResult *out_result) {
+/*
+ * Lookups a request needs before any flow runs. Interactions never add or
+ * remove entities, so these pointers stay valid across a whole batch; flags,
+ * status and holders are still read when the request is applied.
+ */
+typedef struct ResolvedRequest {
   U6NpcState *actor;
+  U6NpcState *target_npc;
+  U6ObjectState *target_obj;
+  U6ObjectState *aux_obj;
+} ResolvedRequest;
 
-  if (state == NULL || request == NULL || out_result == NULL) {
-    return U6_INTERACT_ERR_NULL;
+static void resolve_targets(U6EntityState *state, const U6InteractionRequest *request, ResolvedRequest *out) {
+  out->target_npc = NULL;
+  out->target_obj = NULL;
+  out->aux_obj = NULL;
+  if (request->verb == U6_INTERACT_TALK) {
+    out->target_npc = u6_entities_find_npc(state, request->target_id);
+    return;
   }
+  out->target_obj = u6_entities_find_object(state, request->target_id);
+  if (request->verb == U6_INTERACT_PUT) {
+    out->aux_obj = u6_entities_find_object(state, request->aux_target_id);
+  }
+}
+
+static int apply_resolved(U6EntityState *state,
+                          const U6InteractionRequest *request,
+                          const ResolvedRequest *resolved,
+                          U6InteractionResult *out_result) {
+  U6NpcState *actor = resolved->actor;
 
   out_result->code = U6_INTERACT_ERR_INVALID;
   out_result->event = U6_EVENT_NONE;
   out_result->affected_id = 0;
 
-  actor = u6_entities_find_npc(state, request->actor_npc_id);
   if (actor == NULL || (actor->flags & U6_NPC_FLAG_ACTIVE) == 0u) {
     out_result->code = U6_INTERACT_ERR_NOT_FOUND;
     return out_result->code;
   }
 
   if (request->verb == U6_INTERACT_TALK) {
-    U6NpcState *target = u6_entities_find_npc(state, request->target_id);
+    U6NpcState *target = resolved->target_npc;
     if (target == NULL || (target->flags & U6_NPC_FLAG_ACTIVE) == 0u) {
       out_result->code = U6_INTERACT_ERR_NOT_FOUND;
       return out_result->code;
@@ -90,7 +113,7 @@ int u6_interaction_apply(U6EntityState *state,
   }
 
   if (request->verb == U6_INTERACT_USE) {
-    U6ObjectState *target_obj = u6_entities_find_object(state, request->target_id);
+    U6ObjectState *target_obj = resolved->target_obj;
     if (target_obj == NULL) {
       out_result->code = U6_INTERACT_ERR_NOT_FOUND;
       return out_result->code;
@@ -106,7 +129,7 @@ int u6_interaction_apply(U6EntityState *state,
   }
 
   if (request->verb == U6_INTERACT_OPEN) {
-    U6ObjectState *target_obj = u6_entities_find_object(state, request->target_id);
+    U6ObjectState *target_obj = resolved->target_obj;
     if (target_obj == NULL) {
       out_result->code = U6_INTERACT_ERR_NOT_FOUND;
       return out_result->code;
@@ -127,6 +150,7 @@ int u6_interaction_apply(U6EntityState *state,
     }
 
     target_obj->flags |= U6_OBJECT_FLAG_OPEN;
+    u6_entities_touch_object(state, target_obj->object_id);
     out_result->code = U6_INTERACT_OK;
     out_result->event = U6_EVENT_OPENED;
     out_result->affected_id = target_obj->object_id;
@@ -134,7 +158,7 @@ int u6_interaction_apply(U6EntityState *state,
   }
 
   if (request->verb == U6_INTERACT_TAKE) {
-    U6ObjectState *target_obj = u6_entities_find_object(state, request->target_id);
+    U6ObjectState *target_obj = resolved->target_obj;
     if (target_obj == NULL) {
       out_result->code = U6_INTERACT_ERR_NOT_FOUND;
       return out_result->code;
@@ -163,9 +187,11 @@ int u6_interaction_apply(U6EntityState *state,
         return out_result->code;
       }
     }
+    if (u6_entities_set_holder(state, target_obj->object_id, U6_OBJECT_HOLDER_NPC, actor->npc_id) != 0) {
+      out_result->code = U6_INTERACT_ERR_BLOCKED;
+      return out_result->code;
+    }
     target_obj->status = u6_obj_status_to_inventory(target_obj->status);
-    target_obj->holder_kind = U6_OBJECT_HOLDER_NPC;
-    target_obj->holder_id = actor->npc_id;
     target_obj->map_x = actor->map_x;
     target_obj->map_y = actor->map_y;
     target_obj->map_z = actor->map_z;
@@ -176,7 +202,7 @@ int u6_interaction_apply(U6EntityState *state,
   }
 
   if (request->verb == U6_INTERACT_DROP) {
-    U6ObjectState *target_obj = u6_entities_find_object(state, request->target_id);
+    U6ObjectState *target_obj = resolved->target_obj;
     if (target_obj == NULL) {
       out_result->code = U6_INTERACT_ERR_NOT_FOUND;
       return out_result->code;
@@ -185,9 +211,11 @@ int u6_interaction_apply(U6EntityState *state,
       out_result->code = U6_INTERACT_ERR_BLOCKED;
       return out_result->code;
     }
+    if (u6_entities_set_holder(state, target_obj->object_id, U6_OBJECT_HOLDER_NONE, 0u) != 0) {
+      out_result->code = U6_INTERACT_ERR_BLOCKED;
+      return out_result->code;
+    }
     target_obj->status = u6_obj_status_to_locxyz(target_obj->status);
-    target_obj->holder_kind = U6_OBJECT_HOLDER_NONE;
-    target_obj->holder_id = 0;
     target_obj->map_x = actor->map_x;
     target_obj->map_y = actor->map_y;
     target_obj->map_z = actor->map_z;
@@ -198,8 +226,8 @@ int u6_interaction_apply(U6EntityState *state,
   }
 
   if (request->verb == U6_INTERACT_PUT) {
-    U6ObjectState *target_obj = u6_entities_find_object(state, request->target_id);
-    U6ObjectState *container = u6_entities_find_object(state, request->aux_target_id);
+    U6ObjectState *target_obj = resolved->target_obj;
+    U6ObjectState *container = resolved->aux_obj;
     if (target_obj == NULL || container == NULL) {
       out_result->code = U6_INTERACT_ERR_NOT_FOUND;
       return out_result->code;
@@ -212,9 +240,12 @@ int u6_interaction_apply(U6EntityState *state,
       out_result->code = U6_INTERACT_ERR_RANGE;
       return out_result->code;
     }
+    /* Refuses to nest a container inside its own contents. */
+    if (u6_entities_set_holder(state, target_obj->object_id, U6_OBJECT_HOLDER_OBJECT, container->object_id) != 0) {
+      out_result->code = U6_INTERACT_ERR_BLOCKED;
+      return out_result->code;
+    }
     target_obj->status = u6_obj_status_to_contained(target_obj->status);
-    target_obj->holder_kind = U6_OBJECT_HOLDER_OBJECT;
-    target_obj->holder_id = container->object_id;
     target_obj->map_x = container->map_x;
     target_obj->map_y = container->map_y;
     target_obj->map_z = container->map_z;
@@ -225,7 +256,7 @@ int u6_interaction_apply(U6EntityState *state,
   }
 
   if (request->verb == U6_INTERACT_EQUIP) {
-    U6ObjectState *target_obj = u6_entities_find_object(state, request->target_id);
+    U6ObjectState *target_obj = resolved->target_obj;
     if (target_obj == NULL) {
       out_result->code = U6_INTERACT_ERR_NOT_FOUND;
       return out_result->code;
@@ -241,6 +272,7 @@ int u6_interaction_apply(U6EntityState *state,
       return out_result->code;
     }
     target_obj->status = u6_obj_status_to_equip(target_obj->status);
+    u6_entities_touch_object(state, target_obj->object_id);
     out_result->code = U6_INTERACT_OK;
     out_result->event = U6_EVENT_EQUIPPED;
     out_result->affected_id = target_obj->object_id;
@@ -250,3 +282,67 @@ int u6_interaction_apply(U6EntityState *state,
   out_result->code = U6_INTERACT_ERR_INVALID;
   return out_result->code;
 }
+
+int u6_interaction_apply(U6EntityState *state,
+                         const U6InteractionRequest *request,
+                         U6InteractionResult *out_result) {
+  ResolvedRequest resolved;
+
+  if (state == NULL || request == NULL || out_result == NULL) {
+    return U6_INTERACT_ERR_NULL;
+  }
+  resolved.actor = u6_entities_find_npc(state, request->actor_npc_id);
+  resolve_targets(state, request, &resolved);
+  return apply_resolved(state, request, &resolved, out_result);
+}
+
+enum { ACTOR_CACHE_SLOTS = 32 };
+
+int u6_interaction_apply_batch(U6EntityState *state,
+                               const U6InteractionRequest *requests,
+                               size_t count,
+                               U6InteractionResult *results,
+                               U6InteractionJournal *journal) {
+  ResolvedRequest resolved;
+  uint16_t cached_id[ACTOR_CACHE_SLOTS];
+  U6NpcState *cached_actor[ACTOR_CACHE_SLOTS];
+  uint8_t cached[ACTOR_CACHE_SLOTS];
+  int ok = 0;
+
+  if (state == NULL || (count > 0u && (requests == NULL || results == NULL))) {
+    return U6_INTERACT_ERR_NULL;
+  }
+  if (journal != NULL) {
+    journal->count = 0u;
+  }
+  memset(cached, 0, sizeof(cached));
+  for (size_t i = 0; i < count; i++) {
+    const U6InteractionRequest *request = &requests[i];
+    size_t c = request->actor_npc_id % ACTOR_CACHE_SLOTS;
+
+    /* A busy tick repeats the same few actors; resolve each once. */
+    if (!cached[c] || cached_id[c] != request->actor_npc_id) {
+      cached[c] = 1u;
+      cached_id[c] = request->actor_npc_id;
+      cached_actor[c] = u6_entities_find_npc(state, request->actor_npc_id);
+    }
+    resolved.actor = cached_actor[c];
+    resolve_targets(state, request, &resolved);
+    if (apply_resolved(state, request, &resolved, &results[i]) != U6_INTERACT_OK) {
+      continue;
+    }
+    ok++;
+    if (journal != NULL) {
+      if (journal->count < journal->capacity) {
+        U6InteractionJournalEntry *entry = &journal->entries[journal->count];
+        entry->request_index = (uint32_t)i;
+        entry->event = results[i].event;
+        entry->actor_npc_id = request->actor_npc_id;
+        entry->affected_id = results[i].affected_id;
+        entry->version = u6_entities_version(state);
+      }
+      journal->count++;
+    }
+  }
+  return ok;
+}
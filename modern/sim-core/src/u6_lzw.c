@@ -0,0 +1,346 @@
+#include "u6_lzw.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define U6_LZW_MIN_CODE_SIZE 9u
+#define U6_LZW_MAX_CODE_SIZE 12u
+
+static void reset_dictionary(U6LzwDecoder *dec) {
+  dec->code_size = U6_LZW_MIN_CODE_SIZE;
+  dec->next_code = U6_LZW_FIRST_FREE;
+  dec->has_prev = 0;
+}
+
+void u6_lzw_decoder_init(U6LzwDecoder *dec) {
+  if (dec == NULL) {
+    return;
+  }
+  for (uint16_t i = 0; i < 256u; i++) {
+    dec->prefix[i] = 0;
+    dec->length[i] = 1;
+    dec->suffix[i] = (uint8_t)i;
+    dec->first[i] = (uint8_t)i;
+  }
+  dec->stack_pos = 0;
+  dec->stack_len = 0;
+  dec->bit_buffer = 0;
+  dec->bit_count = 0;
+  dec->prev_code = 0;
+  dec->stopped = 0;
+  reset_dictionary(dec);
+}
+
+/*
+ * Unwinds `code` (plus first[code] again for the KwKwK case) into the stack.
+ * Chains are at most U6_LZW_DICT_SIZE - U6_LZW_FIRST_FREE + 1 long, so the
+ * fixed stack always fits.
+ */
+static void unwind_string(U6LzwDecoder *dec, uint16_t code, int repeat_first) {
+  uint16_t len = dec->length[code];
+  uint16_t c = code;
+
+  if (repeat_first) {
+    dec->stack[len] = dec->first[code];
+  }
+  for (uint16_t i = len; i-- > 0;) {
+    dec->stack[i] = dec->suffix[c];
+    c = dec->prefix[c];
+  }
+  dec->stack_pos = 0;
+  dec->stack_len = (uint16_t)(len + (repeat_first ? 1u : 0u));
+}
+
+static void add_entry(U6LzwDecoder *dec, uint16_t code) {
+  if (dec->has_prev && dec->next_code < U6_LZW_DICT_SIZE) {
+    uint16_t slot = dec->next_code;
+    dec->prefix[slot] = dec->prev_code;
+    dec->suffix[slot] = dec->stack[0];
+    dec->first[slot] = dec->first[dec->prev_code];
+    dec->length[slot] = (uint16_t)(dec->length[dec->prev_code] + 1u);
+    dec->next_code++;
+    if ((dec->next_code == 512u || dec->next_code == 1024u || dec->next_code == 2048u)
+        && dec->code_size < U6_LZW_MAX_CODE_SIZE) {
+      dec->code_size++;
+    }
+  }
+  dec->prev_code = code;
+  dec->has_prev = 1;
+}
+
+int u6_lzw_decoder_feed(U6LzwDecoder *dec,
+                        const uint8_t *in,
+                        size_t in_size,
+                        size_t *in_used,
+                        uint8_t *out,
+                        size_t out_capacity,
+                        size_t *out_written) {
+  size_t used = 0;
+  size_t written = 0;
+  int rc;
+
+  if (dec == NULL || in_used == NULL || out_written == NULL) {
+    return U6_LZW_ERR_NULL;
+  }
+  if ((in == NULL && in_size > 0) || (out == NULL && out_capacity > 0)) {
+    return U6_LZW_ERR_NULL;
+  }
+
+  for (;;) {
+    uint16_t code;
+
+    if (dec->stack_pos < dec->stack_len) {
+      size_t pending = (size_t)(dec->stack_len - dec->stack_pos);
+      size_t room = out_capacity - written;
+      size_t n = pending < room ? pending : room;
+      memcpy(out + written, dec->stack + dec->stack_pos, n);
+      dec->stack_pos = (uint16_t)(dec->stack_pos + n);
+      written += n;
+    }
+    if (written == out_capacity) {
+      rc = U6_LZW_OUTPUT_FULL;
+      break;
+    }
+    if (dec->stopped) {
+      rc = U6_LZW_STOPPED;
+      break;
+    }
+
+    while (dec->bit_count < dec->code_size && used < in_size) {
+      dec->bit_buffer |= (uint32_t)in[used++] << dec->bit_count;
+      dec->bit_count = (uint8_t)(dec->bit_count + 8u);
+    }
+    if (dec->bit_count < dec->code_size) {
+      rc = U6_LZW_OK;
+      break;
+    }
+    code = (uint16_t)(dec->bit_buffer & ((1u << dec->code_size) - 1u));
+    dec->bit_buffer >>= dec->code_size;
+    dec->bit_count = (uint8_t)(dec->bit_count - dec->code_size);
+
+    if (code == U6_LZW_CODE_CLEAR) {
+      reset_dictionary(dec);
+    } else if (code == U6_LZW_CODE_END) {
+      dec->stopped = 1;
+    } else if (code < dec->next_code) {
+      unwind_string(dec, code, 0);
+      add_entry(dec, code);
+    } else if (code == dec->next_code && dec->has_prev) {
+      unwind_string(dec, dec->prev_code, 1);
+      add_entry(dec, code);
+    } else {
+      dec->stopped = 1;
+    }
+  }
+
+  *in_used = used;
+  *out_written = written;
+  return rc;
+}
+
+int u6_lzw_decoded_size(const uint8_t *src, size_t src_size, size_t *out_size) {
+  uint32_t target;
+
+  if (src == NULL || out_size == NULL) {
+    return U6_LZW_ERR_NULL;
+  }
+  if (src_size < U6_LZW_HEADER_SIZE) {
+    return U6_LZW_ERR_HEADER;
+  }
+  target = (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+  if (target == 0) {
+    return U6_LZW_ERR_HEADER;
+  }
+  *out_size = (size_t)target;
+  return U6_LZW_OK;
+}
+
+static int decode_bounded(const uint8_t *payload,
+                          size_t payload_size,
+                          size_t decoded_size,
+                          uint8_t *out,
+                          size_t *out_size) {
+  U6LzwDecoder *dec;
+  size_t used = 0;
+  size_t written = 0;
+
+  dec = (U6LzwDecoder *)malloc(sizeof(*dec));
+  if (dec == NULL) {
+    return U6_LZW_ERR_ALLOC;
+  }
+  u6_lzw_decoder_init(dec);
+  (void)u6_lzw_decoder_feed(dec, payload, payload_size, &used, out, decoded_size, &written);
+  free(dec);
+
+  *out_size = written;
+  return written == decoded_size ? U6_LZW_OK : U6_LZW_ERR_TRUNCATED;
+}
+
+int u6_lzw_decompress(const uint8_t *src,
+                      size_t src_size,
+                      uint8_t *out,
+                      size_t out_capacity,
+                      size_t *out_size) {
+  size_t target = 0;
+  int rc;
+
+  if (src == NULL || out == NULL || out_size == NULL) {
+    return U6_LZW_ERR_NULL;
+  }
+  *out_size = 0;
+  rc = u6_lzw_decoded_size(src, src_size, &target);
+  if (rc != U6_LZW_OK) {
+    return rc;
+  }
+  if (target > out_capacity) {
+    return U6_LZW_ERR_CAPACITY;
+  }
+  return decode_bounded(src + U6_LZW_HEADER_SIZE, src_size - U6_LZW_HEADER_SIZE, target, out, out_size);
+}
+
+int u6_lzw_decompress_known_length(const uint8_t *payload,
+                                   size_t payload_size,
+                                   size_t decoded_size,
+                                   uint8_t *out,
+                                   size_t out_capacity,
+                                   size_t *out_size) {
+  if (payload == NULL || out == NULL || out_size == NULL) {
+    return U6_LZW_ERR_NULL;
+  }
+  *out_size = 0;
+  if (payload_size == 0 || decoded_size == 0 || decoded_size > 0x7fffffffu) {
+    return U6_LZW_ERR_HEADER;
+  }
+  if (decoded_size > out_capacity) {
+    return U6_LZW_ERR_CAPACITY;
+  }
+  return decode_bounded(payload, payload_size, decoded_size, out, out_size);
+}
+
+#define U6_LZW_ENC_HASH_SIZE 8192u
+#define U6_LZW_ENC_EMPTY 0xffffffffu
+
+typedef struct U6LzwEncoder {
+  uint32_t key[U6_LZW_ENC_HASH_SIZE];
+  uint16_t code[U6_LZW_ENC_HASH_SIZE];
+  uint8_t *out;
+  size_t out_capacity;
+  size_t out_pos;
+  uint32_t bit_buffer;
+  uint8_t bit_count;
+} U6LzwEncoder;
+
+static uint32_t encoder_slot(const U6LzwEncoder *enc, uint32_t key) {
+  uint32_t slot = (key * 2654435761u) >> 19;
+  while (enc->key[slot] != U6_LZW_ENC_EMPTY && enc->key[slot] != key) {
+    slot = (slot + 1u) & (U6_LZW_ENC_HASH_SIZE - 1u);
+  }
+  return slot;
+}
+
+static int encoder_put(U6LzwEncoder *enc, uint16_t code, uint8_t code_size) {
+  enc->bit_buffer |= (uint32_t)code << enc->bit_count;
+  enc->bit_count = (uint8_t)(enc->bit_count + code_size);
+  while (enc->bit_count >= 8u) {
+    if (enc->out_pos >= enc->out_capacity) {
+      return -1;
+    }
+    enc->out[enc->out_pos++] = (uint8_t)enc->bit_buffer;
+    enc->bit_buffer >>= 8;
+    enc->bit_count = (uint8_t)(enc->bit_count - 8u);
+  }
+  return 0;
+}
+
+/* Width the decoder will use for the next code, given its next free code. */
+static uint8_t code_size_for(uint16_t decoder_next) {
+  if (decoder_next < 512u) return 9u;
+  if (decoder_next < 1024u) return 10u;
+  if (decoder_next < 2048u) return 11u;
+  return 12u;
+}
+
+size_t u6_lzw_compress_bound(size_t src_size) {
+  return U6_LZW_HEADER_SIZE + (((src_size + 1u) * U6_LZW_MAX_CODE_SIZE + 7u) / 8u) + 1u;
+}
+
+int u6_lzw_compress(const uint8_t *src,
+                    size_t src_size,
+                    uint8_t *out,
+                    size_t out_capacity,
+                    size_t *out_size) {
+  U6LzwEncoder *enc;
+  uint16_t enc_next = U6_LZW_FIRST_FREE;
+  uint16_t dec_next = U6_LZW_FIRST_FREE;
+  uint16_t w;
+  int emitted = 0;
+  int rc = U6_LZW_OK;
+
+  if (src == NULL || out == NULL || out_size == NULL) {
+    return U6_LZW_ERR_NULL;
+  }
+  if (src_size == 0 || src_size > 0xffffffffu) {
+    return U6_LZW_ERR_HEADER;
+  }
+  if (out_capacity < U6_LZW_HEADER_SIZE) {
+    return U6_LZW_ERR_CAPACITY;
+  }
+  enc = (U6LzwEncoder *)malloc(sizeof(*enc));
+  if (enc == NULL) {
+    return U6_LZW_ERR_ALLOC;
+  }
+  memset(enc->key, 0xff, sizeof(enc->key));
+  enc->out = out;
+  enc->out_capacity = out_capacity;
+  enc->out_pos = U6_LZW_HEADER_SIZE;
+  enc->bit_buffer = 0;
+  enc->bit_count = 0;
+  out[0] = (uint8_t)src_size;
+  out[1] = (uint8_t)(src_size >> 8);
+  out[2] = (uint8_t)(src_size >> 16);
+  out[3] = (uint8_t)(src_size >> 24);
+
+  /* The decoder adds its entry one code late, so track its next code apart. */
+  w = src[0];
+  for (size_t i = 1; i <= src_size && rc == U6_LZW_OK; i++) {
+    uint32_t key;
+    uint32_t slot = 0;
+
+    if (i < src_size) {
+      key = ((uint32_t)w << 8) | src[i];
+      slot = encoder_slot(enc, key);
+      if (enc->key[slot] == key) {
+        w = enc->code[slot];
+        continue;
+      }
+    }
+    if (encoder_put(enc, w, code_size_for(dec_next)) != 0) {
+      rc = U6_LZW_ERR_CAPACITY;
+      break;
+    }
+    if (emitted && dec_next < U6_LZW_DICT_SIZE) {
+      dec_next++;
+    }
+    emitted = 1;
+    if (i < src_size) {
+      if (enc_next < U6_LZW_DICT_SIZE) {
+        enc->key[slot] = ((uint32_t)w << 8) | src[i];
+        enc->code[slot] = enc_next++;
+      }
+      w = src[i];
+    }
+  }
+  if (rc == U6_LZW_OK && encoder_put(enc, U6_LZW_CODE_END, code_size_for(dec_next)) != 0) {
+    rc = U6_LZW_ERR_CAPACITY;
+  }
+  if (rc == U6_LZW_OK && enc->bit_count > 0) {
+    if (enc->out_pos >= enc->out_capacity) {
+      rc = U6_LZW_ERR_CAPACITY;
+    } else {
+      enc->out[enc->out_pos++] = (uint8_t)enc->bit_buffer;
+    }
+  }
+  *out_size = rc == U6_LZW_OK ? enc->out_pos : 0;
+  free(enc);
+  return rc;
+}
@@ -0,0 +1,276 @@
+#include "u6_npcpatrol.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define U6_NPCPATROL_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define U6_NPCPATROL_SSE2 1
+#endif
+
+#define U6_NPCPATROL_ALIGN 32u
+#define U6_NPCPATROL_MAX_XY 1023
+#define U6_NPCPATROL_WANT (U6_NPC_FLAG_ACTIVE | U6_NPC_FLAG_PATROL)
+
+static size_t round_up(size_t v, size_t m) {
+  return (v + m - 1u) / m * m;
+}
+
+static void *alloc_column(size_t rows, size_t elem_size) {
+  void *p = aligned_alloc(U6_NPCPATROL_ALIGN, round_up(rows * elem_size, U6_NPCPATROL_ALIGN));
+  if (p != NULL) {
+    memset(p, 0, round_up(rows * elem_size, U6_NPCPATROL_ALIGN));
+  }
+  return p;
+}
+
+int u6_npcpatrol_init(U6NpcPatrolTable *table, size_t capacity) {
+  size_t rows;
+
+  if (table == NULL) {
+    return U6_NPCPATROL_ERR_NULL;
+  }
+  memset(table, 0, sizeof(*table));
+  rows = round_up(capacity > 0 ? capacity : 1u, U6_NPCPATROL_LANES);
+  table->x = (int16_t *)alloc_column(rows, sizeof(int16_t));
+  table->y = (int16_t *)alloc_column(rows, sizeof(int16_t));
+  table->dx = (int8_t *)alloc_column(rows, sizeof(int8_t));
+  table->dy = (int8_t *)alloc_column(rows, sizeof(int8_t));
+  table->flags = (uint8_t *)alloc_column(rows, sizeof(uint8_t));
+  table->npc_slot = (uint16_t *)alloc_column(rows, sizeof(uint16_t));
+  if (table->x == NULL || table->y == NULL || table->dx == NULL || table->dy == NULL || table->flags == NULL
+      || table->npc_slot == NULL) {
+    u6_npcpatrol_free(table);
+    return U6_NPCPATROL_ERR_ALLOC;
+  }
+  table->capacity = capacity;
+  return U6_NPCPATROL_OK;
+}
+
+void u6_npcpatrol_free(U6NpcPatrolTable *table) {
+  if (table == NULL) {
+    return;
+  }
+  free(table->x);
+  free(table->y);
+  free(table->dx);
+  free(table->dy);
+  free(table->flags);
+  free(table->npc_slot);
+  memset(table, 0, sizeof(*table));
+}
+
+int u6_npcpatrol_append(U6NpcPatrolTable *table, const U6NpcState *npc, uint16_t npc_slot) {
+  size_t row;
+
+  if (table == NULL || table->x == NULL || npc == NULL) {
+    return U6_NPCPATROL_ERR_NULL;
+  }
+  if (table->count >= table->capacity) {
+    return U6_NPCPATROL_ERR_FULL;
+  }
+  row = table->count++;
+  table->x[row] = npc->map_x;
+  table->y[row] = npc->map_y;
+  table->dx[row] = npc->patrol_dx;
+  table->dy[row] = npc->patrol_dy;
+  table->flags[row] = npc->flags;
+  table->npc_slot[row] = npc_slot;
+  return U6_NPCPATROL_OK;
+}
+
+int u6_npcpatrol_load(U6NpcPatrolTable *table, const U6EntityState *state) {
+  if (table == NULL || table->x == NULL || state == NULL) {
+    return U6_NPCPATROL_ERR_NULL;
+  }
+  /* Rows left over from a larger load are inert padding from here on. */
+  memset(table->flags, 0, round_up(table->count, U6_NPCPATROL_LANES));
+  table->count = 0;
+  for (size_t i = 0; i < u6_entities_npc_slots(state); i++) {
+    const U6NpcState *npc = u6_entities_npc_at(state, i);
+    int rc;
+    if (npc == NULL) {
+      continue;
+    }
+    rc = u6_npcpatrol_append(table, npc, (uint16_t)i);
+    if (rc != U6_NPCPATROL_OK) {
+      return rc;
+    }
+  }
+  return U6_NPCPATROL_OK;
+}
+
+int u6_npcpatrol_store(const U6NpcPatrolTable *table, U6EntityState *state) {
+  if (table == NULL || state == NULL) {
+    return U6_NPCPATROL_ERR_NULL;
+  }
+  for (size_t row = 0; row < table->count; row++) {
+    U6NpcState *npc = u6_entities_npc_at(state, table->npc_slot[row]);
+    if (npc == NULL) {
+      continue;
+    }
+    if (npc->map_x == table->x[row] && npc->map_y == table->y[row] && npc->patrol_dx == table->dx[row]
+        && npc->patrol_dy == table->dy[row]) {
+      continue;
+    }
+    npc->map_x = table->x[row];
+    npc->map_y = table->y[row];
+    npc->patrol_dx = table->dx[row];
+    npc->patrol_dy = table->dy[row];
+    u6_entities_touch_npc(state, npc->npc_id);
+  }
+  return U6_NPCPATROL_OK;
+}
+
+static int16_t clamp_xy(int32_t v) {
+  if (v < 0) {
+    return 0;
+  }
+  if (v > U6_NPCPATROL_MAX_XY) {
+    return U6_NPCPATROL_MAX_XY;
+  }
+  return (int16_t)v;
+}
+
+/* Same branches as u6_entities_step, one row at a time. */
+void u6_npcpatrol_step_scalar(U6NpcPatrolTable *table, uint32_t tick) {
+  if (table == NULL || (tick % 4u) != 0u) {
+    return;
+  }
+  for (size_t i = 0; i < table->count; i++) {
+    int32_t next_x;
+    int32_t next_y;
+
+    if ((table->flags[i] & U6_NPCPATROL_WANT) != U6_NPCPATROL_WANT) {
+      continue;
+    }
+    next_x = (int32_t)table->x[i] + table->dx[i];
+    next_y = (int32_t)table->y[i] + table->dy[i];
+    if (next_x < 0 || next_x > U6_NPCPATROL_MAX_XY) {
+      table->dx[i] = (int8_t)(-table->dx[i]);
+      next_x = (int32_t)table->x[i] + table->dx[i];
+    }
+    if (next_y < 0 || next_y > U6_NPCPATROL_MAX_XY) {
+      table->dy[i] = (int8_t)(-table->dy[i]);
+      next_y = (int32_t)table->y[i] + table->dy[i];
+    }
+    table->x[i] = clamp_xy(next_x);
+    table->y[i] = clamp_xy(next_y);
+  }
+}
+
+const char *u6_npcpatrol_kernel_name(void) {
+#if defined(U6_NPCPATROL_AVX2)
+  return "avx2";
+#elif defined(U6_NPCPATROL_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+/*
+ * Vector kernels work in 16-bit lanes. Saturating adds are exact here: a
+ * sum that saturates is out of 0..1023 either way, so it bounces and clamps
+ * to the same bound as the 32-bit scalar sum. Negation wraps to int8 (so
+ * -128 stays -128, as the scalar cast does) before the delta is reused.
+ */
+#if defined(U6_NPCPATROL_AVX2)
+static __m256i step_axis_avx2(__m256i pos, __m256i *delta, __m256i active) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i max_xy = _mm256_set1_epi16(U6_NPCPATROL_MAX_XY);
+  __m256i next = _mm256_adds_epi16(pos, *delta);
+  __m256i out = _mm256_or_si256(_mm256_cmpgt_epi16(zero, next), _mm256_cmpgt_epi16(next, max_xy));
+  __m256i flip = _mm256_and_si256(out, active);
+  __m256i neg = _mm256_srai_epi16(_mm256_slli_epi16(_mm256_sub_epi16(zero, *delta), 8), 8);
+
+  *delta = _mm256_blendv_epi8(*delta, neg, flip);
+  next = _mm256_adds_epi16(pos, *delta);
+  next = _mm256_min_epi16(_mm256_max_epi16(next, zero), max_xy);
+  return _mm256_blendv_epi8(pos, next, active);
+}
+
+static __m128i narrow_i16_avx2(__m256i v) {
+  return _mm_packs_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+void u6_npcpatrol_step(U6NpcPatrolTable *table, uint32_t tick) {
+  const __m256i want = _mm256_set1_epi16(U6_NPCPATROL_WANT);
+  size_t rows;
+
+  if (table == NULL || (tick % 4u) != 0u) {
+    return;
+  }
+  rows = round_up(table->count, 16u);
+  for (size_t i = 0; i < rows; i += 16u) {
+    __m256i f = _mm256_cvtepu8_epi16(_mm_load_si128((const __m128i *)(table->flags + i)));
+    __m256i active = _mm256_cmpeq_epi16(_mm256_and_si256(f, want), want);
+    __m256i dx = _mm256_cvtepi8_epi16(_mm_load_si128((const __m128i *)(table->dx + i)));
+    __m256i dy = _mm256_cvtepi8_epi16(_mm_load_si128((const __m128i *)(table->dy + i)));
+    __m256i x = _mm256_load_si256((const __m256i *)(table->x + i));
+    __m256i y = _mm256_load_si256((const __m256i *)(table->y + i));
+
+    x = step_axis_avx2(x, &dx, active);
+    y = step_axis_avx2(y, &dy, active);
+    _mm256_store_si256((__m256i *)(table->x + i), x);
+    _mm256_store_si256((__m256i *)(table->y + i), y);
+    _mm_store_si128((__m128i *)(table->dx + i), narrow_i16_avx2(dx));
+    _mm_store_si128((__m128i *)(table->dy + i), narrow_i16_avx2(dy));
+  }
+}
+#elif defined(U6_NPCPATROL_SSE2)
+static __m128i select_sse2(__m128i mask, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static __m128i widen_i8_sse2(__m128i v) {
+  return _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+}
+
+static __m128i step_axis_sse2(__m128i pos, __m128i *delta, __m128i active) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max_xy = _mm_set1_epi16(U6_NPCPATROL_MAX_XY);
+  __m128i next = _mm_adds_epi16(pos, *delta);
+  __m128i out = _mm_or_si128(_mm_cmpgt_epi16(zero, next), _mm_cmpgt_epi16(next, max_xy));
+  __m128i flip = _mm_and_si128(out, active);
+  __m128i neg = _mm_srai_epi16(_mm_slli_epi16(_mm_sub_epi16(zero, *delta), 8), 8);
+
+  *delta = select_sse2(flip, neg, *delta);
+  next = _mm_adds_epi16(pos, *delta);
+  next = _mm_min_epi16(_mm_max_epi16(next, zero), max_xy);
+  return select_sse2(active, next, pos);
+}
+
+void u6_npcpatrol_step(U6NpcPatrolTable *table, uint32_t tick) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i want = _mm_set1_epi16(U6_NPCPATROL_WANT);
+  size_t rows;
+
+  if (table == NULL || (tick % 4u) != 0u) {
+    return;
+  }
+  rows = round_up(table->count, 8u);
+  for (size_t i = 0; i < rows; i += 8u) {
+    __m128i f = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(table->flags + i)), zero);
+    __m128i active = _mm_cmpeq_epi16(_mm_and_si128(f, want), want);
+    __m128i dx = widen_i8_sse2(_mm_loadl_epi64((const __m128i *)(table->dx + i)));
+    __m128i dy = widen_i8_sse2(_mm_loadl_epi64((const __m128i *)(table->dy + i)));
+    __m128i x = _mm_load_si128((const __m128i *)(table->x + i));
+    __m128i y = _mm_load_si128((const __m128i *)(table->y + i));
+
+    x = step_axis_sse2(x, &dx, active);
+    y = step_axis_sse2(y, &dy, active);
+    _mm_store_si128((__m128i *)(table->x + i), x);
+    _mm_store_si128((__m128i *)(table->y + i), y);
+    _mm_storel_epi64((__m128i *)(table->dx + i), _mm_packs_epi16(dx, dx));
+    _mm_storel_epi64((__m128i *)(table->dy + i), _mm_packs_epi16(dy, dy));
+  }
+}
+#else
+void u6_npcpatrol_step(U6NpcPatrolTable *table, uint32_t tick) {
+  u6_npcpatrol_step_scalar(table, tick);
+}
+#endif
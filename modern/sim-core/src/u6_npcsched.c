@@ -0,0 +1,203 @@
+#include "u6_npcsched.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define WHEEL_MASK (U6_NPCSCHED_WHEEL_SLOTS - 1u)
+
+int u6_npcsched_init(U6NpcScheduler *sched, size_t capacity, uint32_t now) {
+  if (sched == NULL) {
+    return U6_NPCSCHED_ERR_NULL;
+  }
+  memset(sched, 0, sizeof(*sched));
+  if (capacity > 0xffffu) {
+    return U6_NPCSCHED_ERR_RANGE;
+  }
+  if (capacity > 0) {
+    sched->run = (uint16_t *)calloc(capacity, sizeof(uint16_t));
+    sched->run_pos = (uint16_t *)calloc(capacity, sizeof(uint16_t));
+    sched->wake_tick = (uint32_t *)calloc(capacity, sizeof(uint32_t));
+    sched->wheel_next = (uint16_t *)calloc(capacity, sizeof(uint16_t));
+    sched->wheel_prev = (uint16_t *)calloc(capacity, sizeof(uint16_t));
+    sched->mode = (uint8_t *)calloc(capacity, sizeof(uint8_t));
+    if (sched->run == NULL || sched->run_pos == NULL || sched->wake_tick == NULL || sched->wheel_next == NULL
+        || sched->wheel_prev == NULL || sched->mode == NULL) {
+      u6_npcsched_free(sched);
+      return U6_NPCSCHED_ERR_ALLOC;
+    }
+  }
+  sched->capacity = capacity;
+  sched->now = now;
+  return U6_NPCSCHED_OK;
+}
+
+void u6_npcsched_free(U6NpcScheduler *sched) {
+  if (sched == NULL) {
+    return;
+  }
+  free(sched->run);
+  free(sched->run_pos);
+  free(sched->wake_tick);
+  free(sched->wheel_next);
+  free(sched->wheel_prev);
+  free(sched->mode);
+  memset(sched, 0, sizeof(*sched));
+}
+
+static void run_remove(U6NpcScheduler *sched, uint16_t slot) {
+  uint16_t pos = sched->run_pos[slot];
+  uint16_t last = sched->run[sched->run_count - 1u];
+
+  sched->run[pos] = last;
+  sched->run_pos[last] = pos;
+  sched->run_count--;
+}
+
+static void run_push(U6NpcScheduler *sched, uint16_t slot) {
+  sched->run_pos[slot] = (uint16_t)sched->run_count;
+  sched->run[sched->run_count++] = slot;
+  sched->mode[slot] = U6_NPCSCHED_RUNNING;
+}
+
+static void wheel_remove(U6NpcScheduler *sched, uint16_t slot) {
+  uint16_t next = sched->wheel_next[slot];
+  uint16_t prev = sched->wheel_prev[slot];
+
+  if (prev != 0u) {
+    sched->wheel_next[prev - 1u] = next;
+  } else {
+    sched->wheel_head[sched->wake_tick[slot] & WHEEL_MASK] = next;
+  }
+  if (next != 0u) {
+    sched->wheel_prev[next - 1u] = prev;
+  }
+  sched->wheel_next[slot] = 0u;
+  sched->wheel_prev[slot] = 0u;
+  sched->sleeping--;
+}
+
+static void detach(U6NpcScheduler *sched, uint16_t slot) {
+  if (sched->mode[slot] == U6_NPCSCHED_RUNNING) {
+    run_remove(sched, slot);
+  } else if (sched->mode[slot] == U6_NPCSCHED_SLEEPING) {
+    wheel_remove(sched, slot);
+  }
+  sched->mode[slot] = U6_NPCSCHED_IDLE;
+}
+
+/* Wrap-safe "a is at or before b" for the 32-bit tick counter. */
+static int tick_due(uint32_t a, uint32_t b) {
+  return (int32_t)(a - b) <= 0;
+}
+
+int u6_npcsched_activate(U6NpcScheduler *sched, uint16_t slot) {
+  if (sched == NULL) {
+    return U6_NPCSCHED_ERR_NULL;
+  }
+  if (slot >= sched->capacity) {
+    return U6_NPCSCHED_ERR_RANGE;
+  }
+  if (sched->mode[slot] != U6_NPCSCHED_RUNNING) {
+    detach(sched, slot);
+    run_push(sched, slot);
+  }
+  return U6_NPCSCHED_OK;
+}
+
+int u6_npcsched_deactivate(U6NpcScheduler *sched, uint16_t slot) {
+  if (sched == NULL) {
+    return U6_NPCSCHED_ERR_NULL;
+  }
+  if (slot >= sched->capacity) {
+    return U6_NPCSCHED_ERR_RANGE;
+  }
+  detach(sched, slot);
+  return U6_NPCSCHED_OK;
+}
+
+int u6_npcsched_sleep_until(U6NpcScheduler *sched, uint16_t slot, uint32_t wake_tick) {
+  uint32_t bucket;
+
+  if (sched == NULL) {
+    return U6_NPCSCHED_ERR_NULL;
+  }
+  if (slot >= sched->capacity) {
+    return U6_NPCSCHED_ERR_RANGE;
+  }
+  if (tick_due(wake_tick, sched->now)) {
+    return u6_npcsched_activate(sched, slot);
+  }
+  detach(sched, slot);
+  bucket = wake_tick & WHEEL_MASK;
+  sched->wake_tick[slot] = wake_tick;
+  sched->wheel_prev[slot] = 0u;
+  sched->wheel_next[slot] = sched->wheel_head[bucket];
+  if (sched->wheel_head[bucket] != 0u) {
+    sched->wheel_prev[sched->wheel_head[bucket] - 1u] = (uint16_t)(slot + 1u);
+  }
+  sched->wheel_head[bucket] = (uint16_t)(slot + 1u);
+  sched->mode[slot] = U6_NPCSCHED_SLEEPING;
+  sched->sleeping++;
+  return U6_NPCSCHED_OK;
+}
+
+int u6_npcsched_mode(const U6NpcScheduler *sched, uint16_t slot) {
+  if (sched == NULL || slot >= sched->capacity) {
+    return U6_NPCSCHED_IDLE;
+  }
+  return sched->mode[slot];
+}
+
+static void wake_bucket(U6NpcScheduler *sched, uint32_t bucket, uint32_t tick) {
+  uint16_t node = sched->wheel_head[bucket];
+
+  while (node != 0u) {
+    uint16_t slot = (uint16_t)(node - 1u);
+    node = sched->wheel_next[slot];
+    if (tick_due(sched->wake_tick[slot], tick)) {
+      wheel_remove(sched, slot);
+      run_push(sched, slot);
+    }
+  }
+}
+
+size_t u6_npcsched_advance(U6NpcScheduler *sched, uint32_t tick) {
+  uint32_t steps;
+
+  if (sched == NULL) {
+    return 0;
+  }
+  if (tick_due(tick, sched->now)) {
+    return sched->run_count;
+  }
+  steps = tick - sched->now;
+  if (steps > U6_NPCSCHED_WHEEL_SLOTS) {
+    steps = U6_NPCSCHED_WHEEL_SLOTS;
+  }
+  /* Later wheel turns stay put: wake_bucket only takes entries due by tick. */
+  for (uint32_t i = 1; i <= steps && sched->sleeping > 0u; i++) {
+    wake_bucket(sched, (tick - steps + i) & WHEEL_MASK, tick);
+  }
+  sched->now = tick;
+  return sched->run_count;
+}
+
+int u6_npcsched_sync_patrol(U6NpcScheduler *sched, const U6EntityState *state) {
+  const uint8_t want = U6_NPC_FLAG_ACTIVE | U6_NPC_FLAG_PATROL;
+
+  if (sched == NULL || state == NULL) {
+    return U6_NPCSCHED_ERR_NULL;
+  }
+  if (u6_entities_npc_slots(state) > sched->capacity) {
+    return U6_NPCSCHED_ERR_RANGE;
+  }
+  for (size_t i = 0; i < u6_entities_npc_slots(state); i++) {
+    const U6NpcState *npc = u6_entities_npc_at(state, i);
+    if (npc != NULL && (npc->flags & want) == want) {
+      u6_npcsched_activate(sched, (uint16_t)i);
+    } else {
+      u6_npcsched_deactivate(sched, (uint16_t)i);
+    }
+  }
+  return U6_NPCSCHED_OK;
+}
@@ -1,9 +1,17 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "u6_objblk.h"
 #include "u6_objstatus.h"
 
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define U6_OBJ_STATUS_0010 0x10u
 
@@ -37,13 +45,34 @@ uint16_t u6_objblk_shape_type_get_frame(uint16_t shape_type) {
   return (uint16_t)(shape_type >> 10);
 }
 
+static size_t packed_record_count(const uint8_t *bytes, size_t bytes_size) {
+  size_t file_count = read_u16_le(bytes);
+  size_t max_by_size = (bytes_size - 2) / U6_OBJBLK_RECORD_SIZE;
+
+  if (file_count > U6_OBJBLK_MAX_RECORDS) {
+    file_count = U6_OBJBLK_MAX_RECORDS;
+  }
+  return file_count < max_by_size ? file_count : max_by_size;
+}
+
+static void decode_record(const uint8_t *rec, uint16_t area_id, uint16_t index, U6ObjBlkRecord *out) {
+  uint16_t shape_type = read_u16_le(rec + 4);
+
+  out->status = rec[0];
+  decode_coord(rec + 1, &out->x, &out->y, &out->z);
+  out->shape_type = shape_type;
+  out->amount = read_u16_le(rec + 6);
+  out->obj_type = u6_objblk_shape_type_get_type(shape_type);
+  out->obj_frame = u6_objblk_shape_type_get_frame(shape_type);
+  out->source_area = area_id;
+  out->source_index = index;
+}
+
 int u6_objblk_parse_records(const uint8_t *bytes,
                             size_t bytes_size,
                             U6ObjBlkRecord *out_records,
                             size_t out_capacity,
                             size_t *out_count) {
-  uint16_t file_count;
-  size_t max_by_size;
   size_t n;
 
   if (bytes == NULL || out_count == NULL) {
@@ -56,112 +85,279 @@ int u6_objblk_parse_records(const uint8_t *bytes,
     return -2;
   }
 
-  file_count = read_u16_le(bytes);
-  if (file_count > U6_OBJBLK_MAX_RECORDS) {
-    file_count = U6_OBJBLK_MAX_RECORDS;
-  }
-  max_by_size = (bytes_size - 2) / U6_OBJBLK_RECORD_SIZE;
-  n = file_count;
-  if (n > max_by_size) {
-    n = max_by_size;
-  }
+  n = packed_record_count(bytes, bytes_size);
   if (n > out_capacity) {
     return -3;
   }
 
   for (size_t i = 0; i < n; i++) {
-    const uint8_t *rec = bytes + 2 + (i * U6_OBJBLK_RECORD_SIZE);
-    U6ObjBlkRecord *out = &out_records[i];
-    uint16_t shape_type = read_u16_le(rec + 4);
-
-    out->status = rec[0];
-    decode_coord(rec + 1, &out->x, &out->y, &out->z);
-    out->shape_type = shape_type;
-    out->amount = read_u16_le(rec + 6);
-    out->obj_type = u6_objblk_shape_type_get_type(shape_type);
-    out->obj_frame = u6_objblk_shape_type_get_frame(shape_type);
-    out->source_area = 0;
-    out->source_index = (uint16_t)i;
+    decode_record(bytes + 2 + (i * U6_OBJBLK_RECORD_SIZE), 0, (uint16_t)i, &out_records[i]);
   }
 
   *out_count = n;
   return 0;
 }
 
-static int load_one_objblk(const char *path,
+int u6_objblk_parse_locxyz(const uint8_t *bytes,
+                           size_t bytes_size,
                            uint16_t area_id,
                            U6ObjBlkRecord *out_records,
                            size_t out_capacity,
-                           size_t *io_count,
-                           int *out_loaded_file) {
-  FILE *fp;
-  long szl;
-  size_t sz;
-  uint8_t *buf;
-  size_t parsed = 0;
-  int rc;
+                           size_t *io_count) {
+  size_t n;
+  size_t count;
 
-  *out_loaded_file = 0;
-  fp = fopen(path, "rb");
-  if (fp == NULL) {
-    return 0;
+  if (bytes == NULL || io_count == NULL) {
+    return -1;
   }
-
-  if (fseek(fp, 0, SEEK_END) != 0) {
-    fclose(fp);
-    return -2;
+  if (out_records == NULL && out_capacity > 0) {
+    return -1;
   }
-  szl = ftell(fp);
-  if (szl < 0) {
-    fclose(fp);
+  if (bytes_size < 2) {
     return -2;
   }
-  if (fseek(fp, 0, SEEK_SET) != 0) {
-    fclose(fp);
-    return -2;
+
+  n = packed_record_count(bytes, bytes_size);
+  count = *io_count;
+  for (size_t i = 0; i < n; i++) {
+    const uint8_t *rec = bytes + 2 + (i * U6_OBJBLK_RECORD_SIZE);
+    if (!u6_objblk_is_locxyz(rec[0])) {
+      continue;
+    }
+    if (count >= out_capacity) {
+      *io_count = count;
+      return -3;
+    }
+    decode_record(rec, area_id, (uint16_t)i, &out_records[count]);
+    count++;
   }
 
-  sz = (size_t)szl;
-  buf = (uint8_t *)malloc(sz > 0 ? sz : 1);
-  if (buf == NULL) {
-    fclose(fp);
+  *io_count = count;
+  return 0;
+}
+
+static void write_u16_le(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)(v & 0xffu);
+  p[1] = (uint8_t)(v >> 8);
+}
+
+size_t u6_objblk_encoded_size(size_t count) {
+  return 2 + (count * U6_OBJBLK_RECORD_SIZE);
+}
+
+int u6_objblk_encode_records(const U6ObjBlkRecord *records,
+                             size_t count,
+                             uint8_t *out_bytes,
+                             size_t out_capacity,
+                             size_t *out_size) {
+  if (out_bytes == NULL || out_size == NULL || (records == NULL && count > 0)) {
+    return -1;
+  }
+  if (count > U6_OBJBLK_MAX_RECORDS) {
     return -4;
   }
-  if (sz > 0 && fread(buf, 1, sz, fp) != sz) {
-    free(buf);
-    fclose(fp);
-    return -2;
+  if (out_capacity < u6_objblk_encoded_size(count)) {
+    return -3;
   }
-  fclose(fp);
-  *out_loaded_file = 1;
 
-  {
-    U6ObjBlkRecord tmp[U6_OBJBLK_MAX_RECORDS];
-    size_t tmp_count = 0;
-    rc = u6_objblk_parse_records(buf, sz, tmp, U6_OBJBLK_MAX_RECORDS, &tmp_count);
-    free(buf);
-    if (rc != 0) {
-      return rc;
+  write_u16_le(out_bytes, (uint16_t)count);
+  for (size_t i = 0; i < count; i++) {
+    const U6ObjBlkRecord *r = &records[i];
+    uint8_t *rec = out_bytes + 2 + (i * U6_OBJBLK_RECORD_SIZE);
+    if (r->x > U6_OBJBLK_KEY_MAX_XY || r->y > U6_OBJBLK_KEY_MAX_XY || r->z > U6_OBJBLK_KEY_MAX_Z
+        || r->obj_type > 0x03ffu || r->obj_frame > 0x3fu) {
+      return -4;
     }
-    for (size_t i = 0; i < tmp_count; i++) {
-      if (!u6_objblk_is_locxyz(tmp[i].status)) {
-        continue;
-      }
-      if (*io_count >= out_capacity) {
-        return -3;
-      }
-      out_records[*io_count] = tmp[i];
-      out_records[*io_count].source_area = area_id;
-      out_records[*io_count].source_index = (uint16_t)i;
-      (*io_count)++;
-      parsed++;
+    rec[0] = r->status;
+    rec[1] = (uint8_t)(r->x & 0xffu);
+    rec[2] = (uint8_t)((r->x >> 8) | ((r->y & 0x3fu) << 2));
+    rec[3] = (uint8_t)((r->y >> 6) | (r->z << 4));
+    write_u16_le(rec + 4, (uint16_t)(r->obj_type | (r->obj_frame << 10)));
+    write_u16_le(rec + 6, r->amount);
+  }
+  *out_size = u6_objblk_encoded_size(count);
+  return 0;
+}
+
+uint64_t u6_objblk_records_hash(const U6ObjBlkRecord *records, size_t count) {
+  uint64_t h = 1469598103934665603ull;
+
+  if (records == NULL) {
+    return h;
+  }
+  for (size_t i = 0; i < count; i++) {
+    const U6ObjBlkRecord *r = &records[i];
+    uint32_t fields[4];
+    fields[0] = (uint32_t)r->status | ((uint32_t)r->z << 8) | ((uint32_t)r->x << 16);
+    fields[1] = (uint32_t)r->y | ((uint32_t)r->obj_type << 16);
+    fields[2] = (uint32_t)r->obj_frame | ((uint32_t)r->amount << 16);
+    fields[3] = 0x9e3779b9u;
+    for (size_t f = 0; f < 4u; f++) {
+      h ^= fields[f];
+      h *= 1099511628211ull;
     }
   }
+  return h;
+}
 
-  (void)parsed;
+int u6_objblk_write_file(const char *path, const U6ObjBlkRecord *records, size_t count) {
+  char tmp_path[1024];
+  uint8_t *bytes;
+  size_t size = 0;
+  int n;
+  int fd;
+  int rc;
+
+  if (path == NULL || (records == NULL && count > 0)) {
+    return -1;
+  }
+  if (count > U6_OBJBLK_MAX_RECORDS) {
+    return -4;
+  }
+  n = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+  if (n < 0 || (size_t)n >= sizeof(tmp_path)) {
+    return -2;
+  }
+  bytes = (uint8_t *)malloc(u6_objblk_encoded_size(count));
+  if (bytes == NULL) {
+    return -5;
+  }
+  rc = u6_objblk_encode_records(records, count, bytes, u6_objblk_encoded_size(count), &size);
+  if (rc != 0) {
+    free(bytes);
+    return rc;
+  }
+
+  fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    free(bytes);
+    return -2;
+  }
+  for (size_t off = 0; off < size;) {
+    ssize_t w = write(fd, bytes + off, size - off);
+    if (w <= 0) {
+      rc = -2;
+      break;
+    }
+    off += (size_t)w;
+  }
+  free(bytes);
+  if (rc == 0 && fsync(fd) != 0) {
+    rc = -2;
+  }
+  if (close(fd) != 0 && rc == 0) {
+    rc = -2;
+  }
+  if (rc == 0 && rename(tmp_path, path) != 0) {
+    rc = -2;
+  }
+  if (rc != 0) {
+    unlink(tmp_path);
+  }
+  return rc;
+}
+
+int u6_objblk_view_init(U6ObjBlkView *view, const uint8_t *bytes, size_t bytes_size) {
+  if (view == NULL || bytes == NULL) {
+    return -1;
+  }
+  if (bytes_size < 2) {
+    return -2;
+  }
+  view->records = bytes + 2;
+  view->count = packed_record_count(bytes, bytes_size);
+  view->source_area = 0;
+  return 0;
+}
+
+uint8_t u6_objblk_view_status(const U6ObjBlkView *view, size_t index) {
+  return view->records[index * U6_OBJBLK_RECORD_SIZE];
+}
+
+int u6_objblk_view_get(const U6ObjBlkView *view, size_t index, U6ObjBlkRecord *out_record) {
+  if (view == NULL || out_record == NULL) {
+    return -1;
+  }
+  if (index >= view->count) {
+    return -3;
+  }
+  decode_record(view->records + (index * U6_OBJBLK_RECORD_SIZE), view->source_area, (uint16_t)index, out_record);
+  return 0;
+}
+
+int u6_objblk_map_file(const char *path, U6ObjBlkMappedFile *out) {
+  static const uint8_t empty_file[1] = {0};
+  struct stat st;
+  void *base;
+  int fd;
+
+  if (path == NULL || out == NULL) {
+    return -1;
+  }
+  memset(out, 0, sizeof(*out));
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return 0;
+  }
+  if (fstat(fd, &st) != 0 || st.st_size < 0) {
+    close(fd);
+    return -2;
+  }
+  out->loaded = 1;
+  if (st.st_size == 0) {
+    close(fd);
+    out->bytes = empty_file;
+    return 0;
+  }
+
+  base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    out->loaded = 0;
+    return -2;
+  }
+  out->bytes = (const uint8_t *)base;
+  out->size = (size_t)st.st_size;
+  out->map_base = base;
   return 0;
 }
 
+void u6_objblk_unmap_file(U6ObjBlkMappedFile *mapped) {
+  if (mapped == NULL) {
+    return;
+  }
+  if (mapped->map_base != NULL) {
+    munmap(mapped->map_base, mapped->size);
+  }
+  memset(mapped, 0, sizeof(*mapped));
+}
+
+static int load_one_objblk(const char *path,
+                           uint16_t area_id,
+                           U6ObjBlkRecord *out_records,
+                           size_t out_capacity,
+                           size_t *io_count,
+                           int *out_loaded_file) {
+  U6ObjBlkMappedFile mapped;
+  int rc;
+
+  rc = u6_objblk_map_file(path, &mapped);
+  *out_loaded_file = mapped.loaded;
+  if (rc != 0 || !mapped.loaded) {
+    return rc;
+  }
+  rc = u6_objblk_parse_locxyz(mapped.bytes, mapped.size, area_id, out_records, out_capacity, io_count);
+  u6_objblk_unmap_file(&mapped);
+  return rc;
+}
+
+static void outdoor_area_path(char *out, size_t out_size, const char *savegame_dir, uint16_t area_id) {
+  int ax = area_id & 7;
+  int ay = (area_id >> 3) & 7;
+  snprintf(out, out_size, "%s/objblk%c%c", savegame_dir, (char)('a' + ax), (char)('a' + ay));
+}
+
 int u6_objblk_load_outdoor_savegame(const char *savegame_dir,
                                     U6ObjBlkRecord *out_records,
                                     size_t out_capacity,
@@ -178,19 +374,16 @@ int u6_objblk_load_outdoor_savegame(const char *savegame_dir,
     return -1;
   }
 
-  for (int ay = 0; ay < 8; ay++) {
-    for (int ax = 0; ax < 8; ax++) {
-      uint16_t area_id = (uint16_t)((ay << 3) | ax);
-      int loaded_file = 0;
-      int rc;
-      snprintf(path, sizeof(path), "%s/objblk%c%c", savegame_dir, (char)('a' + ax), (char)('a' + ay));
-      rc = load_one_objblk(path, area_id, out_records, out_capacity, &count, &loaded_file);
-      if (rc != 0) {
-        return rc;
-      }
-      if (loaded_file) {
-        files_loaded++;
-      }
+  for (uint16_t area_id = 0; area_id < U6_OBJBLK_OUTDOOR_AREAS; area_id++) {
+    int loaded_file = 0;
+    int rc;
+    outdoor_area_path(path, sizeof(path), savegame_dir, area_id);
+    rc = load_one_objblk(path, area_id, out_records, out_capacity, &count, &loaded_file);
+    if (rc != 0) {
+      return rc;
+    }
+    if (loaded_file) {
+      files_loaded++;
     }
   }
 
@@ -199,9 +392,252 @@ int u6_objblk_load_outdoor_savegame(const char *savegame_dir,
   return 0;
 }
 
-static int compare_render_order(const void *lhs, const void *rhs) {
-  const U6ObjBlkRecord *a = (const U6ObjBlkRecord *)lhs;
-  const U6ObjBlkRecord *b = (const U6ObjBlkRecord *)rhs;
+/*
+ * Parallel loader: workers claim areas from a shared cursor and parse each
+ * file into its own slice. Slices are merged on the calling thread in area
+ * order, so output (and the first error reported) matches the serial loader.
+ */
+typedef struct U6ObjBlkAreaSlice {
+  int rc;
+  int loaded_file;
+  U6ObjBlkRecord *records;
+  size_t count;
+} U6ObjBlkAreaSlice;
+
+typedef struct U6ObjBlkParallelJob {
+  const char *savegame_dir;
+  U6ObjBlkAreaSlice slices[U6_OBJBLK_OUTDOOR_AREAS];
+  atomic_uint next_area;
+} U6ObjBlkParallelJob;
+
+static void load_area_slice(const char *savegame_dir, uint16_t area_id, U6ObjBlkAreaSlice *slice) {
+  char path[512];
+  U6ObjBlkMappedFile mapped;
+  size_t capacity;
+
+  outdoor_area_path(path, sizeof(path), savegame_dir, area_id);
+  slice->rc = u6_objblk_map_file(path, &mapped);
+  slice->loaded_file = mapped.loaded;
+  if (slice->rc != 0 || !mapped.loaded) {
+    return;
+  }
+
+  capacity = mapped.size >= 2 ? packed_record_count(mapped.bytes, mapped.size) : 0u;
+  slice->records = (U6ObjBlkRecord *)malloc((capacity > 0 ? capacity : 1) * sizeof(U6ObjBlkRecord));
+  if (slice->records == NULL) {
+    u6_objblk_unmap_file(&mapped);
+    slice->rc = -4;
+    return;
+  }
+  slice->rc = u6_objblk_parse_locxyz(mapped.bytes, mapped.size, area_id, slice->records, capacity, &slice->count);
+  u6_objblk_unmap_file(&mapped);
+}
+
+static void *parallel_load_worker(void *arg) {
+  U6ObjBlkParallelJob *job = (U6ObjBlkParallelJob *)arg;
+  for (;;) {
+    unsigned area_id = atomic_fetch_add(&job->next_area, 1u);
+    if (area_id >= U6_OBJBLK_OUTDOOR_AREAS) {
+      break;
+    }
+    load_area_slice(job->savegame_dir, (uint16_t)area_id, &job->slices[area_id]);
+  }
+  return NULL;
+}
+
+static unsigned default_worker_count(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n < 1) {
+    return 1;
+  }
+  if (n > U6_OBJBLK_MAX_LOAD_WORKERS) {
+    return U6_OBJBLK_MAX_LOAD_WORKERS;
+  }
+  return (unsigned)n;
+}
+
+int u6_objblk_load_outdoor_savegame_parallel(const char *savegame_dir,
+                                             U6ObjBlkRecord *out_records,
+                                             size_t out_capacity,
+                                             size_t *out_count,
+                                             size_t *out_files_loaded,
+                                             unsigned worker_count) {
+  U6ObjBlkParallelJob *job;
+  pthread_t threads[U6_OBJBLK_MAX_LOAD_WORKERS];
+  unsigned started = 0;
+  size_t count = 0;
+  size_t files_loaded = 0;
+  int rc = 0;
+
+  if (savegame_dir == NULL || out_count == NULL || out_files_loaded == NULL) {
+    return -1;
+  }
+  if (out_records == NULL && out_capacity > 0) {
+    return -1;
+  }
+
+  job = (U6ObjBlkParallelJob *)calloc(1, sizeof(*job));
+  if (job == NULL) {
+    return -4;
+  }
+  job->savegame_dir = savegame_dir;
+  atomic_init(&job->next_area, 0u);
+
+  if (worker_count == 0) {
+    worker_count = default_worker_count();
+  }
+  if (worker_count > U6_OBJBLK_MAX_LOAD_WORKERS) {
+    worker_count = U6_OBJBLK_MAX_LOAD_WORKERS;
+  }
+
+  /* The calling thread is worker 0; a failed spawn just leaves it more work. */
+  for (unsigned i = 1; i < worker_count; i++) {
+    if (pthread_create(&threads[started], NULL, parallel_load_worker, job) != 0) {
+      break;
+    }
+    started++;
+  }
+  parallel_load_worker(job);
+  for (unsigned i = 0; i < started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  for (size_t area_id = 0; area_id < U6_OBJBLK_OUTDOOR_AREAS; area_id++) {
+    const U6ObjBlkAreaSlice *slice = &job->slices[area_id];
+    if (slice->rc != 0) {
+      rc = slice->rc;
+      break;
+    }
+    if (!slice->loaded_file) {
+      continue;
+    }
+    if (slice->count > out_capacity - count) {
+      memcpy(out_records + count, slice->records, (out_capacity - count) * sizeof(U6ObjBlkRecord));
+      rc = -3;
+      break;
+    }
+    if (slice->count > 0) {
+      memcpy(out_records + count, slice->records, slice->count * sizeof(U6ObjBlkRecord));
+    }
+    count += slice->count;
+    files_loaded++;
+  }
+
+  for (size_t area_id = 0; area_id < U6_OBJBLK_OUTDOOR_AREAS; area_id++) {
+    free(job->slices[area_id].records);
+  }
+  free(job);
+
+  if (rc != 0) {
+    return rc;
+  }
+  *out_count = count;
+  *out_files_loaded = files_loaded;
+  return 0;
+}
+
+static int preferred_area(const uint8_t *decoded, const U6ObjBlkSegment *seg, uint16_t *out_area, uint32_t *out_count) {
+  uint32_t area_counts[U6_OBJBLK_OUTDOOR_AREAS];
+  int found = 0;
+
+  memset(area_counts, 0, sizeof(area_counts));
+  for (size_t i = 0; i < seg->count; i++) {
+    const uint8_t *rec = decoded + seg->offset + 2 + (i * U6_OBJBLK_RECORD_SIZE);
+    uint16_t x;
+    uint16_t y;
+    uint8_t z;
+    if (!u6_objblk_is_locxyz(rec[0])) {
+      continue;
+    }
+    decode_coord(rec + 1, &x, &y, &z);
+    area_counts[(((y >> 7) & 7u) << 3) | ((x >> 7) & 7u)]++;
+  }
+  for (uint16_t a = 0; a < U6_OBJBLK_OUTDOOR_AREAS; a++) {
+    if (area_counts[a] > 0 && (!found || area_counts[a] > *out_count)) {
+      *out_area = a;
+      *out_count = area_counts[a];
+      found = 1;
+    }
+  }
+  return found;
+}
+
+int u6_objblk_split_lzobjblk(const uint8_t *decoded,
+                             size_t decoded_size,
+                             U6ObjBlkSegment out_segments[U6_OBJBLK_OUTDOOR_AREAS]) {
+  uint16_t pref_area[U6_OBJBLK_OUTDOOR_AREAS];
+  uint32_t pref_count[U6_OBJBLK_OUTDOOR_AREAS];
+  uint8_t has_pref[U6_OBJBLK_OUTDOOR_AREAS];
+  uint8_t assigned[U6_OBJBLK_OUTDOOR_AREAS];
+  uint8_t area_used[U6_OBJBLK_OUTDOOR_AREAS];
+  size_t off = 0;
+  uint16_t next_free = 0;
+
+  if (decoded == NULL || out_segments == NULL) {
+    return -1;
+  }
+
+  for (size_t seg = 0; seg < U6_OBJBLK_OUTDOOR_AREAS; seg++) {
+    size_t count;
+    if (off + 2 > decoded_size) {
+      return -2;
+    }
+    count = read_u16_le(decoded + off);
+    if (count > U6_OBJBLK_MAX_RECORDS) {
+      return -3;
+    }
+    if (off + 2 + (count * U6_OBJBLK_RECORD_SIZE) > decoded_size) {
+      return -2;
+    }
+    out_segments[seg].offset = off;
+    out_segments[seg].size = 2 + (count * U6_OBJBLK_RECORD_SIZE);
+    out_segments[seg].count = (uint16_t)count;
+    out_segments[seg].area_id = 0;
+    pref_count[seg] = 0;
+    has_pref[seg] = (uint8_t)preferred_area(decoded, &out_segments[seg], &pref_area[seg], &pref_count[seg]);
+    off += out_segments[seg].size;
+  }
+  if (off != decoded_size) {
+    return -4;
+  }
+
+  /* Largest claims first (ties by segment order); 64 entries, so selection is fine. */
+  memset(assigned, 0, sizeof(assigned));
+  memset(area_used, 0, sizeof(area_used));
+  for (;;) {
+    int best = -1;
+    for (size_t seg = 0; seg < U6_OBJBLK_OUTDOOR_AREAS; seg++) {
+      if (!has_pref[seg]) {
+        continue;
+      }
+      if (best < 0 || pref_count[seg] > pref_count[best]) {
+        best = (int)seg;
+      }
+    }
+    if (best < 0) {
+      break;
+    }
+    has_pref[best] = 0;
+    if (!area_used[pref_area[best]]) {
+      out_segments[best].area_id = pref_area[best];
+      assigned[best] = 1;
+      area_used[pref_area[best]] = 1;
+    }
+  }
+  for (size_t seg = 0; seg < U6_OBJBLK_OUTDOOR_AREAS; seg++) {
+    if (assigned[seg]) {
+      continue;
+    }
+    while (area_used[next_free]) {
+      next_free++;
+    }
+    out_segments[seg].area_id = next_free;
+    area_used[next_free] = 1;
+  }
+  return 0;
+}
+
+int u6_objblk_compare_render_order(const U6ObjBlkRecord *a, const U6ObjBlkRecord *b) {
   uint8_t a_use = coord_use(a->status);
   uint8_t b_use = coord_use(b->status);
 
@@ -240,7 +676,142 @@ static int compare_render_order(const void *lhs, const void *rhs) {
   return 0;
 }
 
+static int compare_render_order(const void *lhs, const void *rhs) {
+  return u6_objblk_compare_render_order((const U6ObjBlkRecord *)lhs, (const U6ObjBlkRecord *)rhs);
+}
+
+int u6_objblk_render_key_fits(const U6ObjBlkRecord *record) {
+  return record->x <= U6_OBJBLK_KEY_MAX_XY && record->y <= U6_OBJBLK_KEY_MAX_XY && record->z <= U6_OBJBLK_KEY_MAX_Z;
+}
+
+/*
+ * Key layout, most significant first (58 bits used):
+ *   [57] LOCXYZ class  [56:47] y  [46:37] x  [36:33] 15 - z
+ *   [32] !Is_0010      [31:16] source_area  [15:0] source_index
+ * Unsigned key order equals compare_render_order for records that fit.
+ */
+uint64_t u6_objblk_render_key(const U6ObjBlkRecord *record) {
+  uint64_t key = 0;
+
+  key |= (uint64_t)(coord_use(record->status) == U6_OBJ_COORD_USE_LOCXYZ ? 1u : 0u) << 57;
+  key |= (uint64_t)(record->y & U6_OBJBLK_KEY_MAX_XY) << 47;
+  key |= (uint64_t)(record->x & U6_OBJBLK_KEY_MAX_XY) << 37;
+  key |= (uint64_t)(U6_OBJBLK_KEY_MAX_Z - (record->z & U6_OBJBLK_KEY_MAX_Z)) << 33;
+  key |= (uint64_t)(is_status_0010(record->status) ? 0u : 1u) << 32;
+  key |= (uint64_t)record->source_area << 16;
+  key |= (uint64_t)record->source_index;
+  return key;
+}
+
+enum {
+  RENDER_RADIX_BITS = 11,
+  RENDER_RADIX_BUCKETS = 1 << RENDER_RADIX_BITS,
+  RENDER_RADIX_PASSES = (58 + RENDER_RADIX_BITS - 1) / RENDER_RADIX_BITS,
+  RENDER_RADIX_MIN_COUNT = 64
+};
+
+/*
+ * Stable LSD radix sort over render keys. Passes whose digit is constant
+ * across the input are skipped. Returns -1 when scratch allocation fails or
+ * a record falls outside the packed key ranges (caller falls back to qsort).
+ */
+static int radix_sort_for_render(U6ObjBlkRecord *records, size_t count) {
+  size_t (*hist)[RENDER_RADIX_BUCKETS];
+  uint64_t *keys;
+  uint64_t *keys_tmp = NULL;
+  uint32_t *idx;
+  uint32_t *idx_tmp = NULL;
+  U6ObjBlkRecord *sorted;
+  int rc = -1;
+
+  if (count > UINT32_MAX) {
+    return -1;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (!u6_objblk_render_key_fits(&records[i])) {
+      return -1;
+    }
+  }
+
+  hist = calloc(RENDER_RADIX_PASSES, sizeof(*hist));
+  keys = (uint64_t *)malloc(count * sizeof(uint64_t) * 2);
+  idx = (uint32_t *)malloc(count * sizeof(uint32_t) * 2);
+  sorted = (U6ObjBlkRecord *)malloc(count * sizeof(U6ObjBlkRecord));
+  if (hist == NULL || keys == NULL || idx == NULL || sorted == NULL) {
+    goto done;
+  }
+  keys_tmp = keys + count;
+  idx_tmp = idx + count;
+
+  for (size_t i = 0; i < count; i++) {
+    uint64_t key = u6_objblk_render_key(&records[i]);
+    keys[i] = key;
+    idx[i] = (uint32_t)i;
+    for (int p = 0; p < RENDER_RADIX_PASSES; p++) {
+      hist[p][(key >> (p * RENDER_RADIX_BITS)) & (RENDER_RADIX_BUCKETS - 1)]++;
+    }
+  }
+
+  for (int p = 0; p < RENDER_RADIX_PASSES; p++) {
+    size_t *h = hist[p];
+    unsigned shift = (unsigned)(p * RENDER_RADIX_BITS);
+    size_t sum = 0;
+    uint64_t *swap_keys;
+    uint32_t *swap_idx;
+
+    if (h[(keys[0] >> shift) & (RENDER_RADIX_BUCKETS - 1)] == count) {
+      continue;
+    }
+    for (size_t b = 0; b < RENDER_RADIX_BUCKETS; b++) {
+      size_t n = h[b];
+      h[b] = sum;
+      sum += n;
+    }
+    for (size_t i = 0; i < count; i++) {
+      size_t dst = h[(keys[i] >> shift) & (RENDER_RADIX_BUCKETS - 1)]++;
+      keys_tmp[dst] = keys[i];
+      idx_tmp[dst] = idx[i];
+    }
+    swap_keys = keys;
+    keys = keys_tmp;
+    keys_tmp = swap_keys;
+    swap_idx = idx;
+    idx = idx_tmp;
+    idx_tmp = swap_idx;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    sorted[i] = records[idx[i]];
+  }
+  memcpy(records, sorted, count * sizeof(U6ObjBlkRecord));
+  rc = 0;
+
+done:
+  /* keys/idx may point at the upper half after an odd number of passes. */
+  if (keys != NULL && keys_tmp != NULL && keys_tmp < keys) {
+    keys = keys_tmp;
+  }
+  if (idx != NULL && idx_tmp != NULL && idx_tmp < idx) {
+    idx = idx_tmp;
+  }
+  free(sorted);
+  free(idx);
+  free(keys);
+  free(hist);
+  return rc;
+}
+
 void u6_objblk_sort_for_render(U6ObjBlkRecord *records, size_t count) {
+  if (records == NULL || count < 2) {
+    return;
+  }
+  if (count >= RENDER_RADIX_MIN_COUNT && radix_sort_for_render(records, count) == 0) {
+    return;
+  }
+  qsort(records, count, sizeof(U6ObjBlkRecord), compare_render_order);
+}
+
+void u6_objblk_sort_for_render_qsort(U6ObjBlkRecord *records, size_t count) {
   if (records == NULL || count < 2) {
     return;
   }
@@ -0,0 +1,421 @@
+#include "u6_objblk_store.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int valid_area(uint16_t area_id) {
+  return area_id < U6_OBJBLK_STORE_AREAS;
+}
+
+int u6_objblk_store_init(U6ObjBlkStore *store, const char *savegame_dir, size_t max_resident_areas) {
+  size_t len;
+
+  if (store == NULL || savegame_dir == NULL) {
+    return -1;
+  }
+  memset(store, 0, sizeof(*store));
+  len = strlen(savegame_dir);
+  if (len >= sizeof(store->savegame_dir)) {
+    return -2;
+  }
+  memcpy(store->savegame_dir, savegame_dir, len + 1);
+  store->max_resident = max_resident_areas;
+  return 0;
+}
+
+void u6_objblk_store_free(U6ObjBlkStore *store) {
+  if (store == NULL) {
+    return;
+  }
+  u6_objblk_store_evict_all(store);
+  memset(store, 0, sizeof(*store));
+}
+
+uint16_t u6_objblk_store_area_for_position(uint16_t x, uint16_t y, uint8_t z) {
+  if (z == 0) {
+    if (x > U6_OBJBLK_KEY_MAX_XY || y > U6_OBJBLK_KEY_MAX_XY) {
+      return U6_OBJBLK_STORE_NO_AREA;
+    }
+    return (uint16_t)(((y >> 7) << 3) | (x >> 7));
+  }
+  if (z <= U6_OBJBLK_DUNGEON_LEVELS) {
+    return (uint16_t)(U6_OBJBLK_DUNGEON_AREA_BASE + z - 1u);
+  }
+  return U6_OBJBLK_STORE_NO_AREA;
+}
+
+int u6_objblk_store_area_path(const char *savegame_dir, uint16_t area_id, char *out, size_t out_size) {
+  char c0;
+  char c1;
+  int n;
+
+  if (savegame_dir == NULL || out == NULL) {
+    return -1;
+  }
+  if (!valid_area(area_id)) {
+    return -2;
+  }
+  if (area_id < U6_OBJBLK_OUTDOOR_AREAS) {
+    c0 = (char)('a' + (area_id & 7u));
+    c1 = (char)('a' + ((area_id >> 3) & 7u));
+  } else {
+    c0 = (char)('a' + (area_id - U6_OBJBLK_DUNGEON_AREA_BASE));
+    c1 = 'i';
+  }
+  n = snprintf(out, out_size, "%s/objblk%c%c", savegame_dir, c0, c1);
+  if (n < 0 || (size_t)n >= out_size) {
+    return -3;
+  }
+  return 0;
+}
+
+static void release_area(U6ObjBlkStore *store, U6ObjBlkStoreArea *area) {
+  if (area->state == U6_OBJBLK_AREA_RESIDENT) {
+    store->resident_areas--;
+    store->resident_records -= area->count;
+  }
+  if (area->dirty) {
+    store->dirty_areas--;
+    area->dirty = 0;
+  }
+  free(area->records);
+  area->records = NULL;
+  area->count = 0;
+  area->state = U6_OBJBLK_AREA_UNLOADED;
+}
+
+static void drop_area(U6ObjBlkStore *store, U6ObjBlkStoreArea *area) {
+  /* Unsaved edits are discarded, so the file is the area's content again. */
+  if (area->dirty) {
+    area->hash_valid = 0;
+  }
+  release_area(store, area);
+}
+
+/* Parses an area file; a missing file sets *out_missing and no records. */
+static int read_area_file(const U6ObjBlkStore *store,
+                          uint16_t area_id,
+                          U6ObjBlkRecord **out_records,
+                          size_t *out_count,
+                          int *out_missing) {
+  U6ObjBlkMappedFile mapped;
+  U6ObjBlkRecord *records = NULL;
+  char path[U6_OBJBLK_STORE_PATH_MAX + 16];
+  size_t count = 0;
+  int rc;
+
+  *out_records = NULL;
+  *out_count = 0;
+  *out_missing = 0;
+  rc = u6_objblk_store_area_path(store->savegame_dir, area_id, path, sizeof(path));
+  if (rc != 0) {
+    return rc;
+  }
+  rc = u6_objblk_map_file(path, &mapped);
+  if (rc != 0) {
+    return rc;
+  }
+  if (!mapped.loaded) {
+    *out_missing = 1;
+    return 0;
+  }
+
+  if (mapped.size >= 2) {
+    records = (U6ObjBlkRecord *)malloc(U6_OBJBLK_MAX_RECORDS * sizeof(U6ObjBlkRecord));
+    if (records == NULL) {
+      u6_objblk_unmap_file(&mapped);
+      return -5;
+    }
+    rc = u6_objblk_parse_records(mapped.bytes, mapped.size, records, U6_OBJBLK_MAX_RECORDS, &count);
+    if (rc != 0) {
+      free(records);
+      u6_objblk_unmap_file(&mapped);
+      return rc;
+    }
+    for (size_t i = 0; i < count; i++) {
+      records[i].source_area = area_id;
+    }
+    /* Trim the worst-case buffer down to what the file holds. */
+    if (count < U6_OBJBLK_MAX_RECORDS) {
+      U6ObjBlkRecord *shrunk = (U6ObjBlkRecord *)realloc(records, (count > 0 ? count : 1) * sizeof(U6ObjBlkRecord));
+      if (shrunk != NULL) {
+        records = shrunk;
+      }
+    }
+  }
+  u6_objblk_unmap_file(&mapped);
+  *out_records = records;
+  *out_count = count;
+  return 0;
+}
+
+static int load_area(U6ObjBlkStore *store, uint16_t area_id) {
+  U6ObjBlkStoreArea *area = &store->areas[area_id];
+  U6ObjBlkRecord *records;
+  size_t count;
+  int missing;
+  int rc;
+
+  rc = read_area_file(store, area_id, &records, &count, &missing);
+  if (rc != 0) {
+    return rc;
+  }
+  if (missing) {
+    area->state = U6_OBJBLK_AREA_MISSING;
+    return 0;
+  }
+  /* A cached hash from an earlier residency still describes the file. */
+  area->records = records;
+  area->count = count;
+  area->state = U6_OBJBLK_AREA_RESIDENT;
+  store->resident_areas++;
+  store->resident_records += count;
+  store->loads++;
+  return 0;
+}
+
+static void evict_cold(U6ObjBlkStore *store, uint16_t keep_area) {
+  while (store->max_resident > 0 && store->resident_areas > store->max_resident) {
+    uint16_t victim = U6_OBJBLK_STORE_NO_AREA;
+    for (uint16_t a = 0; a < U6_OBJBLK_STORE_AREAS; a++) {
+      const U6ObjBlkStoreArea *area = &store->areas[a];
+      if (a == keep_area || area->state != U6_OBJBLK_AREA_RESIDENT || area->dirty) {
+        continue;
+      }
+      if (victim == U6_OBJBLK_STORE_NO_AREA || area->last_access < store->areas[victim].last_access) {
+        victim = a;
+      }
+    }
+    if (victim == U6_OBJBLK_STORE_NO_AREA) {
+      return;
+    }
+    drop_area(store, &store->areas[victim]);
+    store->evictions++;
+  }
+}
+
+int u6_objblk_store_get(U6ObjBlkStore *store,
+                        uint16_t area_id,
+                        const U6ObjBlkRecord **out_records,
+                        size_t *out_count) {
+  U6ObjBlkStoreArea *area;
+  int rc;
+
+  if (store == NULL || out_records == NULL || out_count == NULL) {
+    return -1;
+  }
+  if (!valid_area(area_id)) {
+    return -2;
+  }
+  area = &store->areas[area_id];
+  if (area->state == U6_OBJBLK_AREA_UNLOADED) {
+    rc = load_area(store, area_id);
+    if (rc != 0) {
+      return rc;
+    }
+  }
+  area->last_access = ++store->access_clock;
+  evict_cold(store, area_id);
+
+  *out_records = area->records;
+  *out_count = area->count;
+  return 0;
+}
+
+int u6_objblk_store_get_at(U6ObjBlkStore *store,
+                           uint16_t x,
+                           uint16_t y,
+                           uint8_t z,
+                           const U6ObjBlkRecord **out_records,
+                           size_t *out_count) {
+  return u6_objblk_store_get(store, u6_objblk_store_area_for_position(x, y, z), out_records, out_count);
+}
+
+/* Contribution of one area; empty and missing areas contribute nothing. */
+static uint64_t area_hash(uint16_t area_id, const U6ObjBlkRecord *records, size_t count) {
+  uint64_t h;
+  if (count == 0) {
+    return 0;
+  }
+  h = (u6_objblk_records_hash(records, count) ^ ((uint64_t)area_id * 0x9e3779b97f4a7c15ull)) * 1099511628211ull;
+  return h ^ (h >> 29);
+}
+
+static void mark_dirty(U6ObjBlkStore *store, U6ObjBlkStoreArea *area) {
+  area->hash_valid = 0;
+  if (!area->dirty) {
+    area->dirty = 1;
+    store->dirty_areas++;
+  }
+}
+
+int u6_objblk_store_get_mutable(U6ObjBlkStore *store,
+                                uint16_t area_id,
+                                U6ObjBlkRecord **out_records,
+                                size_t *out_count) {
+  const U6ObjBlkRecord *records = NULL;
+  int rc;
+
+  if (out_records == NULL) {
+    return -1;
+  }
+  rc = u6_objblk_store_get(store, area_id, &records, out_count);
+  if (rc != 0) {
+    return rc;
+  }
+  mark_dirty(store, &store->areas[area_id]);
+  *out_records = store->areas[area_id].records;
+  return 0;
+}
+
+int u6_objblk_store_replace(U6ObjBlkStore *store,
+                            uint16_t area_id,
+                            const U6ObjBlkRecord *records,
+                            size_t count) {
+  U6ObjBlkStoreArea *area;
+  U6ObjBlkRecord *copy = NULL;
+
+  if (store == NULL || (records == NULL && count > 0)) {
+    return -1;
+  }
+  if (!valid_area(area_id)) {
+    return -2;
+  }
+  if (count > U6_OBJBLK_MAX_RECORDS) {
+    return -4;
+  }
+  if (count > 0) {
+    copy = (U6ObjBlkRecord *)malloc(count * sizeof(U6ObjBlkRecord));
+    if (copy == NULL) {
+      return -5;
+    }
+    memcpy(copy, records, count * sizeof(U6ObjBlkRecord));
+    for (size_t i = 0; i < count; i++) {
+      copy[i].source_area = area_id;
+      copy[i].source_index = (uint16_t)i;
+    }
+  }
+
+  area = &store->areas[area_id];
+  if (area->state == U6_OBJBLK_AREA_RESIDENT) {
+    store->resident_records -= area->count;
+  } else {
+    store->resident_areas++;
+  }
+  free(area->records);
+  area->records = copy;
+  area->count = count;
+  area->state = U6_OBJBLK_AREA_RESIDENT;
+  area->last_access = ++store->access_clock;
+  store->resident_records += count;
+  mark_dirty(store, area);
+  evict_cold(store, area_id);
+  return 0;
+}
+
+int u6_objblk_store_is_dirty(const U6ObjBlkStore *store, uint16_t area_id) {
+  if (store == NULL || !valid_area(area_id)) {
+    return 0;
+  }
+  return store->areas[area_id].dirty != 0;
+}
+
+int u6_objblk_store_save(U6ObjBlkStore *store, size_t *out_files_written) {
+  size_t written = 0;
+  int rc = 0;
+
+  if (store == NULL) {
+    return -1;
+  }
+  for (uint16_t a = 0; a < U6_OBJBLK_STORE_AREAS && store->dirty_areas > 0; a++) {
+    U6ObjBlkStoreArea *area = &store->areas[a];
+    char path[U6_OBJBLK_STORE_PATH_MAX + 16];
+
+    if (!area->dirty) {
+      continue;
+    }
+    rc = u6_objblk_store_area_path(store->savegame_dir, a, path, sizeof(path));
+    if (rc == 0) {
+      rc = u6_objblk_write_file(path, area->records, area->count);
+    }
+    if (rc != 0) {
+      break;
+    }
+    area->dirty = 0;
+    store->dirty_areas--;
+    area->hash = area_hash(a, area->records, area->count);
+    area->hash_valid = 1;
+    written++;
+  }
+  if (out_files_written != NULL) {
+    *out_files_written = written;
+  }
+  return rc;
+}
+
+uint64_t u6_objblk_store_hash(U6ObjBlkStore *store) {
+  uint64_t sum = 0;
+
+  if (store == NULL) {
+    return 0;
+  }
+  for (uint16_t a = 0; a < U6_OBJBLK_STORE_AREAS; a++) {
+    U6ObjBlkStoreArea *area = &store->areas[a];
+
+    /* Dirty records may still be changing through a get_mutable pointer. */
+    if (area->state == U6_OBJBLK_AREA_RESIDENT && area->dirty) {
+      sum += area_hash(a, area->records, area->count);
+      continue;
+    }
+    if (!area->hash_valid) {
+      if (area->state == U6_OBJBLK_AREA_RESIDENT) {
+        area->hash = area_hash(a, area->records, area->count);
+      } else {
+        U6ObjBlkRecord *records;
+        size_t count;
+        int missing;
+        if (read_area_file(store, a, &records, &count, &missing) != 0) {
+          /* Unreadable: a marker that is not cached, so a fixed file rehashes. */
+          sum += 0x5bd1e9955bd1e995ull * (uint64_t)(a + 1u);
+          continue;
+        }
+        area->hash = area_hash(a, records, count);
+        free(records);
+      }
+      area->hash_valid = 1;
+    }
+    sum += area->hash;
+  }
+  return sum;
+}
+
+int u6_objblk_store_is_resident(const U6ObjBlkStore *store, uint16_t area_id) {
+  if (store == NULL || !valid_area(area_id)) {
+    return 0;
+  }
+  return store->areas[area_id].state == U6_OBJBLK_AREA_RESIDENT;
+}
+
+int u6_objblk_store_evict(U6ObjBlkStore *store, uint16_t area_id) {
+  if (store == NULL) {
+    return -1;
+  }
+  if (!valid_area(area_id)) {
+    return -2;
+  }
+  if (store->areas[area_id].dirty) {
+    return -3;
+  }
+  drop_area(store, &store->areas[area_id]);
+  return 0;
+}
+
+void u6_objblk_store_evict_all(U6ObjBlkStore *store) {
+  if (store == NULL) {
+    return;
+  }
+  for (uint16_t a = 0; a < U6_OBJBLK_STORE_AREAS; a++) {
+    drop_area(store, &store->areas[a]);
+  }
+}
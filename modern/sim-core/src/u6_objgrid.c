@@ -0,0 +1,466 @@
+#include "u6_objgrid.h"
+#include "u6_objstatus.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define U6_OBJGRID_MAP_MAX 1023
+#define U6_OBJGRID_OVERFLOW_BUCKET ((uint32_t)U6_OBJGRID_BUCKETS)
+
+static uint32_t bucket_of(int32_t x, int32_t y, int32_t z) {
+  if (x < 0 || x > U6_OBJGRID_MAP_MAX || y < 0 || y > U6_OBJGRID_MAP_MAX || z < 0 || z >= U6_OBJGRID_Z_LEVELS) {
+    return U6_OBJGRID_OVERFLOW_BUCKET;
+  }
+  return (uint32_t)((((uint32_t)z * U6_OBJGRID_CHUNKS_PER_AXIS) + ((uint32_t)y >> U6_OBJGRID_CHUNK_SHIFT))
+                        * U6_OBJGRID_CHUNKS_PER_AXIS
+                    + ((uint32_t)x >> U6_OBJGRID_CHUNK_SHIFT));
+}
+
+/* Footprint cells in the same order as the net server's objectFootprintCells. */
+static size_t footprint_cells(int32_t x, int32_t y, uint8_t tile_flags, int32_t out_x[4], int32_t out_y[4]) {
+  size_t n = 0;
+  int dbl_h = (tile_flags & U6_OBJGRID_TILE_DOUBLE_WIDTH) != 0u;
+  int dbl_v = (tile_flags & U6_OBJGRID_TILE_DOUBLE_HEIGHT) != 0u;
+
+  out_x[n] = x;
+  out_y[n++] = y;
+  if (dbl_h) {
+    out_x[n] = x - 1;
+    out_y[n++] = y;
+  }
+  if (dbl_v) {
+    out_x[n] = x;
+    out_y[n++] = y - 1;
+  }
+  if (dbl_h && dbl_v) {
+    out_x[n] = x - 1;
+    out_y[n++] = y - 1;
+  }
+  return n;
+}
+
+static void link_entry(U6ObjGrid *grid, uint32_t bucket, uint32_t entry) {
+  uint32_t head = grid->bucket_head[bucket];
+  grid->entry_prev[entry] = 0;
+  grid->entry_next[entry] = head;
+  if (head != 0) {
+    grid->entry_prev[head - 1] = entry + 1;
+  }
+  grid->bucket_head[bucket] = entry + 1;
+}
+
+static void unlink_entry(U6ObjGrid *grid, uint32_t bucket, uint32_t entry) {
+  uint32_t prev = grid->entry_prev[entry];
+  uint32_t next = grid->entry_next[entry];
+  if (prev != 0) {
+    grid->entry_next[prev - 1] = next;
+  } else {
+    grid->bucket_head[bucket] = next;
+  }
+  if (next != 0) {
+    grid->entry_prev[next - 1] = prev;
+  }
+  grid->entry_next[entry] = 0;
+  grid->entry_prev[entry] = 0;
+}
+
+static void link_item(U6ObjGrid *grid, uint32_t ref) {
+  U6ObjGridItem *item = &grid->items[ref];
+  int32_t cx[4];
+  int32_t cy[4];
+  size_t cells = footprint_cells(item->x, item->y, item->tile_flags, cx, cy);
+
+  item->link_count = 0;
+  for (size_t c = 0; c < cells; c++) {
+    uint32_t bucket = bucket_of(cx[c], cy[c], item->z);
+    int dup = 0;
+    for (uint8_t k = 0; k < item->link_count; k++) {
+      if (item->link_bucket[k] == bucket) {
+        dup = 1;
+        break;
+      }
+    }
+    if (dup) {
+      continue;
+    }
+    item->link_bucket[item->link_count] = bucket;
+    link_entry(grid, bucket, (ref * U6_OBJGRID_MAX_LINKS) + item->link_count);
+    item->link_count++;
+  }
+}
+
+static void unlink_item(U6ObjGrid *grid, uint32_t ref) {
+  U6ObjGridItem *item = &grid->items[ref];
+  for (uint8_t k = 0; k < item->link_count; k++) {
+    unlink_entry(grid, item->link_bucket[k], (ref * U6_OBJGRID_MAX_LINKS) + k);
+  }
+  item->link_count = 0;
+}
+
+int u6_objgrid_init(U6ObjGrid *grid, size_t capacity) {
+  if (grid == NULL) {
+    return U6_OBJGRID_ERR_NULL;
+  }
+  memset(grid, 0, sizeof(*grid));
+  if (capacity > (UINT32_MAX / U6_OBJGRID_MAX_LINKS) - 1u) {
+    return U6_OBJGRID_ERR_REF;
+  }
+  grid->items = (U6ObjGridItem *)calloc(capacity > 0 ? capacity : 1, sizeof(U6ObjGridItem));
+  grid->bucket_head = (uint32_t *)calloc((size_t)U6_OBJGRID_BUCKETS + 1u, sizeof(uint32_t));
+  grid->entry_next = (uint32_t *)calloc((capacity > 0 ? capacity : 1) * U6_OBJGRID_MAX_LINKS, sizeof(uint32_t));
+  grid->entry_prev = (uint32_t *)calloc((capacity > 0 ? capacity : 1) * U6_OBJGRID_MAX_LINKS, sizeof(uint32_t));
+  grid->seen_stamp = (uint32_t *)calloc(capacity > 0 ? capacity : 1, sizeof(uint32_t));
+  grid->scratch = (U6ObjGridHit *)malloc((capacity > 0 ? capacity : 1) * sizeof(U6ObjGridHit));
+  if (grid->items == NULL || grid->bucket_head == NULL || grid->entry_next == NULL || grid->entry_prev == NULL
+      || grid->seen_stamp == NULL || grid->scratch == NULL) {
+    u6_objgrid_free(grid);
+    return U6_OBJGRID_ERR_ALLOC;
+  }
+  grid->capacity = capacity;
+  return U6_OBJGRID_OK;
+}
+
+void u6_objgrid_free(U6ObjGrid *grid) {
+  if (grid == NULL) {
+    return;
+  }
+  free(grid->items);
+  free(grid->bucket_head);
+  free(grid->entry_next);
+  free(grid->entry_prev);
+  free(grid->seen_stamp);
+  free(grid->scratch);
+  memset(grid, 0, sizeof(*grid));
+}
+
+void u6_objgrid_clear(U6ObjGrid *grid) {
+  if (grid == NULL || grid->items == NULL) {
+    return;
+  }
+  for (size_t ref = 0; ref < grid->capacity; ref++) {
+    if (grid->items[ref].in_use) {
+      unlink_item(grid, (uint32_t)ref);
+      grid->items[ref].in_use = 0;
+    }
+  }
+  grid->count = 0;
+}
+
+int u6_objgrid_insert(U6ObjGrid *grid,
+                      uint32_t ref,
+                      int32_t x,
+                      int32_t y,
+                      int32_t z,
+                      uint8_t tile_flags,
+                      uint64_t order_key) {
+  U6ObjGridItem *item;
+
+  if (grid == NULL || grid->items == NULL) {
+    return U6_OBJGRID_ERR_NULL;
+  }
+  if (ref >= grid->capacity) {
+    return U6_OBJGRID_ERR_REF;
+  }
+  item = &grid->items[ref];
+  if (item->in_use) {
+    return U6_OBJGRID_ERR_IN_USE;
+  }
+  item->order_key = order_key;
+  item->x = x;
+  item->y = y;
+  item->z = z;
+  item->tile_flags = tile_flags;
+  item->in_use = 1;
+  link_item(grid, ref);
+  grid->count++;
+  return U6_OBJGRID_OK;
+}
+
+int u6_objgrid_remove(U6ObjGrid *grid, uint32_t ref) {
+  if (grid == NULL || grid->items == NULL) {
+    return U6_OBJGRID_ERR_NULL;
+  }
+  if (ref >= grid->capacity) {
+    return U6_OBJGRID_ERR_REF;
+  }
+  if (!grid->items[ref].in_use) {
+    return U6_OBJGRID_ERR_NOT_FOUND;
+  }
+  unlink_item(grid, ref);
+  grid->items[ref].in_use = 0;
+  grid->count--;
+  return U6_OBJGRID_OK;
+}
+
+int u6_objgrid_move(U6ObjGrid *grid, uint32_t ref, int32_t x, int32_t y, int32_t z, uint64_t order_key) {
+  U6ObjGridItem *item;
+
+  if (grid == NULL || grid->items == NULL) {
+    return U6_OBJGRID_ERR_NULL;
+  }
+  if (ref >= grid->capacity) {
+    return U6_OBJGRID_ERR_REF;
+  }
+  item = &grid->items[ref];
+  if (!item->in_use) {
+    return U6_OBJGRID_ERR_NOT_FOUND;
+  }
+  item->order_key = order_key;
+  if (item->x == x && item->y == y && item->z == z) {
+    return U6_OBJGRID_OK;
+  }
+  unlink_item(grid, ref);
+  item->x = x;
+  item->y = y;
+  item->z = z;
+  link_item(grid, ref);
+  return U6_OBJGRID_OK;
+}
+
+int u6_objgrid_insert_objblk(U6ObjGrid *grid,
+                             const U6ObjBlkRecord *records,
+                             const uint8_t *tile_flags,
+                             size_t count) {
+  if (grid == NULL || (records == NULL && count > 0)) {
+    return U6_OBJGRID_ERR_NULL;
+  }
+  for (size_t i = 0; i < count; i++) {
+    int rc;
+    if (!u6_objblk_is_locxyz(records[i].status)) {
+      continue;
+    }
+    rc = u6_objgrid_insert(grid,
+                           (uint32_t)i,
+                           records[i].x,
+                           records[i].y,
+                           records[i].z,
+                           tile_flags != NULL ? tile_flags[i] : 0u,
+                           u6_objblk_render_key(&records[i]));
+    if (rc != U6_OBJGRID_OK) {
+      return rc;
+    }
+  }
+  return U6_OBJGRID_OK;
+}
+
+static uint64_t entity_order_key(uint8_t status, int16_t x, int16_t y, int16_t z, size_t slot) {
+  U6ObjBlkRecord rec;
+
+  memset(&rec, 0, sizeof(rec));
+  rec.status = status;
+  rec.x = (uint16_t)x;
+  rec.y = (uint16_t)y;
+  rec.z = (uint8_t)z;
+  rec.source_area = U6_OBJGRID_ENTITY_AREA;
+  rec.source_index = (uint16_t)slot;
+  return u6_objblk_render_key(&rec);
+}
+
+int u6_objgrid_insert_entity_objects(U6ObjGrid *grid, const U6EntityState *state, uint32_t ref_base) {
+  if (grid == NULL || state == NULL) {
+    return U6_OBJGRID_ERR_NULL;
+  }
+  for (size_t i = 0; i < u6_entities_object_slots(state); i++) {
+    const U6ObjectState *obj = u6_entities_object_at(state, i);
+    int rc;
+    if (obj == NULL || !u6_obj_status_is_locxyz(obj->status)) {
+      continue;
+    }
+    rc = u6_objgrid_insert(grid,
+                           ref_base + (uint32_t)i,
+                           obj->map_x,
+                           obj->map_y,
+                           obj->map_z,
+                           0u,
+                           entity_order_key(obj->status, obj->map_x, obj->map_y, obj->map_z, i));
+    if (rc != U6_OBJGRID_OK) {
+      return rc;
+    }
+  }
+  return U6_OBJGRID_OK;
+}
+
+int u6_objgrid_insert_entity_npcs(U6ObjGrid *grid, const U6EntityState *state, uint32_t ref_base) {
+  if (grid == NULL || state == NULL) {
+    return U6_OBJGRID_ERR_NULL;
+  }
+  for (size_t i = 0; i < u6_entities_npc_slots(state); i++) {
+    const U6NpcState *npc = u6_entities_npc_at(state, i);
+    int rc;
+    if (npc == NULL) {
+      continue;
+    }
+    rc = u6_objgrid_insert(grid,
+                           ref_base + (uint32_t)i,
+                           npc->map_x,
+                           npc->map_y,
+                           npc->map_z,
+                           0u,
+                           entity_order_key(U6_OBJ_COORD_USE_LOCXYZ, npc->map_x, npc->map_y, npc->map_z, i));
+    if (rc != U6_OBJGRID_OK) {
+      return rc;
+    }
+  }
+  return U6_OBJGRID_OK;
+}
+
+static int item_matches(const U6ObjGridItem *item,
+                        int64_t x0,
+                        int64_t y0,
+                        int64_t x1,
+                        int64_t y1,
+                        int has_z,
+                        int32_t z,
+                        U6ObjGridMatch match) {
+  int32_t cx[4];
+  int32_t cy[4];
+  size_t cells;
+
+  if (has_z && item->z != z) {
+    return 0;
+  }
+  cells = (match == U6_OBJGRID_MATCH_FOOTPRINT) ? footprint_cells(item->x, item->y, item->tile_flags, cx, cy) : 1u;
+  if (cells == 1u) {
+    cx[0] = item->x;
+    cy[0] = item->y;
+  }
+  for (size_t c = 0; c < cells; c++) {
+    if (cx[c] >= x0 && cx[c] <= x1 && cy[c] >= y0 && cy[c] <= y1) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int compare_hits(const void *lhs, const void *rhs) {
+  const U6ObjGridHit *a = (const U6ObjGridHit *)lhs;
+  const U6ObjGridHit *b = (const U6ObjGridHit *)rhs;
+  if (a->order_key != b->order_key) {
+    return (a->order_key < b->order_key) ? -1 : 1;
+  }
+  if (a->ref != b->ref) {
+    return (a->ref < b->ref) ? -1 : 1;
+  }
+  return 0;
+}
+
+static size_t collect_bucket(U6ObjGrid *grid,
+                             uint32_t bucket,
+                             int64_t x0,
+                             int64_t y0,
+                             int64_t x1,
+                             int64_t y1,
+                             int has_z,
+                             int32_t z,
+                             U6ObjGridMatch match,
+                             size_t n) {
+  uint32_t e = grid->bucket_head[bucket];
+  while (e != 0) {
+    uint32_t ref = (e - 1) / U6_OBJGRID_MAX_LINKS;
+    const U6ObjGridItem *item = &grid->items[ref];
+    if (grid->seen_stamp[ref] != grid->stamp) {
+      grid->seen_stamp[ref] = grid->stamp;
+      if (item_matches(item, x0, y0, x1, y1, has_z, z, match)) {
+        grid->scratch[n].order_key = item->order_key;
+        grid->scratch[n].ref = ref;
+        n++;
+      }
+    }
+    e = grid->entry_next[e - 1];
+  }
+  return n;
+}
+
+static size_t query_box(U6ObjGrid *grid,
+                        int64_t x0,
+                        int64_t y0,
+                        int64_t x1,
+                        int64_t y1,
+                        int has_z,
+                        int32_t z,
+                        U6ObjGridMatch match,
+                        uint32_t *out_refs,
+                        size_t out_capacity) {
+  size_t n = 0;
+
+  if (grid == NULL || grid->items == NULL || (out_refs == NULL && out_capacity > 0) || x0 > x1 || y0 > y1) {
+    return 0;
+  }
+
+  grid->stamp++;
+  if (grid->stamp == 0) {
+    memset(grid->seen_stamp, 0, grid->capacity * sizeof(uint32_t));
+    grid->stamp = 1;
+  }
+
+  if (x1 >= 0 && y1 >= 0 && x0 <= U6_OBJGRID_MAP_MAX && y0 <= U6_OBJGRID_MAP_MAX) {
+    uint32_t cx0 = (uint32_t)(x0 < 0 ? 0 : x0) >> U6_OBJGRID_CHUNK_SHIFT;
+    uint32_t cy0 = (uint32_t)(y0 < 0 ? 0 : y0) >> U6_OBJGRID_CHUNK_SHIFT;
+    uint32_t cx1 = (uint32_t)(x1 > U6_OBJGRID_MAP_MAX ? U6_OBJGRID_MAP_MAX : x1) >> U6_OBJGRID_CHUNK_SHIFT;
+    uint32_t cy1 = (uint32_t)(y1 > U6_OBJGRID_MAP_MAX ? U6_OBJGRID_MAP_MAX : y1) >> U6_OBJGRID_CHUNK_SHIFT;
+    int32_t z0 = 0;
+    int32_t z1 = U6_OBJGRID_Z_LEVELS - 1;
+
+    if (has_z) {
+      z0 = z;
+      z1 = z;
+    }
+    for (int32_t zl = z0; zl <= z1; zl++) {
+      if (zl < 0 || zl >= U6_OBJGRID_Z_LEVELS) {
+        continue;
+      }
+      for (uint32_t cy = cy0; cy <= cy1; cy++) {
+        for (uint32_t cx = cx0; cx <= cx1; cx++) {
+          uint32_t bucket = (((uint32_t)zl * U6_OBJGRID_CHUNKS_PER_AXIS) + cy) * U6_OBJGRID_CHUNKS_PER_AXIS + cx;
+          n = collect_bucket(grid, bucket, x0, y0, x1, y1, has_z, z, match, n);
+        }
+      }
+    }
+  }
+  n = collect_bucket(grid, U6_OBJGRID_OVERFLOW_BUCKET, x0, y0, x1, y1, has_z, z, match, n);
+
+  if (n > 1) {
+    qsort(grid->scratch, n, sizeof(U6ObjGridHit), compare_hits);
+  }
+  for (size_t i = 0; i < n && i < out_capacity; i++) {
+    out_refs[i] = grid->scratch[i].ref;
+  }
+  return n;
+}
+
+size_t u6_objgrid_query_rect(U6ObjGrid *grid,
+                             int32_t x0,
+                             int32_t y0,
+                             int32_t x1,
+                             int32_t y1,
+                             int has_z,
+                             int32_t z,
+                             U6ObjGridMatch match,
+                             uint32_t *out_refs,
+                             size_t out_capacity) {
+  return query_box(grid, x0, y0, x1, y1, has_z, z, match, out_refs, out_capacity);
+}
+
+size_t u6_objgrid_query_radius(U6ObjGrid *grid,
+                               int32_t cx,
+                               int32_t cy,
+                               int32_t radius,
+                               int has_z,
+                               int32_t z,
+                               U6ObjGridMatch match,
+                               uint32_t *out_refs,
+                               size_t out_capacity) {
+  if (radius < 0) {
+    return 0;
+  }
+  return query_box(grid,
+                   (int64_t)cx - radius,
+                   (int64_t)cy - radius,
+                   (int64_t)cx + radius,
+                   (int64_t)cy + radius,
+                   has_z,
+                   z,
+                   match,
+                   out_refs,
+                   out_capacity);
+}
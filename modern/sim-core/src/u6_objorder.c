@@ -0,0 +1,324 @@
+#include "u6_objorder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define U6_OBJORDER_KEY_CLASS_BIT 57
+#define U6_OBJORDER_KEY_Y_SHIFT 47
+
+static uint8_t random_level(U6ObjOrderIndex *index) {
+  uint32_t x = index->rng_state;
+  uint8_t level = 1;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  index->rng_state = x;
+
+  /* p = 1/4 per level; two bits of the draw per promotion. */
+  while (level < U6_OBJORDER_MAX_LEVEL && (x & 3u) == 0u) {
+    level++;
+    x >>= 2;
+  }
+  return level;
+}
+
+static uint32_t find_update(const U6ObjOrderIndex *index, uint64_t key, uint32_t update[U6_OBJORDER_MAX_LEVEL]) {
+  const U6ObjOrderNode *nodes = index->nodes;
+  uint32_t x = 0;
+
+  for (int i = (int)index->level - 1; i >= 0; i--) {
+    while (nodes[x].next[i] != U6_OBJORDER_NIL && nodes[nodes[x].next[i]].key < key) {
+      x = nodes[x].next[i];
+    }
+    if (update != NULL) {
+      update[i] = x;
+    }
+  }
+  return nodes[x].next[0];
+}
+
+static void reset_links(U6ObjOrderIndex *index) {
+  memset(index->nodes, 0, (index->capacity + 1) * sizeof(U6ObjOrderNode));
+  index->nodes[0].level = U6_OBJORDER_MAX_LEVEL;
+  for (size_t i = 1; i <= index->capacity; i++) {
+    index->nodes[i].next[0] = (i < index->capacity) ? (uint32_t)(i + 1) : U6_OBJORDER_NIL;
+  }
+  index->free_head = index->capacity > 0 ? 1u : U6_OBJORDER_NIL;
+  index->count = 0;
+  index->level = 1;
+  index->rng_state = 0x9e3779b9u;
+}
+
+int u6_objorder_init(U6ObjOrderIndex *index, size_t capacity) {
+  if (index == NULL) {
+    return U6_OBJORDER_ERR_NULL;
+  }
+  memset(index, 0, sizeof(*index));
+  if (capacity >= UINT32_MAX) {
+    return U6_OBJORDER_ERR_FULL;
+  }
+  index->nodes = (U6ObjOrderNode *)malloc((capacity + 1) * sizeof(U6ObjOrderNode));
+  if (index->nodes == NULL) {
+    return U6_OBJORDER_ERR_ALLOC;
+  }
+  index->capacity = capacity;
+  reset_links(index);
+  return U6_OBJORDER_OK;
+}
+
+void u6_objorder_free(U6ObjOrderIndex *index) {
+  if (index == NULL) {
+    return;
+  }
+  free(index->nodes);
+  memset(index, 0, sizeof(*index));
+}
+
+void u6_objorder_clear(U6ObjOrderIndex *index) {
+  if (index == NULL || index->nodes == NULL) {
+    return;
+  }
+  reset_links(index);
+}
+
+int u6_objorder_insert(U6ObjOrderIndex *index, const U6ObjBlkRecord *record) {
+  uint32_t update[U6_OBJORDER_MAX_LEVEL];
+  uint32_t found;
+  uint32_t slot;
+  uint64_t key;
+  uint8_t level;
+
+  if (index == NULL || index->nodes == NULL || record == NULL) {
+    return U6_OBJORDER_ERR_NULL;
+  }
+  if (!u6_objblk_render_key_fits(record)) {
+    return U6_OBJORDER_ERR_KEY_RANGE;
+  }
+
+  key = u6_objblk_render_key(record);
+  found = find_update(index, key, update);
+  if (found != U6_OBJORDER_NIL && index->nodes[found].key == key) {
+    return U6_OBJORDER_ERR_DUPLICATE;
+  }
+  if (index->free_head == U6_OBJORDER_NIL) {
+    return U6_OBJORDER_ERR_FULL;
+  }
+
+  slot = index->free_head;
+  index->free_head = index->nodes[slot].next[0];
+
+  level = random_level(index);
+  if (level > index->level) {
+    for (uint8_t i = index->level; i < level; i++) {
+      update[i] = 0;
+    }
+    index->level = level;
+  }
+
+  index->nodes[slot].key = key;
+  index->nodes[slot].record = *record;
+  index->nodes[slot].level = level;
+  for (uint8_t i = 0; i < level; i++) {
+    index->nodes[slot].next[i] = index->nodes[update[i]].next[i];
+    index->nodes[update[i]].next[i] = slot;
+  }
+  index->count++;
+  return U6_OBJORDER_OK;
+}
+
+int u6_objorder_remove(U6ObjOrderIndex *index, const U6ObjBlkRecord *record) {
+  uint32_t update[U6_OBJORDER_MAX_LEVEL];
+  uint32_t found;
+  uint64_t key;
+
+  if (index == NULL || index->nodes == NULL || record == NULL) {
+    return U6_OBJORDER_ERR_NULL;
+  }
+  if (!u6_objblk_render_key_fits(record)) {
+    return U6_OBJORDER_ERR_NOT_FOUND;
+  }
+
+  key = u6_objblk_render_key(record);
+  found = find_update(index, key, update);
+  if (found == U6_OBJORDER_NIL || index->nodes[found].key != key) {
+    return U6_OBJORDER_ERR_NOT_FOUND;
+  }
+
+  for (uint8_t i = 0; i < index->level; i++) {
+    if (index->nodes[update[i]].next[i] != found) {
+      break;
+    }
+    index->nodes[update[i]].next[i] = index->nodes[found].next[i];
+  }
+  while (index->level > 1 && index->nodes[0].next[index->level - 1] == U6_OBJORDER_NIL) {
+    index->level--;
+  }
+
+  memset(&index->nodes[found], 0, sizeof(index->nodes[found]));
+  index->nodes[found].next[0] = index->free_head;
+  index->free_head = found;
+  index->count--;
+  return U6_OBJORDER_OK;
+}
+
+int u6_objorder_move(U6ObjOrderIndex *index, const U6ObjBlkRecord *from, const U6ObjBlkRecord *to) {
+  uint32_t found;
+  U6ObjBlkRecord saved;
+  int rc;
+
+  if (index == NULL || index->nodes == NULL || from == NULL || to == NULL) {
+    return U6_OBJORDER_ERR_NULL;
+  }
+  if (!u6_objblk_render_key_fits(from)) {
+    return U6_OBJORDER_ERR_NOT_FOUND;
+  }
+  if (!u6_objblk_render_key_fits(to)) {
+    return U6_OBJORDER_ERR_KEY_RANGE;
+  }
+
+  found = find_update(index, u6_objblk_render_key(from), NULL);
+  if (found == U6_OBJORDER_NIL || index->nodes[found].key != u6_objblk_render_key(from)) {
+    return U6_OBJORDER_ERR_NOT_FOUND;
+  }
+  if (u6_objblk_render_key(from) == u6_objblk_render_key(to)) {
+    index->nodes[found].record = *to;
+    return U6_OBJORDER_OK;
+  }
+
+  saved = index->nodes[found].record;
+  rc = u6_objorder_remove(index, from);
+  if (rc != U6_OBJORDER_OK) {
+    return rc;
+  }
+  rc = u6_objorder_insert(index, to);
+  if (rc != U6_OBJORDER_OK) {
+    (void)u6_objorder_insert(index, &saved);
+  }
+  return rc;
+}
+
+int u6_objorder_build(U6ObjOrderIndex *index, const U6ObjBlkRecord *records, size_t count) {
+  uint32_t tail[U6_OBJORDER_MAX_LEVEL];
+  U6ObjBlkRecord *sorted;
+
+  if (index == NULL || index->nodes == NULL || (records == NULL && count > 0)) {
+    return U6_OBJORDER_ERR_NULL;
+  }
+  if (count > index->capacity) {
+    return U6_OBJORDER_ERR_FULL;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (!u6_objblk_render_key_fits(&records[i])) {
+      return U6_OBJORDER_ERR_KEY_RANGE;
+    }
+  }
+
+  sorted = (U6ObjBlkRecord *)malloc((count > 0 ? count : 1) * sizeof(U6ObjBlkRecord));
+  if (sorted == NULL) {
+    return U6_OBJORDER_ERR_ALLOC;
+  }
+  if (count > 0) {
+    memcpy(sorted, records, count * sizeof(U6ObjBlkRecord));
+  }
+  u6_objblk_sort_for_render(sorted, count);
+  for (size_t i = 1; i < count; i++) {
+    if (u6_objblk_render_key(&sorted[i - 1]) == u6_objblk_render_key(&sorted[i])) {
+      free(sorted);
+      return U6_OBJORDER_ERR_DUPLICATE;
+    }
+  }
+
+  /* Sorted input appends at the tail of every level: O(n) bulk load. */
+  reset_links(index);
+  for (int i = 0; i < U6_OBJORDER_MAX_LEVEL; i++) {
+    tail[i] = 0;
+  }
+  for (size_t i = 0; i < count; i++) {
+    uint32_t slot = index->free_head;
+    uint8_t level = random_level(index);
+
+    index->free_head = index->nodes[slot].next[0];
+    index->nodes[slot].next[0] = U6_OBJORDER_NIL;
+    index->nodes[slot].key = u6_objblk_render_key(&sorted[i]);
+    index->nodes[slot].record = sorted[i];
+    index->nodes[slot].level = level;
+    if (level > index->level) {
+      index->level = level;
+    }
+    for (uint8_t l = 0; l < level; l++) {
+      index->nodes[tail[l]].next[l] = slot;
+      tail[l] = slot;
+    }
+  }
+  index->count = count;
+
+  free(sorted);
+  return U6_OBJORDER_OK;
+}
+
+const U6ObjBlkRecord *u6_objorder_first(const U6ObjOrderIndex *index, U6ObjOrderCursor *cursor) {
+  if (index == NULL || index->nodes == NULL || cursor == NULL) {
+    return NULL;
+  }
+  cursor->index = index;
+  cursor->node = index->nodes[0].next[0];
+  return cursor->node != U6_OBJORDER_NIL ? &index->nodes[cursor->node].record : NULL;
+}
+
+const U6ObjBlkRecord *u6_objorder_next(U6ObjOrderCursor *cursor) {
+  if (cursor == NULL || cursor->index == NULL || cursor->node == U6_OBJORDER_NIL) {
+    return NULL;
+  }
+  cursor->node = cursor->index->nodes[cursor->node].next[0];
+  return cursor->node != U6_OBJORDER_NIL ? &cursor->index->nodes[cursor->node].record : NULL;
+}
+
+static uint64_t range_seek_key(uint8_t phase, uint16_t y_min) {
+  return ((uint64_t)phase << U6_OBJORDER_KEY_CLASS_BIT) | ((uint64_t)(y_min & U6_OBJBLK_KEY_MAX_XY) << U6_OBJORDER_KEY_Y_SHIFT);
+}
+
+void u6_objorder_range_begin(const U6ObjOrderIndex *index,
+                             U6ObjOrderRange *range,
+                             uint16_t y_min,
+                             uint16_t y_max) {
+  if (range == NULL) {
+    return;
+  }
+  memset(range, 0, sizeof(*range));
+  if (index == NULL || index->nodes == NULL || y_min > y_max || y_min > U6_OBJBLK_KEY_MAX_XY) {
+    range->phase = 2;
+    return;
+  }
+  range->index = index;
+  range->y_min = y_min;
+  range->y_max = y_max;
+  range->phase = 0;
+  range->node = find_update(index, range_seek_key(0, y_min), NULL);
+}
+
+/*
+ * Non-LOCXYZ records sort ahead of every LOCXYZ record, so a y-range is two
+ * contiguous runs: phase 0 walks the non-LOCXYZ run, phase 1 the LOCXYZ run.
+ */
+const U6ObjBlkRecord *u6_objorder_range_next(U6ObjOrderRange *range) {
+  if (range == NULL) {
+    return NULL;
+  }
+  while (range->phase < 2) {
+    const U6ObjOrderNode *node;
+
+    if (range->node != U6_OBJORDER_NIL) {
+      node = &range->index->nodes[range->node];
+      if ((node->key >> U6_OBJORDER_KEY_CLASS_BIT) == range->phase && node->record.y <= range->y_max) {
+        range->node = node->next[0];
+        return &node->record;
+      }
+    }
+    range->phase++;
+    if (range->phase < 2) {
+      range->node = find_update(range->index, range_seek_key(range->phase, range->y_min), NULL);
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,174 @@
+#include "u6_objpack.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t get_u32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v & 0xffu);
+  p[1] = (uint8_t)((v >> 8) & 0xffu);
+  p[2] = (uint8_t)((v >> 16) & 0xffu);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+int u6_objpack_view(U6ObjPackView *view, const uint8_t *data, size_t size) {
+  size_t count;
+  size_t key_bytes;
+  const uint8_t *records;
+  const char *keys;
+
+  if (view == NULL || (data == NULL && size > 0u)) {
+    return U6_OBJPACK_ERR_NULL;
+  }
+  memset(view, 0, sizeof(*view));
+  if (size < U6_OBJPACK_HEADER_SIZE || memcmp(data, "U6OT", 4) != 0 ||
+      get_u16(data + 4) != U6_OBJPACK_VERSION || get_u16(data + 6) != U6_OBJPACK_RECORD_SIZE) {
+    return U6_OBJPACK_ERR_HEADER;
+  }
+  count = get_u32(data + 8);
+  key_bytes = get_u32(data + 12);
+  if (count > (size - U6_OBJPACK_HEADER_SIZE) / U6_OBJPACK_RECORD_SIZE ||
+      key_bytes != size - U6_OBJPACK_HEADER_SIZE - count * U6_OBJPACK_RECORD_SIZE) {
+    return U6_OBJPACK_ERR_BOUNDS;
+  }
+  records = data + U6_OBJPACK_HEADER_SIZE;
+  keys = (const char *)(records + count * U6_OBJPACK_RECORD_SIZE);
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t *r = records + i * U6_OBJPACK_RECORD_SIZE;
+    size_t offset = get_u32(r);
+    size_t len = r[4];
+    if (len == 0u || len > U6_BRIDGE_KEY_MAX || offset >= key_bytes || key_bytes - offset <= len ||
+        keys[offset + len] != '\0' || memchr(keys + offset, '\0', len) != NULL) {
+      return U6_OBJPACK_ERR_KEY;
+    }
+  }
+  view->records = records;
+  view->keys = keys;
+  view->count = count;
+  view->key_bytes = key_bytes;
+  return U6_OBJPACK_OK;
+}
+
+const char *u6_objpack_key(const U6ObjPackView *view, size_t index) {
+  return view->keys + get_u32(view->records + index * U6_OBJPACK_RECORD_SIZE);
+}
+
+void u6_objpack_get(const U6ObjPackView *view, size_t index, U6BridgeObject *out) {
+  const uint8_t *r = view->records + index * U6_OBJPACK_RECORD_SIZE;
+
+  memset(out, 0, sizeof(*out));
+  memcpy(out->key, view->keys + get_u32(r), r[4]);
+  out->status = r[5];
+  out->tile_flag = r[6];
+  out->holder_kind = r[7];
+  out->x = (int32_t)get_u32(r + 8);
+  out->y = (int32_t)get_u32(r + 12);
+  out->z = (int32_t)get_u32(r + 16);
+  out->holder_key = (int32_t)get_u32(r + 20);
+  out->source_area = (int32_t)get_u32(r + 24);
+  out->source_index = (int32_t)get_u32(r + 28);
+}
+
+static uint32_t key_hash(const char *key) {
+  uint32_t h = 2166136261u;
+  for (; *key != '\0'; key++) {
+    h = (h ^ (uint8_t)*key) * 16777619u;
+  }
+  return h;
+}
+
+int u6_objpack_encode(const U6BridgeObject *objects, size_t count, U6BridgeBuffer *out) {
+  size_t bucket_count = 16u;
+  uint32_t *buckets;    /* object index + 1 of the first holder of each distinct key */
+  uint32_t *offsets;    /* key offset per object */
+  size_t key_bytes = 0;
+  size_t size;
+  uint8_t *p;
+
+  if (out == NULL || (objects == NULL && count > 0u)) {
+    return U6_OBJPACK_ERR_NULL;
+  }
+  if (count > (UINT32_MAX - U6_OBJPACK_HEADER_SIZE) / (U6_OBJPACK_RECORD_SIZE + U6_BRIDGE_KEY_MAX + 1u)) {
+    return U6_OBJPACK_ERR_BOUNDS;
+  }
+  while (bucket_count < count * 2u) {
+    bucket_count *= 2u;
+  }
+  buckets = (uint32_t *)calloc(bucket_count, sizeof(uint32_t));
+  offsets = (uint32_t *)malloc((count > 0u ? count : 1u) * sizeof(uint32_t));
+  if (buckets == NULL || offsets == NULL) {
+    free(buckets);
+    free(offsets);
+    return U6_OBJPACK_ERR_ALLOC;
+  }
+  /* Open addressing over distinct keys; the first object with a key owns its bytes. */
+  for (size_t i = 0; i < count; i++) {
+    const char *nul = (const char *)memchr(objects[i].key, '\0', sizeof(objects[i].key));
+    size_t len;
+    size_t b;
+    if (nul == NULL || nul == objects[i].key) {
+      free(buckets);
+      free(offsets);
+      return U6_OBJPACK_ERR_KEY;
+    }
+    len = (size_t)(nul - objects[i].key);
+    b = key_hash(objects[i].key) & (bucket_count - 1u);
+    while (buckets[b] != 0u && strcmp(objects[buckets[b] - 1u].key, objects[i].key) != 0) {
+      b = (b + 1u) & (bucket_count - 1u);
+    }
+    if (buckets[b] == 0u) {
+      buckets[b] = (uint32_t)i + 1u;
+      offsets[i] = (uint32_t)key_bytes;
+      key_bytes += len + 1u;
+    } else {
+      offsets[i] = offsets[buckets[b] - 1u];
+    }
+  }
+  size = U6_OBJPACK_HEADER_SIZE + count * U6_OBJPACK_RECORD_SIZE + key_bytes;
+  if (out->capacity < size) {
+    uint8_t *data = (uint8_t *)realloc(out->data, size);
+    if (data == NULL) {
+      free(buckets);
+      free(offsets);
+      return U6_OBJPACK_ERR_ALLOC;
+    }
+    out->data = data;
+    out->capacity = size;
+  }
+  p = out->data;
+  memcpy(p, "U6OT", 4);
+  p[4] = (uint8_t)(U6_OBJPACK_VERSION & 0xffu);
+  p[5] = (uint8_t)(U6_OBJPACK_VERSION >> 8);
+  p[6] = (uint8_t)(U6_OBJPACK_RECORD_SIZE & 0xffu);
+  p[7] = (uint8_t)(U6_OBJPACK_RECORD_SIZE >> 8);
+  put_u32(p + 8, (uint32_t)count);
+  put_u32(p + 12, (uint32_t)key_bytes);
+  for (size_t i = 0; i < count; i++) {
+    const U6BridgeObject *o = &objects[i];
+    uint8_t *r = p + U6_OBJPACK_HEADER_SIZE + i * U6_OBJPACK_RECORD_SIZE;
+    size_t len = strlen(o->key);
+    put_u32(r, offsets[i]);
+    r[4] = (uint8_t)len;
+    r[5] = o->status;
+    r[6] = o->tile_flag;
+    r[7] = o->holder_kind;
+    put_u32(r + 8, (uint32_t)o->x);
+    put_u32(r + 12, (uint32_t)o->y);
+    put_u32(r + 16, (uint32_t)o->z);
+    put_u32(r + 20, (uint32_t)o->holder_key);
+    put_u32(r + 24, (uint32_t)o->source_area);
+    put_u32(r + 28, (uint32_t)o->source_index);
+    memcpy(p + U6_OBJPACK_HEADER_SIZE + count * U6_OBJPACK_RECORD_SIZE + offsets[i], o->key, len + 1u);
+  }
+  out->size = size;
+  free(buckets);
+  free(offsets);
+  return U6_OBJPACK_OK;
+}
@@ -0,0 +1,138 @@
+#include "u6_objselect.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void swap_items(U6BridgeObject *a, U6BridgeObject *b) {
+  U6BridgeObject tmp = *a;
+  *a = *b;
+  *b = tmp;
+}
+
+/* Max-heap on render order over items[0..n). */
+static void sift_down(U6BridgeObject *items, size_t i, size_t n) {
+  for (;;) {
+    size_t largest = i;
+    size_t left = 2u * i + 1u;
+    size_t right = left + 1u;
+    if (left < n && u6_bridge_object_cmp(&items[left], &items[largest]) > 0) {
+      largest = left;
+    }
+    if (right < n && u6_bridge_object_cmp(&items[right], &items[largest]) > 0) {
+      largest = right;
+    }
+    if (largest == i) {
+      return;
+    }
+    swap_items(&items[i], &items[largest]);
+    i = largest;
+  }
+}
+
+static void sift_up(U6BridgeObject *items, size_t i) {
+  while (i > 0u) {
+    size_t parent = (i - 1u) / 2u;
+    if (u6_bridge_object_cmp(&items[i], &items[parent]) <= 0) {
+      return;
+    }
+    swap_items(&items[i], &items[parent]);
+    i = parent;
+  }
+}
+
+void u6_objselect_init(U6ObjSelect *s, size_t limit) {
+  if (s != NULL) {
+    memset(s, 0, sizeof(*s));
+    s->limit = limit > 0u ? limit : 1u;
+  }
+}
+
+void u6_objselect_free(U6ObjSelect *s) {
+  if (s != NULL) {
+    free(s->items);
+    s->items = NULL;
+    s->count = 0;
+    s->capacity = 0;
+  }
+}
+
+void u6_objselect_reset(U6ObjSelect *s) {
+  if (s != NULL) {
+    s->count = 0;
+  }
+}
+
+int u6_objselect_push(U6ObjSelect *s, const U6BridgeObject *object) {
+  if (s == NULL || object == NULL) {
+    return U6_OBJSELECT_ERR_NULL;
+  }
+  if (s->count < s->limit) {
+    if (s->count == s->capacity) {
+      size_t grown_capacity = s->capacity == 0u ? 16u : s->capacity * 2u;
+      U6BridgeObject *grown;
+      if (grown_capacity > s->limit) {
+        grown_capacity = s->limit;
+      }
+      grown = (U6BridgeObject *)realloc(s->items, grown_capacity * sizeof(U6BridgeObject));
+      if (grown == NULL) {
+        return U6_OBJSELECT_ERR_ALLOC;
+      }
+      s->items = grown;
+      s->capacity = grown_capacity;
+    }
+    s->items[s->count] = *object;
+    sift_up(s->items, s->count);
+    s->count++;
+    return U6_OBJSELECT_OK;
+  }
+  /* Full: only an object ahead of the current worst displaces it. */
+  if (u6_bridge_object_cmp(object, &s->items[0]) < 0) {
+    s->items[0] = *object;
+    sift_down(s->items, 0, s->count);
+  }
+  return U6_OBJSELECT_OK;
+}
+
+size_t u6_objselect_finish(U6ObjSelect *s) {
+  if (s == NULL) {
+    return 0;
+  }
+  /* Heapsort: repeatedly move the max to the end of the shrinking heap. */
+  for (size_t n = s->count; n > 1u; n--) {
+    swap_items(&s->items[0], &s->items[n - 1u]);
+    sift_down(s->items, 0, n - 1u);
+  }
+  return s->count;
+}
+
+U6BridgeObject *u6_objselect_take(U6ObjSelect *s, size_t *out_count) {
+  U6BridgeObject *items;
+  if (s == NULL || out_count == NULL) {
+    return NULL;
+  }
+  *out_count = u6_objselect_finish(s);
+  items = s->items;
+  s->items = NULL;
+  s->count = 0;
+  s->capacity = 0;
+  return items;
+}
+
+int u6_objselect_query(U6ObjSelect *s, const U6BridgeObject *objects, size_t count, const U6BridgeQuery *q) {
+  if (s == NULL || (objects == NULL && count > 0u) || q == NULL) {
+    return U6_OBJSELECT_ERR_NULL;
+  }
+  u6_objselect_reset(s);
+  for (size_t i = 0; i < count; i++) {
+    int rc;
+    if (!u6_bridge_object_matches(&objects[i], q)) {
+      continue;
+    }
+    rc = u6_objselect_push(s, &objects[i]);
+    if (rc != U6_OBJSELECT_OK) {
+      return rc;
+    }
+  }
+  u6_objselect_finish(s);
+  return U6_OBJSELECT_OK;
+}
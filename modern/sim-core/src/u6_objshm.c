@@ -0,0 +1,255 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "u6_objshm.h"
+#include "u6_objselect.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define READ_SPIN_LIMIT 100000u
+#define QUERY_RETRY_LIMIT 64u
+
+static size_t align64(size_t v) {
+  return (v + 63u) & ~(size_t)63u;
+}
+
+/* Column offsets in layout order; returns the total size. */
+static size_t layout(uint32_t capacity, size_t offsets[10]) {
+  static const size_t widths[10] = {4, 4, 4, 4, 4, 4, 1, 1, 1, U6_OBJSHM_KEY_SIZE};
+  size_t off = U6_OBJSHM_HEADER_SIZE;
+  for (size_t i = 0; i < 10u; i++) {
+    offsets[i] = off;
+    off = align64(off + widths[i] * (size_t)capacity);
+  }
+  return off;
+}
+
+size_t u6_objshm_size(uint32_t capacity) {
+  size_t offsets[10];
+  return layout(capacity, offsets);
+}
+
+static void bind_columns(U6ObjShm *shm, uint32_t capacity) {
+  size_t o[10];
+  uint8_t *base = (uint8_t *)shm->map_base;
+
+  layout(capacity, o);
+  shm->header = (U6ObjShmHeader *)base;
+  shm->x = (int32_t *)(base + o[0]);
+  shm->y = (int32_t *)(base + o[1]);
+  shm->z = (int32_t *)(base + o[2]);
+  shm->holder_key = (int32_t *)(base + o[3]);
+  shm->source_area = (int32_t *)(base + o[4]);
+  shm->source_index = (int32_t *)(base + o[5]);
+  shm->status = base + o[6];
+  shm->tile_flag = base + o[7];
+  shm->holder_kind = base + o[8];
+  shm->keys = (char (*)[U6_OBJSHM_KEY_SIZE])(base + o[9]);
+  shm->capacity = capacity;
+}
+
+int u6_objshm_create(U6ObjShm *shm, const char *path, uint32_t capacity) {
+  size_t size;
+  void *base;
+  int fd;
+
+  if (shm == NULL || path == NULL) {
+    return U6_OBJSHM_ERR_NULL;
+  }
+  memset(shm, 0, sizeof(*shm));
+  size = u6_objshm_size(capacity);
+  fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return U6_OBJSHM_ERR_IO;
+  }
+  if (ftruncate(fd, (off_t)size) != 0) {
+    close(fd);
+    return U6_OBJSHM_ERR_IO;
+  }
+  base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    return U6_OBJSHM_ERR_IO;
+  }
+  shm->map_base = base;
+  shm->map_size = size;
+  bind_columns(shm, capacity);
+  memcpy(shm->header->magic, "U6SH", 4);
+  shm->header->version = U6_OBJSHM_VERSION;
+  shm->header->capacity = capacity;
+  atomic_store_explicit(&shm->header->seq, 0u, memory_order_relaxed);
+  atomic_store_explicit(&shm->header->count, 0u, memory_order_relaxed);
+  atomic_store_explicit(&shm->header->generation, 0u, memory_order_relaxed);
+  atomic_store_explicit(&shm->header->retired, 0u, memory_order_release);
+  return U6_OBJSHM_OK;
+}
+
+int u6_objshm_open(U6ObjShm *shm, const char *path) {
+  struct stat st;
+  const U6ObjShmHeader *header;
+  void *base;
+  int fd;
+
+  if (shm == NULL || path == NULL) {
+    return U6_OBJSHM_ERR_NULL;
+  }
+  memset(shm, 0, sizeof(*shm));
+  fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return U6_OBJSHM_ERR_IO;
+  }
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < U6_OBJSHM_HEADER_SIZE) {
+    close(fd);
+    return U6_OBJSHM_ERR_FORMAT;
+  }
+  base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    return U6_OBJSHM_ERR_IO;
+  }
+  header = (const U6ObjShmHeader *)base;
+  if (memcmp(header->magic, "U6SH", 4) != 0 || header->version != U6_OBJSHM_VERSION ||
+      u6_objshm_size(header->capacity) > (size_t)st.st_size) {
+    munmap(base, (size_t)st.st_size);
+    return U6_OBJSHM_ERR_FORMAT;
+  }
+  shm->map_base = base;
+  shm->map_size = (size_t)st.st_size;
+  bind_columns(shm, header->capacity);
+  return U6_OBJSHM_OK;
+}
+
+void u6_objshm_close(U6ObjShm *shm) {
+  if (shm == NULL) {
+    return;
+  }
+  if (shm->map_base != NULL) {
+    munmap(shm->map_base, shm->map_size);
+  }
+  memset(shm, 0, sizeof(*shm));
+}
+
+void u6_objshm_write_begin(U6ObjShm *shm) {
+  atomic_fetch_add_explicit(&shm->header->seq, 1u, memory_order_relaxed);
+  /* Orders the odd seq before every row store that follows. */
+  atomic_thread_fence(memory_order_release);
+}
+
+void u6_objshm_write_row(U6ObjShm *shm, uint32_t row, const U6BridgeObject *object) {
+  if (row >= shm->capacity) {
+    return;
+  }
+  shm->x[row] = object->x;
+  shm->y[row] = object->y;
+  shm->z[row] = object->z;
+  shm->holder_key[row] = object->holder_key;
+  shm->source_area[row] = object->source_area;
+  shm->source_index[row] = object->source_index;
+  shm->status[row] = object->status;
+  shm->tile_flag[row] = object->tile_flag;
+  shm->holder_kind[row] = object->holder_kind;
+  memset(shm->keys[row], 0, U6_OBJSHM_KEY_SIZE);
+  memcpy(shm->keys[row], object->key, strlen(object->key));
+}
+
+void u6_objshm_write_end(U6ObjShm *shm, uint32_t count) {
+  atomic_store_explicit(&shm->header->count, count < shm->capacity ? count : shm->capacity, memory_order_relaxed);
+  atomic_fetch_add_explicit(&shm->header->generation, 1u, memory_order_relaxed);
+  atomic_fetch_add_explicit(&shm->header->seq, 1u, memory_order_release);
+}
+
+void u6_objshm_retire(U6ObjShm *shm) {
+  atomic_store_explicit(&shm->header->retired, 1u, memory_order_release);
+}
+
+int u6_objshm_read_begin(const U6ObjShm *shm, uint32_t *out_seq) {
+  U6ObjShmHeader *header;
+
+  if (shm == NULL || shm->header == NULL || out_seq == NULL) {
+    return U6_OBJSHM_ERR_NULL;
+  }
+  header = shm->header;
+  for (uint32_t spin = 0; spin < READ_SPIN_LIMIT; spin++) {
+    uint32_t seq = atomic_load_explicit(&header->seq, memory_order_acquire);
+    if ((seq & 1u) == 0u) {
+      uint32_t count;
+      if (atomic_load_explicit(&header->retired, memory_order_acquire) != 0u) {
+        return U6_OBJSHM_ERR_RETIRED;
+      }
+      count = atomic_load_explicit(&header->count, memory_order_relaxed);
+      *out_seq = seq;
+      return (int)(count < shm->capacity ? count : shm->capacity);
+    }
+    if ((spin & 63u) == 63u) {
+      sched_yield();
+    }
+  }
+  return U6_OBJSHM_ERR_BUSY;
+}
+
+int u6_objshm_read_valid(const U6ObjShm *shm, uint32_t seq) {
+  /* Orders every row load before the seq re-check. */
+  atomic_thread_fence(memory_order_acquire);
+  return atomic_load_explicit(&shm->header->seq, memory_order_relaxed) == seq;
+}
+
+void u6_objshm_row(const U6ObjShm *shm, uint32_t row, U6BridgeObject *out) {
+  memset(out, 0, sizeof(*out));
+  memcpy(out->key, shm->keys[row], U6_BRIDGE_KEY_MAX);
+  out->x = shm->x[row];
+  out->y = shm->y[row];
+  out->z = shm->z[row];
+  out->holder_key = shm->holder_key[row];
+  out->source_area = shm->source_area[row];
+  out->source_index = shm->source_index[row];
+  out->status = shm->status[row];
+  out->tile_flag = shm->tile_flag[row];
+  out->holder_kind = shm->holder_kind[row];
+}
+
+int u6_objshm_query(const U6ObjShm *shm, const U6BridgeQuery *q, U6BridgeObject **out, size_t *out_count) {
+  U6ObjSelect select;
+
+  if (shm == NULL || q == NULL || out == NULL || out_count == NULL) {
+    return U6_OBJSHM_ERR_NULL;
+  }
+  u6_objselect_init(&select, q->limit > 0 ? (size_t)q->limit : 1u);
+  for (uint32_t attempt = 0; attempt < QUERY_RETRY_LIMIT; attempt++) {
+    uint32_t seq;
+    int count = u6_objshm_read_begin(shm, &seq);
+
+    if (count < 0) {
+      u6_objselect_free(&select);
+      return count;
+    }
+    u6_objselect_reset(&select);
+    for (uint32_t row = 0; row < (uint32_t)count; row++) {
+      U6BridgeObject probe;
+      /* Only the filter columns are read until a row matches. */
+      probe.x = shm->x[row];
+      probe.y = shm->y[row];
+      probe.z = shm->z[row];
+      probe.tile_flag = shm->tile_flag[row];
+      if (!u6_bridge_object_matches(&probe, q)) {
+        continue;
+      }
+      u6_objshm_row(shm, row, &probe);
+      if (u6_objselect_push(&select, &probe) != U6_OBJSELECT_OK) {
+        u6_objselect_free(&select);
+        return U6_OBJSHM_ERR_ALLOC;
+      }
+    }
+    if (!u6_objshm_read_valid(shm, seq)) {
+      continue;
+    }
+    *out = u6_objselect_take(&select, out_count);
+    return U6_OBJSHM_OK;
+  }
+  u6_objselect_free(&select);
+  return U6_OBJSHM_ERR_BUSY;
+}
@@ -0,0 +1,574 @@
+#include "u6_objtable.h"
+#include "u6_objstatus.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define U6_OBJTABLE_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define U6_OBJTABLE_SSE2 1
+#endif
+
+#define U6_OBJTABLE_ALIGN 32u
+#define U6_OBJTABLE_SMALL_TYPE_SET 8u
+
+static size_t round_up(size_t v, size_t m) {
+  return (v + m - 1u) / m * m;
+}
+
+static void *alloc_column(size_t rows, size_t elem_size) {
+  void *p = aligned_alloc(U6_OBJTABLE_ALIGN, round_up(rows * elem_size, U6_OBJTABLE_ALIGN));
+  if (p != NULL) {
+    memset(p, 0, round_up(rows * elem_size, U6_OBJTABLE_ALIGN));
+  }
+  return p;
+}
+
+int u6_objtable_init(U6ObjTable *table, size_t capacity) {
+  size_t rows;
+
+  if (table == NULL) {
+    return U6_OBJTABLE_ERR_NULL;
+  }
+  memset(table, 0, sizeof(*table));
+  rows = round_up(capacity > 0 ? capacity : 1u, U6_OBJTABLE_BLOCK_ROWS);
+  table->x = (uint16_t *)alloc_column(rows, sizeof(uint16_t));
+  table->y = (uint16_t *)alloc_column(rows, sizeof(uint16_t));
+  table->z = (uint8_t *)alloc_column(rows, sizeof(uint8_t));
+  table->status = (uint8_t *)alloc_column(rows, sizeof(uint8_t));
+  table->obj_type = (uint16_t *)alloc_column(rows, sizeof(uint16_t));
+  table->obj_frame = (uint8_t *)alloc_column(rows, sizeof(uint8_t));
+  table->amount = (uint16_t *)alloc_column(rows, sizeof(uint16_t));
+  table->source_area = (uint16_t *)alloc_column(rows, sizeof(uint16_t));
+  table->source_index = (uint16_t *)alloc_column(rows, sizeof(uint16_t));
+  if (table->x == NULL || table->y == NULL || table->z == NULL || table->status == NULL || table->obj_type == NULL
+      || table->obj_frame == NULL || table->amount == NULL || table->source_area == NULL
+      || table->source_index == NULL) {
+    u6_objtable_free(table);
+    return U6_OBJTABLE_ERR_ALLOC;
+  }
+  table->capacity = capacity;
+  return U6_OBJTABLE_OK;
+}
+
+void u6_objtable_free(U6ObjTable *table) {
+  if (table == NULL) {
+    return;
+  }
+  free(table->x);
+  free(table->y);
+  free(table->z);
+  free(table->status);
+  free(table->obj_type);
+  free(table->obj_frame);
+  free(table->amount);
+  free(table->source_area);
+  free(table->source_index);
+  memset(table, 0, sizeof(*table));
+}
+
+/* Rows past count are never reported: the last selection word is masked. */
+void u6_objtable_clear(U6ObjTable *table) {
+  if (table == NULL) {
+    return;
+  }
+  table->count = 0;
+}
+
+int u6_objtable_append(U6ObjTable *table, const U6ObjBlkRecord *records, size_t count) {
+  if (table == NULL || table->x == NULL || (records == NULL && count > 0)) {
+    return U6_OBJTABLE_ERR_NULL;
+  }
+  if (count > table->capacity - table->count) {
+    return U6_OBJTABLE_ERR_FULL;
+  }
+  for (size_t i = 0; i < count; i++) {
+    const U6ObjBlkRecord *r = &records[i];
+    size_t row = table->count + i;
+    if (r->obj_frame > 0xffu) {
+      return U6_OBJTABLE_ERR_RANGE;
+    }
+    table->x[row] = r->x;
+    table->y[row] = r->y;
+    table->z[row] = r->z;
+    table->status[row] = r->status;
+    table->obj_type[row] = r->obj_type;
+    table->obj_frame[row] = (uint8_t)r->obj_frame;
+    table->amount[row] = r->amount;
+    table->source_area[row] = r->source_area;
+    table->source_index[row] = r->source_index;
+  }
+  table->count += count;
+  return U6_OBJTABLE_OK;
+}
+
+int u6_objtable_get(const U6ObjTable *table, size_t row, U6ObjBlkRecord *out_record) {
+  if (table == NULL || out_record == NULL) {
+    return U6_OBJTABLE_ERR_NULL;
+  }
+  if (row >= table->count) {
+    return U6_OBJTABLE_ERR_RANGE;
+  }
+  memset(out_record, 0, sizeof(*out_record));
+  out_record->status = table->status[row];
+  out_record->x = table->x[row];
+  out_record->y = table->y[row];
+  out_record->z = table->z[row];
+  out_record->obj_type = table->obj_type[row];
+  out_record->obj_frame = table->obj_frame[row];
+  out_record->shape_type = (uint16_t)((table->obj_type[row] & 0x03ffu) | ((unsigned)table->obj_frame[row] << 10));
+  out_record->amount = table->amount[row];
+  out_record->source_area = table->source_area[row];
+  out_record->source_index = table->source_index[row];
+  return U6_OBJTABLE_OK;
+}
+
+size_t u6_objtable_selection_words(size_t count) {
+  return (count + 63u) / 64u;
+}
+
+static uint64_t tail_mask(size_t count) {
+  size_t bits = count & 63u;
+  return bits == 0 ? ~(uint64_t)0 : (((uint64_t)1 << bits) - 1u);
+}
+
+void u6_objtable_select_all(const U6ObjTable *table, uint64_t *sel) {
+  size_t words;
+
+  if (table == NULL || sel == NULL) {
+    return;
+  }
+  words = u6_objtable_selection_words(table->count);
+  for (size_t w = 0; w < words; w++) {
+    sel[w] = ~(uint64_t)0;
+  }
+  if (words > 0) {
+    sel[words - 1] &= tail_mask(table->count);
+  }
+}
+
+static size_t popcount64(uint64_t v) {
+#if defined(__GNUC__)
+  return (size_t)__builtin_popcountll(v);
+#else
+  size_t n = 0;
+  while (v != 0) {
+    v &= v - 1u;
+    n++;
+  }
+  return n;
+#endif
+}
+
+static unsigned lowest_bit(uint64_t v) {
+#if defined(__GNUC__)
+  return (unsigned)__builtin_ctzll(v);
+#else
+  unsigned bit = 0;
+  while (((v >> bit) & 1u) == 0u) {
+    bit++;
+  }
+  return bit;
+#endif
+}
+
+size_t u6_objtable_selection_count(const U6ObjTable *table, const uint64_t *sel) {
+  size_t words;
+  size_t n = 0;
+
+  if (table == NULL || sel == NULL) {
+    return 0;
+  }
+  words = u6_objtable_selection_words(table->count);
+  for (size_t w = 0; w < words; w++) {
+    n += popcount64(sel[w]);
+  }
+  return n;
+}
+
+size_t u6_objtable_selection_rows(const U6ObjTable *table,
+                                  const uint64_t *sel,
+                                  uint32_t *out_rows,
+                                  size_t out_capacity) {
+  size_t words;
+  size_t n = 0;
+
+  if (table == NULL || sel == NULL) {
+    return 0;
+  }
+  words = u6_objtable_selection_words(table->count);
+  for (size_t w = 0; w < words; w++) {
+    uint64_t bits = sel[w];
+    while (bits != 0) {
+      unsigned bit = lowest_bit(bits);
+      if (n < out_capacity && out_rows != NULL) {
+        out_rows[n] = (uint32_t)(w * 64u + bit);
+      }
+      n++;
+      bits &= bits - 1u;
+    }
+  }
+  return n;
+}
+
+const char *u6_objtable_kernel_name(void) {
+#if defined(U6_OBJTABLE_AVX2)
+  return "avx2";
+#elif defined(U6_OBJTABLE_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+/*
+ * Scalar reference kernels. Blocks whose selection word is already zero are
+ * skipped; the vector kernels share that rule, so chained filters get
+ * cheaper as the selection thins out.
+ */
+static void finish_selection(const U6ObjTable *table, uint64_t *sel) {
+  size_t words = u6_objtable_selection_words(table->count);
+  if (words > 0) {
+    sel[words - 1] &= tail_mask(table->count);
+  }
+}
+
+void u6_objtable_filter_rect_scalar(const U6ObjTable *table,
+                                    uint16_t x0,
+                                    uint16_t y0,
+                                    uint16_t x1,
+                                    uint16_t y1,
+                                    uint64_t *sel) {
+  size_t words;
+
+  if (table == NULL || sel == NULL) {
+    return;
+  }
+  words = u6_objtable_selection_words(table->count);
+  for (size_t w = 0; w < words; w++) {
+    const size_t base = w * 64u;
+    uint64_t m = 0;
+    if (sel[w] == 0) {
+      continue;
+    }
+    for (unsigned i = 0; i < 64u; i++) {
+      uint16_t x = table->x[base + i];
+      uint16_t y = table->y[base + i];
+      m |= (uint64_t)(x >= x0 && x <= x1 && y >= y0 && y <= y1) << i;
+    }
+    sel[w] &= m;
+  }
+  finish_selection(table, sel);
+}
+
+void u6_objtable_filter_z_scalar(const U6ObjTable *table, uint8_t z, uint64_t *sel) {
+  size_t words;
+
+  if (table == NULL || sel == NULL) {
+    return;
+  }
+  words = u6_objtable_selection_words(table->count);
+  for (size_t w = 0; w < words; w++) {
+    const size_t base = w * 64u;
+    uint64_t m = 0;
+    if (sel[w] == 0) {
+      continue;
+    }
+    for (unsigned i = 0; i < 64u; i++) {
+      m |= (uint64_t)(table->z[base + i] == z) << i;
+    }
+    sel[w] &= m;
+  }
+  finish_selection(table, sel);
+}
+
+void u6_objtable_filter_coord_use_scalar(const U6ObjTable *table, uint8_t coord_use, uint64_t *sel) {
+  size_t words;
+
+  if (table == NULL || sel == NULL) {
+    return;
+  }
+  words = u6_objtable_selection_words(table->count);
+  for (size_t w = 0; w < words; w++) {
+    const size_t base = w * 64u;
+    uint64_t m = 0;
+    if (sel[w] == 0) {
+      continue;
+    }
+    for (unsigned i = 0; i < 64u; i++) {
+      m |= (uint64_t)(u6_obj_status_coord_use(table->status[base + i]) == coord_use) << i;
+    }
+    sel[w] &= m;
+  }
+  finish_selection(table, sel);
+}
+
+/* Type sets of any size go through a 64K-bit membership map. */
+static void filter_types_bitmap(const U6ObjTable *table, const uint16_t *types, size_t type_count, uint64_t *sel) {
+  static const size_t map_words = 65536u / 64u;
+  uint64_t *member;
+  size_t words = u6_objtable_selection_words(table->count);
+
+  member = (uint64_t *)calloc(map_words, sizeof(uint64_t));
+  if (member == NULL) {
+    /* Allocation failure cannot be reported here; select nothing. */
+    memset(sel, 0, words * sizeof(uint64_t));
+    return;
+  }
+  for (size_t t = 0; t < type_count; t++) {
+    member[types[t] >> 6] |= (uint64_t)1 << (types[t] & 63u);
+  }
+  for (size_t w = 0; w < words; w++) {
+    const size_t base = w * 64u;
+    uint64_t m = 0;
+    if (sel[w] == 0) {
+      continue;
+    }
+    for (unsigned i = 0; i < 64u; i++) {
+      uint16_t t = table->obj_type[base + i];
+      m |= ((member[t >> 6] >> (t & 63u)) & 1u) << i;
+    }
+    sel[w] &= m;
+  }
+  free(member);
+  finish_selection(table, sel);
+}
+
+void u6_objtable_filter_types_scalar(const U6ObjTable *table,
+                                     const uint16_t *types,
+                                     size_t type_count,
+                                     uint64_t *sel) {
+  if (table == NULL || sel == NULL || (types == NULL && type_count > 0)) {
+    return;
+  }
+  filter_types_bitmap(table, types, type_count, sel);
+}
+
+#if defined(U6_OBJTABLE_AVX2)
+
+/* (v - lo) <= width as unsigned 16-bit, via saturating subtract. */
+static __m256i in_range16(__m256i v, __m256i lo, __m256i width) {
+  __m256i d = _mm256_sub_epi16(v, lo);
+  return _mm256_cmpeq_epi16(_mm256_subs_epu16(d, width), _mm256_setzero_si256());
+}
+
+/* Two 16-lane 0/-1 masks -> 32 bits in row order. */
+static uint32_t movemask16x2(__m256i a, __m256i b) {
+  __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+  return (uint32_t)_mm256_movemask_epi8(packed);
+}
+
+static uint64_t block_rect(const U6ObjTable *table, size_t base, __m256i x0, __m256i xw, __m256i y0, __m256i yw) {
+  uint64_t m = 0;
+  for (unsigned k = 0; k < 2u; k++) {
+    const size_t r = base + k * 32u;
+    __m256i xa = _mm256_loadu_si256((const __m256i *)(table->x + r));
+    __m256i xb = _mm256_loadu_si256((const __m256i *)(table->x + r + 16u));
+    __m256i ya = _mm256_loadu_si256((const __m256i *)(table->y + r));
+    __m256i yb = _mm256_loadu_si256((const __m256i *)(table->y + r + 16u));
+    __m256i a = _mm256_and_si256(in_range16(xa, x0, xw), in_range16(ya, y0, yw));
+    __m256i b = _mm256_and_si256(in_range16(xb, x0, xw), in_range16(yb, y0, yw));
+    m |= (uint64_t)movemask16x2(a, b) << (k * 32u);
+  }
+  return m;
+}
+
+static uint64_t block_eq8(const uint8_t *col, size_t base, __m256i mask, __m256i want) {
+  __m256i a = _mm256_loadu_si256((const __m256i *)(col + base));
+  __m256i b = _mm256_loadu_si256((const __m256i *)(col + base + 32u));
+  uint32_t lo = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(a, mask), want));
+  uint32_t hi = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(b, mask), want));
+  return (uint64_t)lo | ((uint64_t)hi << 32);
+}
+
+static uint64_t block_types(const U6ObjTable *table, size_t base, const __m256i *want, size_t n) {
+  uint64_t m = 0;
+  for (unsigned k = 0; k < 2u; k++) {
+    const size_t r = base + k * 32u;
+    __m256i va = _mm256_loadu_si256((const __m256i *)(table->obj_type + r));
+    __m256i vb = _mm256_loadu_si256((const __m256i *)(table->obj_type + r + 16u));
+    __m256i a = _mm256_setzero_si256();
+    __m256i b = _mm256_setzero_si256();
+    for (size_t t = 0; t < n; t++) {
+      a = _mm256_or_si256(a, _mm256_cmpeq_epi16(va, want[t]));
+      b = _mm256_or_si256(b, _mm256_cmpeq_epi16(vb, want[t]));
+    }
+    m |= (uint64_t)movemask16x2(a, b) << (k * 32u);
+  }
+  return m;
+}
+
+#define U6_VEC __m256i
+#define U6_SET1_16(v) _mm256_set1_epi16((short)(v))
+#define U6_SET1_8(v) _mm256_set1_epi8((char)(v))
+
+#elif defined(U6_OBJTABLE_SSE2)
+
+static __m128i in_range16(__m128i v, __m128i lo, __m128i width) {
+  __m128i d = _mm_sub_epi16(v, lo);
+  return _mm_cmpeq_epi16(_mm_subs_epu16(d, width), _mm_setzero_si128());
+}
+
+static uint32_t movemask16x2(__m128i a, __m128i b) {
+  return (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(a, b));
+}
+
+static uint64_t block_rect(const U6ObjTable *table, size_t base, __m128i x0, __m128i xw, __m128i y0, __m128i yw) {
+  uint64_t m = 0;
+  for (unsigned k = 0; k < 4u; k++) {
+    const size_t r = base + k * 16u;
+    __m128i xa = _mm_loadu_si128((const __m128i *)(table->x + r));
+    __m128i xb = _mm_loadu_si128((const __m128i *)(table->x + r + 8u));
+    __m128i ya = _mm_loadu_si128((const __m128i *)(table->y + r));
+    __m128i yb = _mm_loadu_si128((const __m128i *)(table->y + r + 8u));
+    __m128i a = _mm_and_si128(in_range16(xa, x0, xw), in_range16(ya, y0, yw));
+    __m128i b = _mm_and_si128(in_range16(xb, x0, xw), in_range16(yb, y0, yw));
+    m |= (uint64_t)movemask16x2(a, b) << (k * 16u);
+  }
+  return m;
+}
+
+static uint64_t block_eq8(const uint8_t *col, size_t base, __m128i mask, __m128i want) {
+  uint64_t m = 0;
+  for (unsigned k = 0; k < 4u; k++) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(col + base + k * 16u));
+    m |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, mask), want)) << (k * 16u);
+  }
+  return m;
+}
+
+static uint64_t block_types(const U6ObjTable *table, size_t base, const __m128i *want, size_t n) {
+  uint64_t m = 0;
+  for (unsigned k = 0; k < 4u; k++) {
+    const size_t r = base + k * 16u;
+    __m128i va = _mm_loadu_si128((const __m128i *)(table->obj_type + r));
+    __m128i vb = _mm_loadu_si128((const __m128i *)(table->obj_type + r + 8u));
+    __m128i a = _mm_setzero_si128();
+    __m128i b = _mm_setzero_si128();
+    for (size_t t = 0; t < n; t++) {
+      a = _mm_or_si128(a, _mm_cmpeq_epi16(va, want[t]));
+      b = _mm_or_si128(b, _mm_cmpeq_epi16(vb, want[t]));
+    }
+    m |= (uint64_t)movemask16x2(a, b) << (k * 16u);
+  }
+  return m;
+}
+
+#define U6_VEC __m128i
+#define U6_SET1_16(v) _mm_set1_epi16((short)(v))
+#define U6_SET1_8(v) _mm_set1_epi8((char)(v))
+
+#endif
+
+#if defined(U6_VEC)
+
+void u6_objtable_filter_rect(const U6ObjTable *table, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint64_t *sel) {
+  U6_VEC vx0;
+  U6_VEC vxw;
+  U6_VEC vy0;
+  U6_VEC vyw;
+  size_t words;
+
+  if (table == NULL || sel == NULL) {
+    return;
+  }
+  words = u6_objtable_selection_words(table->count);
+  if (x0 > x1 || y0 > y1) {
+    memset(sel, 0, words * sizeof(uint64_t));
+    return;
+  }
+  vx0 = U6_SET1_16(x0);
+  vxw = U6_SET1_16(x1 - x0);
+  vy0 = U6_SET1_16(y0);
+  vyw = U6_SET1_16(y1 - y0);
+  for (size_t w = 0; w < words; w++) {
+    if (sel[w] != 0) {
+      sel[w] &= block_rect(table, w * 64u, vx0, vxw, vy0, vyw);
+    }
+  }
+  finish_selection(table, sel);
+}
+
+void u6_objtable_filter_z(const U6ObjTable *table, uint8_t z, uint64_t *sel) {
+  U6_VEC mask;
+  U6_VEC want;
+  size_t words;
+
+  if (table == NULL || sel == NULL) {
+    return;
+  }
+  words = u6_objtable_selection_words(table->count);
+  mask = U6_SET1_8(0xff);
+  want = U6_SET1_8(z);
+  for (size_t w = 0; w < words; w++) {
+    if (sel[w] != 0) {
+      sel[w] &= block_eq8(table->z, w * 64u, mask, want);
+    }
+  }
+  finish_selection(table, sel);
+}
+
+void u6_objtable_filter_coord_use(const U6ObjTable *table, uint8_t coord_use, uint64_t *sel) {
+  U6_VEC mask;
+  U6_VEC want;
+  size_t words;
+
+  if (table == NULL || sel == NULL) {
+    return;
+  }
+  words = u6_objtable_selection_words(table->count);
+  mask = U6_SET1_8(U6_OBJ_STATUS_COORD_USE_MASK);
+  want = U6_SET1_8(coord_use);
+  for (size_t w = 0; w < words; w++) {
+    if (sel[w] != 0) {
+      sel[w] &= block_eq8(table->status, w * 64u, mask, want);
+    }
+  }
+  finish_selection(table, sel);
+}
+
+void u6_objtable_filter_types(const U6ObjTable *table, const uint16_t *types, size_t type_count, uint64_t *sel) {
+  U6_VEC want[U6_OBJTABLE_SMALL_TYPE_SET];
+  size_t words;
+
+  if (table == NULL || sel == NULL || (types == NULL && type_count > 0)) {
+    return;
+  }
+  if (type_count > U6_OBJTABLE_SMALL_TYPE_SET) {
+    filter_types_bitmap(table, types, type_count, sel);
+    return;
+  }
+  words = u6_objtable_selection_words(table->count);
+  for (size_t t = 0; t < type_count; t++) {
+    want[t] = U6_SET1_16(types[t]);
+  }
+  for (size_t w = 0; w < words; w++) {
+    if (sel[w] != 0) {
+      sel[w] &= block_types(table, w * 64u, want, type_count);
+    }
+  }
+  finish_selection(table, sel);
+}
+
+#else
+
+void u6_objtable_filter_rect(const U6ObjTable *table, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint64_t *sel) {
+  u6_objtable_filter_rect_scalar(table, x0, y0, x1, y1, sel);
+}
+
+void u6_objtable_filter_z(const U6ObjTable *table, uint8_t z, uint64_t *sel) {
+  u6_objtable_filter_z_scalar(table, z, sel);
+}
+
+void u6_objtable_filter_coord_use(const U6ObjTable *table, uint8_t coord_use, uint64_t *sel) {
+  u6_objtable_filter_coord_use_scalar(table, coord_use, sel);
+}
+
+void u6_objtable_filter_types(const U6ObjTable *table, const uint16_t *types, size_t type_count, uint64_t *sel) {
+  u6_objtable_filter_types_scalar(table, types, type_count, sel);
+}
+
+#endif
@@ -0,0 +1,327 @@
+#include "u6_schedule.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "u6_objblk.h"
+
+enum {
+  HOURS_PER_DAY = 24,
+  DAYS_PER_MONTH = 28,
+  MONTHS_PER_YEAR = 13
+};
+
+static uint16_t read_u16_le(const uint8_t *p) {
+  return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static void decode_entry(const uint8_t *p, U6ScheduleEntry *out) {
+  out->hour = (uint8_t)(p[0] & 0x1fu);
+  out->day_of_week = (uint8_t)(p[0] >> 5);
+  out->worktype = p[1];
+  out->x = (uint16_t)p[2] | (uint16_t)((p[3] & 0x03u) << 8);
+  out->y = (uint16_t)(p[3] >> 2) | (uint16_t)((p[4] & 0x0fu) << 6);
+  out->z = (uint8_t)((p[4] >> 4) & 0x0fu);
+}
+
+int u6_schedule_parse(const uint8_t *bytes, size_t size, U6ScheduleTable *out_table) {
+  uint16_t total;
+
+  if (bytes == NULL || out_table == NULL) {
+    return U6_SCHEDULE_ERR_NULL;
+  }
+  memset(out_table, 0, sizeof(*out_table));
+  if (size < U6_SCHEDULE_HEADER_SIZE) {
+    return U6_SCHEDULE_ERR_SIZE;
+  }
+  total = read_u16_le(bytes + U6_SCHEDULE_ACTORS * 2u);
+  if (size < U6_SCHEDULE_HEADER_SIZE + (size_t)total * U6_SCHEDULE_ENTRY_SIZE) {
+    return U6_SCHEDULE_ERR_SIZE;
+  }
+  for (size_t a = 0; a < U6_SCHEDULE_ACTORS; a++) {
+    uint16_t first = read_u16_le(bytes + a * 2u);
+    uint16_t end = a + 1u < U6_SCHEDULE_ACTORS ? read_u16_le(bytes + (a + 1u) * 2u) : total;
+    if (first > end || end > total) {
+      return U6_SCHEDULE_ERR_FORMAT;
+    }
+    out_table->first[a] = first;
+    out_table->count[a] = (uint16_t)(end - first);
+  }
+  if (total > 0) {
+    out_table->entries = (U6ScheduleEntry *)malloc((size_t)total * sizeof(U6ScheduleEntry));
+    if (out_table->entries == NULL) {
+      memset(out_table, 0, sizeof(*out_table));
+      return U6_SCHEDULE_ERR_ALLOC;
+    }
+  }
+  for (size_t i = 0; i < total; i++) {
+    decode_entry(bytes + U6_SCHEDULE_HEADER_SIZE + i * U6_SCHEDULE_ENTRY_SIZE, &out_table->entries[i]);
+  }
+  out_table->entry_count = total;
+  return U6_SCHEDULE_OK;
+}
+
+int u6_schedule_load_file(const char *path, U6ScheduleTable *out_table) {
+  U6ObjBlkMappedFile mapped;
+  int rc;
+
+  if (path == NULL || out_table == NULL) {
+    return U6_SCHEDULE_ERR_NULL;
+  }
+  memset(out_table, 0, sizeof(*out_table));
+  if (u6_objblk_map_file(path, &mapped) != 0 || !mapped.loaded) {
+    return U6_SCHEDULE_ERR_IO;
+  }
+  rc = u6_schedule_parse(mapped.bytes, mapped.size, out_table);
+  u6_objblk_unmap_file(&mapped);
+  return rc;
+}
+
+void u6_schedule_free(U6ScheduleTable *table) {
+  if (table == NULL) {
+    return;
+  }
+  free(table->entries);
+  memset(table, 0, sizeof(*table));
+}
+
+uint8_t u6_schedule_day_of_week(const SimWorldState *world) {
+  uint8_t day = (world != NULL && world->date_d > 0) ? world->date_d : 1u;
+  return (uint8_t)((day - 1u) % U6_SCHEDULE_DAYS_PER_WEEK + 1u);
+}
+
+uint32_t u6_schedule_world_hours(const SimWorldState *world) {
+  uint32_t days;
+
+  if (world == NULL) {
+    return 0;
+  }
+  days = ((uint32_t)world->date_y * MONTHS_PER_YEAR + (world->date_m > 0 ? world->date_m - 1u : 0u)) * DAYS_PER_MONTH
+         + (world->date_d > 0 ? world->date_d - 1u : 0u);
+  return days * HOURS_PER_DAY + world->time_h;
+}
+
+static uint32_t week_hour(const SimWorldState *world) {
+  return (uint32_t)(u6_schedule_day_of_week(world) - 1u) * HOURS_PER_DAY + world->time_h;
+}
+
+uint16_t u6_schedule_active_entry(const U6ScheduleTable *table, uint8_t actor, uint8_t day_of_week, uint8_t hour) {
+  const U6ScheduleEntry *entries;
+  uint16_t count;
+
+  if (table == NULL || table->count[actor] == 0) {
+    return U6_SCHEDULE_NO_ENTRY;
+  }
+  entries = table->entries + table->first[actor];
+  count = table->count[actor];
+  for (uint16_t i = 0; i < count; i++) {
+    if (entries[i].day_of_week > day_of_week || entries[i].hour > hour) {
+      return (uint16_t)(table->first[actor] + (i > 0 ? i - 1u : count - 1u));
+    }
+  }
+  return (uint16_t)(table->first[actor] + count - 1u);
+}
+
+static uint16_t active_at_week_hour(const U6ScheduleTable *table, uint8_t actor, uint32_t wh) {
+  return u6_schedule_active_entry(table,
+                                  actor,
+                                  (uint8_t)(wh / HOURS_PER_DAY + 1u),
+                                  (uint8_t)(wh % HOURS_PER_DAY));
+}
+
+/*
+ * One event per actor per week hour whose active entry differs from the hour
+ * before (hour 0 compares against the end of the week). The first pass
+ * counts events per bucket, the second writes them in bucket order.
+ */
+static size_t build_events(const U6ScheduleTable *table, U6ScheduleEngine *engine, int fill) {
+  uint32_t cursor[U6_SCHEDULE_WEEK_HOURS];
+  size_t total = 0;
+
+  if (fill) {
+    memcpy(cursor, engine->bucket_start, sizeof(cursor));
+  } else {
+    memset(engine->bucket_start, 0, sizeof(engine->bucket_start));
+  }
+  for (uint32_t a = 0; a < U6_SCHEDULE_ACTORS; a++) {
+    uint16_t prev;
+
+    if (table->count[a] == 0) {
+      continue;
+    }
+    prev = active_at_week_hour(table, (uint8_t)a, U6_SCHEDULE_WEEK_HOURS - 1u);
+    for (uint32_t wh = 0; wh < U6_SCHEDULE_WEEK_HOURS; wh++) {
+      uint16_t entry = active_at_week_hour(table, (uint8_t)a, wh);
+      if (entry == prev) {
+        continue;
+      }
+      prev = entry;
+      total++;
+      if (fill) {
+        U6ScheduleEvent *ev = &engine->events[cursor[wh]++];
+        ev->entry = entry;
+        ev->actor = (uint8_t)a;
+        ev->reserved = 0;
+      } else {
+        engine->bucket_start[wh + 1u]++;
+      }
+    }
+  }
+  return total;
+}
+
+int u6_schedule_engine_init(U6ScheduleEngine *engine, const U6ScheduleTable *table) {
+  if (engine == NULL || table == NULL) {
+    return U6_SCHEDULE_ERR_NULL;
+  }
+  memset(engine, 0, sizeof(*engine));
+  engine->table = table;
+  engine->event_count = build_events(table, engine, 0);
+  for (uint32_t wh = 0; wh < U6_SCHEDULE_WEEK_HOURS; wh++) {
+    engine->bucket_start[wh + 1u] += engine->bucket_start[wh];
+  }
+  if (engine->event_count > 0) {
+    engine->events = (U6ScheduleEvent *)malloc(engine->event_count * sizeof(U6ScheduleEvent));
+    if (engine->events == NULL) {
+      memset(engine, 0, sizeof(*engine));
+      return U6_SCHEDULE_ERR_ALLOC;
+    }
+    build_events(table, engine, 1);
+  }
+  for (uint32_t a = 0; a < U6_SCHEDULE_ACTORS; a++) {
+    engine->current[a] = U6_SCHEDULE_NO_ENTRY;
+    engine->unplaced[a] = U6_SCHEDULE_NO_ENTRY;
+  }
+  return U6_SCHEDULE_OK;
+}
+
+void u6_schedule_engine_free(U6ScheduleEngine *engine) {
+  if (engine == NULL) {
+    return;
+  }
+  free(engine->events);
+  memset(engine, 0, sizeof(*engine));
+}
+
+static void set_unplaced(U6ScheduleEngine *engine, uint8_t actor, uint16_t entry) {
+  if (engine->unplaced[actor] == U6_SCHEDULE_NO_ENTRY && entry != U6_SCHEDULE_NO_ENTRY) {
+    engine->unplaced_count++;
+  } else if (engine->unplaced[actor] != U6_SCHEDULE_NO_ENTRY && entry == U6_SCHEDULE_NO_ENTRY) {
+    engine->unplaced_count--;
+  }
+  engine->unplaced[actor] = entry;
+}
+
+int u6_schedule_engine_bind(U6ScheduleEngine *engine, uint8_t actor, uint16_t npc_id) {
+  if (engine == NULL) {
+    return U6_SCHEDULE_ERR_NULL;
+  }
+  engine->npc_id[actor] = npc_id;
+  engine->current[actor] = U6_SCHEDULE_NO_ENTRY;
+  set_unplaced(engine, actor, U6_SCHEDULE_NO_ENTRY);
+  engine->synced = 0;
+  return U6_SCHEDULE_OK;
+}
+
+size_t u6_schedule_engine_bind_matching(U6ScheduleEngine *engine, const U6EntityState *state) {
+  size_t bound = 0;
+
+  if (engine == NULL || state == NULL) {
+    return 0;
+  }
+  for (uint32_t a = 1; a < U6_SCHEDULE_ACTORS; a++) {
+    if (engine->table->count[a] == 0 || u6_entities_find_npc((U6EntityState *)state, (uint16_t)a) == NULL) {
+      continue;
+    }
+    u6_schedule_engine_bind(engine, (uint8_t)a, (uint16_t)a);
+    bound++;
+  }
+  return bound;
+}
+
+/* current only advances once the NPC is really there; a failed move is kept for retry. */
+static int place_actor(U6ScheduleEngine *engine, U6EntityState *state, uint8_t actor, uint16_t entry) {
+  const U6ScheduleEntry *e;
+
+  if (engine->npc_id[actor] == 0 || entry == U6_SCHEDULE_NO_ENTRY) {
+    return 0;
+  }
+  if (engine->current[actor] == entry) {
+    set_unplaced(engine, actor, U6_SCHEDULE_NO_ENTRY);
+    return 0;
+  }
+  e = &engine->table->entries[entry];
+  if (u6_entities_move_npc(state, engine->npc_id[actor], (int16_t)e->x, (int16_t)e->y, (int16_t)e->z) != 0) {
+    set_unplaced(engine, actor, entry);
+    return 0;
+  }
+  engine->current[actor] = entry;
+  set_unplaced(engine, actor, U6_SCHEDULE_NO_ENTRY);
+  engine->moves++;
+  return 1;
+}
+
+static int retry_unplaced(U6ScheduleEngine *engine, U6EntityState *state) {
+  int moved = 0;
+  for (uint32_t a = 0; a < U6_SCHEDULE_ACTORS && engine->unplaced_count > 0u; a++) {
+    if (engine->unplaced[a] != U6_SCHEDULE_NO_ENTRY) {
+      moved += place_actor(engine, state, (uint8_t)a, engine->unplaced[a]);
+    }
+  }
+  return moved;
+}
+
+int u6_schedule_engine_sync(U6ScheduleEngine *engine, U6EntityState *state, const SimWorldState *world) {
+  uint16_t pending[U6_SCHEDULE_ACTORS];
+  uint8_t touched[U6_SCHEDULE_ACTORS];
+  size_t touched_count = 0;
+  uint32_t hours;
+  uint32_t wh;
+  int moved = 0;
+
+  if (engine == NULL || state == NULL || world == NULL) {
+    return U6_SCHEDULE_ERR_NULL;
+  }
+  hours = u6_schedule_world_hours(world);
+  wh = week_hour(world);
+  if (engine->synced && hours == engine->hour_clock) {
+    return engine->unplaced_count > 0u ? retry_unplaced(engine, state) : 0;
+  }
+  if (!engine->synced || hours < engine->hour_clock || hours - engine->hour_clock >= U6_SCHEDULE_WEEK_HOURS) {
+    for (uint32_t a = 0; a < U6_SCHEDULE_ACTORS; a++) {
+      if (engine->npc_id[a] != 0) {
+        moved += place_actor(engine, state, (uint8_t)a, active_at_week_hour(engine->table, (uint8_t)a, wh));
+      }
+    }
+  } else {
+    uint32_t crossed = hours - engine->hour_clock;
+    uint32_t b = (wh + U6_SCHEDULE_WEEK_HOURS - crossed + 1u) % U6_SCHEDULE_WEEK_HOURS;
+
+    for (uint32_t a = 0; a < U6_SCHEDULE_ACTORS; a++) {
+      pending[a] = U6_SCHEDULE_NO_ENTRY;
+    }
+    for (uint32_t n = 0; n < crossed; n++) {
+      for (uint32_t i = engine->bucket_start[b]; i < engine->bucket_start[b + 1u]; i++) {
+        const U6ScheduleEvent *ev = &engine->events[i];
+        if (engine->npc_id[ev->actor] == 0) {
+          continue;
+        }
+        if (pending[ev->actor] == U6_SCHEDULE_NO_ENTRY) {
+          touched[touched_count++] = ev->actor;
+        }
+        pending[ev->actor] = ev->entry;
+      }
+      b = b + 1u == U6_SCHEDULE_WEEK_HOURS ? 0u : b + 1u;
+    }
+    for (size_t i = 0; i < touched_count; i++) {
+      moved += place_actor(engine, state, touched[i], pending[touched[i]]);
+    }
+    /* Actors without a new event still owe an earlier failed move. */
+    if (engine->unplaced_count > 0u) {
+      moved += retry_unplaced(engine, state);
+    }
+  }
+  engine->hour_clock = hours;
+  engine->synced = 1;
+  return moved;
+}
@@ -0,0 +1,51 @@
+#include "test_bridge_objects.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t rng_state = 1u;
+
+void test_rand_seed(uint32_t seed) {
+  rng_state = seed;
+}
+
+uint32_t test_rand(void) {
+  rng_state = rng_state * 1664525u + 1013904223u;
+  return rng_state >> 8;
+}
+
+void test_bridge_object_fill(U6BridgeObject *o, const TestBridgeRanges *ranges) {
+  memset(o, 0, sizeof(*o));
+  o->x = (int)(test_rand() % ranges->xy_span) + ranges->xy_min;
+  o->y = (int)(test_rand() % ranges->xy_span) + ranges->xy_min;
+  o->z = (int)(test_rand() % ranges->z_span);
+  o->status = (uint8_t)test_rand();
+  o->tile_flag = (uint8_t)test_rand();
+  o->holder_kind = (uint8_t)(test_rand() % 3u);
+  o->holder_key = (int)test_rand() - 0x400000;
+  o->source_area = (int)(test_rand() % ranges->area_span);
+  o->source_index = (int)(test_rand() % ranges->index_span);
+}
+
+static int cmp_objects(const void *a, const void *b) {
+  return u6_bridge_object_cmp((const U6BridgeObject *)a, (const U6BridgeObject *)b);
+}
+
+size_t test_bridge_reference_query(const U6BridgeObject *objects, size_t count, const U6BridgeQuery *q, U6BridgeObject *out) {
+  U6BridgeObject *sorted;
+  size_t limit = q->limit > 0 ? (size_t)q->limit : 1u;
+  size_t n = 0;
+
+  if (count == 0u || (sorted = (U6BridgeObject *)malloc(count * sizeof(U6BridgeObject))) == NULL) {
+    return 0;
+  }
+  memcpy(sorted, objects, count * sizeof(U6BridgeObject));
+  qsort(sorted, count, sizeof(U6BridgeObject), cmp_objects);
+  for (size_t i = 0; i < count && n < limit; i++) {
+    if (u6_bridge_object_matches(&sorted[i], q)) {
+      out[n++] = sorted[i];
+    }
+  }
+  free(sorted);
+  return n;
+}
@@ -0,0 +1,31 @@
+#ifndef U6M_TEST_BRIDGE_OBJECTS_H
+#define U6M_TEST_BRIDGE_OBJECTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "u6_bridge_proto.h"
+
+/*
+ * Shared fixture for the world object table tests: one seeded LCG, a random
+ * object generator and the sort-everything-then-filter query that the argv
+ * query bridge used. Tests pick their own key scheme and ranges.
+ */
+typedef struct TestBridgeRanges {
+  int xy_min;
+  uint32_t xy_span;
+  uint32_t z_span;
+  uint32_t area_span;
+  uint32_t index_span;
+} TestBridgeRanges;
+
+void test_rand_seed(uint32_t seed);
+uint32_t test_rand(void);
+
+/* Zeroes *o (key included) and fills every other field from test_rand(). */
+void test_bridge_object_fill(U6BridgeObject *o, const TestBridgeRanges *ranges);
+
+/* Writes up to max(limit, 1) matches of q over objects[0..count) to out, in comparator order. */
+size_t test_bridge_reference_query(const U6BridgeObject *objects, size_t count, const U6BridgeQuery *q, U6BridgeObject *out);
+
+#endif
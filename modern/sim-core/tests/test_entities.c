@@ -1,6 +1,7 @@
 #include "u6_entities.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static int test_npc_patrol_step(void) {
@@ -117,6 +118,813 @@ static int test_entities_roundtrip(void) {
   return 0;
 }
 
+static int test_id_index(void) {
+  static U6EntityState state;
+  static U6EntityState copy;
+  static uint8_t blob[8192];
+  U6ObjectState obj;
+  U6NpcState npc;
+  size_t written = 0;
+
+  u6_entities_init(&state);
+  memset(&obj, 0, sizeof(obj));
+  memset(&npc, 0, sizeof(npc));
+  /* Strided ids: low bits are constant, so placement relies on the hash. */
+  for (uint16_t i = 0; i < U6M_INLINE_OBJECTS; i++) {
+    obj.object_id = (uint16_t)(i * 256u + 3u);
+    obj.tile_id = i;
+    if (u6_entities_add_object(&state, &obj) != 0) {
+      return 1;
+    }
+  }
+  for (uint16_t i = 0; i < U6M_INLINE_NPCS; i++) {
+    npc.npc_id = (uint16_t)(0xffffu - i);
+    if (u6_entities_add_npc(&state, &npc) != 0) {
+      return 2;
+    }
+  }
+  u6_entities_remove_object(&state, 3u);
+  obj.object_id = 3u;
+  u6_entities_add_object(&state, &obj);
+  obj.object_id = 2u;
+  if (u6_entities_add_object(&state, &obj) != -2) {
+    return 3;
+  }
+  obj.object_id = 259u;
+  u6_entities_remove_object(&state, 1027u);
+  if (u6_entities_add_object(&state, &obj) != -3) {
+    return 4;
+  }
+  npc.npc_id = 0xffffu;
+  u6_entities_remove_npc(&state, 0xfff0u);
+  if (u6_entities_add_npc(&state, &npc) != -3) {
+    return 5;
+  }
+
+  /* Remove every third object; the rest must still resolve to themselves. */
+  for (uint16_t i = 0; i < U6M_INLINE_OBJECTS; i += 3) {
+    uint16_t id = (uint16_t)(i * 256u + 3u);
+    int rc = u6_entities_remove_object(&state, id);
+    if (rc != 0 && !(id == 1027u && rc == -2)) {
+      return 6;
+    }
+  }
+  if (u6_entities_remove_object(&state, 3u) != -2 || u6_entities_remove_npc(&state, 0xfff0u) != -2) {
+    return 7;
+  }
+  for (uint16_t i = 0; i < U6M_INLINE_OBJECTS; i++) {
+    uint16_t id = (uint16_t)(i * 256u + 3u);
+    U6ObjectState *found = u6_entities_find_object(&state, id);
+    int expect = (i % 3u) != 0u && id != 1027u;
+    if ((found != NULL) != expect || (found != NULL && found->object_id != id)) {
+      return 8;
+    }
+  }
+  for (uint16_t i = 0; i < U6M_INLINE_NPCS; i++) {
+    uint16_t id = (uint16_t)(0xffffu - i);
+    U6NpcState *found = u6_entities_find_npc(&state, id);
+    if ((found != NULL) != (id != 0xfff0u) || (found != NULL && found->npc_id != id)) {
+      return 9;
+    }
+  }
+
+  if (u6_entities_serialize(&state, blob, sizeof(blob), &written) != 0
+      || u6_entities_deserialize(&copy, blob, written) != 0) {
+    return 10;
+  }
+  for (size_t i = 0; i < u6_entities_object_slots(&state); i++) {
+    const U6ObjectState *live = u6_entities_object_at(&state, i);
+    const U6ObjectState *found = live != NULL ? u6_entities_find_object(&copy, live->object_id) : NULL;
+    if (live != NULL && (found == NULL || memcmp(found, live, sizeof(*live)) != 0)) {
+      return 11;
+    }
+  }
+  if (copy.object_count != state.object_count) {
+    return 11;
+  }
+  if (u6_entities_find_npc(&copy, 0xfffeu) == NULL || u6_entities_find_npc(&copy, 0xfff0u) != NULL) {
+    return 12;
+  }
+
+  /* Duplicate ids in a blob are rejected. */
+  blob[U6M_ENTITY_HEADER_SIZE + U6M_ENTITY_OBJECT_SIZE] = blob[U6M_ENTITY_HEADER_SIZE];
+  blob[U6M_ENTITY_HEADER_SIZE + U6M_ENTITY_OBJECT_SIZE + 1] = blob[U6M_ENTITY_HEADER_SIZE + 1];
+  if (u6_entities_deserialize(&copy, blob, written) != -7) {
+    return 13;
+  }
+
+  /* Direct id edits are picked up by reindex. */
+  state.npcs[0].npc_id = 77u;
+  if (u6_entities_reindex(&state) != 0 || u6_entities_find_npc(&state, 77u) != &state.npcs[0]) {
+    return 14;
+  }
+  return 0;
+}
+
+static int test_growable_pools(void) {
+  static U6EntityState state;
+  static U6EntityState copy;
+  static uint8_t blob[U6M_ENTITY_HEADER_SIZE + 5000 * U6M_ENTITY_OBJECT_SIZE + U6M_MAX_NPCS * U6M_ENTITY_NPC_SIZE];
+  static uint8_t v2[U6M_ENTITY_HEADER_SIZE_V2 + U6M_ENTITY_OBJECT_SIZE];
+  size_t arena_size = u6_entities_arena_bytes(5000, U6M_MAX_NPCS);
+  uint8_t *buffer = (uint8_t *)malloc(arena_size);
+  uint8_t *copy_buffer = (uint8_t *)malloc(arena_size);
+  U6EntityArena arena;
+  U6EntityArena copy_arena;
+  U6ObjectState obj;
+  U6NpcState npc;
+  U6ObjectState *pinned;
+  U6EntityHandle handle;
+  U6EntityHandle npc_handle;
+  size_t written = 0;
+  size_t used;
+  int rc = 0;
+
+  if (buffer == NULL || copy_buffer == NULL) {
+    free(buffer);
+    free(copy_buffer);
+    return 1;
+  }
+  u6_entity_arena_init(&arena, buffer, arena_size);
+  u6_entities_init_arena(&state, &arena);
+  memset(&obj, 0, sizeof(obj));
+  memset(&npc, 0, sizeof(npc));
+
+  for (uint16_t i = 0; i < 5000u; i++) {
+    obj.object_id = (uint16_t)(i * 13u + 1u);
+    obj.tile_id = i;
+    if (u6_entities_add_object(&state, &obj) != 0) {
+      rc = 2;
+      goto done;
+    }
+  }
+  for (uint16_t i = 0; i < U6M_MAX_NPCS; i++) {
+    npc.npc_id = i;
+    npc.map_x = (int16_t)i;
+    if (u6_entities_add_npc(&state, &npc) != 0) {
+      rc = 3;
+      goto done;
+    }
+  }
+  if (u6_entities_add_npc(&state, &npc) != -3) {
+    rc = 4;
+    goto done;
+  }
+  npc.npc_id = 999u;
+  if (u6_entities_add_npc(&state, &npc) != -2) {
+    rc = 4;
+    goto done;
+  }
+
+  /* Pointers and handles stay valid while other entities come and go. */
+  pinned = u6_entities_find_object(&state, (uint16_t)(4321u * 13u + 1u));
+  handle = u6_entities_object_handle(&state, (uint16_t)(4321u * 13u + 1u));
+  npc_handle = u6_entities_npc_handle(&state, 200u);
+  if (pinned == NULL || pinned->tile_id != 4321u || u6_entities_object_from_handle(&state, handle) != pinned) {
+    rc = 5;
+    goto done;
+  }
+  for (uint16_t i = 0; i < 5000u; i += 2u) {
+    if (i != 4320u && u6_entities_remove_object(&state, (uint16_t)(i * 13u + 1u)) != 0) {
+      rc = 6;
+      goto done;
+    }
+  }
+  used = arena.used;
+  for (uint16_t i = 0; i < 2000u; i++) {
+    obj.object_id = (uint16_t)((i + 1u) * 13u);
+    obj.tile_id = (uint16_t)(60000u + i);
+    if (u6_entities_add_object(&state, &obj) != 0) {
+      rc = 7;
+      goto done;
+    }
+  }
+  if (arena.used != used || u6_entities_object_slots(&state) != 5000u || state.object_count != 4501u) {
+    rc = 8;
+    goto done;
+  }
+  if (u6_entities_find_object(&state, (uint16_t)(4321u * 13u + 1u)) != pinned || pinned->tile_id != 4321u) {
+    rc = 9;
+    goto done;
+  }
+
+  /* A removed entity's handle goes stale even when its slot is reused. */
+  u6_entities_remove_object(&state, (uint16_t)(4321u * 13u + 1u));
+  obj.object_id = 7u;
+  u6_entities_add_object(&state, &obj);
+  if (u6_entities_object_from_handle(&state, handle) != NULL || u6_entities_find_object(&state, 7u) != pinned) {
+    rc = 10;
+    goto done;
+  }
+  if (u6_entities_npc_from_handle(&state, npc_handle) == NULL
+      || u6_entities_npc_from_handle(&state, npc_handle)->map_x != 200
+      || u6_entities_object_from_handle(&state, U6M_ENTITY_HANDLE_NONE) != NULL) {
+    rc = 11;
+    goto done;
+  }
+
+  if (u6_entities_serialize(&state, blob, sizeof(blob), &written) != 0
+      || written != u6_entities_serialized_size(&state)) {
+    rc = 12;
+    goto done;
+  }
+  u6_entity_arena_init(&copy_arena, copy_buffer, arena_size);
+  if (u6_entities_deserialize_arena(&copy, &copy_arena, blob, written) != 0
+      || copy.object_count != state.object_count || copy.npc_count != U6M_MAX_NPCS) {
+    rc = 13;
+    goto done;
+  }
+  for (size_t i = 0; i < u6_entities_object_slots(&state); i++) {
+    const U6ObjectState *live = u6_entities_object_at(&state, i);
+    const U6ObjectState *found = live != NULL ? u6_entities_find_object(&copy, live->object_id) : NULL;
+    if (live != NULL && (found == NULL || memcmp(found, live, sizeof(*live)) != 0)) {
+      rc = 14;
+      goto done;
+    }
+  }
+  /* Without an arena only the inline pages are available. */
+  if (u6_entities_deserialize(&copy, blob, written) != -8 || copy.object_count != 0u) {
+    rc = 15;
+    goto done;
+  }
+
+  /* Version 2 blobs (u16 counts, 12-byte header) still load. */
+  v2[0] = 0x55;
+  v2[1] = 0x36;
+  v2[2] = 0x45;
+  v2[3] = 0x4e;
+  v2[4] = 2;
+  v2[6] = 1;
+  v2[U6M_ENTITY_HEADER_SIZE_V2] = 42;
+  v2[U6M_ENTITY_HEADER_SIZE_V2 + 12] = 0x08;
+  if (u6_entities_deserialize(&copy, v2, sizeof(v2)) != 0 || copy.object_count != 1u
+      || u6_entities_find_object(&copy, 42u) == NULL) {
+    rc = 16;
+    goto done;
+  }
+
+done:
+  free(buffer);
+  free(copy_buffer);
+  return rc;
+}
+
+/* Brute-force subtree size over holder fields. */
+static size_t naive_contents(U6EntityState *state, uint8_t holder_kind, uint16_t holder_id, uint32_t *quantity) {
+  size_t total = 0;
+
+  for (size_t i = 0; i < u6_entities_object_slots(state); i++) {
+    const U6ObjectState *obj = u6_entities_object_at(state, i);
+    if (obj != NULL && obj->holder_kind == holder_kind && obj->holder_id == holder_id) {
+      *quantity += obj->quantity;
+      total += 1u + naive_contents(state, U6_OBJECT_HOLDER_OBJECT, obj->object_id, quantity);
+    }
+  }
+  return total;
+}
+
+static int test_containment(void) {
+  static U6EntityState state;
+  static uint8_t blob[4096];
+  uint16_t ids[U6M_INLINE_OBJECTS];
+  uint8_t depths[U6M_INLINE_OBJECTS];
+  U6ObjectState obj;
+  U6NpcState npc;
+  uint32_t count = 0;
+  uint32_t quantity = 0;
+  uint32_t seed = 12345u;
+  size_t written = 0;
+
+  u6_entities_init(&state);
+  memset(&npc, 0, sizeof(npc));
+  for (uint16_t i = 1; i <= 4; i++) {
+    npc.npc_id = i;
+    u6_entities_add_npc(&state, &npc);
+  }
+  /* NPC 1 carries bag 10 > pouch 11 > gem 12; coin 13 sits in the bag too. */
+  memset(&obj, 0, sizeof(obj));
+  obj.object_id = 10;
+  obj.holder_kind = U6_OBJECT_HOLDER_NPC;
+  obj.holder_id = 1;
+  obj.quantity = 1;
+  u6_entities_add_object(&state, &obj);
+  obj.object_id = 11;
+  obj.holder_kind = U6_OBJECT_HOLDER_OBJECT;
+  obj.holder_id = 10;
+  u6_entities_add_object(&state, &obj);
+  obj.object_id = 12;
+  obj.holder_id = 11;
+  obj.quantity = 5;
+  u6_entities_add_object(&state, &obj);
+  obj.object_id = 13;
+  obj.holder_id = 10;
+  obj.quantity = 20;
+  u6_entities_add_object(&state, &obj);
+
+  if (u6_entities_children(&state, U6_OBJECT_HOLDER_NPC, 1, ids, 4) != 1 || ids[0] != 10
+      || u6_entities_children(&state, U6_OBJECT_HOLDER_OBJECT, 10, NULL, 0) != 2) {
+    return 1;
+  }
+  if (u6_entities_contents(&state, U6_OBJECT_HOLDER_NPC, 1, ids, depths, 8) != 4 || ids[0] != 10 || depths[0] != 1) {
+    return 2;
+  }
+  for (size_t i = 0; i < 4; i++) {
+    if (ids[i] == 12 && depths[i] != 3) {
+      return 3;
+    }
+  }
+  if (u6_entities_contents_totals(&state, U6_OBJECT_HOLDER_NPC, 1, &count, &quantity) != 0 || count != 4
+      || quantity != 27u) {
+    return 4;
+  }
+  if (u6_entities_contents_totals(&state, U6_OBJECT_HOLDER_NPC, 99, &count, &quantity) != -2) {
+    return 5;
+  }
+
+  /* A container cannot go inside its own contents. */
+  if (u6_entities_set_holder(&state, 10, U6_OBJECT_HOLDER_OBJECT, 12) != -4
+      || u6_entities_set_holder(&state, 10, U6_OBJECT_HOLDER_OBJECT, 10) != -4) {
+    return 6;
+  }
+  if (u6_entities_set_holder(&state, 11, U6_OBJECT_HOLDER_NPC, 2) != 0
+      || u6_entities_contents(&state, U6_OBJECT_HOLDER_NPC, 2, NULL, NULL, 0) != 2
+      || u6_entities_contents(&state, U6_OBJECT_HOLDER_NPC, 1, NULL, NULL, 0) != 2) {
+    return 7;
+  }
+
+  /* Removing a holder orphans its children until the id returns. */
+  u6_entities_remove_object(&state, 10);
+  if (u6_entities_children(&state, U6_OBJECT_HOLDER_NPC, 1, NULL, 0) != 0) {
+    return 8;
+  }
+  obj.object_id = 10;
+  obj.holder_kind = U6_OBJECT_HOLDER_NONE;
+  obj.holder_id = 0;
+  u6_entities_add_object(&state, &obj);
+  if (u6_entities_children(&state, U6_OBJECT_HOLDER_OBJECT, 10, ids, 4) != 1 || ids[0] != 13) {
+    return 9;
+  }
+
+  /* Random moves, removals and re-adds against a brute-force walk. */
+  for (uint16_t i = 20; i < 200; i++) {
+    obj.object_id = i;
+    obj.quantity = (uint8_t)i;
+    obj.holder_kind = U6_OBJECT_HOLDER_NONE;
+    obj.holder_id = 0;
+    u6_entities_add_object(&state, &obj);
+  }
+  for (int step = 0; step < 4000; step++) {
+    uint16_t id;
+    uint8_t kind;
+    uint16_t holder;
+    seed = seed * 1103515245u + 12345u;
+    id = (uint16_t)(20u + ((seed >> 8) % 180u));
+    kind = (uint8_t)((seed >> 20) % 3u);
+    holder = kind == U6_OBJECT_HOLDER_NPC ? (uint16_t)(1u + ((seed >> 4) % 5u)) : (uint16_t)(20u + ((seed >> 12) % 185u));
+    if ((seed >> 28) == 0u) {
+      /* Re-add loose so holder fields never form a cycle the walk below would chase. */
+      u6_entities_remove_object(&state, id);
+      obj.object_id = id;
+      obj.holder_kind = U6_OBJECT_HOLDER_NONE;
+      obj.holder_id = 0;
+      u6_entities_add_object(&state, &obj);
+    }
+    u6_entities_set_holder(&state, id, kind, holder);
+    if ((step % 97) == 0) {
+      for (uint16_t h = 1; h <= 5; h++) {
+        uint32_t expect_quantity = 0;
+        size_t expect = naive_contents(&state, U6_OBJECT_HOLDER_NPC, h, &expect_quantity);
+        if (u6_entities_contents_totals(&state, U6_OBJECT_HOLDER_NPC, h, &count, &quantity) == 0
+            && (count != expect || quantity != expect_quantity)) {
+          return 10;
+        }
+      }
+      for (uint16_t h = 20; h < 200; h += 7) {
+        uint32_t expect_quantity = 0;
+        size_t expect = naive_contents(&state, U6_OBJECT_HOLDER_OBJECT, h, &expect_quantity);
+        if (u6_entities_contents(&state, U6_OBJECT_HOLDER_OBJECT, h, NULL, NULL, 0) != expect) {
+          return 11;
+        }
+      }
+    }
+  }
+
+  /* Deserialize rebuilds the tree lazily from holder fields. */
+  {
+    static U6EntityState copy;
+    if (u6_entities_serialize(&state, blob, sizeof(blob), &written) != 0
+        || u6_entities_deserialize(&copy, blob, written) != 0) {
+      return 12;
+    }
+    for (uint16_t h = 1; h <= 4; h++) {
+      if (u6_entities_contents(&copy, U6_OBJECT_HOLDER_NPC, h, NULL, NULL, 0)
+          != u6_entities_contents(&state, U6_OBJECT_HOLDER_NPC, h, NULL, NULL, 0)) {
+        return 13;
+      }
+    }
+  }
+  return 0;
+}
+
+static uint32_t delta_rng(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+/* Same live ids with the same fields on both sides. */
+static int replicas_match(U6EntityState *a, U6EntityState *b) {
+  if (a->object_count != b->object_count || a->npc_count != b->npc_count) {
+    return 0;
+  }
+  for (size_t i = 0; i < u6_entities_object_slots(a); i++) {
+    const U6ObjectState *x = u6_entities_object_at(a, i);
+    const U6ObjectState *y;
+    if (x == NULL) {
+      continue;
+    }
+    y = u6_entities_find_object(b, x->object_id);
+    if (y == NULL || memcmp(x, y, sizeof(*x)) != 0) {
+      return 0;
+    }
+  }
+  for (size_t i = 0; i < u6_entities_npc_slots(a); i++) {
+    const U6NpcState *x = u6_entities_npc_at(a, i);
+    const U6NpcState *y;
+    if (x == NULL) {
+      continue;
+    }
+    y = u6_entities_find_npc(b, x->npc_id);
+    if (y == NULL || x->body_tile != y->body_tile || x->map_x != y->map_x || x->map_y != y->map_y
+        || x->map_z != y->map_z || x->patrol_dx != y->patrol_dx || x->patrol_dy != y->patrol_dy
+        || x->flags != y->flags) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static int test_delta_sync(void) {
+  static U6EntityState sender;
+  static U6EntityState replica;
+  static uint8_t blob[U6M_ENTITY_HEADER_SIZE + 3000 * U6M_ENTITY_OBJECT_SIZE + U6M_MAX_NPCS * U6M_ENTITY_NPC_SIZE];
+  size_t arena_size = u6_entities_arena_bytes(3000, U6M_MAX_NPCS);
+  uint8_t *buffer = (uint8_t *)malloc(arena_size);
+  uint8_t *replica_buffer = (uint8_t *)malloc(arena_size);
+  U6EntityArena arena;
+  U6EntityArena replica_arena;
+  U6ObjectState obj;
+  U6NpcState npc;
+  uint32_t rng = 0x1234567u;
+  uint32_t base;
+  uint16_t next_object_id = 1;
+  size_t written = 0;
+  size_t size = 0;
+  uint16_t kids[8];
+  uint16_t replica_kids[8];
+  int rc = 0;
+
+  if (buffer == NULL || replica_buffer == NULL) {
+    free(buffer);
+    free(replica_buffer);
+    return 1;
+  }
+  u6_entity_arena_init(&arena, buffer, arena_size);
+  u6_entities_init_arena(&sender, &arena);
+  memset(&obj, 0, sizeof(obj));
+  memset(&npc, 0, sizeof(npc));
+  for (uint16_t i = 0; i < 2000u; i++, next_object_id++) {
+    obj.object_id = next_object_id;
+    obj.tile_id = i;
+    obj.map_x = (int16_t)(i % 1000u);
+    obj.holder_kind = (i % 5u == 4u) ? U6_OBJECT_HOLDER_OBJECT : U6_OBJECT_HOLDER_NONE;
+    obj.holder_id = obj.holder_kind != U6_OBJECT_HOLDER_NONE ? (uint16_t)(i - 3u) : 0u;
+    u6_entities_add_object(&sender, &obj);
+  }
+  for (uint16_t i = 0; i < 150u; i++) {
+    npc.npc_id = (uint16_t)(i + 1u);
+    npc.map_x = (int16_t)(i * 5u);
+    npc.map_y = (int16_t)(i * 3u);
+    npc.patrol_dx = (int8_t)((i % 3u) - 1);
+    npc.patrol_dy = 1;
+    npc.flags = (i % 2u) ? (U6_NPC_FLAG_ACTIVE | U6_NPC_FLAG_PATROL) : U6_NPC_FLAG_ACTIVE;
+    u6_entities_add_npc(&sender, &npc);
+  }
+
+  /* Bootstrap the replica from a full snapshot; later rounds send deltas. */
+  u6_entity_arena_init(&replica_arena, replica_buffer, arena_size);
+  if (u6_entities_serialize(&sender, blob, sizeof(blob), &written) != 0
+      || u6_entities_deserialize_arena(&replica, &replica_arena, blob, written) != 0) {
+    rc = 2;
+    goto done;
+  }
+  base = u6_entities_version(&sender);
+  if (u6_entities_delta_size(&sender, base, &size) != 0 || size != U6M_ENTITY_DELTA_HEADER_SIZE) {
+    rc = 3;
+    goto done;
+  }
+
+  /* One move costs one NPC record. */
+  u6_entities_move_npc(&sender, 7u, 100, 200, 0);
+  if (u6_entities_delta_size(&sender, base, &size) != 0
+      || size != U6M_ENTITY_DELTA_HEADER_SIZE + U6M_ENTITY_NPC_SIZE) {
+    rc = 4;
+    goto done;
+  }
+
+  for (int round = 0; round < 200; round++) {
+    int ops = 1 + (int)(delta_rng(&rng) % 40u);
+    for (int op = 0; op < ops; op++) {
+      uint32_t r = delta_rng(&rng);
+      uint16_t oid = (uint16_t)(1u + delta_rng(&rng) % next_object_id);
+      uint16_t nid = (uint16_t)(1u + delta_rng(&rng) % 160u);
+      U6ObjectState *target = u6_entities_find_object(&sender, oid);
+
+      switch (r % 8u) {
+        case 0:
+          u6_entities_move_npc(&sender, nid, (int16_t)(r % 1024u), (int16_t)((r >> 10) % 1024u), 0);
+          break;
+        case 1:
+          u6_entities_step(&sender, 4u);
+          break;
+        case 2:
+          u6_entities_remove_object(&sender, oid);
+          break;
+        case 3:
+          if (next_object_id < 2900u) {
+            obj.object_id = next_object_id++;
+            obj.tile_id = (uint16_t)r;
+            obj.holder_kind = U6_OBJECT_HOLDER_NONE;
+            obj.holder_id = 0;
+            u6_entities_add_object(&sender, &obj);
+          }
+          break;
+        case 4:
+          u6_entities_set_holder(&sender, oid, U6_OBJECT_HOLDER_OBJECT, (uint16_t)(1u + r % next_object_id));
+          break;
+        case 5:
+          if (target != NULL) {
+            target->quantity = (uint8_t)r;
+            u6_entities_touch_object(&sender, oid);
+          }
+          break;
+        case 6:
+          if (u6_entities_remove_npc(&sender, nid) != 0) {
+            npc.npc_id = nid;
+            u6_entities_add_npc(&sender, &npc);
+          }
+          break;
+        default:
+          u6_entities_set_holder(&sender, oid, U6_OBJECT_HOLDER_NPC, nid);
+          break;
+      }
+    }
+    if (u6_entities_serialize_delta(&sender, base, blob, sizeof(blob), &written) != 0) {
+      rc = 5;
+      goto done;
+    }
+    if (u6_entities_apply_delta(&replica, blob, written) != 0) {
+      rc = 6;
+      goto done;
+    }
+    base = u6_entities_version(&sender);
+    if (!replicas_match(&sender, &replica)) {
+      rc = 7;
+      goto done;
+    }
+    /* Slot layouts differ (the replica was compacted); hashes must not. */
+    if (u6_entities_hash(&sender) != u6_entities_hash(&replica)) {
+      rc = 13;
+      goto done;
+    }
+    if ((round % 25) == 0) {
+      static U6EntityState rebuilt;
+      uint8_t *rebuilt_buffer = (uint8_t *)malloc(arena_size);
+      U6EntityArena rebuilt_arena;
+      int same;
+      if (rebuilt_buffer == NULL) {
+        rc = 14;
+        goto done;
+      }
+      u6_entity_arena_init(&rebuilt_arena, rebuilt_buffer, arena_size);
+      same = u6_entities_serialize(&sender, blob, sizeof(blob), &written) == 0
+             && u6_entities_deserialize_arena(&rebuilt, &rebuilt_arena, blob, written) == 0
+             && u6_entities_hash(&rebuilt) == u6_entities_hash(&sender);
+      free(rebuilt_buffer);
+      if (!same) {
+        rc = 15;
+        goto done;
+      }
+    }
+  }
+
+  /* Containment rebuilt from applied holders matches the sender's tree. */
+  for (uint16_t id = 1; id < next_object_id; id += 17u) {
+    size_t n = u6_entities_children(&sender, U6_OBJECT_HOLDER_OBJECT, id, kids, 8);
+    size_t m = u6_entities_children(&replica, U6_OBJECT_HOLDER_OBJECT, id, replica_kids, 8);
+    if (n != m) {
+      rc = 8;
+      goto done;
+    }
+  }
+
+  /* Hash tracks content: an edit changes it, reverting restores it. */
+  {
+    uint64_t before = u6_entities_hash(&sender);
+    U6NpcState *moved = NULL;
+    int16_t old_x;
+    for (size_t i = 0; moved == NULL && i < u6_entities_npc_slots(&sender); i++) {
+      moved = u6_entities_npc_at(&sender, i);
+    }
+    if (moved == NULL) {
+      rc = 16;
+      goto done;
+    }
+    old_x = moved->map_x;
+    u6_entities_move_npc(&sender, moved->npc_id, (int16_t)(old_x ^ 1), moved->map_y, moved->map_z);
+    if (u6_entities_hash(&sender) == before) {
+      rc = 17;
+      goto done;
+    }
+    u6_entities_move_npc(&sender, moved->npc_id, old_x, moved->map_y, moved->map_z);
+    if (u6_entities_hash(&sender) != before) {
+      rc = 18;
+      goto done;
+    }
+  }
+
+  /* Bases outside what the tombstone ring covers need a full snapshot. */
+  if (u6_entities_delta_size(&sender, u6_entities_version(&sender) + 1u, &size) != -5) {
+    rc = 9;
+    goto done;
+  }
+  for (uint16_t id = 1; id < next_object_id && sender.tombstone_floor <= base; id++) {
+    u6_entities_remove_object(&sender, id);
+  }
+  if (u6_entities_serialize_delta(&sender, base, blob, sizeof(blob), &written) != -5) {
+    rc = 10;
+    goto done;
+  }
+  if (u6_entities_delta_size(&sender, u6_entities_version(&sender), &size) != 0
+      || size != U6M_ENTITY_DELTA_HEADER_SIZE) {
+    rc = 11;
+    goto done;
+  }
+
+  blob[4] = 9u;
+  if (u6_entities_apply_delta(&replica, blob, U6M_ENTITY_DELTA_HEADER_SIZE) != -4) {
+    rc = 12;
+    goto done;
+  }
+
+done:
+  free(buffer);
+  free(replica_buffer);
+  return rc;
+}
+
+static size_t brute_npcs_near(U6EntityState *state, int x, int y, int z, int radius, uint16_t *out) {
+  size_t n = 0;
+
+  for (uint32_t id = 0; id <= 0xffffu; id++) {
+    const U6NpcState *npc = u6_entities_find_npc(state, (uint16_t)id);
+    if (npc != NULL && npc->map_z == z && abs(npc->map_x - x) <= radius && abs(npc->map_y - y) <= radius) {
+      out[n++] = (uint16_t)id;
+    }
+  }
+  return n;
+}
+
+static int test_npc_proximity(void) {
+  static U6EntityState state;
+  static U6EntityState copy;
+  static uint8_t blob[U6M_ENTITY_HEADER_SIZE + U6M_MAX_NPCS * U6M_ENTITY_NPC_SIZE];
+  size_t arena_size = u6_entities_arena_bytes(0, U6M_MAX_NPCS);
+  uint8_t *buffer = (uint8_t *)malloc(arena_size);
+  uint8_t *copy_buffer = (uint8_t *)malloc(arena_size);
+  U6EntityArena arena;
+  U6EntityArena copy_arena;
+  U6NpcState npc;
+  uint16_t got[U6M_MAX_NPCS];
+  uint16_t want[U6M_MAX_NPCS];
+  uint32_t rng = 0xabcdef1u;
+  size_t written = 0;
+  int rc = 0;
+
+  if (buffer == NULL || copy_buffer == NULL) {
+    free(buffer);
+    free(copy_buffer);
+    return 1;
+  }
+  u6_entity_arena_init(&arena, buffer, arena_size);
+  u6_entities_init_arena(&state, &arena);
+  memset(&npc, 0, sizeof(npc));
+  /* A crowded town block plus a few stragglers, some on other levels. */
+  for (uint16_t i = 0; i < U6M_MAX_NPCS; i++) {
+    npc.npc_id = (uint16_t)(i * 7u + 2u);
+    npc.map_x = (int16_t)(300 + (int)(delta_rng(&rng) % 64u));
+    npc.map_y = (int16_t)(400 + (int)(delta_rng(&rng) % 64u));
+    npc.map_z = (int16_t)((delta_rng(&rng) % 8u) == 0u ? 1 : 0);
+    npc.patrol_dx = (int8_t)((int)(delta_rng(&rng) % 5u) - 2);
+    npc.patrol_dy = (int8_t)((int)(delta_rng(&rng) % 5u) - 2);
+    npc.flags = U6_NPC_FLAG_ACTIVE | U6_NPC_FLAG_PATROL;
+    if (i == 5u) {
+      npc.map_x = -12; /* added raw, outside the clamp */
+    }
+    if (u6_entities_add_npc(&state, &npc) != 0) {
+      rc = 2;
+      goto done;
+    }
+  }
+
+  for (int round = 0; round < 400; round++) {
+    uint32_t r = delta_rng(&rng);
+    int qx = 290 + (int)(delta_rng(&rng) % 90u);
+    int qy = 390 + (int)(delta_rng(&rng) % 90u);
+    int qz = (int)(delta_rng(&rng) % 2u);
+    int radius = (r & 1u) ? (int)(delta_rng(&rng) % 6u) : (int)(delta_rng(&rng) % 200u);
+    uint16_t id = (uint16_t)((delta_rng(&rng) % U6M_MAX_NPCS) * 7u + 2u);
+    U6NpcState *target = u6_entities_find_npc(&state, id);
+    size_t n;
+    size_t m;
+
+    switch (r % 6u) {
+      case 0:
+        u6_entities_move_npc(&state, id, (int16_t)(qx + 3), (int16_t)(qy - 3), (int16_t)qz);
+        break;
+      case 1:
+        u6_entities_step(&state, 4u);
+        break;
+      case 2:
+        if (target != NULL) {
+          npc = *target;
+          u6_entities_remove_npc(&state, id);
+          if ((r & 8u) != 0u) {
+            npc.map_x = (int16_t)qx;
+            u6_entities_add_npc(&state, &npc);
+          }
+        }
+        break;
+      case 3:
+        if (target != NULL) {
+          target->map_y = (int16_t)(target->map_y + 17);
+          u6_entities_touch_npc(&state, id);
+        }
+        break;
+      default:
+        break;
+    }
+
+    n = u6_entities_npcs_near(&state, (int16_t)qx, (int16_t)qy, (int16_t)qz, (int16_t)radius, got, U6M_MAX_NPCS);
+    m = brute_npcs_near(&state, qx, qy, qz, radius, want);
+    if (n != m || memcmp(got, want, n * sizeof(uint16_t)) != 0) {
+      rc = 3;
+      goto done;
+    }
+  }
+
+  /* Negative coordinates bucket on their own side of zero. */
+  npc.npc_id = 9999u;
+  npc.map_x = -3;
+  npc.map_y = 2;
+  npc.map_z = 0;
+  npc.flags = 0;
+  u6_entities_remove_npc(&state, 2u);
+  if (u6_entities_add_npc(&state, &npc) != 0 || u6_entities_npcs_near(&state, 0, 0, 0, 3, got, 1) != 1
+      || got[0] != 9999u || u6_entities_npcs_near(&state, 5, 0, 0, 7, NULL, 0) != 0) {
+    rc = 4;
+    goto done;
+  }
+
+  /* A deserialized copy rebuilds the buckets and answers identically. */
+  u6_entity_arena_init(&copy_arena, copy_buffer, arena_size);
+  if (u6_entities_serialize(&state, blob, sizeof(blob), &written) != 0
+      || u6_entities_deserialize_arena(&copy, &copy_arena, blob, written) != 0) {
+    rc = 5;
+    goto done;
+  }
+  for (int q = 0; q < 50; q++) {
+    int qx = 280 + q * 3;
+    size_t n = u6_entities_npcs_near(&copy, (int16_t)qx, 430, 0, 10, got, U6M_MAX_NPCS);
+    size_t m = u6_entities_npcs_near(&state, (int16_t)qx, 430, 0, 10, want, U6M_MAX_NPCS);
+    if (n != m || memcmp(got, want, n * sizeof(uint16_t)) != 0) {
+      rc = 6;
+      goto done;
+    }
+  }
+  if (u6_entities_npcs_near(&state, 300, 400, 0, -1, got, U6M_MAX_NPCS) != 0) {
+    rc = 7;
+  }
+
+done:
+  free(buffer);
+  free(copy_buffer);
+  return rc;
+}
+
 int main(void) {
   int rc;
 
@@ -132,6 +940,36 @@ int main(void) {
     return 1;
   }
 
+  rc = test_id_index();
+  if (rc != 0) {
+    fprintf(stderr, "test_id_index failed: %d\n", rc);
+    return 1;
+  }
+
+  rc = test_growable_pools();
+  if (rc != 0) {
+    fprintf(stderr, "test_growable_pools failed: %d\n", rc);
+    return 1;
+  }
+
+  rc = test_containment();
+  if (rc != 0) {
+    fprintf(stderr, "test_containment failed: %d\n", rc);
+    return 1;
+  }
+
+  rc = test_delta_sync();
+  if (rc != 0) {
+    fprintf(stderr, "test_delta_sync failed: %d\n", rc);
+    return 1;
+  }
+
+  rc = test_npc_proximity();
+  if (rc != 0) {
+    fprintf(stderr, "test_npc_proximity failed: %d\n", rc);
+    return 1;
+  }
+
   printf("test_entities: ok\n");
   return 0;
 }
@@ -189,6 +189,9 @@ static int test_take_equip_put_drop_sequence(void) {
       || obj->holder_id != 1) {
     return 25;
   }
+  if (u6_entities_children(&state, U6_OBJECT_HOLDER_NPC, 1, NULL, 0) != 1) {
+    return 25;
+  }
 
   req.verb = U6_INTERACT_EQUIP;
   rc = u6_interaction_apply(&state, &req, &res);
@@ -209,6 +212,10 @@ static int test_take_equip_put_drop_sequence(void) {
       || obj->holder_id != 301) {
     return 29;
   }
+  if (u6_entities_children(&state, U6_OBJECT_HOLDER_NPC, 1, NULL, 0) != 0
+      || u6_entities_children(&state, U6_OBJECT_HOLDER_OBJECT, 301, NULL, 0) != 1) {
+    return 29;
+  }
 
   req.verb = U6_INTERACT_TAKE;
   req.aux_target_id = 0;
@@ -231,6 +238,70 @@ static int test_take_equip_put_drop_sequence(void) {
   if (obj->map_x != avatar.map_x || obj->map_y != avatar.map_y || obj->map_z != avatar.map_z) {
     return 34;
   }
+  if (u6_entities_children(&state, U6_OBJECT_HOLDER_NPC, 1, NULL, 0) != 0
+      || u6_entities_children(&state, U6_OBJECT_HOLDER_OBJECT, 301, NULL, 0) != 0) {
+    return 35;
+  }
+
+  return 0;
+}
+
+static int test_put_container_into_own_contents(void) {
+  U6EntityState state;
+  U6NpcState avatar;
+  U6ObjectState bag;
+  U6ObjectState pouch;
+  U6InteractionRequest req;
+  U6InteractionResult res;
+  U6ObjectState *obj;
+  int rc;
+
+  u6_entities_init(&state);
+  memset(&avatar, 0, sizeof(avatar));
+  avatar.npc_id = 1;
+  avatar.map_x = 10;
+  avatar.map_y = 10;
+  avatar.flags = U6_NPC_FLAG_ACTIVE;
+
+  memset(&bag, 0, sizeof(bag));
+  bag.object_id = 500;
+  bag.map_x = 10;
+  bag.map_y = 10;
+  bag.status = u6_obj_status_to_inventory(0);
+  bag.holder_kind = U6_OBJECT_HOLDER_NPC;
+  bag.holder_id = 1;
+
+  memset(&pouch, 0, sizeof(pouch));
+  pouch.object_id = 501;
+  pouch.map_x = 10;
+  pouch.map_y = 10;
+  pouch.status = u6_obj_status_to_contained(0);
+  pouch.holder_kind = U6_OBJECT_HOLDER_OBJECT;
+  pouch.holder_id = 500;
+
+  /* pouch arrives before its bag and is adopted once the bag exists */
+  if (u6_entities_add_object(&state, &pouch) != 0 || u6_entities_add_object(&state, &bag) != 0
+      || u6_entities_add_npc(&state, &avatar) != 0) {
+    return 60;
+  }
+
+  memset(&req, 0, sizeof(req));
+  req.actor_npc_id = 1;
+  req.verb = U6_INTERACT_PUT;
+  req.target_id = 500;
+  req.aux_target_id = 501;
+  rc = u6_interaction_apply(&state, &req, &res);
+  if (rc != U6_INTERACT_ERR_BLOCKED) {
+    return 61;
+  }
+  obj = u6_entities_find_object(&state, 500);
+  if (obj == NULL || !u6_obj_status_is_inventory(obj->status) || obj->holder_kind != U6_OBJECT_HOLDER_NPC
+      || obj->holder_id != 1) {
+    return 62;
+  }
+  if (u6_entities_contents(&state, U6_OBJECT_HOLDER_NPC, 1, NULL, NULL, 0) != 2) {
+    return 63;
+  }
 
   return 0;
 }
@@ -316,6 +387,112 @@ static int test_invalid_transition_guards(void) {
   return 0;
 }
 
+static uint32_t batch_rng(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+static void build_batch_world(U6EntityState *state) {
+  U6NpcState npc;
+  U6ObjectState obj;
+
+  u6_entities_init(state);
+  memset(&npc, 0, sizeof(npc));
+  for (uint16_t i = 1; i <= 8; i++) {
+    npc.npc_id = i;
+    npc.map_x = (int16_t)(i % 4u);
+    npc.map_y = (int16_t)(i / 4u);
+    npc.flags = i == 8u ? 0u : U6_NPC_FLAG_ACTIVE;
+    u6_entities_add_npc(state, &npc);
+  }
+  memset(&obj, 0, sizeof(obj));
+  for (uint16_t i = 1; i <= 120; i++) {
+    obj.object_id = (uint16_t)(100u + i);
+    obj.map_x = (int16_t)(i % 5u);
+    obj.map_y = (int16_t)(i % 3u);
+    obj.flags = (uint8_t)(i % 32u);
+    obj.status = 0;
+    u6_entities_add_object(state, &obj);
+  }
+}
+
+/* A batch must leave the same state and results as one call per request. */
+static int test_batch_matches_sequential(void) {
+  static U6EntityState one_by_one;
+  static U6EntityState batched;
+  static uint8_t blob_a[U6M_ENTITY_HEADER_SIZE + 256 * U6M_ENTITY_OBJECT_SIZE + 64 * U6M_ENTITY_NPC_SIZE];
+  static uint8_t blob_b[sizeof(blob_a)];
+  U6InteractionRequest reqs[400];
+  U6InteractionResult expect[400];
+  U6InteractionResult got[400];
+  U6InteractionJournalEntry entries[400];
+  U6InteractionJournal journal;
+  uint32_t rng = 77u;
+  size_t size_a = 0;
+  size_t size_b = 0;
+  int ok = 0;
+  int rc;
+  size_t j = 0;
+
+  build_batch_world(&one_by_one);
+  build_batch_world(&batched);
+  for (size_t i = 0; i < 400u; i++) {
+    reqs[i].verb = (U6InteractionVerb)(1u + batch_rng(&rng) % 8u); /* 8 is not a verb */
+    reqs[i].actor_npc_id = (uint16_t)(1u + batch_rng(&rng) % 9u);
+    reqs[i].target_id = (uint16_t)(reqs[i].verb == U6_INTERACT_TALK ? 1u + batch_rng(&rng) % 9u
+                                                                    : 100u + batch_rng(&rng) % 125u);
+    reqs[i].aux_target_id = (uint16_t)(100u + batch_rng(&rng) % 125u);
+  }
+  for (size_t i = 0; i < 400u; i++) {
+    if (u6_interaction_apply(&one_by_one, &reqs[i], &expect[i]) == U6_INTERACT_OK) {
+      ok++;
+    }
+  }
+
+  journal.entries = entries;
+  journal.capacity = 400u;
+  rc = u6_interaction_apply_batch(&batched, reqs, 400u, got, &journal);
+  if (rc != ok || ok == 0 || journal.count != (size_t)ok) {
+    return 60;
+  }
+  for (size_t i = 0; i < 400u; i++) {
+    if (got[i].code != expect[i].code || got[i].event != expect[i].event || got[i].affected_id != expect[i].affected_id) {
+      return 61;
+    }
+    if (got[i].code != U6_INTERACT_OK) {
+      continue;
+    }
+    if (j >= journal.count || entries[j].request_index != i || entries[j].event != got[i].event
+        || entries[j].actor_npc_id != reqs[i].actor_npc_id || entries[j].affected_id != got[i].affected_id
+        || (j > 0 && entries[j].version < entries[j - 1].version)) {
+      return 62;
+    }
+    j++;
+  }
+  if (entries[journal.count - 1u].version != u6_entities_version(&batched)) {
+    return 63;
+  }
+  if (u6_entities_serialize(&one_by_one, blob_a, sizeof(blob_a), &size_a) != 0
+      || u6_entities_serialize(&batched, blob_b, sizeof(blob_b), &size_b) != 0 || size_a != size_b
+      || memcmp(blob_a, blob_b, size_a) != 0 || u6_entities_hash(&one_by_one) != u6_entities_hash(&batched)) {
+    return 64;
+  }
+
+  /* A short journal keeps the first entries and still counts them all. */
+  build_batch_world(&batched);
+  journal.capacity = 3u;
+  if (u6_interaction_apply_batch(&batched, reqs, 400u, got, &journal) != ok || journal.count != (size_t)ok
+      || entries[2].request_index >= 400u || u6_interaction_apply_batch(NULL, reqs, 1u, got, NULL) != U6_INTERACT_ERR_NULL
+      || u6_interaction_apply_batch(&batched, NULL, 0u, NULL, NULL) != 0) {
+    return 65;
+  }
+  return 0;
+}
+
 int main(void) {
   int rc;
 
@@ -343,6 +520,18 @@ int main(void) {
     return 1;
   }
 
+  rc = test_put_container_into_own_contents();
+  if (rc != 0) {
+    fprintf(stderr, "test_put_container_into_own_contents failed: %d\n", rc);
+    return 1;
+  }
+
+  rc = test_batch_matches_sequential();
+  if (rc != 0) {
+    fprintf(stderr, "test_batch_matches_sequential failed: %d\n", rc);
+    return 1;
+  }
+
   printf("test_interaction: ok\n");
   return 0;
 }
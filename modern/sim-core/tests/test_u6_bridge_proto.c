@@ -0,0 +1,424 @@
+#include "u6_bridge_proto.h"
+#include "u6_world_interact_bridge.h"
+#include "test_bridge_objects.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OBJECT_COUNT 600
+
+static int fail(const char *msg) {
+  fprintf(stderr, "%s\n", msg);
+  return 1;
+}
+
+typedef struct Frame {
+  uint8_t data[65536];
+  size_t size;
+} Frame;
+
+static void put_u8(Frame *f, uint8_t v) {
+  f->data[f->size++] = v;
+}
+
+static void put_u32(Frame *f, uint32_t v) {
+  put_u8(f, (uint8_t)(v & 0xffu));
+  put_u8(f, (uint8_t)((v >> 8) & 0xffu));
+  put_u8(f, (uint8_t)((v >> 16) & 0xffu));
+  put_u8(f, (uint8_t)(v >> 24));
+}
+
+static void put_key(Frame *f, const char *key) {
+  size_t len = strlen(key);
+  put_u8(f, (uint8_t)len);
+  memcpy(f->data + f->size, key, len);
+  f->size += len;
+}
+
+static void put_record(Frame *f, const U6BridgeObject *o) {
+  put_key(f, o->key);
+  put_u32(f, (uint32_t)o->x);
+  put_u32(f, (uint32_t)o->y);
+  put_u32(f, (uint32_t)o->z);
+  put_u8(f, o->status);
+  put_u8(f, o->tile_flag);
+  put_u8(f, o->holder_kind);
+  put_u8(f, 0u);
+  put_u32(f, (uint32_t)o->holder_key);
+  put_u32(f, (uint32_t)o->source_area);
+  put_u32(f, (uint32_t)o->source_index);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Runs one request; returns the response status and leaves the payload in *payload. */
+static int call(U6BridgeWorld *world, const Frame *req, U6BridgeBuffer *out, const uint8_t **payload) {
+  if (u6_bridge_handle(world, req->data, req->size, out) != U6_BRIDGE_OK) {
+    return 1000;
+  }
+  if (out->size < 9u || get_u32(out->data) != out->size - 4u || out->data[4] != (req->size > 0u ? req->data[0] : 0u)) {
+    return 1001;
+  }
+  *payload = out->data + 9u;
+  return (int)(int32_t)get_u32(out->data + 5u);
+}
+
+static void random_object(U6BridgeObject *o, int index) {
+  static const TestBridgeRanges ranges = {0, 48u, 3u, 4u, 8u};
+  test_bridge_object_fill(o, &ranges);
+  /* Mostly numeric keys so they join assoc chains; some are not numbers. */
+  if (index % 7 == 3) {
+    snprintf(o->key, sizeof(o->key), "obj-%d", index);
+  } else {
+    snprintf(o->key, sizeof(o->key), "%d", 100 + index);
+  }
+  /* Holders point back into the table so chains actually form. */
+  o->holder_key = o->holder_kind != 0u ? 100 + (int)(test_rand() % OBJECT_COUNT) : 0;
+}
+
+static U6BridgeObject expected[OBJECT_COUNT];
+
+static int check_queries(U6BridgeWorld *world, const U6BridgeObject *ref, size_t ref_count, U6BridgeBuffer *out) {
+  for (int round = 0; round < 40; round++) {
+    U6BridgeQuery q;
+    Frame req;
+    const uint8_t *p;
+    size_t expected_count;
+    size_t off = 4u;
+
+    memset(&q, 0, sizeof(q));
+    q.has_x = round % 5 != 0;
+    q.has_y = round % 5 != 0;
+    q.has_z = round % 3 == 0;
+    q.projection_footprint = round % 2;
+    q.x = (int)(test_rand() % 48u);
+    q.y = (int)(test_rand() % 48u);
+    q.z = (int)(test_rand() % 3u);
+    q.radius = (int)(test_rand() % 10u);
+    q.limit = round % 4 == 0 ? 0 : (int)(test_rand() % 300u);
+    req.size = 0;
+    put_u8(&req, U6_BRIDGE_OP_QUERY);
+    put_u8(&req, (uint8_t)q.has_x);
+    put_u8(&req, (uint8_t)q.has_y);
+    put_u8(&req, (uint8_t)q.has_z);
+    put_u8(&req, (uint8_t)q.projection_footprint);
+    put_u32(&req, (uint32_t)q.x);
+    put_u32(&req, (uint32_t)q.y);
+    put_u32(&req, (uint32_t)q.z);
+    put_u32(&req, (uint32_t)q.radius);
+    put_u32(&req, (uint32_t)q.limit);
+    if (call(world, &req, out, &p) != U6_BRIDGE_OK) {
+      return fail("query status");
+    }
+    expected_count = test_bridge_reference_query(ref, ref_count, &q, expected);
+    if (get_u32(p) != expected_count) {
+      return fail("query count mismatch");
+    }
+    for (size_t i = 0; i < expected_count; i++) {
+      uint8_t len = p[off];
+      if (len != strlen(expected[i].key) || memcmp(p + off + 1u, expected[i].key, len) != 0) {
+        return fail("query order mismatch");
+      }
+      off += 1u + len;
+    }
+    if (9u + off != out->size) {
+      return fail("query trailing bytes");
+    }
+  }
+  return 0;
+}
+
+static int check_assoc(U6BridgeWorld *world, const U6BridgeObject *ref, size_t ref_count, U6BridgeBuffer *out) {
+  U6AssocChainNode *nodes = (U6AssocChainNode *)calloc(ref_count, sizeof(U6AssocChainNode));
+  size_t node_count = 0;
+  Frame req;
+  const uint8_t *p;
+  size_t off = 4u;
+  int targets[64];
+
+  for (size_t i = 0; i < ref_count; i++) {
+    int key = atoi(ref[i].key);
+    if (key == 0) continue;
+    nodes[node_count].key = key;
+    nodes[node_count].status = ref[i].status;
+    nodes[node_count].holder_kind = ref[i].holder_kind;
+    nodes[node_count].holder_key = ref[i].holder_key;
+    node_count++;
+  }
+  req.size = 0;
+  put_u8(&req, U6_BRIDGE_OP_ASSOC);
+  put_u32(&req, 64u);
+  for (int i = 0; i < 64; i++) {
+    /* Includes keys that are absent (removed or never numeric). */
+    targets[i] = 100 + (int)(test_rand() % (OBJECT_COUNT + 20u));
+    put_u32(&req, (uint32_t)targets[i]);
+  }
+  if (call(world, &req, out, &p) != U6_BRIDGE_OK || get_u32(p) != 64u) {
+    free(nodes);
+    return fail("assoc status");
+  }
+  for (int i = 0; i < 64; i++) {
+    U6AssocChainResult expect;
+    int code;
+    uint8_t flags;
+
+    memset(&expect, 0, sizeof(expect));
+    code = u6_assoc_chain_analyze(nodes, node_count, targets[i], &expect);
+    flags = (uint8_t)((expect.chain_accessible ? U6_BRIDGE_ASSOC_ACCESSIBLE : 0u) |
+                      (expect.cycle_detected ? U6_BRIDGE_ASSOC_CYCLE : 0u) |
+                      (expect.missing_parent ? U6_BRIDGE_ASSOC_MISSING_PARENT : 0u) |
+                      (expect.parent_owned ? U6_BRIDGE_ASSOC_PARENT_OWNED : 0u));
+    if ((int)get_u32(p + off) != targets[i] || (int)get_u32(p + off + 4u) != code ||
+        (int)get_u32(p + off + 8u) != expect.root_anchor_key || (int)get_u32(p + off + 12u) != expect.blocked_by_key ||
+        p[off + 16u] != flags || p[off + 17u] != expect.chain_len) {
+      free(nodes);
+      return fail("assoc result mismatch");
+    }
+    off += 18u;
+    for (size_t j = 0; j < expect.chain_len; j++) {
+      if ((int)get_u32(p + off) != expect.chain_keys[j]) {
+        free(nodes);
+        return fail("assoc chain mismatch");
+      }
+      off += 4u;
+    }
+  }
+  free(nodes);
+  return 9u + off == out->size ? 0 : fail("assoc trailing bytes");
+}
+
+static int check_interact(U6BridgeWorld *world, U6BridgeBuffer *out) {
+  for (int i = 0; i < 64; i++) {
+    U6WorldInteractInput in;
+    U6WorldInteractResult expect;
+    Frame req;
+    const uint8_t *p;
+
+    in.verb = (uint8_t)(test_rand() % 6u);
+    in.status = (uint8_t)(test_rand() & 0xffu);
+    in.holder_kind = (uint8_t)(test_rand() % 3u);
+    in.owner_matches_actor = (uint8_t)(test_rand() & 1u);
+    in.has_container = (uint8_t)(test_rand() & 1u);
+    in.chain_accessible = (uint8_t)(test_rand() & 1u);
+    in.container_cycle = (uint8_t)(test_rand() & 1u);
+    expect.code = U6_WORLD_INTERACT_ERR_BAD_VERB;
+    expect.status = in.status;
+    expect.holder_kind = in.holder_kind;
+    (void)u6_world_interact_apply(&in, &expect);
+    req.size = 0;
+    put_u8(&req, U6_BRIDGE_OP_INTERACT);
+    put_u8(&req, in.verb);
+    put_u8(&req, in.status);
+    put_u8(&req, in.holder_kind);
+    put_u8(&req, in.owner_matches_actor);
+    put_u8(&req, in.has_container);
+    put_u8(&req, in.chain_accessible);
+    put_u8(&req, in.container_cycle);
+    if (call(world, &req, out, &p) != U6_BRIDGE_OK) {
+      return fail("interact status");
+    }
+    if ((int)get_u32(p) != expect.code || p[4] != expect.status || p[5] != expect.holder_kind) {
+      return fail("interact mismatch");
+    }
+  }
+  return 0;
+}
+
+static uint32_t hello_count(U6BridgeWorld *world, U6BridgeBuffer *out) {
+  Frame req;
+  const uint8_t *p;
+  req.size = 0;
+  put_u8(&req, U6_BRIDGE_OP_HELLO);
+  if (call(world, &req, out, &p) != U6_BRIDGE_OK || get_u32(p) != U6_BRIDGE_PROTOCOL_VERSION) {
+    return 0xffffffffu;
+  }
+  return get_u32(p + 4u);
+}
+
+static U6BridgeObject ref[OBJECT_COUNT];
+static Frame load;
+
+int main(void) {
+  U6BridgeWorld world;
+  U6BridgeBuffer out;
+  Frame req;
+  const uint8_t *p;
+  size_t ref_count = OBJECT_COUNT;
+  int rc;
+
+  test_rand_seed(0x2468aceu);
+  u6_bridge_world_init(&world);
+  memset(&out, 0, sizeof(out));
+
+  if (hello_count(&world, &out) != 0u) {
+    return fail("hello on empty table");
+  }
+  load.size = 0;
+  put_u8(&load, U6_BRIDGE_OP_LOAD);
+  put_u32(&load, OBJECT_COUNT);
+  for (int i = 0; i < OBJECT_COUNT; i++) {
+    random_object(&ref[i], i);
+    put_record(&load, &ref[i]);
+  }
+  if (call(&world, &load, &out, &p) != U6_BRIDGE_OK || get_u32(p) != OBJECT_COUNT) {
+    return fail("load");
+  }
+  if ((rc = check_queries(&world, ref, ref_count, &out)) != 0) return rc;
+  if ((rc = check_assoc(&world, ref, ref_count, &out)) != 0) return rc;
+  if ((rc = check_interact(&world, &out)) != 0) return rc;
+
+  /*
+   * Upsert rewrites 30 existing keys and adds 10 new ones, then remove drops
+   * the 10 originals at the tail of ref; the new records take their places.
+   */
+  req.size = 0;
+  put_u8(&req, U6_BRIDGE_OP_UPSERT);
+  put_u32(&req, 40u);
+  for (int i = 0; i < 40; i++) {
+    U6BridgeObject o;
+    if (i < 30) {
+      size_t at = test_rand() % ref_count;
+      random_object(&o, 0);
+      memcpy(o.key, ref[at].key, sizeof(o.key));
+      ref[at] = o;
+    } else {
+      random_object(&o, OBJECT_COUNT + i);
+    }
+    put_record(&req, &o);
+    if (i >= 30) {
+      ref[ref_count - 1u - (size_t)(i - 30)] = o;
+    }
+  }
+  {
+    Frame rem;
+    rem.size = 0;
+    put_u8(&rem, U6_BRIDGE_OP_REMOVE);
+    put_u32(&rem, 10u);
+    for (int i = 0; i < 10; i++) {
+      char key[U6_BRIDGE_KEY_MAX + 1u];
+      int index = OBJECT_COUNT - 1 - i;
+      if (index % 7 == 3) {
+        snprintf(key, sizeof(key), "obj-%d", index);
+      } else {
+        snprintf(key, sizeof(key), "%d", 100 + index);
+      }
+      put_key(&rem, key);
+    }
+    if (call(&world, &req, &out, &p) != U6_BRIDGE_OK || get_u32(p) != OBJECT_COUNT + 10u) {
+      return fail("upsert");
+    }
+    if (call(&world, &rem, &out, &p) != U6_BRIDGE_OK || get_u32(p) != 10u) {
+      return fail("remove");
+    }
+  }
+  if (hello_count(&world, &out) != OBJECT_COUNT) {
+    return fail("count after upsert/remove");
+  }
+  if (u6_bridge_world_find(&world, ref[0].key) == NULL || memcmp(u6_bridge_world_find(&world, ref[0].key), &ref[0], sizeof(ref[0])) != 0) {
+    return fail("find after upsert");
+  }
+  if ((rc = check_queries(&world, ref, ref_count, &out)) != 0) return rc;
+  if ((rc = check_assoc(&world, ref, ref_count, &out)) != 0) return rc;
+
+  /* A snapshot payload loads into a fresh table that answers identically. */
+  {
+    U6BridgeWorld copy;
+    u6_bridge_world_init(&copy);
+    req.size = 0;
+    put_u8(&req, U6_BRIDGE_OP_SNAPSHOT);
+    if (call(&world, &req, &out, &p) != U6_BRIDGE_OK || get_u32(p) != OBJECT_COUNT) {
+      return fail("snapshot");
+    }
+    load.size = 0;
+    put_u8(&load, U6_BRIDGE_OP_LOAD);
+    memcpy(load.data + load.size, p, out.size - 9u);
+    load.size += out.size - 9u;
+    if (call(&copy, &load, &out, &p) != U6_BRIDGE_OK || get_u32(p) != OBJECT_COUNT) {
+      return fail("load from snapshot");
+    }
+    for (size_t i = 0; i < ref_count; i++) {
+      const U6BridgeObject *o = u6_bridge_world_find(&copy, ref[i].key);
+      if (o == NULL || memcmp(o, &ref[i], sizeof(*o)) != 0) {
+        return fail("snapshot record mismatch");
+      }
+    }
+    if ((rc = check_queries(&copy, ref, ref_count, &out)) != 0) return rc;
+    u6_bridge_world_free(&copy);
+  }
+
+  /* An upsert that outgrows the table reserves room for all of it up front. */
+  {
+    U6BridgeWorld grown;
+    u6_bridge_world_init(&grown);
+    req.size = 0;
+    put_u8(&req, U6_BRIDGE_OP_UPSERT);
+    put_u32(&req, 1000u);
+    for (int i = 0; i < 1000; i++) {
+      U6BridgeObject o;
+      random_object(&o, OBJECT_COUNT + 100 + i);
+      put_record(&req, &o);
+    }
+    if (call(&grown, &req, &out, &p) != U6_BRIDGE_OK || get_u32(p) != 1000u || grown.capacity < 1000u) {
+      return fail("upsert across several table growths");
+    }
+    u6_bridge_world_free(&grown);
+  }
+
+  /* Malformed frames answer with an error status and change nothing. */
+  req.size = 0;
+  if (call(&world, &req, &out, &p) != U6_BRIDGE_ERR_FRAME || out.size != 9u) {
+    return fail("empty body");
+  }
+  req.size = 0;
+  put_u8(&req, 99u);
+  if (call(&world, &req, &out, &p) != U6_BRIDGE_ERR_OP) {
+    return fail("unknown op");
+  }
+  req.size = 0;
+  put_u8(&req, U6_BRIDGE_OP_LOAD);
+  put_u32(&req, 5u);
+  put_record(&req, &ref[0]);
+  if (call(&world, &req, &out, &p) != U6_BRIDGE_ERR_FRAME) {
+    return fail("load with short payload");
+  }
+  req.size = 0;
+  put_u8(&req, U6_BRIDGE_OP_UPSERT);
+  put_u32(&req, 2u);
+  {
+    U6BridgeObject moved = ref[1];
+    moved.x += 1000;
+    put_record(&req, &moved);
+  }
+  put_u8(&req, 0u); /* empty key */
+  memset(req.data + req.size, 0, U6_BRIDGE_RECORD_FIXED_SIZE);
+  req.size += U6_BRIDGE_RECORD_FIXED_SIZE;
+  if (call(&world, &req, &out, &p) != U6_BRIDGE_ERR_RECORD || out.size != 9u) {
+    return fail("upsert with bad record");
+  }
+  if (u6_bridge_world_find(&world, ref[1].key)->x != ref[1].x) {
+    return fail("bad upsert frame applied a record");
+  }
+  req.size = 0;
+  put_u8(&req, U6_BRIDGE_OP_QUERY);
+  put_u8(&req, 1u);
+  if (call(&world, &req, &out, &p) != U6_BRIDGE_ERR_FRAME) {
+    return fail("truncated query");
+  }
+  req.size = 0;
+  put_u8(&req, U6_BRIDGE_OP_LOAD);
+  put_u32(&req, 1u);
+  put_key(&req, "not-a-record");
+  for (int i = 0; i < 16; i++) put_u8(&req, 0u);
+  if (call(&world, &req, &out, &p) >= 0 || hello_count(&world, &out) != OBJECT_COUNT) {
+    return fail("truncated load replaced the table");
+  }
+  if ((rc = check_queries(&world, ref, ref_count, &out)) != 0) return rc;
+
+  u6_bridge_buffer_free(&out);
+  u6_bridge_world_free(&world);
+  printf("PASS: u6 bridge proto\n");
+  return 0;
+}
@@ -0,0 +1,356 @@
+#include "u6_entity_snapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { OBJECTS = 3000, NPCS = 200, HISTORY = 12 };
+
+static int fail(const char *msg) {
+  fprintf(stderr, "FAIL: %s\n", msg);
+  return 1;
+}
+
+static uint32_t rng_next(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+static uint8_t *new_arena_state(U6EntityState *state, U6EntityArena *arena) {
+  size_t size = u6_entities_arena_bytes(OBJECTS + 512u, U6M_MAX_NPCS);
+  uint8_t *buffer = (uint8_t *)malloc(size);
+
+  if (buffer != NULL) {
+    u6_entity_arena_init(arena, buffer, size);
+    u6_entities_init_arena(state, arena);
+  }
+  return buffer;
+}
+
+static void populate(U6EntityState *state) {
+  U6ObjectState obj;
+  U6NpcState npc;
+
+  memset(&obj, 0, sizeof(obj));
+  for (uint16_t i = 0; i < OBJECTS; i++) {
+    obj.object_id = (uint16_t)(i + 1u);
+    obj.tile_id = (uint16_t)(100u + i % 50u);
+    obj.map_x = (int16_t)(i % 700u);
+    obj.map_y = (int16_t)(i / 7u);
+    obj.quantity = (uint8_t)(i % 9u);
+    /* Every tenth object sits inside the one before it. */
+    obj.holder_kind = (i % 10u == 9u) ? U6_OBJECT_HOLDER_OBJECT : U6_OBJECT_HOLDER_NONE;
+    obj.holder_id = obj.holder_kind != U6_OBJECT_HOLDER_NONE ? i : 0u;
+    obj.status = 0;
+    u6_entities_add_object(state, &obj);
+  }
+  memset(&npc, 0, sizeof(npc));
+  for (uint16_t i = 0; i < NPCS; i++) {
+    npc.npc_id = (uint16_t)(i + 1u);
+    npc.map_x = (int16_t)(200 + i);
+    npc.map_y = (int16_t)(300 + i % 17u);
+    npc.patrol_dx = (int8_t)(i % 3u) - 1;
+    npc.flags = U6_NPC_FLAG_ACTIVE | U6_NPC_FLAG_PATROL;
+    u6_entities_add_npc(state, &npc);
+  }
+}
+
+/* A handful of edits, as one turn of play would make. */
+static void mutate(U6EntityState *state, uint32_t *rng, uint32_t edits) {
+  for (uint32_t e = 0; e < edits; e++) {
+    uint32_t r = rng_next(rng);
+    uint16_t id = (uint16_t)(1u + rng_next(rng) % (OBJECTS + 200u));
+
+    switch (r % 6u) {
+      case 0: {
+        U6ObjectState *obj = u6_entities_find_object(state, id);
+        if (obj != NULL) {
+          obj->quantity = (uint8_t)(obj->quantity + 1u);
+          u6_entities_touch_object(state, id);
+        }
+        break;
+      }
+      case 1:
+        u6_entities_remove_object(state, id);
+        break;
+      case 2: {
+        U6ObjectState obj;
+        memset(&obj, 0, sizeof(obj));
+        obj.object_id = id;
+        obj.tile_id = 7;
+        obj.map_x = (int16_t)(r % 1000u);
+        u6_entities_add_object(state, &obj);
+        break;
+      }
+      case 3:
+        u6_entities_set_holder(state, id, U6_OBJECT_HOLDER_NPC, (uint16_t)(1u + r % NPCS));
+        break;
+      case 4:
+        u6_entities_move_npc(state, (uint16_t)(1u + r % NPCS), (int16_t)(r % 900u), (int16_t)(r % 700u), 0);
+        break;
+      default:
+        if ((r & 64u) != 0u) {
+          u6_entities_remove_npc(state, (uint16_t)(1u + r % NPCS));
+        } else {
+          u6_entities_step(state, r);
+        }
+        break;
+    }
+  }
+}
+
+/* Same entities by id, and the same holder child lists. */
+static int same_entities(U6EntityState *a, U6EntityState *b) {
+  uint16_t ka[64];
+  uint16_t kb[64];
+
+  if (a->object_count != b->object_count || a->npc_count != b->npc_count || u6_entities_hash(a) != u6_entities_hash(b)) {
+    return 0;
+  }
+  for (size_t s = 0; s < u6_entities_object_slots(a); s++) {
+    const U6ObjectState *x = u6_entities_object_at(a, s);
+    const U6ObjectState *y = x != NULL ? u6_entities_find_object(b, x->object_id) : NULL;
+    if (x == NULL) {
+      continue;
+    }
+    if (y == NULL || memcmp(x, y, sizeof(*x)) != 0) {
+      return 0;
+    }
+    if (u6_entities_children(a, U6_OBJECT_HOLDER_OBJECT, x->object_id, ka, 64)
+            != u6_entities_children(b, U6_OBJECT_HOLDER_OBJECT, x->object_id, kb, 64)) {
+      return 0;
+    }
+  }
+  for (size_t s = 0; s < u6_entities_npc_slots(a); s++) {
+    const U6NpcState *x = u6_entities_npc_at(a, s);
+    const U6NpcState *y = x != NULL ? u6_entities_find_npc(b, x->npc_id) : NULL;
+    if (x == NULL) {
+      continue;
+    }
+    if (y == NULL || x->map_x != y->map_x || x->map_y != y->map_y || x->flags != y->flags
+        || u6_entities_npcs_near(a, x->map_x, x->map_y, x->map_z, 2, ka, 64)
+               != u6_entities_npcs_near(b, x->map_x, x->map_y, x->map_z, 2, kb, 64)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static int test_capture_shares_untouched_pages(void) {
+  static U6EntityState state;
+  U6EntityArena arena;
+  U6EntitySnapshot s0;
+  U6EntitySnapshot s1;
+  U6EntitySnapshot fork;
+  uint8_t *buffer = new_arena_state(&state, &arena);
+  size_t shared = 0;
+  size_t pages = 0;
+  int rc = 0;
+
+  if (buffer == NULL) {
+    return fail("alloc");
+  }
+  populate(&state);
+  if (u6_entity_snapshot_capture(&s0, &state, NULL) != U6_ENTITY_SNAPSHOT_OK) {
+    free(buffer);
+    return fail("capture s0");
+  }
+  /* One object on page 5 and one NPC on page 2. */
+  u6_entities_find_object(&state, 1290)->quantity = 99;
+  u6_entities_touch_object(&state, 1290);
+  u6_entities_move_npc(&state, 150, 1, 1, 0);
+  if (u6_entity_snapshot_capture(&s1, &state, &s0) != U6_ENTITY_SNAPSHOT_OK) {
+    u6_entity_snapshot_release(&s0);
+    free(buffer);
+    return fail("capture s1");
+  }
+  for (size_t p = 0; p < U6M_OBJECT_PAGES && s1.object_pages[p] != NULL; p++) {
+    pages++;
+    shared += s1.object_pages[p] == s0.object_pages[p];
+  }
+  if (pages != (OBJECTS + U6M_OBJECT_PAGE_SIZE - 1u) / U6M_OBJECT_PAGE_SIZE || shared != pages - 1u
+      || s1.object_pages[1289u / U6M_OBJECT_PAGE_SIZE] == s0.object_pages[1289u / U6M_OBJECT_PAGE_SIZE]
+      || s1.object_pages[0]->refs != 2u) {
+    rc = fail("only the edited object page should be copied");
+  }
+  if (rc == 0 && (s1.npc_pages[0] != s0.npc_pages[0] || s1.npc_pages[2] == s0.npc_pages[2])) {
+    rc = fail("only the edited NPC page should be copied");
+  }
+
+  /* A fork outlives the snapshot it came from. */
+  if (rc == 0 && u6_entity_snapshot_fork(&fork, &s1) != U6_ENTITY_SNAPSHOT_OK) {
+    rc = fail("fork");
+  }
+  u6_entity_snapshot_release(&s1);
+  if (rc == 0) {
+    const U6ObjectState *edited = u6_entity_snapshot_object_at(&fork, 1289u);
+    const U6ObjectState *old = u6_entity_snapshot_object_at(&s0, 1289u);
+    if (edited == NULL || old == NULL || edited->quantity != 99u || old->quantity == 99u || fork.object_pages[0]->refs != 2u
+        || u6_entity_snapshot_npc_at(&fork, 149u)->map_x != 1) {
+      rc = fail("fork contents");
+    }
+  }
+  u6_entity_snapshot_release(&fork);
+  if (rc == 0 && s0.object_pages[0]->refs != 1u) {
+    rc = fail("refs after release");
+  }
+  u6_entity_snapshot_release(&s0);
+  free(buffer);
+  return rc;
+}
+
+/*
+ * Keep a chain of snapshots (each captured against the previous one) plus a
+ * full serialized copy of the state at the same points, then roll back to
+ * random points and compare against the serialized reference.
+ */
+static int test_history_restore(void) {
+  static U6EntityState state;
+  static U6EntityState reference;
+  static U6EntityState replica;
+  static U6EntitySnapshot history[HISTORY];
+  static uint8_t *blobs[HISTORY];
+  static size_t blob_sizes[HISTORY];
+  U6EntityArena arena;
+  U6EntityArena ref_arena;
+  U6EntityArena rep_arena;
+  uint8_t *buffer = new_arena_state(&state, &arena);
+  uint8_t *ref_buffer = new_arena_state(&reference, &ref_arena);
+  uint8_t *rep_buffer = new_arena_state(&replica, &rep_arena);
+  uint32_t rng = 0x1234567u;
+  uint32_t synced = 0;
+  int rc = 0;
+
+  if (buffer == NULL || ref_buffer == NULL || rep_buffer == NULL) {
+    free(buffer);
+    free(ref_buffer);
+    free(rep_buffer);
+    return fail("alloc");
+  }
+  populate(&state);
+  for (int h = 0; h < HISTORY && rc == 0; h++) {
+    size_t size = u6_entities_serialized_size(&state);
+    blobs[h] = (uint8_t *)malloc(size);
+    if (blobs[h] == NULL || u6_entities_serialize(&state, blobs[h], size, &blob_sizes[h]) != 0
+        || u6_entity_snapshot_capture(&history[h], &state, h > 0 ? &history[h - 1] : NULL) != U6_ENTITY_SNAPSHOT_OK) {
+      rc = fail("capture history");
+    }
+    mutate(&state, &rng, 1u + rng_next(&rng) % 40u);
+  }
+
+  /* The replica follows state through deltas, including across restores. */
+  if (rc == 0) {
+    size_t size = u6_entities_serialized_size(&state);
+    uint8_t *blob = (uint8_t *)malloc(size);
+    size_t written = 0;
+    if (blob == NULL || u6_entities_serialize(&state, blob, size, &written) != 0
+        || u6_entities_deserialize_arena(&replica, &rep_arena, blob, written) != 0) {
+      rc = fail("seed replica");
+    }
+    free(blob);
+    synced = u6_entities_version(&state);
+  }
+
+  for (int round = 0; round < 40 && rc == 0; round++) {
+    int h = (int)(rng_next(&rng) % HISTORY);
+    size_t delta_size = 0;
+    uint8_t *delta;
+    int changes;
+
+    mutate(&state, &rng, 1u + rng_next(&rng) % 30u);
+    changes = u6_entity_snapshot_restore(&state, &history[h]);
+    u6_entity_arena_init(&ref_arena, ref_buffer, ref_arena.size);
+    if (changes < 0 || u6_entities_deserialize_arena(&reference, &ref_arena, blobs[h], blob_sizes[h]) != 0) {
+      rc = fail("restore");
+      break;
+    }
+    if (!same_entities(&state, &reference) || !same_entities(&reference, &state)) {
+      rc = fail("restored state differs from the reference");
+      break;
+    }
+    if (u6_entity_snapshot_restore(&state, &history[h]) != 0) {
+      rc = fail("second restore should be a no-op");
+      break;
+    }
+    /* Versions only move forward, so the replica catches up with a delta. */
+    if (u6_entities_delta_size(&state, synced, &delta_size) != 0) {
+      continue; /* tombstone ring overrun: a real peer would resync in full */
+    }
+    delta = (uint8_t *)malloc(delta_size);
+    if (delta == NULL || u6_entities_serialize_delta(&state, synced, delta, delta_size, &delta_size) != 0
+        || u6_entities_apply_delta(&replica, delta, delta_size) != 0 || !same_entities(&state, &replica)) {
+      rc = fail("replica diverged across restore");
+    }
+    free(delta);
+    synced = u6_entities_version(&state);
+  }
+
+  /* Restoring into a state the snapshot did not come from reconciles in full. */
+  if (rc == 0) {
+    u6_entity_arena_init(&ref_arena, ref_buffer, ref_arena.size);
+    u6_entities_init_arena(&reference, &ref_arena);
+    populate(&reference);
+    mutate(&reference, &rng, 200u);
+    if (u6_entity_snapshot_restore(&reference, &history[HISTORY - 1]) <= 0) {
+      rc = fail("foreign restore");
+    } else {
+      u6_entity_arena_init(&rep_arena, rep_buffer, rep_arena.size);
+      if (u6_entities_deserialize_arena(&replica, &rep_arena, blobs[HISTORY - 1], blob_sizes[HISTORY - 1]) != 0
+          || !same_entities(&reference, &replica) || !same_entities(&replica, &reference)) {
+        rc = fail("foreign restore differs");
+      }
+    }
+  }
+
+  for (int h = 0; h < HISTORY; h++) {
+    u6_entity_snapshot_release(&history[h]);
+    free(blobs[h]);
+  }
+  free(buffer);
+  free(ref_buffer);
+  free(rep_buffer);
+  return rc;
+}
+
+/* Rolling back a few edits only visits and rewrites what changed. */
+static int test_rollback_is_local(void) {
+  static U6EntityState state;
+  U6EntityArena arena;
+  U6EntitySnapshot snap;
+  uint8_t *buffer = new_arena_state(&state, &arena);
+  uint64_t before;
+  int rc = 0;
+
+  if (buffer == NULL) {
+    return fail("alloc");
+  }
+  populate(&state);
+  before = u6_entities_hash(&state);
+  if (u6_entity_snapshot_capture(&snap, &state, NULL) != U6_ENTITY_SNAPSHOT_OK) {
+    free(buffer);
+    return fail("capture");
+  }
+  u6_entities_remove_object(&state, 10);
+  u6_entities_find_object(&state, 2000)->tile_id = 1;
+  u6_entities_touch_object(&state, 2000);
+  u6_entities_move_npc(&state, 3, 50, 50, 0);
+  if (u6_entity_snapshot_restore(&state, &snap) != 3 || u6_entities_hash(&state) != before
+      || u6_entities_children(&state, U6_OBJECT_HOLDER_OBJECT, 9, NULL, 0) != 1u) {
+    rc = fail("rollback of three edits");
+  }
+  u6_entity_snapshot_release(&snap);
+  free(buffer);
+  return rc;
+}
+
+int main(void) {
+  if (test_capture_shares_untouched_pages() != 0) return 1;
+  if (test_history_restore() != 0) return 1;
+  if (test_rollback_is_local() != 0) return 1;
+  printf("PASS: u6 entity snapshot\n");
+  return 0;
+}
@@ -0,0 +1,344 @@
+#include "u6_lzw.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int fail(const char *msg) {
+  fprintf(stderr, "FAIL: %s\n", msg);
+  return 1;
+}
+
+static uint32_t rng_next(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+/*
+ * Straight port of decompressU6Lzw (client-web/app.ts): per-entry buffers,
+ * bit-at-a-time reads. Returns bytes produced (<= target).
+ */
+static size_t reference_decode(const uint8_t *src, size_t src_size, uint8_t *out, size_t target) {
+  static uint8_t *table[4096];
+  static size_t table_len[4096];
+  static uint8_t literal[256];
+  size_t out_pos = 0;
+  size_t bit_pos = 0;
+  int code_size = 9;
+  int next_code = 258;
+  uint8_t *prev = NULL;
+  size_t prev_len = 0;
+  uint8_t *kwk = NULL;
+
+  for (int i = 0; i < 256; i++) {
+    literal[i] = (uint8_t)i;
+    table[i] = &literal[i];
+    table_len[i] = 1;
+  }
+  for (int i = 256; i < 4096; i++) {
+    table[i] = NULL;
+  }
+
+  while (out_pos < target) {
+    int code = 0;
+    const uint8_t *entry;
+    size_t entry_len;
+    for (int i = 0; i < code_size; i++) {
+      size_t bi = (bit_pos + (size_t)i) >> 3;
+      if (bi >= src_size) {
+        code = -1;
+        break;
+      }
+      code |= ((src[bi] >> ((bit_pos + (size_t)i) & 7u)) & 1) << i;
+    }
+    if (code < 0) {
+      break;
+    }
+    bit_pos += (size_t)code_size;
+    if (code == 256) {
+      for (int i = 258; i < 4096; i++) {
+        free(table[i]);
+        table[i] = NULL;
+      }
+      code_size = 9;
+      next_code = 258;
+      free(prev);
+      prev = NULL;
+      continue;
+    }
+    if (code == 257) {
+      break;
+    }
+    if (table[code] != NULL) {
+      entry = table[code];
+      entry_len = table_len[code];
+    } else if (code == next_code && prev != NULL) {
+      free(kwk);
+      kwk = (uint8_t *)malloc(prev_len + 1);
+      memcpy(kwk, prev, prev_len);
+      kwk[prev_len] = prev[0];
+      entry = kwk;
+      entry_len = prev_len + 1;
+    } else {
+      break;
+    }
+    for (size_t i = 0; i < entry_len && out_pos + i < target; i++) {
+      out[out_pos + i] = entry[i];
+    }
+    out_pos += entry_len;
+    if (prev != NULL && next_code < 4096) {
+      uint8_t *n = (uint8_t *)malloc(prev_len + 1);
+      memcpy(n, prev, prev_len);
+      n[prev_len] = entry[0];
+      table[next_code] = n;
+      table_len[next_code] = prev_len + 1;
+      next_code++;
+      if ((next_code == 512 || next_code == 1024 || next_code == 2048) && code_size < 12) {
+        code_size++;
+      }
+    }
+    {
+      uint8_t *copy = (uint8_t *)malloc(entry_len);
+      memcpy(copy, entry, entry_len);
+      free(prev);
+      prev = copy;
+      prev_len = entry_len;
+    }
+  }
+
+  for (int i = 258; i < 4096; i++) {
+    free(table[i]);
+    table[i] = NULL;
+  }
+  free(kwk);
+  free(prev);
+  return out_pos < target ? out_pos : target;
+}
+
+static void fill_sample(uint8_t *buf, size_t size, uint32_t seed, unsigned alphabet) {
+  uint32_t rng = seed;
+  for (size_t i = 0; i < size; i++) {
+    if (i >= 16 && (rng_next(&rng) % 4u) == 0u) {
+      buf[i] = buf[i - 1 - (rng_next(&rng) % 16u)];
+    } else {
+      buf[i] = (uint8_t)(rng_next(&rng) % alphabet);
+    }
+  }
+}
+
+static int test_roundtrip(void) {
+  static const size_t sizes[] = {1, 2, 3, 257, 4096, 70000, 300000};
+  static const unsigned alphabets[] = {1, 4, 256};
+  int rc = 0;
+
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && rc == 0; s++) {
+    for (size_t a = 0; a < sizeof(alphabets) / sizeof(alphabets[0]) && rc == 0; a++) {
+      size_t n = sizes[s];
+      size_t bound = u6_lzw_compress_bound(n);
+      uint8_t *plain = (uint8_t *)malloc(n);
+      uint8_t *packed = (uint8_t *)malloc(bound);
+      uint8_t *decoded = (uint8_t *)malloc(n);
+      uint8_t *reference = (uint8_t *)malloc(n);
+      size_t packed_size = 0;
+      size_t decoded_size = 0;
+
+      fill_sample(plain, n, (uint32_t)(0x1234u + s * 7u + a), alphabets[a]);
+      if (u6_lzw_compress(plain, n, packed, bound, &packed_size) != U6_LZW_OK) {
+        rc = fail("compress failed");
+      } else if (u6_lzw_decompress(packed, packed_size, decoded, n, &decoded_size) != U6_LZW_OK
+                 || decoded_size != n || memcmp(decoded, plain, n) != 0) {
+        rc = fail("roundtrip mismatch");
+      } else if (reference_decode(packed + 4, packed_size - 4, reference, n) != n || memcmp(reference, plain, n) != 0) {
+        rc = fail("reference decoder rejects encoder output");
+      } else if (u6_lzw_decompress_known_length(packed + 4, packed_size - 4, n, decoded, n, &decoded_size) != U6_LZW_OK
+                 || memcmp(decoded, plain, n) != 0) {
+        rc = fail("known-length decode mismatch");
+      }
+      free(plain);
+      free(packed);
+      free(decoded);
+      free(reference);
+    }
+  }
+  return rc;
+}
+
+static void put_bits(uint8_t *buf, size_t *bit_pos, unsigned code, unsigned width) {
+  for (unsigned i = 0; i < width; i++) {
+    if ((code >> i) & 1u) {
+      buf[(*bit_pos + i) >> 3] |= (uint8_t)(1u << ((*bit_pos + i) & 7u));
+    }
+  }
+  *bit_pos += width;
+}
+
+static int test_clear_and_kwkwk(void) {
+  uint8_t stream[16];
+  uint8_t out[8];
+  size_t bit_pos = 32;
+  size_t produced = 0;
+
+  memset(stream, 0, sizeof(stream));
+  stream[0] = 5;
+  put_bits(stream, &bit_pos, 'A', 9);
+  put_bits(stream, &bit_pos, 'B', 9);
+  put_bits(stream, &bit_pos, U6_LZW_CODE_CLEAR, 9);
+  put_bits(stream, &bit_pos, 'C', 9);
+  put_bits(stream, &bit_pos, 258, 9); /* undefined after CLEAR: KwKwK -> "CC" */
+  put_bits(stream, &bit_pos, U6_LZW_CODE_END, 9);
+
+  if (u6_lzw_decompress(stream, sizeof(stream), out, sizeof(out), &produced) != U6_LZW_OK
+      || produced != 5 || memcmp(out, "ABCCC", 5) != 0) {
+    return fail("clear/KwKwK stream mismatch");
+  }
+
+  /* Header promises more than END delivers: partial output is kept. */
+  stream[0] = 8;
+  if (u6_lzw_decompress(stream, sizeof(stream), out, sizeof(out), &produced) != U6_LZW_ERR_TRUNCATED
+      || produced != 5) {
+    return fail("early END should report truncation");
+  }
+  stream[0] = 0;
+  if (u6_lzw_decompress(stream, sizeof(stream), out, sizeof(out), &produced) != U6_LZW_ERR_HEADER) {
+    return fail("zero-length header should be rejected");
+  }
+  stream[0] = 9;
+  if (u6_lzw_decompress(stream, sizeof(stream), out, sizeof(out), &produced) != U6_LZW_ERR_CAPACITY) {
+    return fail("capacity guard mismatch");
+  }
+  return 0;
+}
+
+static int test_streaming_chunks(void) {
+  enum { PLAIN = 50000 };
+  static uint8_t plain[PLAIN];
+  static uint8_t packed[PLAIN * 2];
+  static uint8_t decoded[PLAIN];
+  U6LzwDecoder *dec = (U6LzwDecoder *)malloc(sizeof(U6LzwDecoder));
+  size_t packed_size = 0;
+  size_t in_pos = 4;
+  size_t out_pos = 0;
+  uint32_t rng = 0xfeedbeefu;
+  int rc = 0;
+  int status = U6_LZW_OK;
+
+  if (dec == NULL) {
+    return fail("decoder alloc failed");
+  }
+  fill_sample(plain, PLAIN, 0xabcdu, 8);
+  if (u6_lzw_compress(plain, PLAIN, packed, sizeof(packed), &packed_size) != U6_LZW_OK) {
+    free(dec);
+    return fail("stream fixture compress failed");
+  }
+
+  u6_lzw_decoder_init(dec);
+  while (status != U6_LZW_STOPPED && out_pos < PLAIN) {
+    size_t in_chunk = 1 + rng_next(&rng) % 5u;
+    size_t out_chunk = 1 + rng_next(&rng) % 37u;
+    size_t used = 0;
+    size_t written = 0;
+    if (in_chunk > packed_size - in_pos) {
+      in_chunk = packed_size - in_pos;
+    }
+    if (out_chunk > PLAIN - out_pos) {
+      out_chunk = PLAIN - out_pos;
+    }
+    status = u6_lzw_decoder_feed(dec, packed + in_pos, in_chunk, &used, decoded + out_pos, out_chunk, &written);
+    if (status < 0 || (in_chunk == 0 && written == 0 && status == U6_LZW_OK)) {
+      rc = fail("streaming decoder stalled");
+      break;
+    }
+    in_pos += used;
+    out_pos += written;
+  }
+  if (rc == 0 && (out_pos != PLAIN || memcmp(decoded, plain, PLAIN) != 0)) {
+    rc = fail("streaming decode mismatch");
+  }
+  free(dec);
+  return rc;
+}
+
+/* Garbage and bit-flipped streams: never overrun, always agree with the TS port. */
+static int test_fuzz_parity(void) {
+  enum { MAX_IN = 600, MAX_OUT = 4000 };
+  static uint8_t src[MAX_IN];
+  static uint8_t got[MAX_OUT];
+  static uint8_t want[MAX_OUT];
+  static uint8_t plain[MAX_OUT];
+  uint32_t rng = 0x0ddba11u;
+
+  for (int iter = 0; iter < 3000; iter++) {
+    size_t in_size;
+    size_t target = 1 + rng_next(&rng) % (MAX_OUT - 1);
+    size_t produced = 0;
+    size_t want_n;
+    int rc;
+
+    if ((iter & 1) == 0) {
+      in_size = rng_next(&rng) % MAX_IN;
+      for (size_t i = 0; i < in_size; i++) {
+        src[i] = (uint8_t)rng_next(&rng);
+      }
+    } else {
+      size_t plain_n = 1 + rng_next(&rng) % 700u;
+      fill_sample(plain, plain_n, rng_next(&rng), 1 + rng_next(&rng) % 20u);
+      if (u6_lzw_compress(plain, plain_n, src, MAX_IN, &in_size) != U6_LZW_OK) {
+        continue;
+      }
+      for (int f = 0; f < 3; f++) {
+        if (in_size > 4) {
+          src[4 + rng_next(&rng) % (in_size - 4)] ^= (uint8_t)(1u << (rng_next(&rng) % 8u));
+        }
+      }
+    }
+    if (in_size < 4) {
+      in_size = 4;
+    }
+    src[0] = (uint8_t)target;
+    src[1] = (uint8_t)(target >> 8);
+    src[2] = 0;
+    src[3] = 0;
+
+    memset(got, 0xa5, sizeof(got));
+    rc = u6_lzw_decompress(src, in_size, got, target, &produced);
+    want_n = reference_decode(src + 4, in_size - 4, want, target);
+    if ((rc != U6_LZW_OK && rc != U6_LZW_ERR_TRUNCATED) || produced != want_n || memcmp(got, want, want_n) != 0) {
+      return fail("fuzz parity mismatch");
+    }
+    if (produced < target && got[produced] != 0xa5) {
+      return fail("decoder wrote past produced length");
+    }
+  }
+  return 0;
+}
+
+int main(void) {
+  int rc;
+
+  rc = test_roundtrip();
+  if (rc != 0) {
+    return rc;
+  }
+
+  rc = test_clear_and_kwkwk();
+  if (rc != 0) {
+    return rc;
+  }
+
+  rc = test_streaming_chunks();
+  if (rc != 0) {
+    return rc;
+  }
+
+  rc = test_fuzz_parity();
+  if (rc != 0) {
+    return rc;
+  }
+
+  puts("PASS: u6 lzw");
+  return 0;
+}
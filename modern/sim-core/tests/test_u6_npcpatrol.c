@@ -0,0 +1,131 @@
+#include "u6_npcpatrol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { N = 5003 };
+
+static int fail(const char *msg) {
+  fprintf(stderr, "FAIL: %s\n", msg);
+  return 1;
+}
+
+static uint32_t rng_next(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+/* Full int16/int8 ranges, including -128 deltas and far out-of-map positions. */
+static int test_kernel_matches_scalar(void) {
+  U6NpcPatrolTable vec;
+  U6NpcPatrolTable ref;
+  uint32_t rng = 0x5eed1234u;
+
+  if (u6_npcpatrol_init(&vec, N) != U6_NPCPATROL_OK || u6_npcpatrol_init(&ref, N) != U6_NPCPATROL_OK) {
+    return fail("init");
+  }
+  for (size_t i = 0; i < N; i++) {
+    U6NpcState npc;
+    uint32_t r = rng_next(&rng);
+    memset(&npc, 0, sizeof(npc));
+    if ((r & 3u) == 0u) {
+      npc.map_x = (int16_t)(rng_next(&rng) & 0xffffu);
+      npc.map_y = (int16_t)(rng_next(&rng) & 0xffffu);
+    } else {
+      npc.map_x = (int16_t)(rng_next(&rng) % 1024u);
+      npc.map_y = (int16_t)((r >> 8) % 1024u);
+    }
+    npc.patrol_dx = (int8_t)(rng_next(&rng) & 0xffu);
+    npc.patrol_dy = (int8_t)((r & 4u) != 0u ? -128 : (int8_t)(rng_next(&rng) % 5u) - 2);
+    npc.flags = (uint8_t)((r >> 16) & 7u);
+    u6_npcpatrol_append(&vec, &npc, (uint16_t)i);
+    u6_npcpatrol_append(&ref, &npc, (uint16_t)i);
+  }
+  for (uint32_t tick = 0; tick < 400u; tick++) {
+    u6_npcpatrol_step(&vec, tick);
+    u6_npcpatrol_step_scalar(&ref, tick);
+  }
+  if (memcmp(vec.x, ref.x, N * sizeof(int16_t)) != 0 || memcmp(vec.y, ref.y, N * sizeof(int16_t)) != 0
+      || memcmp(vec.dx, ref.dx, N) != 0 || memcmp(vec.dy, ref.dy, N) != 0) {
+    u6_npcpatrol_free(&vec);
+    u6_npcpatrol_free(&ref);
+    return fail("vector kernel diverged from scalar reference");
+  }
+  u6_npcpatrol_free(&vec);
+  u6_npcpatrol_free(&ref);
+  return 0;
+}
+
+/* load/step/store must match u6_entities_step on the same state. */
+static int test_matches_entities_step(void) {
+  static U6EntityState table_state;
+  static U6EntityState entity_state;
+  size_t arena_size = u6_entities_arena_bytes(0, U6M_MAX_NPCS);
+  uint8_t *buf_a = (uint8_t *)malloc(arena_size);
+  uint8_t *buf_b = (uint8_t *)malloc(arena_size);
+  U6EntityArena arena_a;
+  U6EntityArena arena_b;
+  U6NpcPatrolTable table;
+  uint32_t rng = 77u;
+  int rc = 0;
+
+  if (buf_a == NULL || buf_b == NULL || u6_npcpatrol_init(&table, U6M_MAX_NPCS) != U6_NPCPATROL_OK) {
+    free(buf_a);
+    free(buf_b);
+    return fail("alloc");
+  }
+  u6_entity_arena_init(&arena_a, buf_a, arena_size);
+  u6_entity_arena_init(&arena_b, buf_b, arena_size);
+  u6_entities_init_arena(&table_state, &arena_a);
+  u6_entities_init_arena(&entity_state, &arena_b);
+  for (uint16_t i = 0; i < U6M_MAX_NPCS; i++) {
+    U6NpcState npc;
+    memset(&npc, 0, sizeof(npc));
+    npc.npc_id = (uint16_t)(i + 1u);
+    npc.map_x = (int16_t)(rng_next(&rng) % 1024u);
+    npc.map_y = (int16_t)(rng_next(&rng) % 1024u);
+    npc.patrol_dx = (int8_t)((int)(rng_next(&rng) % 7u) - 3);
+    npc.patrol_dy = (int8_t)((int)(rng_next(&rng) % 7u) - 3);
+    npc.flags = (uint8_t)(rng_next(&rng) % 4u);
+    u6_entities_add_npc(&table_state, &npc);
+    u6_entities_add_npc(&entity_state, &npc);
+  }
+  /* A freed slot in the middle must be skipped on load and store. */
+  u6_entities_remove_npc(&table_state, 100u);
+  u6_entities_remove_npc(&entity_state, 100u);
+
+  if (u6_npcpatrol_load(&table, &table_state) != U6_NPCPATROL_OK || table.count != U6M_MAX_NPCS - 1u) {
+    rc = fail("load");
+  }
+  for (uint32_t tick = 0; rc == 0 && tick < 2000u; tick++) {
+    u6_npcpatrol_step(&table, tick);
+    u6_entities_step(&entity_state, tick);
+  }
+  if (rc == 0) {
+    u6_npcpatrol_store(&table, &table_state);
+    for (size_t i = 0; i < u6_entities_npc_slots(&entity_state); i++) {
+      const U6NpcState *a = u6_entities_npc_at(&table_state, i);
+      const U6NpcState *b = u6_entities_npc_at(&entity_state, i);
+      if ((a == NULL) != (b == NULL) || (a != NULL && memcmp(a, b, sizeof(*a)) != 0)) {
+        rc = fail("table step diverged from u6_entities_step");
+        break;
+      }
+    }
+  }
+  u6_npcpatrol_free(&table);
+  free(buf_a);
+  free(buf_b);
+  return rc;
+}
+
+int main(void) {
+  if (test_kernel_matches_scalar() != 0) return 1;
+  if (test_matches_entities_step() != 0) return 1;
+  printf("PASS: u6 npcpatrol (%s)\n", u6_npcpatrol_kernel_name());
+  return 0;
+}
@@ -0,0 +1,170 @@
+#include "u6_npcsched.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { CAP = 3000 };
+
+static int fail(const char *msg) {
+  fprintf(stderr, "FAIL: %s\n", msg);
+  return 1;
+}
+
+static uint32_t rng_next(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+/* Naive model: per-slot mode and wake tick, woken by a full scan. */
+static uint8_t g_mode[CAP];
+static uint32_t g_wake[CAP];
+
+static int check_against_model(const U6NpcScheduler *sched) {
+  static uint8_t seen[CAP];
+  size_t running = 0;
+  size_t sleeping = 0;
+
+  memset(seen, 0, sizeof(seen));
+  for (size_t i = 0; i < sched->run_count; i++) {
+    uint16_t slot = sched->run[i];
+    if (slot >= CAP || seen[slot] || g_mode[slot] != U6_NPCSCHED_RUNNING || sched->run_pos[slot] != i) {
+      return 0;
+    }
+    seen[slot] = 1;
+  }
+  for (uint16_t s = 0; s < CAP; s++) {
+    if (u6_npcsched_mode(sched, s) != g_mode[s]) {
+      return 0;
+    }
+    running += g_mode[s] == U6_NPCSCHED_RUNNING;
+    sleeping += g_mode[s] == U6_NPCSCHED_SLEEPING;
+  }
+  return running == sched->run_count && sleeping == sched->sleeping;
+}
+
+static int test_random_against_model(void) {
+  U6NpcScheduler sched;
+  uint32_t rng = 0xfeedbeefu;
+  uint32_t now = 1000u;
+
+  if (u6_npcsched_init(&sched, CAP, now) != U6_NPCSCHED_OK) {
+    return fail("init");
+  }
+  memset(g_mode, 0, sizeof(g_mode));
+  for (int step = 0; step < 60000; step++) {
+    uint32_t r = rng_next(&rng);
+    uint16_t slot = (uint16_t)(rng_next(&rng) % CAP);
+    switch (r % 8u) {
+      case 0:
+      case 1:
+        u6_npcsched_activate(&sched, slot);
+        g_mode[slot] = U6_NPCSCHED_RUNNING;
+        break;
+      case 2:
+        u6_npcsched_deactivate(&sched, slot);
+        g_mode[slot] = U6_NPCSCHED_IDLE;
+        break;
+      case 3:
+      case 4: {
+        /* Mix near wake-ups with ones several wheel turns out. */
+        uint32_t delay = (r & 0x100u) ? (rng_next(&rng) % 2000u) : (rng_next(&rng) % 40u);
+        u6_npcsched_sleep_until(&sched, slot, now + delay);
+        g_mode[slot] = delay == 0u ? U6_NPCSCHED_RUNNING : U6_NPCSCHED_SLEEPING;
+        g_wake[slot] = now + delay;
+        break;
+      }
+      default: {
+        uint32_t jump = (r & 0x1000u) ? (rng_next(&rng) % 700u) : (rng_next(&rng) % 3u);
+        now += jump;
+        u6_npcsched_advance(&sched, now);
+        for (uint16_t s = 0; s < CAP; s++) {
+          if (g_mode[s] == U6_NPCSCHED_SLEEPING && g_wake[s] <= now) {
+            g_mode[s] = U6_NPCSCHED_RUNNING;
+          }
+        }
+        break;
+      }
+    }
+    if ((step % 251) == 0 && !check_against_model(&sched)) {
+      u6_npcsched_free(&sched);
+      return fail("scheduler diverged from naive model");
+    }
+  }
+  if (!check_against_model(&sched)) {
+    u6_npcsched_free(&sched);
+    return fail("final state diverged from naive model");
+  }
+  if (u6_npcsched_activate(&sched, CAP) != U6_NPCSCHED_ERR_RANGE) {
+    u6_npcsched_free(&sched);
+    return fail("out-of-range slot accepted");
+  }
+  u6_npcsched_free(&sched);
+  return 0;
+}
+
+/* Stepping only the run list matches stepping every NPC. */
+static int test_step_run_list_matches_full_step(void) {
+  static U6EntityState full;
+  static U6EntityState active;
+  size_t arena_size = u6_entities_arena_bytes(0, U6M_MAX_NPCS);
+  uint8_t *buf_a = (uint8_t *)malloc(arena_size);
+  uint8_t *buf_b = (uint8_t *)malloc(arena_size);
+  U6EntityArena arena_a;
+  U6EntityArena arena_b;
+  U6NpcScheduler sched;
+  uint32_t rng = 99u;
+  int rc = 0;
+
+  if (buf_a == NULL || buf_b == NULL || u6_npcsched_init(&sched, U6M_MAX_NPCS, 0u) != U6_NPCSCHED_OK) {
+    free(buf_a);
+    free(buf_b);
+    return fail("alloc");
+  }
+  u6_entity_arena_init(&arena_a, buf_a, arena_size);
+  u6_entity_arena_init(&arena_b, buf_b, arena_size);
+  u6_entities_init_arena(&full, &arena_a);
+  u6_entities_init_arena(&active, &arena_b);
+  for (uint16_t i = 0; i < U6M_MAX_NPCS; i++) {
+    U6NpcState npc;
+    memset(&npc, 0, sizeof(npc));
+    npc.npc_id = (uint16_t)(i + 1u);
+    npc.map_x = (int16_t)(rng_next(&rng) % 1024u);
+    npc.map_y = (int16_t)(rng_next(&rng) % 1024u);
+    npc.patrol_dx = (int8_t)((int)(rng_next(&rng) % 5u) - 2);
+    npc.patrol_dy = (int8_t)((int)(rng_next(&rng) % 5u) - 2);
+    /* Most of the population is idle; only one in eight patrols. */
+    npc.flags = (rng_next(&rng) % 8u) == 0u ? (U6_NPC_FLAG_ACTIVE | U6_NPC_FLAG_PATROL) : U6_NPC_FLAG_ACTIVE;
+    u6_entities_add_npc(&full, &npc);
+    u6_entities_add_npc(&active, &npc);
+  }
+  u6_npcsched_sync_patrol(&sched, &active);
+  if (sched.run_count == 0u || sched.run_count >= U6M_MAX_NPCS / 2u) {
+    rc = fail("unexpected run-list size");
+  }
+  for (uint32_t tick = 1; rc == 0 && tick <= 1200u; tick++) {
+    u6_npcsched_advance(&sched, tick);
+    u6_entities_step(&full, tick);
+    u6_entities_step_slots(&active, sched.run, sched.run_count, tick);
+  }
+  for (size_t i = 0; rc == 0 && i < U6M_MAX_NPCS; i++) {
+    if (memcmp(u6_entities_npc_at(&full, i), u6_entities_npc_at(&active, i), sizeof(U6NpcState)) != 0) {
+      rc = fail("run-list step diverged from full step");
+    }
+  }
+  u6_npcsched_free(&sched);
+  free(buf_a);
+  free(buf_b);
+  return rc;
+}
+
+int main(void) {
+  if (test_random_against_model() != 0) return 1;
+  if (test_step_run_list_matches_full_step() != 0) return 1;
+  printf("PASS: u6 npcsched\n");
+  return 0;
+}
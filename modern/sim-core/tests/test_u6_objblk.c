@@ -77,6 +77,73 @@ static int test_parse_records(void) {
   return 0;
 }
 
+static int test_parse_locxyz_and_view(void) {
+  uint8_t blob[2 + (4 * U6_OBJBLK_RECORD_SIZE)];
+  U6ObjBlkRecord full[4];
+  U6ObjBlkRecord filtered[4];
+  U6ObjBlkRecord lazy;
+  U6ObjBlkView view;
+  size_t full_count = 0;
+  size_t filtered_count = 0;
+  size_t j = 0;
+  uint8_t c[3];
+
+  memset(full, 0, sizeof(full));
+  memset(filtered, 0, sizeof(filtered));
+  memset(&lazy, 0, sizeof(lazy));
+  memset(blob, 0, sizeof(blob));
+  /* Header claims more records than the buffer holds; both paths clamp. */
+  put_u16_le(blob + 0, 9);
+  for (int i = 0; i < 4; i++) {
+    uint8_t *rec = blob + 2 + (i * U6_OBJBLK_RECORD_SIZE);
+    rec[0] = (uint8_t)((i == 1) ? 0x18 : ((i == 2) ? 0x21 : 0x00));
+    encode_coord(c, (uint16_t)(100 + i), (uint16_t)(200 + i), (uint8_t)i);
+    memcpy(rec + 1, c, 3);
+    put_u16_le(rec + 4, (uint16_t)(0x050u + (unsigned)i + ((unsigned)i << 10)));
+    put_u16_le(rec + 6, (uint16_t)(i * 7));
+  }
+
+  if (u6_objblk_parse_records(blob, sizeof(blob), full, 4, &full_count) != 0 || full_count != 4) {
+    return fail("reference parse failed");
+  }
+  if (u6_objblk_parse_locxyz(blob, sizeof(blob), 12, filtered, 4, &filtered_count) != 0) {
+    return fail("parse_locxyz failed");
+  }
+  if (filtered_count != 3) {
+    return fail("parse_locxyz filter count mismatch");
+  }
+  for (size_t i = 0; i < full_count; i++) {
+    if (!u6_objblk_is_locxyz(full[i].status)) {
+      continue;
+    }
+    full[i].source_area = 12;
+    if (memcmp(&full[i], &filtered[j], sizeof(U6ObjBlkRecord)) != 0) {
+      return fail("parse_locxyz record mismatch");
+    }
+    j++;
+  }
+
+  filtered_count = 0;
+  if (u6_objblk_parse_locxyz(blob, sizeof(blob), 12, filtered, 2, &filtered_count) != -3 || filtered_count != 2) {
+    return fail("parse_locxyz capacity guard mismatch");
+  }
+
+  if (u6_objblk_view_init(&view, blob, sizeof(blob)) != 0 || view.count != 4) {
+    return fail("view init mismatch");
+  }
+  if (u6_objblk_view_status(&view, 1) != 0x18) {
+    return fail("view status peek mismatch");
+  }
+  view.source_area = 12;
+  if (u6_objblk_view_get(&view, 3, &lazy) != 0 || memcmp(&lazy, &full[3], sizeof(lazy)) != 0) {
+    return fail("view lazy decode mismatch");
+  }
+  if (u6_objblk_view_get(&view, 4, &lazy) != -3) {
+    return fail("view bounds guard mismatch");
+  }
+  return 0;
+}
+
 static int write_objblk(const char *path, const uint8_t *buf, size_t n) {
   FILE *fp = fopen(path, "wb");
   if (fp == NULL) {
@@ -167,6 +234,86 @@ static int test_load_outdoor(void) {
   return 0;
 }
 
+static int test_load_outdoor_parallel(void) {
+  char dir[512];
+  char path[sizeof(dir) + sizeof("/objblkaa")];
+  uint8_t blob[2 + (5 * U6_OBJBLK_RECORD_SIZE)];
+  U6ObjBlkRecord serial[256];
+  U6ObjBlkRecord parallel[256];
+  size_t serial_count = 0;
+  size_t serial_files = 0;
+  const unsigned worker_counts[] = {1u, 3u, 0u};
+  uint8_t c[3];
+  int rc;
+
+  snprintf(dir, sizeof(dir), "/tmp/u6m_objblk_par_test_%ld_%ld", (long)getpid(), (long)time(NULL));
+  if (mkdir(dir, 0700) != 0) {
+    return fail("mkdir parallel fixture dir failed");
+  }
+
+  /* Every third area gets five records; every fourth record is CONTAINED. */
+  for (int area = 0; area < 64; area += 3) {
+    memset(blob, 0, sizeof(blob));
+    put_u16_le(blob + 0, 5);
+    for (int i = 0; i < 5; i++) {
+      uint8_t *rec = blob + 2 + (i * U6_OBJBLK_RECORD_SIZE);
+      rec[0] = (uint8_t)(((area + i) % 4) == 0 ? 0x08 : 0x00);
+      encode_coord(c, (uint16_t)((area & 7) * 128 + i), (uint16_t)((area >> 3) * 128 + (i * 3)), (uint8_t)(i & 1));
+      memcpy(rec + 1, c, 3);
+      put_u16_le(rec + 4, (uint16_t)(0x100u + (unsigned)area));
+      put_u16_le(rec + 6, (uint16_t)i);
+    }
+    snprintf(path, sizeof(path), "%s/objblk%c%c", dir, (char)('a' + (area & 7)), (char)('a' + (area >> 3)));
+    if (write_objblk(path, blob, sizeof(blob)) != 0) {
+      return fail("write parallel fixture objblk failed");
+    }
+  }
+
+  rc = u6_objblk_load_outdoor_savegame(dir, serial, 256, &serial_count, &serial_files);
+  if (rc != 0 || serial_files != 22) {
+    return fail("serial reference load failed");
+  }
+
+  for (size_t w = 0; w < sizeof(worker_counts) / sizeof(worker_counts[0]); w++) {
+    size_t count = 0;
+    size_t files = 0;
+    memset(parallel, 0xcd, sizeof(parallel));
+    rc = u6_objblk_load_outdoor_savegame_parallel(dir, parallel, 256, &count, &files, worker_counts[w]);
+    if (rc != 0) {
+      return fail("parallel load failed");
+    }
+    if (count != serial_count || files != serial_files) {
+      return fail("parallel load count mismatch");
+    }
+    for (size_t i = 0; i < count; i++) {
+      if (parallel[i].source_area != serial[i].source_area
+          || parallel[i].source_index != serial[i].source_index
+          || parallel[i].x != serial[i].x
+          || parallel[i].y != serial[i].y
+          || parallel[i].z != serial[i].z
+          || parallel[i].shape_type != serial[i].shape_type) {
+        return fail("parallel load order mismatch");
+      }
+    }
+  }
+
+  {
+    size_t count = 0;
+    size_t files = 0;
+    rc = u6_objblk_load_outdoor_savegame_parallel(dir, parallel, serial_count - 1, &count, &files, 4u);
+    if (rc != -3) {
+      return fail("parallel load capacity guard mismatch");
+    }
+  }
+
+  for (int area = 0; area < 64; area += 3) {
+    snprintf(path, sizeof(path), "%s/objblk%c%c", dir, (char)('a' + (area & 7)), (char)('a' + (area >> 3)));
+    remove(path);
+  }
+  rmdir(dir);
+  return 0;
+}
+
 static int test_render_sort(void) {
   U6ObjBlkRecord recs[6];
 
@@ -243,6 +390,193 @@ static int test_render_sort(void) {
   return 0;
 }
 
+static uint32_t test_rng_next(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+static int records_same_order(const U6ObjBlkRecord *a, const U6ObjBlkRecord *b, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (a[i].source_area != b[i].source_area || a[i].source_index != b[i].source_index
+        || a[i].status != b[i].status || a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static int test_radix_render_sort_parity(void) {
+  enum { N = 6000 };
+  static const uint8_t statuses[] = {0x00, 0x08, 0x10, 0x18, 0x01, 0x11, 0x20};
+  U6ObjBlkRecord *radix = (U6ObjBlkRecord *)calloc(N, sizeof(U6ObjBlkRecord));
+  U6ObjBlkRecord *legacy = (U6ObjBlkRecord *)calloc(N, sizeof(U6ObjBlkRecord));
+  uint32_t rng = 0x2468aceu;
+  int rc = 0;
+
+  if (radix == NULL || legacy == NULL) {
+    free(radix);
+    free(legacy);
+    return fail("radix fixture allocation failed");
+  }
+
+  /* Narrow coordinate ranges force plenty of y/x/z ties. */
+  for (size_t i = 0; i < N; i++) {
+    radix[i].status = statuses[test_rng_next(&rng) % sizeof(statuses)];
+    radix[i].x = (uint16_t)(300 + (test_rng_next(&rng) % 24u));
+    radix[i].y = (uint16_t)(350 + (test_rng_next(&rng) % 24u));
+    radix[i].z = (uint8_t)(test_rng_next(&rng) % 3u);
+    radix[i].source_area = (uint16_t)(test_rng_next(&rng) % 64u);
+    radix[i].source_index = (uint16_t)i;
+  }
+  memcpy(legacy, radix, N * sizeof(U6ObjBlkRecord));
+
+  for (size_t i = 1; i < N; i++) {
+    int cmp = u6_objblk_compare_render_order(&radix[i - 1], &radix[i]);
+    uint64_t ka = u6_objblk_render_key(&radix[i - 1]);
+    uint64_t kb = u6_objblk_render_key(&radix[i]);
+    if ((cmp < 0) != (ka < kb) || (cmp > 0) != (ka > kb)) {
+      rc = fail("render key order disagrees with comparator");
+      goto done;
+    }
+  }
+
+  u6_objblk_sort_for_render(radix, N);
+  u6_objblk_sort_for_render_qsort(legacy, N);
+  if (!records_same_order(radix, legacy, N)) {
+    rc = fail("radix render order mismatch");
+    goto done;
+  }
+
+  /* Out-of-range coordinates take the comparator fallback path. */
+  radix[17].x = 0x0800;
+  legacy[17].x = 0x0800;
+  u6_objblk_sort_for_render(radix, N);
+  u6_objblk_sort_for_render_qsort(legacy, N);
+  if (!records_same_order(radix, legacy, N)) {
+    rc = fail("render order fallback mismatch");
+  }
+
+done:
+  free(radix);
+  free(legacy);
+  return rc;
+}
+
+static size_t append_area_record(uint8_t *buf, size_t off, uint8_t status, uint16_t area_id) {
+  buf[off] = status;
+  encode_coord(&buf[off + 1], (uint16_t)((area_id & 7u) * 128u + 5u), (uint16_t)(((area_id >> 3) & 7u) * 128u + 5u), 0);
+  buf[off + 4] = 0x10;
+  buf[off + 5] = 0x00;
+  buf[off + 6] = 0x01;
+  buf[off + 7] = 0x00;
+  return off + U6_OBJBLK_RECORD_SIZE;
+}
+
+static int test_split_lzobjblk(void) {
+  static uint8_t stream[2 + 64 * (2 + 4 * U6_OBJBLK_RECORD_SIZE)];
+  U6ObjBlkSegment segs[U6_OBJBLK_OUTDOOR_AREAS];
+  size_t off = 0;
+
+  memset(stream, 0, sizeof(stream));
+  for (uint16_t seg = 0; seg < U6_OBJBLK_OUTDOOR_AREAS; seg++) {
+    size_t count_off = off;
+    uint16_t count = 0;
+    off += 2;
+    if (seg == 1) {
+      /* Majority wins inside a segment: 3x area 9 beats 1x area 2. */
+      off = append_area_record(stream, off, 0x00, 9);
+      off = append_area_record(stream, off, 0x00, 9);
+      off = append_area_record(stream, off, 0x00, 9);
+      off = append_area_record(stream, off, 0x00, 2);
+      count = 4;
+    } else if (seg == 2) {
+      off = append_area_record(stream, off, 0x00, 9);
+      off = append_area_record(stream, off, 0x00, 9);
+      count = 2;
+    } else if (seg == 3) {
+      off = append_area_record(stream, off, 0x08, 40);
+      count = 1;
+    } else if (seg >= 4) {
+      off = append_area_record(stream, off, 0x00, seg);
+      count = 1;
+    }
+    stream[count_off] = (uint8_t)count;
+  }
+
+  if (u6_objblk_split_lzobjblk(stream, off, segs) != 0) {
+    return fail("lzobjblk split failed");
+  }
+  /* seg 1 claims area 9 (largest claim); losers take free areas 0..3 in segment order. */
+  if (segs[1].area_id != 9 || segs[0].area_id != 0 || segs[2].area_id != 1 || segs[3].area_id != 2
+      || segs[9].area_id != 3 || segs[40].area_id != 40 || segs[63].area_id != 63) {
+    return fail("lzobjblk area assignment mismatch");
+  }
+  if (segs[1].count != 4 || segs[1].size != 2 + 4 * U6_OBJBLK_RECORD_SIZE || segs[2].offset != segs[1].offset + segs[1].size) {
+    return fail("lzobjblk segment bounds mismatch");
+  }
+
+  if (u6_objblk_split_lzobjblk(stream, off - 1, segs) != -2) {
+    return fail("truncated lzobjblk should fail");
+  }
+  if (u6_objblk_split_lzobjblk(stream, off + 1, segs) != -4) {
+    return fail("trailing lzobjblk bytes should fail");
+  }
+  stream[0] = 0x01;
+  stream[1] = 0x0c;
+  if (u6_objblk_split_lzobjblk(stream, off, segs) != -3) {
+    return fail("oversized lzobjblk count should fail");
+  }
+  return 0;
+}
+
+static int test_encode_roundtrip(void) {
+  uint8_t blob[2 + 6 * U6_OBJBLK_RECORD_SIZE];
+  uint8_t encoded[sizeof(blob)];
+  U6ObjBlkRecord recs[6];
+  size_t count = 0;
+  size_t size = 0;
+  uint32_t rng = 0x5eedu;
+
+  memset(blob, 0, sizeof(blob));
+  put_u16_le(blob, 6);
+  for (size_t i = 0; i < 6; i++) {
+    uint8_t *rec = blob + 2 + (i * U6_OBJBLK_RECORD_SIZE);
+    rng = rng * 1103515245u + 12345u;
+    rec[0] = (uint8_t)(rng >> 8);
+    encode_coord(rec + 1, (uint16_t)((rng >> 4) & 0x3ffu), (uint16_t)((rng >> 14) & 0x3ffu), (uint8_t)(i & 0x0fu));
+    put_u16_le(rec + 4, (uint16_t)(rng >> 16));
+    put_u16_le(rec + 6, (uint16_t)(rng ^ 0xa5a5u));
+  }
+
+  if (u6_objblk_parse_records(blob, sizeof(blob), recs, 6, &count) != 0 || count != 6) {
+    return fail("encode fixture parse failed");
+  }
+  if (u6_objblk_encode_records(recs, count, encoded, sizeof(encoded), &size) != 0
+      || size != sizeof(blob) || memcmp(encoded, blob, size) != 0) {
+    return fail("encode(parse(bytes)) should reproduce bytes");
+  }
+
+  /* Edited type/frame rebuild the packed shape word. */
+  recs[0].obj_type = 0x12a;
+  recs[0].obj_frame = 3;
+  if (u6_objblk_encode_records(recs, count, encoded, sizeof(encoded), &size) != 0
+      || encoded[6] != 0x2a || encoded[7] != (uint8_t)(0x01u | (3u << 2))) {
+    return fail("encode shape word mismatch");
+  }
+  if (u6_objblk_encode_records(recs, count, encoded, sizeof(encoded) - 1, &size) != -3) {
+    return fail("encode capacity guard mismatch");
+  }
+  recs[1].x = 0x400;
+  if (u6_objblk_encode_records(recs, count, encoded, sizeof(encoded), &size) != -4) {
+    return fail("encode range guard mismatch");
+  }
+  return 0;
+}
+
 int main(void) {
   int rc;
 
@@ -251,16 +585,41 @@ int main(void) {
     return rc;
   }
 
+  rc = test_parse_locxyz_and_view();
+  if (rc != 0) {
+    return rc;
+  }
+
   rc = test_load_outdoor();
   if (rc != 0) {
     return rc;
   }
 
+  rc = test_load_outdoor_parallel();
+  if (rc != 0) {
+    return rc;
+  }
+
   rc = test_render_sort();
   if (rc != 0) {
     return rc;
   }
 
+  rc = test_radix_render_sort_parity();
+  if (rc != 0) {
+    return rc;
+  }
+
+  rc = test_split_lzobjblk();
+  if (rc != 0) {
+    return rc;
+  }
+
+  rc = test_encode_roundtrip();
+  if (rc != 0) {
+    return rc;
+  }
+
   puts("PASS: u6 objblk");
   return 0;
 }
@@ -0,0 +1,358 @@
+#include "u6_objblk_store.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static int fail(const char *msg) {
+  fprintf(stderr, "FAIL: %s\n", msg);
+  return 1;
+}
+
+static void encode_coord(uint8_t out[3], uint16_t x, uint16_t y, uint8_t z) {
+  out[0] = (uint8_t)(x & 0xffu);
+  out[1] = (uint8_t)(((x >> 8) & 0x03u) | ((y & 0x3fu) << 2));
+  out[2] = (uint8_t)(((y >> 6) & 0x0fu) | ((z & 0x0fu) << 4));
+}
+
+/* Writes `count` records at (x + i, y, z); every third record is inventory. */
+static int write_area(const char *dir, uint16_t area_id, uint16_t count, uint16_t x, uint16_t y, uint8_t z) {
+  char path[600];
+  uint8_t blob[2 + 16 * U6_OBJBLK_RECORD_SIZE];
+  FILE *fp;
+
+  if (count > 16 || u6_objblk_store_area_path(dir, area_id, path, sizeof(path)) != 0) {
+    return -1;
+  }
+  memset(blob, 0, sizeof(blob));
+  blob[0] = (uint8_t)count;
+  for (uint16_t i = 0; i < count; i++) {
+    uint8_t *rec = blob + 2 + (i * U6_OBJBLK_RECORD_SIZE);
+    rec[0] = (uint8_t)((i % 3u) == 2u ? 0x08 : 0x00);
+    encode_coord(rec + 1, (uint16_t)(x + i), y, z);
+    rec[4] = (uint8_t)(0x40u + i);
+    rec[6] = 1;
+  }
+  fp = fopen(path, "wb");
+  if (fp == NULL) {
+    return -1;
+  }
+  fwrite(blob, 1, 2 + (size_t)count * U6_OBJBLK_RECORD_SIZE, fp);
+  fclose(fp);
+  return 0;
+}
+
+static void remove_area(const char *dir, uint16_t area_id) {
+  char path[600];
+  if (u6_objblk_store_area_path(dir, area_id, path, sizeof(path)) == 0) {
+    remove(path);
+  }
+}
+
+static int test_area_mapping(void) {
+  char path[600];
+
+  if (u6_objblk_store_area_for_position(0, 0, 0) != 0
+      || u6_objblk_store_area_for_position(130, 0, 0) != 1
+      || u6_objblk_store_area_for_position(0, 130, 0) != 8
+      || u6_objblk_store_area_for_position(1023, 1023, 0) != 63
+      || u6_objblk_store_area_for_position(1024, 0, 0) != U6_OBJBLK_STORE_NO_AREA
+      || u6_objblk_store_area_for_position(10, 10, 1) != 64
+      || u6_objblk_store_area_for_position(10, 10, 5) != 68
+      || u6_objblk_store_area_for_position(10, 10, 6) != U6_OBJBLK_STORE_NO_AREA) {
+    return fail("area_for_position mismatch");
+  }
+  if (u6_objblk_store_area_path("sg", 9, path, sizeof(path)) != 0 || strcmp(path, "sg/objblkbb") != 0) {
+    return fail("outdoor area path mismatch");
+  }
+  if (u6_objblk_store_area_path("sg", 66, path, sizeof(path)) != 0 || strcmp(path, "sg/objblkci") != 0) {
+    return fail("dungeon area path mismatch");
+  }
+  if (u6_objblk_store_area_path("sg", 69, path, sizeof(path)) != -2) {
+    return fail("invalid area path should fail");
+  }
+  return 0;
+}
+
+static int test_lazy_load_and_evict(void) {
+  char dir[512];
+  U6ObjBlkStore store;
+  const U6ObjBlkRecord *recs = NULL;
+  size_t count = 0;
+  int rc = 0;
+
+  snprintf(dir, sizeof(dir), "/tmp/u6m_objblk_store_test_%ld_%ld", (long)getpid(), (long)time(NULL));
+  if (mkdir(dir, 0700) != 0) {
+    return fail("mkdir fixture dir failed");
+  }
+  if (write_area(dir, 0, 3, 10, 20, 0) != 0
+      || write_area(dir, 9, 5, 140, 140, 0) != 0
+      || write_area(dir, 64, 4, 30, 30, 1) != 0
+      || write_area(dir, 66, 2, 50, 60, 3) != 0) {
+    rc = fail("write fixture failed");
+    goto cleanup;
+  }
+
+  if (u6_objblk_store_init(&store, dir, 2) != 0) {
+    rc = fail("store init failed");
+    goto cleanup;
+  }
+  if (store.loads != 0 || store.resident_areas != 0) {
+    rc = fail("store should start empty");
+    goto done;
+  }
+
+  /* First access loads all records (inventory included) with area ids set. */
+  if (u6_objblk_store_get_at(&store, 12, 20, 0, &recs, &count) != 0 || count != 3
+      || recs[2].status != 0x08 || recs[1].x != 11 || recs[2].source_area != 0 || recs[2].source_index != 2) {
+    rc = fail("outdoor area load mismatch");
+    goto done;
+  }
+  if (u6_objblk_store_get(&store, 0, &recs, &count) != 0 || store.loads != 1) {
+    rc = fail("second access should not reload");
+    goto done;
+  }
+  if (u6_objblk_store_get_at(&store, 31, 30, 1, &recs, &count) != 0 || count != 4
+      || recs[0].z != 1 || recs[0].source_area != 64) {
+    rc = fail("dungeon level load mismatch");
+    goto done;
+  }
+
+  /* Missing file is an empty area and does not count toward residency. */
+  if (u6_objblk_store_get(&store, 5, &recs, &count) != 0 || count != 0 || store.resident_areas != 2) {
+    rc = fail("missing area should be empty");
+    goto done;
+  }
+
+  /* Third resident area evicts the least recently used one (area 0). */
+  if (u6_objblk_store_get(&store, 9, &recs, &count) != 0 || count != 5) {
+    rc = fail("area 9 load mismatch");
+    goto done;
+  }
+  if (u6_objblk_store_is_resident(&store, 0) || !u6_objblk_store_is_resident(&store, 64)
+      || !u6_objblk_store_is_resident(&store, 9) || store.evictions != 1 || store.resident_records != 9) {
+    rc = fail("LRU eviction mismatch");
+    goto done;
+  }
+  if (u6_objblk_store_get(&store, 66, &recs, &count) != 0 || count != 2 || recs[1].y != 60
+      || u6_objblk_store_is_resident(&store, 64)) {
+    rc = fail("second eviction mismatch");
+    goto done;
+  }
+  if (u6_objblk_store_get(&store, 0, &recs, &count) != 0 || count != 3 || store.loads != 5) {
+    rc = fail("evicted area reload mismatch");
+    goto done;
+  }
+  if (u6_objblk_store_get(&store, U6_OBJBLK_STORE_NO_AREA, &recs, &count) != -2) {
+    rc = fail("invalid area should fail");
+    goto done;
+  }
+
+  u6_objblk_store_evict_all(&store);
+  if (store.resident_areas != 0 || store.resident_records != 0) {
+    rc = fail("evict_all should drop everything");
+  }
+
+done:
+  u6_objblk_store_free(&store);
+cleanup:
+  remove_area(dir, 0);
+  remove_area(dir, 9);
+  remove_area(dir, 64);
+  remove_area(dir, 66);
+  rmdir(dir);
+  return rc;
+}
+
+static int file_exists(const char *dir, const char *name) {
+  char path[600];
+  struct stat st;
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  return stat(path, &st) == 0;
+}
+
+static int test_dirty_save(void) {
+  char dir[512];
+  U6ObjBlkStore store;
+  const U6ObjBlkRecord *recs = NULL;
+  U6ObjBlkRecord *edit = NULL;
+  U6ObjBlkRecord added[4];
+  size_t count = 0;
+  size_t written = 0;
+  uint64_t clean_hash;
+  uint64_t saved_hash;
+  int rc = 0;
+
+  snprintf(dir, sizeof(dir), "/tmp/u6m_objblk_save_test_%ld_%ld", (long)getpid(), (long)time(NULL));
+  if (mkdir(dir, 0700) != 0) {
+    return fail("mkdir save fixture dir failed");
+  }
+  if (write_area(dir, 0, 3, 10, 20, 0) != 0 || write_area(dir, 1, 2, 130, 20, 0) != 0) {
+    rc = fail("write save fixture failed");
+    goto cleanup;
+  }
+
+  u6_objblk_store_init(&store, dir, 1);
+  if (u6_objblk_store_save(&store, &written) != 0 || written != 0) {
+    rc = fail("clean store should write nothing");
+    goto done;
+  }
+  if (u6_objblk_store_get(&store, 0, &recs, &count) != 0) {
+    rc = fail("get before edit failed");
+    goto done;
+  }
+  clean_hash = u6_objblk_store_hash(&store);
+  if (u6_objblk_store_get_mutable(&store, 0, &edit, &count) != 0 || count != 3) {
+    rc = fail("get_mutable failed");
+    goto done;
+  }
+  edit[1].x = 77;
+  edit[1].obj_frame = 2;
+  if (u6_objblk_store_hash(&store) == clean_hash) {
+    rc = fail("store hash should change after an edit");
+    goto done;
+  }
+  /* Further edits through the same pointer must show up without a new get_mutable. */
+  saved_hash = u6_objblk_store_hash(&store);
+  edit[2].amount = 9;
+  if (u6_objblk_store_hash(&store) == saved_hash) {
+    rc = fail("store hash missed an edit through an earlier get_mutable pointer");
+    goto done;
+  }
+  edit[2].amount = 0;
+
+  /* Dirty area 0 is pinned: cap of 1 cannot evict it. */
+  if (u6_objblk_store_get(&store, 1, &recs, &count) != 0 || !u6_objblk_store_is_resident(&store, 0)
+      || u6_objblk_store_evict(&store, 0) != -3) {
+    rc = fail("dirty area should stay resident");
+    goto done;
+  }
+
+  /* Replace adds a record in a previously missing dungeon area. */
+  memset(added, 0, sizeof(added));
+  added[0].x = 5;
+  added[0].y = 6;
+  added[0].z = 2;
+  added[0].obj_type = 0x99;
+  added[0].amount = 4;
+  added[0].source_index = 42;
+  if (u6_objblk_store_replace(&store, 65, added, 1) != 0 || !u6_objblk_store_is_dirty(&store, 65)
+      || store.dirty_areas != 2) {
+    rc = fail("replace should mark the area dirty");
+    goto done;
+  }
+  if (u6_objblk_store_get(&store, 65, &recs, &count) != 0 || count != 1 || recs[0].source_index != 0
+      || recs[0].source_area != 65) {
+    rc = fail("replace should renumber records");
+    goto done;
+  }
+
+  saved_hash = u6_objblk_store_hash(&store);
+  if (u6_objblk_store_save(&store, &written) != 0 || written != 2 || store.dirty_areas != 0) {
+    rc = fail("save should write exactly the dirty areas");
+    goto done;
+  }
+  if (file_exists(dir, "objblkaa.tmp") || !file_exists(dir, "objblkbi")) {
+    rc = fail("save should rename temp files into place");
+    goto done;
+  }
+  u6_objblk_store_free(&store);
+
+  u6_objblk_store_init(&store, dir, 0);
+  if (u6_objblk_store_get(&store, 0, &recs, &count) != 0 || count != 3 || recs[1].x != 77 || recs[1].obj_frame != 2
+      || recs[0].x != 10 || recs[2].status != 0x08) {
+    rc = fail("saved area reload mismatch");
+    goto done;
+  }
+  if (u6_objblk_store_get(&store, 65, &recs, &count) != 0 || count != 1 || recs[0].obj_type != 0x99
+      || recs[0].z != 2 || recs[0].amount != 4) {
+    rc = fail("saved dungeon area reload mismatch");
+    goto done;
+  }
+  if (u6_objblk_store_hash(&store) != saved_hash) {
+    rc = fail("reloaded areas should hash like the saved ones");
+    goto done;
+  }
+  if (u6_objblk_store_get(&store, 1, &recs, &count) != 0 || count != 2 || recs[0].x != 130) {
+    rc = fail("untouched area changed");
+    goto done;
+  }
+
+  /* Residency and access order must not move the hash: evict everything,
+   * reload in another order, and compare a never-accessed store. */
+  if (u6_objblk_store_evict(&store, 0) != 0 || u6_objblk_store_evict(&store, 65) != 0
+      || u6_objblk_store_evict(&store, 1) != 0 || store.resident_areas != 0
+      || u6_objblk_store_hash(&store) != saved_hash) {
+    rc = fail("evicted areas should keep their hash");
+    goto done;
+  }
+  if (u6_objblk_store_hash(&store) == clean_hash) {
+    rc = fail("a saved edit dropped out of the hash after eviction");
+    goto done;
+  }
+  if (u6_objblk_store_get(&store, 65, &recs, &count) != 0 || u6_objblk_store_get(&store, 1, &recs, &count) != 0
+      || u6_objblk_store_hash(&store) != saved_hash) {
+    rc = fail("reload order changed the hash");
+    goto done;
+  }
+  /* Discarded edits fall back to the file contents. */
+  if (u6_objblk_store_get_mutable(&store, 1, &edit, &count) != 0) {
+    rc = fail("get_mutable after reload failed");
+    goto done;
+  }
+  edit[0].x = 131;
+  if (u6_objblk_store_hash(&store) == saved_hash) {
+    rc = fail("edit after reload should change the hash");
+    goto done;
+  }
+  u6_objblk_store_evict_all(&store);
+  if (u6_objblk_store_hash(&store) != saved_hash) {
+    rc = fail("discarded edit should restore the file hash");
+    goto done;
+  }
+  u6_objblk_store_free(&store);
+
+  u6_objblk_store_init(&store, dir, 1);
+  if (u6_objblk_store_hash(&store) != saved_hash || store.resident_areas != 0) {
+    rc = fail("a never-accessed store should hash like a loaded one");
+    goto done;
+  }
+  if (u6_objblk_store_get(&store, 1, &recs, &count) != 0 || u6_objblk_store_get(&store, 0, &recs, &count) != 0
+      || u6_objblk_store_is_resident(&store, 1) || u6_objblk_store_hash(&store) != saved_hash) {
+    rc = fail("LRU eviction changed the hash");
+  }
+
+done:
+  u6_objblk_store_free(&store);
+cleanup:
+  remove_area(dir, 0);
+  remove_area(dir, 1);
+  remove_area(dir, 65);
+  rmdir(dir);
+  return rc;
+}
+
+int main(void) {
+  int rc;
+
+  rc = test_area_mapping();
+  if (rc != 0) {
+    return rc;
+  }
+
+  rc = test_lazy_load_and_evict();
+  if (rc != 0) {
+    return rc;
+  }
+
+  rc = test_dirty_save();
+  if (rc != 0) {
+    return rc;
+  }
+
+  puts("PASS: u6 objblk store");
+  return 0;
+}
@@ -0,0 +1,218 @@
+#include "u6_objgrid.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { N = 4000 };
+
+static int fail(const char *msg) {
+  fprintf(stderr, "FAIL: %s\n", msg);
+  return 1;
+}
+
+static uint32_t rng_next(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+/* Brute-force reference mirroring footprint_hits in the net query bridge. */
+static int ref_matches(const U6ObjBlkRecord *r, uint8_t tf, int cx, int cy, int radius, int has_z, int z, int footprint) {
+  int x = r->x;
+  int y = r->y;
+  if (has_z && r->z != z) return 0;
+  if (abs(x - cx) <= radius && abs(y - cy) <= radius) return 1;
+  if (!footprint) return 0;
+  if ((tf & 0x80) && abs((x - 1) - cx) <= radius && abs(y - cy) <= radius) return 1;
+  if ((tf & 0x40) && abs(x - cx) <= radius && abs((y - 1) - cy) <= radius) return 1;
+  if ((tf & 0xc0) == 0xc0 && abs((x - 1) - cx) <= radius && abs((y - 1) - cy) <= radius) return 1;
+  return 0;
+}
+
+static U6ObjBlkRecord g_recs[N];
+static uint8_t g_flags[N];
+
+static int compare_ref_order(const void *lhs, const void *rhs) {
+  uint32_t a = *(const uint32_t *)lhs;
+  uint32_t b = *(const uint32_t *)rhs;
+  uint64_t ka = u6_objblk_render_key(&g_recs[a]);
+  uint64_t kb = u6_objblk_render_key(&g_recs[b]);
+  if (ka != kb) return ka < kb ? -1 : 1;
+  return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+static int check_query(U6ObjGrid *grid, int cx, int cy, int radius, int has_z, int z, int footprint) {
+  static uint32_t got[N];
+  static uint32_t want[N];
+  size_t want_n = 0;
+  size_t got_n;
+
+  for (uint32_t i = 0; i < N; i++) {
+    if (grid->items[i].in_use && ref_matches(&g_recs[i], g_flags[i], cx, cy, radius, has_z, z, footprint)) {
+      want[want_n++] = i;
+    }
+  }
+  qsort(want, want_n, sizeof(uint32_t), compare_ref_order);
+
+  got_n = u6_objgrid_query_radius(grid,
+                                  cx,
+                                  cy,
+                                  radius,
+                                  has_z,
+                                  z,
+                                  footprint ? U6_OBJGRID_MATCH_FOOTPRINT : U6_OBJGRID_MATCH_ANCHOR,
+                                  got,
+                                  N);
+  if (got_n != want_n) {
+    return 0;
+  }
+  return memcmp(got, want, want_n * sizeof(uint32_t)) == 0;
+}
+
+static int test_radius_queries(void) {
+  U6ObjGrid grid;
+  uint32_t rng = 0x600dcafeu;
+  int rc = 0;
+
+  memset(g_recs, 0, sizeof(g_recs));
+  for (size_t i = 0; i < N; i++) {
+    g_recs[i].status = (uint8_t)((i % 7u) == 0u ? 0x08 : 0x00);
+    g_recs[i].x = (uint16_t)(rng_next(&rng) % 96u);
+    g_recs[i].y = (uint16_t)(rng_next(&rng) % 96u);
+    g_recs[i].z = (uint8_t)(rng_next(&rng) % 2u);
+    g_recs[i].source_area = (uint16_t)(i / 100u);
+    g_recs[i].source_index = (uint16_t)i;
+    g_flags[i] = (uint8_t)((rng_next(&rng) % 4u) << 6);
+  }
+  /* Chunk-edge anchors whose footprint spills into the neighbouring chunk. */
+  g_recs[1].x = 8;
+  g_recs[1].y = 16;
+  g_flags[1] = 0xc0;
+  g_recs[2].x = 0;
+  g_recs[2].y = 0;
+  g_flags[2] = 0xc0;
+
+  if (u6_objgrid_init(&grid, N) != U6_OBJGRID_OK) {
+    return fail("grid init failed");
+  }
+  if (u6_objgrid_insert_objblk(&grid, g_recs, g_flags, N) != U6_OBJGRID_OK) {
+    rc = fail("grid bulk insert failed");
+    goto done;
+  }
+
+  for (int q = 0; q < 300 && rc == 0; q++) {
+    int cx = (int)(rng_next(&rng) % 110u) - 5;
+    int cy = (int)(rng_next(&rng) % 110u) - 5;
+    int radius = (int)(rng_next(&rng) % 12u);
+    int has_z = (int)(rng_next(&rng) % 2u);
+    int footprint = (int)(rng_next(&rng) % 2u);
+    if (!check_query(&grid, cx, cy, radius, has_z, 0, footprint)) {
+      rc = fail("radius query mismatch");
+    }
+  }
+  if (rc == 0 && !check_query(&grid, 7, 15, 0, 1, 0, 1)) {
+    rc = fail("chunk-edge footprint query mismatch");
+  }
+
+  /* Moves across chunks and off-grid (overflow list) stay queryable. */
+  for (int m = 0; m < 500 && rc == 0; m++) {
+    uint32_t i = rng_next(&rng) % N;
+    if (!grid.items[i].in_use) {
+      continue;
+    }
+    g_recs[i].x = (uint16_t)(rng_next(&rng) % 96u);
+    g_recs[i].y = (uint16_t)(rng_next(&rng) % 96u);
+    if ((m % 50) == 0) {
+      g_recs[i].x = 2000;
+    }
+    if (u6_objgrid_move(&grid, i, g_recs[i].x, g_recs[i].y, g_recs[i].z, u6_objblk_render_key(&g_recs[i])) != 0) {
+      rc = fail("grid move failed");
+    }
+  }
+  for (uint32_t i = 0; i < N && rc == 0; i += 9) {
+    if (grid.items[i].in_use && u6_objgrid_remove(&grid, i) != U6_OBJGRID_OK) {
+      rc = fail("grid remove failed");
+    }
+  }
+  for (int q = 0; q < 200 && rc == 0; q++) {
+    int cx = (int)(rng_next(&rng) % 100u);
+    int cy = (int)(rng_next(&rng) % 100u);
+    int radius = (int)(rng_next(&rng) % 20u);
+    if (!check_query(&grid, cx, cy, radius, 1, (int)(rng_next(&rng) % 2u), 1)) {
+      rc = fail("query mismatch after move/remove");
+    }
+  }
+  if (rc == 0 && !check_query(&grid, 2000, 40, 100, 0, 0, 0)) {
+    rc = fail("overflow query mismatch");
+  }
+
+done:
+  u6_objgrid_free(&grid);
+  return rc;
+}
+
+static int test_entities(void) {
+  U6EntityState state;
+  U6ObjGrid grid;
+  U6ObjectState obj;
+  U6NpcState npc;
+  uint32_t refs[8];
+  size_t n;
+  int rc = 0;
+
+  u6_entities_init(&state);
+  memset(&obj, 0, sizeof(obj));
+  obj.object_id = 1;
+  obj.map_x = 100;
+  obj.map_y = 100;
+  u6_entities_add_object(&state, &obj);
+  obj.object_id = 2;
+  obj.status = 0x10;
+  obj.holder_kind = U6_OBJECT_HOLDER_NPC;
+  obj.holder_id = 5;
+  u6_entities_add_object(&state, &obj);
+  memset(&npc, 0, sizeof(npc));
+  npc.npc_id = 5;
+  npc.map_x = 101;
+  npc.map_y = 99;
+  u6_entities_add_npc(&state, &npc);
+
+  if (u6_objgrid_init(&grid, 16) != U6_OBJGRID_OK) {
+    return fail("entity grid init failed");
+  }
+  if (u6_objgrid_insert_entity_objects(&grid, &state, 0) != U6_OBJGRID_OK
+      || u6_objgrid_insert_entity_npcs(&grid, &state, 8) != U6_OBJGRID_OK) {
+    rc = fail("entity grid insert failed");
+    goto done;
+  }
+  n = u6_objgrid_query_radius(&grid, 100, 100, 1, 1, 0, U6_OBJGRID_MATCH_ANCHOR, refs, 8);
+  /* Inventory object 2 is not LOCXYZ; NPC at y=99 sorts ahead of object at y=100. */
+  if (n != 2 || refs[0] != 8 || refs[1] != 0) {
+    rc = fail("entity grid query mismatch");
+  }
+
+done:
+  u6_objgrid_free(&grid);
+  return rc;
+}
+
+int main(void) {
+  int rc;
+
+  rc = test_radius_queries();
+  if (rc != 0) {
+    return rc;
+  }
+
+  rc = test_entities();
+  if (rc != 0) {
+    return rc;
+  }
+
+  puts("PASS: u6 objgrid");
+  return 0;
+}
@@ -0,0 +1,215 @@
+#include "u6_objorder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { N = 1500 };
+
+static int fail(const char *msg) {
+  fprintf(stderr, "FAIL: %s\n", msg);
+  return 1;
+}
+
+static uint32_t rng_next(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+static void random_position(U6ObjBlkRecord *rec, uint32_t *rng) {
+  static const uint8_t statuses[] = {0x00, 0x00, 0x08, 0x10, 0x18, 0x01};
+  rec->status = statuses[rng_next(rng) % sizeof(statuses)];
+  rec->x = (uint16_t)(rng_next(rng) % 64u);
+  rec->y = (uint16_t)(rng_next(rng) % 64u);
+  rec->z = (uint8_t)(rng_next(rng) % 3u);
+}
+
+/* Reference: sort the live subset with the legacy comparator and compare. */
+static int matches_reference(const U6ObjOrderIndex *index, const U6ObjBlkRecord *live, const int *alive) {
+  U6ObjBlkRecord ref[N];
+  U6ObjOrderCursor cursor;
+  const U6ObjBlkRecord *it;
+  size_t n = 0;
+  size_t i = 0;
+
+  for (size_t k = 0; k < N; k++) {
+    if (alive[k]) {
+      ref[n++] = live[k];
+    }
+  }
+  u6_objblk_sort_for_render_qsort(ref, n);
+  if (index->count != n) {
+    return 0;
+  }
+  for (it = u6_objorder_first(index, &cursor); it != NULL; it = u6_objorder_next(&cursor)) {
+    if (i >= n || it->source_area != ref[i].source_area || it->source_index != ref[i].source_index) {
+      return 0;
+    }
+    i++;
+  }
+  return i == n;
+}
+
+static int test_incremental_ops(void) {
+  static U6ObjBlkRecord live[N];
+  static int alive[N];
+  U6ObjOrderIndex index;
+  uint32_t rng = 0x51ed270bu;
+  int rc = 0;
+
+  if (u6_objorder_init(&index, N) != U6_OBJORDER_OK) {
+    return fail("init failed");
+  }
+
+  memset(live, 0, sizeof(live));
+  for (size_t i = 0; i < N; i++) {
+    live[i].source_area = (uint16_t)(i % 64u);
+    live[i].source_index = (uint16_t)i;
+    random_position(&live[i], &rng);
+    if (u6_objorder_insert(&index, &live[i]) != U6_OBJORDER_OK) {
+      rc = fail("insert failed");
+      goto done;
+    }
+    alive[i] = 1;
+  }
+  if (u6_objorder_insert(&index, &live[0]) != U6_OBJORDER_ERR_DUPLICATE) {
+    rc = fail("duplicate insert guard mismatch");
+    goto done;
+  }
+  if (!matches_reference(&index, live, alive)) {
+    rc = fail("order mismatch after inserts");
+    goto done;
+  }
+
+  for (int step = 0; step < 4000; step++) {
+    size_t k = rng_next(&rng) % N;
+    uint32_t op = rng_next(&rng) % 3u;
+    if (!alive[k]) {
+      if (u6_objorder_insert(&index, &live[k]) != U6_OBJORDER_OK) {
+        rc = fail("reinsert failed");
+        goto done;
+      }
+      alive[k] = 1;
+    } else if (op == 0) {
+      if (u6_objorder_remove(&index, &live[k]) != U6_OBJORDER_OK) {
+        rc = fail("remove failed");
+        goto done;
+      }
+      alive[k] = 0;
+    } else {
+      U6ObjBlkRecord moved = live[k];
+      random_position(&moved, &rng);
+      if (u6_objorder_move(&index, &live[k], &moved) != U6_OBJORDER_OK) {
+        rc = fail("move failed");
+        goto done;
+      }
+      live[k] = moved;
+    }
+  }
+  if (!matches_reference(&index, live, alive)) {
+    rc = fail("order mismatch after mixed ops");
+    goto done;
+  }
+
+  {
+    U6ObjBlkRecord gone = live[0];
+    gone.x = 999;
+    if (u6_objorder_remove(&index, &gone) != U6_OBJORDER_ERR_NOT_FOUND) {
+      rc = fail("remove of stale key should miss");
+      goto done;
+    }
+  }
+
+  /* Bulk build from the live set must match incremental state. */
+  {
+    U6ObjOrderIndex bulk;
+    U6ObjBlkRecord subset[N];
+    size_t n = 0;
+    for (size_t k = 0; k < N; k++) {
+      if (alive[k]) {
+        subset[n++] = live[k];
+      }
+    }
+    if (u6_objorder_init(&bulk, N) != U6_OBJORDER_OK || u6_objorder_build(&bulk, subset, n) != U6_OBJORDER_OK) {
+      u6_objorder_free(&bulk);
+      rc = fail("bulk build failed");
+      goto done;
+    }
+    if (!matches_reference(&bulk, live, alive)) {
+      u6_objorder_free(&bulk);
+      rc = fail("bulk build order mismatch");
+      goto done;
+    }
+    u6_objorder_free(&bulk);
+  }
+
+done:
+  u6_objorder_free(&index);
+  return rc;
+}
+
+static int test_y_range(void) {
+  static U6ObjBlkRecord recs[N];
+  U6ObjBlkRecord ref[N];
+  U6ObjOrderIndex index;
+  U6ObjOrderRange range;
+  const U6ObjBlkRecord *it;
+  uint32_t rng = 0x0badf00du;
+  size_t n = 0;
+  size_t i = 0;
+  int rc = 0;
+
+  memset(recs, 0, sizeof(recs));
+  for (size_t k = 0; k < N; k++) {
+    recs[k].source_area = 3;
+    recs[k].source_index = (uint16_t)k;
+    random_position(&recs[k], &rng);
+  }
+  if (u6_objorder_init(&index, N) != U6_OBJORDER_OK || u6_objorder_build(&index, recs, N) != U6_OBJORDER_OK) {
+    u6_objorder_free(&index);
+    return fail("range fixture build failed");
+  }
+
+  for (size_t k = 0; k < N; k++) {
+    if (recs[k].y >= 20 && recs[k].y <= 23) {
+      ref[n++] = recs[k];
+    }
+  }
+  u6_objblk_sort_for_render_qsort(ref, n);
+
+  u6_objorder_range_begin(&index, &range, 20, 23);
+  while ((it = u6_objorder_range_next(&range)) != NULL) {
+    if (i >= n || it->source_index != ref[i].source_index) {
+      rc = fail("y-range order mismatch");
+      break;
+    }
+    i++;
+  }
+  if (rc == 0 && i != n) {
+    rc = fail("y-range count mismatch");
+  }
+
+  u6_objorder_free(&index);
+  return rc;
+}
+
+int main(void) {
+  int rc;
+
+  rc = test_incremental_ops();
+  if (rc != 0) {
+    return rc;
+  }
+
+  rc = test_y_range();
+  if (rc != 0) {
+    return rc;
+  }
+
+  puts("PASS: u6 objorder");
+  return 0;
+}
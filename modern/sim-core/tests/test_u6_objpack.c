@@ -0,0 +1,155 @@
+#include "u6_objpack.h"
+#include "u6_objblk.h"
+#include "test_bridge_objects.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OBJECT_COUNT 2000
+
+static int fail(const char *msg) {
+  fprintf(stderr, "%s\n", msg);
+  return 1;
+}
+
+static U6BridgeObject objects[OBJECT_COUNT];
+
+static void fill_objects(void) {
+  static const TestBridgeRanges ranges = {-1024, 2048u, 6u, 64u, 1024u};
+  for (int i = 0; i < OBJECT_COUNT; i++) {
+    U6BridgeObject *o = &objects[i];
+    test_bridge_object_fill(o, &ranges);
+    /* Every fifth record repeats an earlier key so interning has work to do. */
+    if (i % 5 == 4) {
+      memcpy(o->key, objects[test_rand() % (uint32_t)i].key, sizeof(o->key));
+    } else if (i % 97 == 0) {
+      memset(o->key, 'k', U6_BRIDGE_KEY_MAX);
+      snprintf(o->key, sizeof(o->key), "%d", i);
+      o->key[strlen(o->key)] = 'k';
+    } else {
+      snprintf(o->key, sizeof(o->key), "%d", 1000 + i);
+    }
+  }
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v & 0xffu);
+  p[1] = (uint8_t)((v >> 8) & 0xffu);
+  p[2] = (uint8_t)((v >> 16) & 0xffu);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static int check_roundtrip(const U6BridgeBuffer *buf) {
+  U6ObjPackView view;
+  size_t distinct_bytes = 0;
+
+  if (u6_objpack_view(&view, buf->data, buf->size) != U6_OBJPACK_OK || view.count != OBJECT_COUNT) {
+    return fail("view of encoded table");
+  }
+  for (int i = 0; i < OBJECT_COUNT; i++) {
+    U6BridgeObject got;
+    int first = 1;
+    u6_objpack_get(&view, (size_t)i, &got);
+    if (memcmp(&got, &objects[i], sizeof(got)) != 0 || strcmp(u6_objpack_key(&view, (size_t)i), objects[i].key) != 0) {
+      return fail("record roundtrip mismatch");
+    }
+    for (int j = 0; j < i && first; j++) {
+      if (strcmp(objects[j].key, objects[i].key) == 0) {
+        first = 0;
+        if (u6_objpack_key(&view, (size_t)j) != u6_objpack_key(&view, (size_t)i)) {
+          return fail("duplicate key not interned");
+        }
+      }
+    }
+    if (first) {
+      distinct_bytes += strlen(objects[i].key) + 1u;
+    }
+  }
+  if (view.key_bytes != distinct_bytes) {
+    return fail("key table not minimal");
+  }
+  return 0;
+}
+
+static int expect_view(const uint8_t *data, size_t size, int expected, const char *msg) {
+  U6ObjPackView view;
+  return u6_objpack_view(&view, data, size) == expected ? 0 : fail(msg);
+}
+
+int main(void) {
+  U6BridgeBuffer buf;
+  uint8_t *bad;
+  size_t records_end;
+  int rc;
+
+  memset(&buf, 0, sizeof(buf));
+  test_rand_seed(0x13579bdu);
+  fill_objects();
+  if (u6_objpack_encode(objects, OBJECT_COUNT, &buf) != U6_OBJPACK_OK) {
+    return fail("encode");
+  }
+  if ((rc = check_roundtrip(&buf)) != 0) return rc;
+
+  /* Through a file mapping, as the query bridge reads it. */
+  {
+    const char *path = "u6_objpack_test.bin";
+    U6ObjBlkMappedFile mapped;
+    U6ObjPackView view;
+    FILE *f = fopen(path, "wb");
+    if (f == NULL || fwrite(buf.data, 1, buf.size, f) != buf.size) {
+      return fail("write table file");
+    }
+    fclose(f);
+    if (u6_objblk_map_file(path, &mapped) != 0 || !mapped.loaded ||
+        u6_objpack_view(&view, mapped.bytes, mapped.size) != U6_OBJPACK_OK || view.count != OBJECT_COUNT) {
+      return fail("mapped table view");
+    }
+    u6_objblk_unmap_file(&mapped);
+    remove(path);
+  }
+
+  /* Corruptions are rejected by the view, never read past the buffer. */
+  bad = (uint8_t *)malloc(buf.size);
+  records_end = U6_OBJPACK_HEADER_SIZE + OBJECT_COUNT * U6_OBJPACK_RECORD_SIZE;
+  memcpy(bad, buf.data, buf.size);
+  bad[0] = 'X';
+  if ((rc = expect_view(bad, buf.size, U6_OBJPACK_ERR_HEADER, "bad magic")) != 0) return rc;
+  memcpy(bad, buf.data, buf.size);
+  bad[4] = 9;
+  if ((rc = expect_view(bad, buf.size, U6_OBJPACK_ERR_HEADER, "bad version")) != 0) return rc;
+  if ((rc = expect_view(buf.data, 8u, U6_OBJPACK_ERR_HEADER, "short header")) != 0) return rc;
+  if ((rc = expect_view(buf.data, buf.size - 1u, U6_OBJPACK_ERR_BOUNDS, "truncated keys")) != 0) return rc;
+  if ((rc = expect_view(buf.data, records_end - 3u, U6_OBJPACK_ERR_BOUNDS, "truncated records")) != 0) return rc;
+  memcpy(bad, buf.data, buf.size);
+  put_u32(bad + 8, 0xffffffffu);
+  if ((rc = expect_view(bad, buf.size, U6_OBJPACK_ERR_BOUNDS, "huge count")) != 0) return rc;
+  memcpy(bad, buf.data, buf.size);
+  put_u32(bad + U6_OBJPACK_HEADER_SIZE + 7u * U6_OBJPACK_RECORD_SIZE, (uint32_t)(buf.size - records_end));
+  if ((rc = expect_view(bad, buf.size, U6_OBJPACK_ERR_KEY, "key offset past table")) != 0) return rc;
+  memcpy(bad, buf.data, buf.size);
+  bad[U6_OBJPACK_HEADER_SIZE + 7u * U6_OBJPACK_RECORD_SIZE + 4u] += 1u;
+  if ((rc = expect_view(bad, buf.size, U6_OBJPACK_ERR_KEY, "key without terminator")) != 0) return rc;
+  memcpy(bad, buf.data, buf.size);
+  bad[U6_OBJPACK_HEADER_SIZE + 4u] = 0u;
+  if ((rc = expect_view(bad, buf.size, U6_OBJPACK_ERR_KEY, "empty key")) != 0) return rc;
+  free(bad);
+
+  /* Empty tables are valid; unterminated or empty keys do not encode. */
+  if (u6_objpack_encode(NULL, 0u, &buf) != U6_OBJPACK_OK || buf.size != U6_OBJPACK_HEADER_SIZE ||
+      expect_view(buf.data, buf.size, U6_OBJPACK_OK, "empty table") != 0) {
+    return fail("empty table");
+  }
+  objects[3].key[0] = '\0';
+  if (u6_objpack_encode(objects, OBJECT_COUNT, &buf) != U6_OBJPACK_ERR_KEY) {
+    return fail("empty key encoded");
+  }
+  memset(objects[3].key, 'z', sizeof(objects[3].key));
+  if (u6_objpack_encode(objects, OBJECT_COUNT, &buf) != U6_OBJPACK_ERR_KEY) {
+    return fail("unterminated key encoded");
+  }
+
+  u6_bridge_buffer_free(&buf);
+  printf("PASS: u6 objpack\n");
+  return 0;
+}
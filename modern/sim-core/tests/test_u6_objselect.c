@@ -0,0 +1,137 @@
+#include "u6_objselect.h"
+#include "test_bridge_objects.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OBJECT_COUNT 5000
+
+static int fail(const char *msg) {
+  fprintf(stderr, "%s\n", msg);
+  return 1;
+}
+
+static U6BridgeObject objects[OBJECT_COUNT];
+
+/* Narrow ranges so many objects tie on y/x/z/area/index and fall through to the key. */
+static void fill_objects(void) {
+  static const TestBridgeRanges ranges = {-12, 24u, 2u, 2u, 3u};
+  for (int i = 0; i < OBJECT_COUNT; i++) {
+    test_bridge_object_fill(&objects[i], &ranges);
+    snprintf(objects[i].key, sizeof(objects[i].key), "k%u", (unsigned)(test_rand() % 100000u));
+  }
+}
+
+static int same_result(const U6BridgeObject *got, size_t got_count, const U6BridgeObject *want, size_t want_count) {
+  if (got_count != want_count) {
+    return 0;
+  }
+  for (size_t i = 0; i < want_count; i++) {
+    if (strcmp(got[i].key, want[i].key) != 0 || u6_bridge_object_cmp(&got[i], &want[i]) != 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void random_query(U6BridgeQuery *q, int iter) {
+  static const int limits[] = {1, 2, 7, 64, 500, OBJECT_COUNT, OBJECT_COUNT * 2};
+  memset(q, 0, sizeof(*q));
+  q->has_x = q->has_y = iter % 6 != 0;
+  q->has_z = iter % 3 == 0;
+  q->x = (int)(test_rand() % 32u) - 16;
+  q->y = (int)(test_rand() % 32u) - 16;
+  q->z = (int)(test_rand() % 2u);
+  q->radius = iter % 11 == 0 ? -1 : (int)(test_rand() % 8u);
+  q->projection_footprint = iter % 2 == 0;
+  q->limit = iter % 13 == 0 ? 0 : limits[test_rand() % (sizeof(limits) / sizeof(limits[0]))];
+}
+
+static int check_query_parity(void) {
+  static U6BridgeObject want[OBJECT_COUNT];
+  U6ObjSelect select;
+  int rc = 0;
+
+  for (int iter = 0; iter < 300 && rc == 0; iter++) {
+    U6BridgeQuery q;
+    size_t count = iter % 4 == 0 ? (size_t)(test_rand() % 40u) : OBJECT_COUNT;
+    size_t want_count;
+
+    random_query(&q, iter);
+    want_count = test_bridge_reference_query(objects, count, &q, want);
+    u6_objselect_init(&select, q.limit > 0 ? (size_t)q.limit : 1u);
+    if (u6_objselect_query(&select, objects, count, &q) != U6_OBJSELECT_OK) {
+      rc = fail("objselect query failed");
+    } else if (!same_result(select.items, select.count, want, want_count)) {
+      rc = fail("objselect query differs from sort-then-filter");
+    } else if (select.capacity > select.limit) {
+      rc = fail("objselect storage grew past the limit");
+    }
+    u6_objselect_free(&select);
+  }
+  return rc;
+}
+
+static int check_reuse_and_take(void) {
+  static U6BridgeObject want[OBJECT_COUNT];
+  U6ObjSelect select;
+  U6BridgeQuery q;
+  U6BridgeObject *taken;
+  size_t taken_count = 0;
+  size_t want_count;
+
+  /* One selector across queries: reset must not leak earlier matches. */
+  u6_objselect_init(&select, 32);
+  for (int iter = 0; iter < 20; iter++) {
+    random_query(&q, iter * 5 + 1);
+    q.limit = 32;
+    want_count = test_bridge_reference_query(objects, OBJECT_COUNT, &q, want);
+    if (u6_objselect_query(&select, objects, OBJECT_COUNT, &q) != U6_OBJSELECT_OK ||
+        !same_result(select.items, select.count, want, want_count)) {
+      u6_objselect_free(&select);
+      return fail("reused selector diverged");
+    }
+  }
+
+  u6_objselect_free(&select);
+
+  /* Streaming pushes in reverse input order, then ownership transfer. */
+  memset(&q, 0, sizeof(q));
+  q.limit = 100;
+  want_count = test_bridge_reference_query(objects, OBJECT_COUNT, &q, want);
+  u6_objselect_init(&select, 100);
+  for (size_t i = OBJECT_COUNT; i-- > 0u;) {
+    if (u6_objselect_push(&select, &objects[i]) != U6_OBJSELECT_OK) {
+      u6_objselect_free(&select);
+      return fail("push failed");
+    }
+  }
+  taken = u6_objselect_take(&select, &taken_count);
+  if (select.items != NULL || select.count != 0u || !same_result(taken, taken_count, want, want_count)) {
+    free(taken);
+    return fail("take returned the wrong selection");
+  }
+  free(taken);
+  u6_objselect_free(&select);
+
+  u6_objselect_init(&select, 0);
+  if (select.limit != 1u || u6_objselect_take(&select, &taken_count) != NULL || taken_count != 0u) {
+    return fail("empty selection mishandled");
+  }
+  if (u6_objselect_push(NULL, &objects[0]) != U6_OBJSELECT_ERR_NULL ||
+      u6_objselect_query(&select, NULL, 1, &q) != U6_OBJSELECT_ERR_NULL) {
+    return fail("null arguments accepted");
+  }
+  return 0;
+}
+
+int main(void) {
+  test_rand_seed(0x5eed1234u);
+  fill_objects();
+  if (check_query_parity() != 0 || check_reuse_and_take() != 0) {
+    return 1;
+  }
+  printf("PASS: u6 objselect\n");
+  return 0;
+}
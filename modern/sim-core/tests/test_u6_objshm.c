@@ -0,0 +1,267 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "u6_objshm.h"
+#include "test_bridge_objects.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OBJECT_COUNT 3000
+#define SHM_PATH "u6_objshm_test.bin"
+#define CHURN_ROWS 256
+#define CHURN_COMMITS 4000
+
+static int fail(const char *msg) {
+  fprintf(stderr, "%s\n", msg);
+  return 1;
+}
+
+static U6BridgeObject objects[OBJECT_COUNT];
+
+/* A small coordinate range so ties fall through to the later keys. */
+static void fill_objects(void) {
+  static const TestBridgeRanges ranges = {-32, 64u, 3u, 4u, 16u};
+  for (int i = 0; i < OBJECT_COUNT; i++) {
+    U6BridgeObject *o = &objects[i];
+    test_bridge_object_fill(o, &ranges);
+    if (i % 211 == 0) {
+      memset(o->key, 'k', U6_BRIDGE_KEY_MAX);
+      o->key[0] = (char)('a' + i % 26);
+    } else {
+      snprintf(o->key, sizeof(o->key), "%d", 5000 + i);
+    }
+  }
+}
+
+static int check_roundtrip(void) {
+  U6ObjShm writer;
+  U6ObjShm reader;
+  uint32_t seq;
+  int count;
+
+  if (u6_objshm_create(&writer, SHM_PATH, OBJECT_COUNT) != U6_OBJSHM_OK) {
+    return fail("create failed");
+  }
+  u6_objshm_write_begin(&writer);
+  for (uint32_t i = 0; i < OBJECT_COUNT; i++) {
+    u6_objshm_write_row(&writer, i, &objects[i]);
+  }
+  u6_objshm_write_end(&writer, OBJECT_COUNT);
+
+  if (u6_objshm_open(&reader, SHM_PATH) != U6_OBJSHM_OK || reader.capacity != OBJECT_COUNT) {
+    u6_objshm_close(&writer);
+    return fail("open failed");
+  }
+  count = u6_objshm_read_begin(&reader, &seq);
+  if (count != OBJECT_COUNT || (seq & 1u) != 0u) {
+    return fail("read_begin count/seq mismatch");
+  }
+  for (uint32_t i = 0; i < OBJECT_COUNT; i++) {
+    U6BridgeObject row;
+    u6_objshm_row(&reader, i, &row);
+    if (memcmp(&row, &objects[i], sizeof(row)) != 0) {
+      return fail("row roundtrip mismatch");
+    }
+  }
+  if (!u6_objshm_read_valid(&reader, seq)) {
+    return fail("quiet table reported a concurrent write");
+  }
+
+  /* An open write makes readers wait; a publish invalidates older reads. */
+  u6_objshm_write_begin(&writer);
+  if (u6_objshm_read_begin(&reader, &seq) != U6_OBJSHM_ERR_BUSY) {
+    return fail("read_begin did not report an unfinished write");
+  }
+  u6_objshm_write_end(&writer, OBJECT_COUNT);
+  if (u6_objshm_read_begin(&reader, &seq) != OBJECT_COUNT) {
+    return fail("read_begin failed after the write ended");
+  }
+  u6_objshm_write_begin(&writer);
+  u6_objshm_write_end(&writer, OBJECT_COUNT - 1u);
+  if (u6_objshm_read_valid(&reader, seq)) {
+    return fail("read stayed valid across a publish");
+  }
+  if (reader.header->generation != 3u) {
+    return fail("generation not bumped per publish");
+  }
+
+  u6_objshm_retire(&writer);
+  if (u6_objshm_read_begin(&reader, &seq) != U6_OBJSHM_ERR_RETIRED) {
+    return fail("retired segment still readable");
+  }
+  u6_objshm_close(&reader);
+  u6_objshm_close(&writer);
+  return 0;
+}
+
+static int check_queries(void) {
+  static U6BridgeObject expected[OBJECT_COUNT];
+  U6ObjShm writer;
+  U6ObjShm reader;
+  int rc = 0;
+
+  if (u6_objshm_create(&writer, SHM_PATH, OBJECT_COUNT + 64u) != U6_OBJSHM_OK) {
+    return fail("create failed");
+  }
+  u6_objshm_write_begin(&writer);
+  for (uint32_t i = 0; i < OBJECT_COUNT; i++) {
+    u6_objshm_write_row(&writer, i, &objects[i]);
+  }
+  u6_objshm_write_end(&writer, OBJECT_COUNT);
+  if (u6_objshm_open(&reader, SHM_PATH) != U6_OBJSHM_OK) {
+    u6_objshm_close(&writer);
+    return fail("open failed");
+  }
+
+  for (int iter = 0; iter < 400 && rc == 0; iter++) {
+    U6BridgeQuery q;
+    U6BridgeObject *got = NULL;
+    size_t got_count = 0;
+    size_t want;
+
+    memset(&q, 0, sizeof(q));
+    q.has_x = q.has_y = iter % 7 != 0;
+    q.has_z = iter % 3 == 0;
+    q.x = (int)(test_rand() % 80u) - 40;
+    q.y = (int)(test_rand() % 80u) - 40;
+    q.z = (int)(test_rand() % 3u);
+    q.radius = (int)(test_rand() % 12u);
+    q.projection_footprint = iter % 2 == 0;
+    q.limit = iter % 5 == 0 ? OBJECT_COUNT : 1 + (int)(test_rand() % 64u);
+
+    want = test_bridge_reference_query(objects, OBJECT_COUNT, &q, expected);
+    if (u6_objshm_query(&reader, &q, &got, &got_count) != U6_OBJSHM_OK) {
+      rc = fail("query failed");
+    } else if (got_count != want) {
+      rc = fail("query count mismatch");
+    } else {
+      for (size_t i = 0; i < want; i++) {
+        if (strcmp(got[i].key, expected[i].key) != 0 || memcmp(&got[i], &expected[i], sizeof(got[i])) != 0) {
+          rc = fail("query order mismatch");
+          break;
+        }
+      }
+    }
+    free(got);
+  }
+  u6_objshm_close(&reader);
+  u6_objshm_close(&writer);
+  return rc;
+}
+
+/*
+ * Concurrent churn: every publish rewrites all rows with x = y = the
+ * publish number, so any torn snapshot shows mixed coordinates.
+ */
+static atomic_int churn_done;
+
+static void *churn_writer(void *arg) {
+  U6ObjShm *writer = (U6ObjShm *)arg;
+  for (int commit = 1; commit <= CHURN_COMMITS; commit++) {
+    u6_objshm_write_begin(writer);
+    for (uint32_t i = 0; i < CHURN_ROWS; i++) {
+      U6BridgeObject o;
+      memset(&o, 0, sizeof(o));
+      snprintf(o.key, sizeof(o.key), "c%u", (unsigned)i);
+      o.x = commit;
+      o.y = commit;
+      o.source_index = (int)i;
+      u6_objshm_write_row(writer, i, &o);
+    }
+    u6_objshm_write_end(writer, CHURN_ROWS);
+  }
+  atomic_store(&churn_done, 1);
+  return NULL;
+}
+
+static int check_concurrent_reads(void) {
+  U6ObjShm writer;
+  U6ObjShm reader;
+  pthread_t thread;
+  U6BridgeQuery q;
+  int rc = 0;
+  int snapshots = 0;
+
+  if (u6_objshm_create(&writer, SHM_PATH, CHURN_ROWS) != U6_OBJSHM_OK ||
+      u6_objshm_open(&reader, SHM_PATH) != U6_OBJSHM_OK) {
+    return fail("create/open failed");
+  }
+  memset(&q, 0, sizeof(q));
+  q.limit = CHURN_ROWS;
+  atomic_init(&churn_done, 0);
+  if (pthread_create(&thread, NULL, churn_writer, &writer) != 0) {
+    return fail("pthread_create failed");
+  }
+  while (rc == 0 && !atomic_load(&churn_done)) {
+    U6BridgeObject *got = NULL;
+    size_t got_count = 0;
+    int qrc = u6_objshm_query(&reader, &q, &got, &got_count);
+    if (qrc == U6_OBJSHM_ERR_BUSY) {
+      continue;
+    }
+    if (qrc != U6_OBJSHM_OK) {
+      rc = fail("concurrent query failed");
+    } else if (got_count != 0u && got_count != CHURN_ROWS) {
+      rc = fail("concurrent query saw a partial row count");
+    } else {
+      for (size_t i = 1; i < got_count; i++) {
+        if (got[i].x != got[0].x || got[i].y != got[0].y) {
+          rc = fail("concurrent query returned a torn snapshot");
+          break;
+        }
+      }
+      snapshots++;
+    }
+    free(got);
+  }
+  pthread_join(thread, NULL);
+  u6_objshm_close(&reader);
+  u6_objshm_close(&writer);
+  if (rc == 0 && snapshots == 0) {
+    return fail("reader never completed a snapshot");
+  }
+  return rc;
+}
+
+static int check_rejects(void) {
+  U6ObjShm shm;
+  FILE *f = fopen(SHM_PATH, "wb");
+  static const uint8_t junk[96] = {'U', '6', 'S', 'X'};
+
+  if (f == NULL) {
+    return fail("fixture write failed");
+  }
+  fwrite(junk, 1, sizeof(junk), f);
+  fclose(f);
+  if (u6_objshm_open(&shm, SHM_PATH) != U6_OBJSHM_ERR_FORMAT) {
+    return fail("bad magic accepted");
+  }
+  /* A header whose capacity outruns the file. */
+  if (u6_objshm_create(&shm, SHM_PATH, 8) != U6_OBJSHM_OK) {
+    return fail("create failed");
+  }
+  shm.header->capacity = 4096u;
+  u6_objshm_close(&shm);
+  if (u6_objshm_open(&shm, SHM_PATH) != U6_OBJSHM_ERR_FORMAT) {
+    return fail("oversized capacity accepted");
+  }
+  if (u6_objshm_open(&shm, "u6_objshm_missing.bin") != U6_OBJSHM_ERR_IO) {
+    return fail("missing file not reported");
+  }
+  return 0;
+}
+
+int main(void) {
+  test_rand_seed(0x2468aceu);
+  fill_objects();
+  if (check_roundtrip() != 0 || check_queries() != 0 || check_concurrent_reads() != 0 || check_rejects() != 0) {
+    remove(SHM_PATH);
+    return 1;
+  }
+  remove(SHM_PATH);
+  printf("PASS: u6 objshm\n");
+  return 0;
+}
@@ -0,0 +1,164 @@
+#include "u6_objtable.h"
+#include "u6_objstatus.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { N = 5003, WORDS = (N + 63) / 64 };
+
+static int fail(const char *msg) {
+  fprintf(stderr, "FAIL: %s\n", msg);
+  return 1;
+}
+
+static uint32_t rng_next(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+static U6ObjBlkRecord g_recs[N];
+
+static int in_set(uint16_t t, const uint16_t *types, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (types[i] == t) return 1;
+  }
+  return 0;
+}
+
+static int test_build_and_get(U6ObjTable *table) {
+  U6ObjBlkRecord r;
+
+  if (table->count != N) {
+    return fail("table count mismatch");
+  }
+  for (size_t i = 0; i < N; i += 97) {
+    if (u6_objtable_get(table, i, &r) != U6_OBJTABLE_OK || r.x != g_recs[i].x || r.y != g_recs[i].y
+        || r.z != g_recs[i].z || r.status != g_recs[i].status || r.obj_type != g_recs[i].obj_type
+        || r.obj_frame != g_recs[i].obj_frame || r.amount != g_recs[i].amount
+        || r.source_index != g_recs[i].source_index || r.shape_type != g_recs[i].shape_type) {
+      return fail("row roundtrip mismatch");
+    }
+  }
+  if (u6_objtable_get(table, N, &r) != U6_OBJTABLE_ERR_RANGE) {
+    return fail("out-of-range row should fail");
+  }
+  if (u6_objtable_append(table, g_recs, 1) != U6_OBJTABLE_ERR_FULL) {
+    return fail("append past capacity should fail");
+  }
+  return 0;
+}
+
+/* Chained filters: vector path, scalar path and brute force must agree bit for bit. */
+static int test_filter_parity(const U6ObjTable *table) {
+  static uint64_t vec[WORDS];
+  static uint64_t ref[WORDS];
+  static uint32_t rows[N];
+  static const uint8_t uses[] = {
+      U6_OBJ_COORD_USE_LOCXYZ, U6_OBJ_COORD_USE_CONTAINED, U6_OBJ_COORD_USE_INVEN, U6_OBJ_COORD_USE_EQUIP};
+  uint32_t rng = 0xc0ffee11u;
+
+  for (int q = 0; q < 400; q++) {
+    uint16_t x0 = (uint16_t)(rng_next(&rng) % 1100u);
+    uint16_t y0 = (uint16_t)(rng_next(&rng) % 1100u);
+    uint16_t x1 = (uint16_t)(x0 + rng_next(&rng) % 300u - 20u);
+    uint16_t y1 = (uint16_t)(y0 + rng_next(&rng) % 300u - 20u);
+    uint8_t z = (uint8_t)(rng_next(&rng) % 6u);
+    uint8_t use = uses[rng_next(&rng) % 4u];
+    uint16_t types[20];
+    size_t type_count = (q % 3 == 0) ? 20u : (size_t)(rng_next(&rng) % 9u);
+    int use_z = (int)(rng_next(&rng) % 2u);
+    size_t want = 0;
+    size_t got;
+
+    if (q == 7) {
+      x0 = 0;
+      y0 = 0;
+      x1 = 0xffff;
+      y1 = 0xffff;
+    }
+    for (size_t t = 0; t < type_count; t++) {
+      types[t] = (uint16_t)(rng_next(&rng) % 64u);
+    }
+
+    u6_objtable_select_all(table, vec);
+    u6_objtable_select_all(table, ref);
+    u6_objtable_filter_coord_use(table, use, vec);
+    u6_objtable_filter_coord_use_scalar(table, use, ref);
+    if (use_z) {
+      u6_objtable_filter_z(table, z, vec);
+      u6_objtable_filter_z_scalar(table, z, ref);
+    }
+    u6_objtable_filter_rect(table, x0, y0, x1, y1, vec);
+    u6_objtable_filter_rect_scalar(table, x0, y0, x1, y1, ref);
+    if (type_count > 0) {
+      u6_objtable_filter_types(table, types, type_count, vec);
+      u6_objtable_filter_types_scalar(table, types, type_count, ref);
+    }
+    if (memcmp(vec, ref, sizeof(vec)) != 0) {
+      return fail("vector/scalar selection mismatch");
+    }
+
+    got = u6_objtable_selection_rows(table, vec, rows, N);
+    for (size_t i = 0; i < N; i++) {
+      const U6ObjBlkRecord *r = &g_recs[i];
+      if (u6_obj_status_coord_use(r->status) != use) continue;
+      if (use_z && r->z != z) continue;
+      if (r->x < x0 || r->x > x1 || r->y < y0 || r->y > y1) continue;
+      if (type_count > 0 && !in_set(r->obj_type, types, type_count)) continue;
+      if (want >= got || rows[want] != i) {
+        return fail("selection differs from brute force");
+      }
+      want++;
+    }
+    if (want != got || u6_objtable_selection_count(table, vec) != got) {
+      return fail("selection count mismatch");
+    }
+  }
+  return 0;
+}
+
+int main(void) {
+  U6ObjTable table;
+  uint32_t rng = 0x1badb002u;
+  int rc;
+
+  memset(g_recs, 0, sizeof(g_recs));
+  for (size_t i = 0; i < N; i++) {
+    g_recs[i].status = (uint8_t)(rng_next(&rng) & 0xffu);
+    g_recs[i].x = (uint16_t)(rng_next(&rng) % 1024u);
+    g_recs[i].y = (uint16_t)(rng_next(&rng) % 1024u);
+    g_recs[i].z = (uint8_t)(rng_next(&rng) % 6u);
+    g_recs[i].obj_type = (uint16_t)(rng_next(&rng) % 64u);
+    g_recs[i].obj_frame = (uint16_t)(rng_next(&rng) % 8u);
+    g_recs[i].shape_type = (uint16_t)(g_recs[i].obj_type | (g_recs[i].obj_frame << 10));
+    g_recs[i].amount = (uint16_t)rng_next(&rng);
+    g_recs[i].source_area = (uint16_t)(i / 100u);
+    g_recs[i].source_index = (uint16_t)i;
+  }
+  /* Extremes exercise the unsigned range compare. */
+  g_recs[0].x = 0;
+  g_recs[1].x = 0xffff;
+  g_recs[1].y = 0xffff;
+
+  if (u6_objtable_init(&table, N) != U6_OBJTABLE_OK || u6_objtable_append(&table, g_recs, N) != U6_OBJTABLE_OK) {
+    u6_objtable_free(&table);
+    return fail("table build failed");
+  }
+
+  rc = test_build_and_get(&table);
+  if (rc == 0) {
+    rc = test_filter_parity(&table);
+  }
+  u6_objtable_free(&table);
+  if (rc != 0) {
+    return rc;
+  }
+
+  printf("PASS: u6 objtable (%s)\n", u6_objtable_kernel_name());
+  return 0;
+}
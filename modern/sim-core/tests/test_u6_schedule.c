@@ -0,0 +1,346 @@
+#include "u6_schedule.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+enum { ACTORS_USED = 200, MAX_PER_ACTOR = 8 };
+
+static int fail(const char *msg) {
+  fprintf(stderr, "FAIL: %s\n", msg);
+  return 1;
+}
+
+static uint32_t rng_next(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+static void write_u16_le(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)(v & 0xffu);
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void encode_entry(uint8_t *p, const U6ScheduleEntry *e) {
+  p[0] = (uint8_t)((e->hour & 0x1fu) | (e->day_of_week << 5));
+  p[1] = e->worktype;
+  p[2] = (uint8_t)(e->x & 0xffu);
+  p[3] = (uint8_t)((e->x >> 8) | ((e->y & 0x3fu) << 2));
+  p[4] = (uint8_t)((e->y >> 6) | (e->z << 4));
+}
+
+/* Actors 1..ACTORS_USED get 1..8 entries with ascending hours; some are day-specific. */
+static uint8_t *build_schedule_file(uint32_t seed, size_t *out_size, U6ScheduleEntry *out_entries) {
+  U6ScheduleEntry entries[U6_SCHEDULE_ACTORS * MAX_PER_ACTOR];
+  uint16_t offsets[U6_SCHEDULE_ACTORS];
+  uint16_t total = 0;
+  uint32_t rng = seed;
+  uint8_t *bytes;
+
+  for (uint32_t a = 0; a < U6_SCHEDULE_ACTORS; a++) {
+    uint32_t n = (a >= 1 && a <= ACTORS_USED) ? 1u + rng_next(&rng) % MAX_PER_ACTOR : 0u;
+    uint8_t hour = (uint8_t)(rng_next(&rng) % 4u);
+    offsets[a] = total;
+    for (uint32_t i = 0; i < n && hour < 24u; i++) {
+      U6ScheduleEntry *e = &entries[total++];
+      e->hour = hour;
+      e->day_of_week = (rng_next(&rng) % 5u) == 0u ? (uint8_t)(1u + rng_next(&rng) % 7u) : 0u;
+      e->worktype = (uint8_t)(rng_next(&rng) & 0xffu);
+      e->x = (uint16_t)(rng_next(&rng) % 1024u);
+      e->y = (uint16_t)(rng_next(&rng) % 1024u);
+      e->z = (uint8_t)(rng_next(&rng) % 6u);
+      hour = (uint8_t)(hour + 1u + rng_next(&rng) % 6u);
+    }
+  }
+  *out_size = U6_SCHEDULE_HEADER_SIZE + (size_t)total * U6_SCHEDULE_ENTRY_SIZE;
+  bytes = (uint8_t *)malloc(*out_size);
+  if (bytes == NULL) {
+    return NULL;
+  }
+  for (uint32_t a = 0; a < U6_SCHEDULE_ACTORS; a++) {
+    write_u16_le(bytes + a * 2u, offsets[a]);
+  }
+  write_u16_le(bytes + U6_SCHEDULE_ACTORS * 2u, total);
+  for (uint16_t i = 0; i < total; i++) {
+    encode_entry(bytes + U6_SCHEDULE_HEADER_SIZE + (size_t)i * U6_SCHEDULE_ENTRY_SIZE, &entries[i]);
+  }
+  memcpy(out_entries, entries, (size_t)total * sizeof(U6ScheduleEntry));
+  return bytes;
+}
+
+/* Straight re-reading of the legacy rule over the raw table. */
+static const U6ScheduleEntry *naive_active(const U6ScheduleTable *t, uint8_t actor, const SimWorldState *w) {
+  uint8_t dow = (uint8_t)((w->date_d - 1u) % 7u + 1u);
+  const U6ScheduleEntry *e = t->entries + t->first[actor];
+  uint16_t n = t->count[actor];
+  uint16_t pick = (uint16_t)(n - 1u);
+
+  if (n == 0) {
+    return NULL;
+  }
+  for (uint16_t i = 0; i < n; i++) {
+    if (e[i].day_of_week > dow || e[i].hour > w->time_h) {
+      pick = i == 0 ? (uint16_t)(n - 1u) : (uint16_t)(i - 1u);
+      break;
+    }
+  }
+  return &e[pick];
+}
+
+static int test_parse(void) {
+  static U6ScheduleEntry expect[U6_SCHEDULE_ACTORS * MAX_PER_ACTOR];
+  U6ScheduleTable table;
+  size_t size = 0;
+  uint8_t *bytes = build_schedule_file(7u, &size, expect);
+  int rc = 0;
+
+  if (bytes == NULL) {
+    return fail("alloc");
+  }
+  if (u6_schedule_parse(bytes, size, &table) != U6_SCHEDULE_OK) {
+    free(bytes);
+    return fail("parse");
+  }
+  if (table.entry_count != (size - U6_SCHEDULE_HEADER_SIZE) / U6_SCHEDULE_ENTRY_SIZE || table.count[0] != 0) {
+    rc = fail("entry counts");
+  }
+  for (size_t i = 0; rc == 0 && i < table.entry_count; i++) {
+    const U6ScheduleEntry *a = &table.entries[i];
+    const U6ScheduleEntry *b = &expect[i];
+    if (a->hour != b->hour || a->day_of_week != b->day_of_week || a->worktype != b->worktype || a->x != b->x
+        || a->y != b->y || a->z != b->z) {
+      rc = fail("decoded entry mismatch");
+    }
+  }
+  u6_schedule_free(&table);
+  if (rc == 0 && u6_schedule_parse(bytes, size - 1u, &table) != U6_SCHEDULE_ERR_SIZE) {
+    rc = fail("truncated file accepted");
+  }
+  write_u16_le(bytes + 10u, 0xfff0u);
+  if (rc == 0 && u6_schedule_parse(bytes, size, &table) != U6_SCHEDULE_ERR_FORMAT) {
+    rc = fail("out-of-order offsets accepted");
+  }
+  free(bytes);
+  return rc;
+}
+
+static int test_load_file(void) {
+  static U6ScheduleEntry expect[U6_SCHEDULE_ACTORS * MAX_PER_ACTOR];
+  U6ScheduleTable table;
+  char path[256];
+  size_t size = 0;
+  uint8_t *bytes = build_schedule_file(11u, &size, expect);
+  FILE *fp;
+  int rc = 0;
+
+  if (bytes == NULL) {
+    return fail("alloc");
+  }
+  snprintf(path, sizeof(path), "/tmp/u6m_schedule_test_%ld_%ld", (long)getpid(), (long)time(NULL));
+  fp = fopen(path, "wb");
+  if (fp == NULL || fwrite(bytes, 1, size, fp) != size) {
+    if (fp != NULL) {
+      fclose(fp);
+    }
+    free(bytes);
+    return fail("write temp schedule");
+  }
+  fclose(fp);
+  if (u6_schedule_load_file(path, &table) != U6_SCHEDULE_OK || table.entry_count == 0
+      || memcmp(&table.entries[table.entry_count - 1u], &expect[table.entry_count - 1u], sizeof(U6ScheduleEntry)) != 0) {
+    rc = fail("load_file");
+  }
+  u6_schedule_free(&table);
+  remove(path);
+  if (rc == 0 && u6_schedule_load_file(path, &table) != U6_SCHEDULE_ERR_IO) {
+    rc = fail("missing file not reported");
+  }
+  free(bytes);
+  return rc;
+}
+
+static int check_positions(const U6ScheduleTable *table, U6EntityState *entities, const SimWorldState *world) {
+  for (uint32_t a = 1; a <= ACTORS_USED; a++) {
+    const U6ScheduleEntry *e = naive_active(table, (uint8_t)a, world);
+    const U6NpcState *npc = u6_entities_find_npc(entities, (uint16_t)a);
+    if (e == NULL) {
+      continue;
+    }
+    if (npc == NULL || npc->map_x != e->x || npc->map_y != e->y || npc->map_z != e->z) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Drive the real sim clock and compare every scheduled NPC with the naive rule. */
+static int test_engine_follows_world_clock(void) {
+  static U6ScheduleEntry scratch[U6_SCHEDULE_ACTORS * MAX_PER_ACTOR];
+  static U6EntityState entities;
+  static uint8_t arena_buf[64u * 1024u];
+  U6EntityArena arena;
+  U6ScheduleTable table;
+  U6ScheduleEngine engine;
+  SimConfig cfg;
+  SimState sim;
+  size_t size = 0;
+  uint8_t *bytes = build_schedule_file(0x5eedu, &size, scratch);
+  uint32_t rng = 1234u;
+  int rc = 0;
+
+  if (bytes == NULL || u6_schedule_parse(bytes, size, &table) != U6_SCHEDULE_OK) {
+    free(bytes);
+    return fail("parse");
+  }
+  free(bytes);
+  if (u6_schedule_engine_init(&engine, &table) != U6_SCHEDULE_OK || engine.event_count == 0) {
+    u6_schedule_free(&table);
+    return fail("engine init");
+  }
+
+  if (u6_entities_arena_bytes(0, U6M_MAX_NPCS) > sizeof(arena_buf)) {
+    u6_schedule_engine_free(&engine);
+    u6_schedule_free(&table);
+    return fail("arena too small");
+  }
+  u6_entity_arena_init(&arena, arena_buf, sizeof(arena_buf));
+  u6_entities_init_arena(&entities, &arena);
+  for (uint16_t a = 1; a <= ACTORS_USED + 20u; a++) {
+    U6NpcState npc;
+    memset(&npc, 0, sizeof(npc));
+    npc.npc_id = a;
+    npc.flags = U6_NPC_FLAG_ACTIVE;
+    u6_entities_add_npc(&entities, &npc);
+  }
+  if (u6_schedule_engine_bind_matching(&engine, &entities) != ACTORS_USED) {
+    rc = fail("bind_matching count");
+  }
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.seed = 3u;
+  cfg.initial_world.time_h = 23;
+  cfg.initial_world.time_m = 30;
+  cfg.initial_world.date_d = 27;
+  cfg.initial_world.date_m = 13;
+  cfg.initial_world.date_y = 161;
+  sim_init(&sim, &cfg);
+  if (rc == 0 && (u6_schedule_engine_sync(&engine, &entities, &sim.world) < 0
+                  || !check_positions(&table, &entities, &sim.world))) {
+    rc = fail("initial resolve");
+  }
+
+  for (int step = 0; rc == 0 && step < 3000; step++) {
+    uint32_t r = rng_next(&rng);
+    uint32_t ticks;
+    uint32_t hours_before = u6_schedule_world_hours(&sim.world);
+    int moved;
+
+    if ((r % 50u) == 0u) {
+      ticks = 4u * 60u * 24u * (1u + rng_next(&rng) % 10u); /* days of fast-forward */
+    } else if ((r % 7u) == 0u) {
+      ticks = 4u * 60u * (1u + rng_next(&rng) % 30u);
+    } else {
+      ticks = 1u + rng_next(&rng) % 300u;
+    }
+    sim_step_ticks(&sim, NULL, 0, ticks, NULL);
+    moved = u6_schedule_engine_sync(&engine, &entities, &sim.world);
+    if (moved < 0 || moved > ACTORS_USED) {
+      rc = fail("sync result out of range");
+    } else if (u6_schedule_world_hours(&sim.world) == hours_before && moved != 0) {
+      rc = fail("sync moved NPCs without an hour boundary");
+    } else if (!check_positions(&table, &entities, &sim.world)) {
+      rc = fail("engine diverged from naive schedule");
+    }
+  }
+
+  if (rc == 0 && u6_schedule_engine_sync(&engine, &entities, &sim.world) != 0) {
+    rc = fail("repeat sync in the same hour did work");
+  }
+  u6_schedule_engine_free(&engine);
+  u6_schedule_free(&table);
+  return rc;
+}
+
+/* A move that fails (NPC not loaded yet) is retried by a later sync in the same hour. */
+static int test_failed_move_retries(void) {
+  static U6ScheduleEntry scratch[U6_SCHEDULE_ACTORS * MAX_PER_ACTOR];
+  static U6EntityState entities;
+  static uint8_t arena_buf[64u * 1024u];
+  const uint16_t late = 5u;
+  U6EntityArena arena;
+  U6ScheduleTable table;
+  U6ScheduleEngine engine;
+  SimConfig cfg;
+  SimState sim;
+  U6NpcState npc;
+  size_t size = 0;
+  uint8_t *bytes = build_schedule_file(0xfa11u, &size, scratch);
+  int rc = 0;
+  int moved;
+
+  if (bytes == NULL || u6_schedule_parse(bytes, size, &table) != U6_SCHEDULE_OK) {
+    free(bytes);
+    return fail("retry parse");
+  }
+  free(bytes);
+  if (u6_schedule_engine_init(&engine, &table) != U6_SCHEDULE_OK) {
+    u6_schedule_free(&table);
+    return fail("retry engine init");
+  }
+  u6_entity_arena_init(&arena, arena_buf, sizeof(arena_buf));
+  u6_entities_init_arena(&entities, &arena);
+  for (uint16_t a = 1; a <= ACTORS_USED; a++) {
+    if (a == late) {
+      continue;
+    }
+    memset(&npc, 0, sizeof(npc));
+    npc.npc_id = a;
+    npc.flags = U6_NPC_FLAG_ACTIVE;
+    u6_entities_add_npc(&entities, &npc);
+  }
+  for (uint16_t a = 1; a <= ACTORS_USED; a++) {
+    u6_schedule_engine_bind(&engine, (uint8_t)a, a);
+  }
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.seed = 5u;
+  cfg.initial_world.time_h = 9;
+  cfg.initial_world.date_d = 3;
+  cfg.initial_world.date_m = 4;
+  cfg.initial_world.date_y = 161;
+  sim_init(&sim, &cfg);
+  moved = u6_schedule_engine_sync(&engine, &entities, &sim.world);
+  if (moved != ACTORS_USED - 1 || engine.unplaced_count != 1u) {
+    rc = fail("missing NPC should leave exactly one unplaced actor");
+  }
+
+  memset(&npc, 0, sizeof(npc));
+  npc.npc_id = late;
+  npc.flags = U6_NPC_FLAG_ACTIVE;
+  u6_entities_add_npc(&entities, &npc);
+  if (rc == 0 && (u6_schedule_engine_sync(&engine, &entities, &sim.world) != 1 || engine.unplaced_count != 0u
+                  || !check_positions(&table, &entities, &sim.world))) {
+    rc = fail("same-hour sync should place the late NPC");
+  }
+  if (rc == 0 && u6_schedule_engine_sync(&engine, &entities, &sim.world) != 0) {
+    rc = fail("sync after the retry did work");
+  }
+  u6_schedule_engine_free(&engine);
+  u6_schedule_free(&table);
+  return rc;
+}
+
+int main(void) {
+  if (test_parse() != 0) return 1;
+  if (test_load_file() != 0) return 1;
+  if (test_engine_follows_world_clock() != 0) return 1;
+  if (test_failed_move_retries() != 0) return 1;
+  printf("PASS: u6 schedule\n");
+  return 0;
+}
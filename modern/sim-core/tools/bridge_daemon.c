@@ -0,0 +1,149 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "u6_bridge_proto.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ * Long-lived bridge: keeps the world object table resident and answers
+ * length-prefixed frames (see u6_bridge_proto.h) on stdin/stdout, or on a
+ * Unix socket with --socket PATH (connections are served one at a time and
+ * share the table). A clean EOF between frames ends the session.
+ */
+
+static int read_full(int fd, uint8_t *buf, size_t n) {
+  size_t got = 0;
+  while (got < n) {
+    ssize_t rc = read(fd, buf + got, n - got);
+    if (rc < 0 && errno == EINTR) continue;
+    if (rc <= 0) return got == 0 ? 0 : -1;
+    got += (size_t)rc;
+  }
+  return 1;
+}
+
+static int write_full(int fd, const uint8_t *buf, size_t n) {
+  size_t put = 0;
+  while (put < n) {
+    ssize_t rc = write(fd, buf + put, n - put);
+    if (rc < 0 && errno == EINTR) continue;
+    if (rc <= 0) return 0;
+    put += (size_t)rc;
+  }
+  return 1;
+}
+
+/* 0 on clean EOF, -1 on a broken stream or I/O failure. */
+static int serve(U6BridgeWorld *world, int in_fd, int out_fd) {
+  uint8_t *body = NULL;
+  size_t body_capacity = 0;
+  U6BridgeBuffer out;
+  int result = -1;
+
+  memset(&out, 0, sizeof(out));
+  for (;;) {
+    uint8_t prefix[4];
+    uint32_t len;
+    int rc = read_full(in_fd, prefix, sizeof(prefix));
+    if (rc == 0) {
+      result = 0;
+      break;
+    }
+    if (rc < 0) {
+      fprintf(stderr, "truncated frame header\n");
+      break;
+    }
+    len = (uint32_t)prefix[0] | ((uint32_t)prefix[1] << 8) | ((uint32_t)prefix[2] << 16) | ((uint32_t)prefix[3] << 24);
+    if (len == 0u || len > U6_BRIDGE_MAX_FRAME) {
+      fprintf(stderr, "bad frame length: %u\n", (unsigned)len);
+      break;
+    }
+    if (len > body_capacity) {
+      uint8_t *grown = (uint8_t *)realloc(body, len);
+      if (grown == NULL) {
+        fprintf(stderr, "allocation failure\n");
+        break;
+      }
+      body = grown;
+      body_capacity = len;
+    }
+    if (read_full(in_fd, body, len) != 1) {
+      fprintf(stderr, "truncated frame body\n");
+      break;
+    }
+    if (u6_bridge_handle(world, body, len, &out) != U6_BRIDGE_OK) {
+      fprintf(stderr, "allocation failure\n");
+      break;
+    }
+    if (!write_full(out_fd, out.data, out.size)) {
+      break;
+    }
+  }
+  free(body);
+  u6_bridge_buffer_free(&out);
+  return result;
+}
+
+static int serve_socket(U6BridgeWorld *world, const char *path) {
+  struct sockaddr_un addr;
+  int listen_fd;
+
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "socket path too long: %s\n", path);
+    return 2;
+  }
+  listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd < 0) {
+    perror("socket");
+    return 2;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path, strlen(path) + 1u);
+  unlink(path);
+  if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listen_fd, 4) != 0) {
+    perror("bind");
+    close(listen_fd);
+    return 2;
+  }
+  for (;;) {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      perror("accept");
+      break;
+    }
+    (void)serve(world, fd, fd);
+    close(fd);
+  }
+  close(listen_fd);
+  unlink(path);
+  return 2;
+}
+
+int main(int argc, char **argv) {
+  U6BridgeWorld world;
+  int rc;
+
+  if (argc != 1 && !(argc == 3 && strcmp(argv[1], "--socket") == 0)) {
+    fprintf(stderr, "usage: %s [--socket <path>]\n", argv[0]);
+    return 2;
+  }
+  /* A peer that goes away mid-response is a write error, not a signal. */
+  signal(SIGPIPE, SIG_IGN);
+  u6_bridge_world_init(&world);
+  if (argc == 3) {
+    rc = serve_socket(&world, argv[2]);
+  } else {
+    rc = serve(&world, STDIN_FILENO, STDOUT_FILENO) == 0 ? 0 : 1;
+  }
+  u6_bridge_world_free(&world);
+  return rc;
+}
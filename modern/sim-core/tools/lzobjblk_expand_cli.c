@@ -0,0 +1,141 @@
+#include "u6_lzw.h"
+#include "u6_objblk.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t *read_file(const char *path, size_t *out_size) {
+  FILE *fp = fopen(path, "rb");
+  uint8_t *buf = NULL;
+  long size;
+
+  if (fp == NULL) {
+    return NULL;
+  }
+  if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+    fclose(fp);
+    return NULL;
+  }
+  buf = (uint8_t *)malloc((size_t)size + 1);
+  if (buf != NULL && fread(buf, 1, (size_t)size, fp) != (size_t)size) {
+    free(buf);
+    buf = NULL;
+  }
+  fclose(fp);
+  *out_size = (size_t)size;
+  return buf;
+}
+
+static int write_area_files(const char *out_dir, const uint8_t *decoded, const U6ObjBlkSegment *segments) {
+  for (size_t seg = 0; seg < U6_OBJBLK_OUTDOOR_AREAS; seg++) {
+    char path[1024];
+    uint16_t area_id = segments[seg].area_id;
+    FILE *fp;
+
+    snprintf(path, sizeof(path), "%s/objblk%c%c", out_dir, 'a' + (area_id & 7u), 'a' + ((area_id >> 3) & 7u));
+    fp = fopen(path, "wb");
+    if (fp == NULL) {
+      fprintf(stderr, "cannot write %s\n", path);
+      return 1;
+    }
+    if (fwrite(decoded + segments[seg].offset, 1, segments[seg].size, fp) != segments[seg].size) {
+      fclose(fp);
+      fprintf(stderr, "short write %s\n", path);
+      return 1;
+    }
+    fclose(fp);
+  }
+  return 0;
+}
+
+static void print_records(const uint8_t *decoded, const U6ObjBlkSegment *segments) {
+  static U6ObjBlkRecord records[U6_OBJBLK_MAX_RECORDS];
+
+  printf("area,index,status,x,y,z,type,frame,amount\n");
+  /* Area order, so output lines up with the per-area objblk loaders. */
+  for (uint16_t area_id = 0; area_id < U6_OBJBLK_OUTDOOR_AREAS; area_id++) {
+    for (size_t seg = 0; seg < U6_OBJBLK_OUTDOOR_AREAS; seg++) {
+      size_t count = 0;
+      if (segments[seg].area_id != area_id) {
+        continue;
+      }
+      if (u6_objblk_parse_records(decoded + segments[seg].offset,
+                                  segments[seg].size,
+                                  records,
+                                  U6_OBJBLK_MAX_RECORDS,
+                                  &count)
+          != 0) {
+        continue;
+      }
+      for (size_t i = 0; i < count; i++) {
+        const U6ObjBlkRecord *r = &records[i];
+        printf("%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+               (unsigned)area_id,
+               (unsigned)r->source_index,
+               (unsigned)r->status,
+               (unsigned)r->x,
+               (unsigned)r->y,
+               (unsigned)r->z,
+               (unsigned)r->obj_type,
+               (unsigned)r->obj_frame,
+               (unsigned)r->amount);
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  U6ObjBlkSegment segments[U6_OBJBLK_OUTDOOR_AREAS];
+  uint8_t *src;
+  uint8_t *decoded;
+  size_t src_size = 0;
+  size_t decoded_size = 0;
+  size_t produced = 0;
+  int rc;
+
+  if (argc != 2 && argc != 3) {
+    fprintf(stderr, "usage: %s <lzobjblk_path> [out_dir]\n", argv[0]);
+    return 2;
+  }
+
+  src = read_file(argv[1], &src_size);
+  if (src == NULL) {
+    fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 2;
+  }
+  if (u6_lzw_decoded_size(src, src_size, &decoded_size) != U6_LZW_OK) {
+    free(src);
+    fprintf(stderr, "invalid lzw header\n");
+    return 1;
+  }
+  decoded = (uint8_t *)malloc(decoded_size);
+  if (decoded == NULL) {
+    free(src);
+    fprintf(stderr, "allocation failure\n");
+    return 2;
+  }
+  rc = u6_lzw_decompress(src, src_size, decoded, decoded_size, &produced);
+  free(src);
+  if (rc != U6_LZW_OK && rc != U6_LZW_ERR_TRUNCATED) {
+    free(decoded);
+    fprintf(stderr, "lzw decode failed rc=%d\n", rc);
+    return 1;
+  }
+
+  rc = u6_objblk_split_lzobjblk(decoded, produced, segments);
+  if (rc != 0) {
+    free(decoded);
+    fprintf(stderr, "invalid lzobjblk stream rc=%d (decoded %zu of %zu bytes)\n", rc, produced, decoded_size);
+    return 1;
+  }
+
+  if (argc == 3) {
+    rc = write_area_files(argv[2], decoded, segments);
+  } else {
+    print_records(decoded, segments);
+    rc = 0;
+  }
+  free(decoded);
+  return rc;
+}
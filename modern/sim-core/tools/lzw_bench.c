@@ -0,0 +1,103 @@
+#include "u6_lzw.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint32_t rng_next(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+static double now_ms(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1.0e6;
+}
+
+/* objblk-shaped payload: 8-byte records with clustered coords and few shapes. */
+static void fill_objblk_like(uint8_t *buf, size_t size, uint32_t seed) {
+  uint32_t rng = seed;
+  for (size_t i = 0; i + 8 <= size; i += 8) {
+    uint16_t x = (uint16_t)(rng_next(&rng) % 128u);
+    uint16_t y = (uint16_t)(rng_next(&rng) % 128u);
+    uint16_t shape = (uint16_t)(rng_next(&rng) % 48u);
+    buf[i] = (uint8_t)((rng_next(&rng) % 4u) == 0u ? 0x08 : 0x00);
+    buf[i + 1] = (uint8_t)x;
+    buf[i + 2] = (uint8_t)((y & 0x3fu) << 2);
+    buf[i + 3] = (uint8_t)(y >> 6);
+    buf[i + 4] = (uint8_t)shape;
+    buf[i + 5] = 0;
+    buf[i + 6] = (uint8_t)(rng_next(&rng) % 3u);
+    buf[i + 7] = 0;
+  }
+  for (size_t i = size & ~(size_t)7u; i < size; i++) {
+    buf[i] = 0;
+  }
+}
+
+int main(int argc, char **argv) {
+  static const size_t default_sizes[] = {16384, 200000, 1 << 20, 8 << 20};
+  int rounds = 5;
+
+  if (argc > 1) {
+    rounds = (int)strtol(argv[1], NULL, 10);
+    if (rounds <= 0) {
+      rounds = 1;
+    }
+  }
+
+  printf("bytes,packed_bytes,decode_ms,decode_mb_s\n");
+  for (size_t s = 0; s < sizeof(default_sizes) / sizeof(default_sizes[0]); s++) {
+    size_t size = default_sizes[s];
+    size_t bound = u6_lzw_compress_bound(size);
+    uint8_t *plain = (uint8_t *)malloc(size);
+    uint8_t *packed = (uint8_t *)malloc(bound);
+    uint8_t *decoded = (uint8_t *)malloc(size);
+    size_t packed_size = 0;
+    double decode_ms = 0.0;
+
+    if (plain == NULL || packed == NULL || decoded == NULL) {
+      free(plain);
+      free(packed);
+      free(decoded);
+      fprintf(stderr, "allocation failure\n");
+      return 2;
+    }
+    fill_objblk_like(plain, size, 0x9e3779b9u ^ (uint32_t)size);
+    if (u6_lzw_compress(plain, size, packed, bound, &packed_size) != U6_LZW_OK) {
+      fprintf(stderr, "compress failed at %zu bytes\n", size);
+      return 2;
+    }
+
+    for (int r = 0; r < rounds; r++) {
+      size_t produced = 0;
+      double t0 = now_ms();
+      if (u6_lzw_decompress(packed, packed_size, decoded, size, &produced) != U6_LZW_OK || produced != size) {
+        fprintf(stderr, "decode failed at %zu bytes\n", size);
+        return 2;
+      }
+      decode_ms += now_ms() - t0;
+    }
+    if (memcmp(decoded, plain, size) != 0) {
+      fprintf(stderr, "roundtrip mismatch at %zu bytes\n", size);
+      return 2;
+    }
+
+    decode_ms /= rounds;
+    printf("%zu,%zu,%.3f,%.1f\n",
+           size,
+           packed_size,
+           decode_ms,
+           decode_ms > 0.0 ? ((double)size / (1024.0 * 1024.0)) / (decode_ms / 1000.0) : 0.0);
+    free(plain);
+    free(packed);
+    free(decoded);
+  }
+  return 0;
+}
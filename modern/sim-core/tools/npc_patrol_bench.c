@@ -0,0 +1,91 @@
+#include "u6_npcpatrol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint32_t rng_next(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+static double now_ms(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1.0e6;
+}
+
+static int fill(U6NpcPatrolTable *table, size_t count, uint32_t seed) {
+  uint32_t rng = seed;
+
+  if (u6_npcpatrol_init(table, count) != U6_NPCPATROL_OK) {
+    return -1;
+  }
+  for (size_t i = 0; i < count; i++) {
+    U6NpcState npc;
+    memset(&npc, 0, sizeof(npc));
+    npc.map_x = (int16_t)(rng_next(&rng) % 1024u);
+    npc.map_y = (int16_t)(rng_next(&rng) % 1024u);
+    npc.patrol_dx = (int8_t)((int)(rng_next(&rng) % 3u) - 1);
+    npc.patrol_dy = (int8_t)((int)(rng_next(&rng) % 3u) - 1);
+    npc.flags = (rng_next(&rng) % 8u) == 0u ? U6_NPC_FLAG_ACTIVE : (U6_NPC_FLAG_ACTIVE | U6_NPC_FLAG_PATROL);
+    u6_npcpatrol_append(table, &npc, (uint16_t)i);
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  static const size_t counts[] = {256, 4096, 16384, 65536};
+  int steps = 2000;
+
+  if (argc > 1) {
+    steps = (int)strtol(argv[1], NULL, 10);
+    if (steps <= 0) {
+      steps = 1;
+    }
+  }
+
+  printf("kernel=%s\n", u6_npcpatrol_kernel_name());
+  printf("npcs,scalar_us_per_step,kernel_us_per_step,speedup\n");
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    U6NpcPatrolTable scalar;
+    U6NpcPatrolTable vec;
+    double t0;
+    double scalar_ms;
+    double vec_ms;
+
+    if (fill(&scalar, counts[c], 1234u) != 0 || fill(&vec, counts[c], 1234u) != 0) {
+      fprintf(stderr, "alloc failed\n");
+      return 1;
+    }
+    /* Every step lands on a patrol tick (tick % 4 == 0). */
+    t0 = now_ms();
+    for (int s = 0; s < steps; s++) {
+      u6_npcpatrol_step_scalar(&scalar, (uint32_t)s * 4u);
+    }
+    scalar_ms = now_ms() - t0;
+    t0 = now_ms();
+    for (int s = 0; s < steps; s++) {
+      u6_npcpatrol_step(&vec, (uint32_t)s * 4u);
+    }
+    vec_ms = now_ms() - t0;
+    if (memcmp(scalar.x, vec.x, counts[c] * sizeof(int16_t)) != 0
+        || memcmp(scalar.y, vec.y, counts[c] * sizeof(int16_t)) != 0) {
+      fprintf(stderr, "kernel mismatch at %zu npcs\n", counts[c]);
+      return 1;
+    }
+    printf("%zu,%.3f,%.3f,%.2f\n",
+           counts[c],
+           scalar_ms * 1000.0 / steps,
+           vec_ms * 1000.0 / steps,
+           vec_ms > 0.0 ? scalar_ms / vec_ms : 0.0);
+    u6_npcpatrol_free(&scalar);
+    u6_npcpatrol_free(&vec);
+  }
+  return 0;
+}
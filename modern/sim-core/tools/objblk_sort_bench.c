@@ -0,0 +1,86 @@
+#include "u6_objblk.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint32_t rng_next(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+static double now_ms(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1.0e6;
+}
+
+static void fill_world(U6ObjBlkRecord *records, size_t count, uint32_t seed) {
+  static const uint8_t statuses[] = {0x00, 0x00, 0x00, 0x08, 0x10, 0x18};
+  uint32_t rng = seed;
+  for (size_t i = 0; i < count; i++) {
+    memset(&records[i], 0, sizeof(records[i]));
+    records[i].status = statuses[rng_next(&rng) % sizeof(statuses)];
+    records[i].x = (uint16_t)(rng_next(&rng) & 0x3ffu);
+    records[i].y = (uint16_t)(rng_next(&rng) & 0x3ffu);
+    records[i].z = (uint8_t)(rng_next(&rng) % 6u);
+    records[i].source_area = (uint16_t)(rng_next(&rng) % 64u);
+    records[i].source_index = (uint16_t)(i % U6_OBJBLK_MAX_RECORDS);
+  }
+}
+
+int main(int argc, char **argv) {
+  static const size_t default_sizes[] = {1000, 10000, 50000, 200000};
+  int rounds = 5;
+
+  if (argc > 1) {
+    rounds = (int)strtol(argv[1], NULL, 10);
+    if (rounds <= 0) {
+      rounds = 1;
+    }
+  }
+
+  printf("count,qsort_ms,radix_ms,speedup\n");
+  for (size_t s = 0; s < sizeof(default_sizes) / sizeof(default_sizes[0]); s++) {
+    size_t count = default_sizes[s];
+    U6ObjBlkRecord *base = (U6ObjBlkRecord *)malloc(count * sizeof(U6ObjBlkRecord));
+    U6ObjBlkRecord *work = (U6ObjBlkRecord *)malloc(count * sizeof(U6ObjBlkRecord));
+    double qsort_ms = 0.0;
+    double radix_ms = 0.0;
+
+    if (base == NULL || work == NULL) {
+      free(base);
+      free(work);
+      fprintf(stderr, "allocation failure\n");
+      return 2;
+    }
+    fill_world(base, count, 0x9e3779b9u ^ (uint32_t)count);
+
+    for (int r = 0; r < rounds; r++) {
+      double t0;
+      memcpy(work, base, count * sizeof(U6ObjBlkRecord));
+      t0 = now_ms();
+      u6_objblk_sort_for_render_qsort(work, count);
+      qsort_ms += now_ms() - t0;
+
+      memcpy(work, base, count * sizeof(U6ObjBlkRecord));
+      t0 = now_ms();
+      u6_objblk_sort_for_render(work, count);
+      radix_ms += now_ms() - t0;
+    }
+
+    printf("%zu,%.3f,%.3f,%.2f\n",
+           count,
+           qsort_ms / rounds,
+           radix_ms / rounds,
+           radix_ms > 0.0 ? qsort_ms / radix_ms : 0.0);
+    free(base);
+    free(work);
+  }
+  return 0;
+}
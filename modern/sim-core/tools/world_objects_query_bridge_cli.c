@@ -1,38 +1,19 @@
-#include "u6_objstatus.h"
+#include "u6_bridge_proto.h"
+#include "u6_objblk.h"
+#include "u6_objpack.h"
+#include "u6_objselect.h"
+#include "u6_objshm.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-typedef struct QueryObject {
-  char key[40];
-  int x;
-  int y;
-  int z;
-  int status;
-  int tile_flag;
-  int source_area;
-  int source_index;
-} QueryObject;
-
-typedef struct QuerySpec {
-  int has_x;
-  int x;
-  int has_y;
-  int y;
-  int has_z;
-  int z;
-  int radius;
-  int projection_footprint;
-  int limit;
-} QuerySpec;
-
 static int parse_int(const char *s) {
   if (s == NULL) return 0;
   return (int)strtol(s, NULL, 10);
 }
 
-static int parse_obj_arg(const char *arg, QueryObject *out) {
+static int parse_obj_arg(const char *arg, U6BridgeObject *out) {
   char buf[256];
   char *parts[9];
   size_t n = 0;
@@ -51,82 +32,125 @@ static int parse_obj_arg(const char *arg, QueryObject *out) {
   out->x = parse_int(parts[1]);
   out->y = parse_int(parts[2]);
   out->z = parse_int(parts[3]);
-  out->status = parse_int(parts[4]) & 0xff;
-  out->tile_flag = parse_int(parts[8]) & 0xff;
+  out->status = (uint8_t)(parse_int(parts[4]) & 0xff);
+  out->tile_flag = (uint8_t)(parse_int(parts[8]) & 0xff);
   out->source_area = parse_int(parts[6]);
   out->source_index = parse_int(parts[7]);
   return out->key[0] != '\0';
 }
 
-static int is_status_0010(int status) {
-  return (status & 0x10) != 0;
-}
-
-static int cmp_objects(const void *va, const void *vb) {
-  const QueryObject *a = (const QueryObject *)va;
-  const QueryObject *b = (const QueryObject *)vb;
-  const int a_use = u6_obj_status_coord_use((unsigned char)(a->status & 0xff));
-  const int b_use = u6_obj_status_coord_use((unsigned char)(b->status & 0xff));
-  if (a_use != 0 && b_use == 0) return -1;
-  if (b_use != 0 && a_use == 0) return 1;
-  if (a->y != b->y) return a->y - b->y;
-  if (a->x != b->x) return a->x - b->x;
-  if (a->z != b->z) return b->z - a->z;
-  if (is_status_0010(a->status) != is_status_0010(b->status)) {
-    return is_status_0010(a->status) ? -1 : 1;
+/* Whole stream into a malloc'd buffer (the packed table on stdin). */
+static uint8_t *read_stream(FILE *f, size_t *out_size) {
+  size_t size = 0;
+  size_t capacity = 1u << 16;
+  uint8_t *data = (uint8_t *)malloc(capacity);
+  size_t got;
+
+  while (data != NULL && (got = fread(data + size, 1, capacity - size, f)) > 0u) {
+    size += got;
+    if (size == capacity) {
+      uint8_t *grown = (uint8_t *)realloc(data, capacity * 2u);
+      if (grown == NULL) {
+        free(data);
+        return NULL;
+      }
+      data = grown;
+      capacity *= 2u;
+    }
   }
-  if (a->source_area != b->source_area) return a->source_area - b->source_area;
-  if (a->source_index != b->source_index) return a->source_index - b->source_index;
-  return strcmp(a->key, b->key);
+  if (data != NULL && ferror(f)) {
+    free(data);
+    return NULL;
+  }
+  *out_size = size;
+  return data;
 }
 
-static int footprint_hits(const QueryObject *o, const QuerySpec *q) {
-  const int x = o->x;
-  const int y = o->y;
-  const int dx = abs(x - q->x);
-  const int dy = abs(y - q->y);
-  if (dx <= q->radius && dy <= q->radius) {
-    return 1;
-  }
-  if (o->tile_flag & 0x80) {
-    const int ldx = abs((x - 1) - q->x);
-    const int ldy = abs(y - q->y);
-    if (ldx <= q->radius && ldy <= q->radius) return 1;
+/* Loads objects from a packed table file (mapped) or "-" (stdin). */
+static int load_table(const char *source, U6BridgeObject **out_objects, size_t *out_count) {
+  U6ObjBlkMappedFile mapped;
+  U6ObjPackView view;
+  uint8_t *stream = NULL;
+  const uint8_t *bytes;
+  size_t size = 0;
+  int rc;
+
+  memset(&mapped, 0, sizeof(mapped));
+  if (strcmp(source, "-") == 0) {
+    stream = read_stream(stdin, &size);
+    if (stream == NULL) {
+      fprintf(stderr, "failed to read table from stdin\n");
+      return 0;
+    }
+    bytes = stream;
+  } else {
+    if (u6_objblk_map_file(source, &mapped) != 0 || !mapped.loaded) {
+      fprintf(stderr, "failed to map table: %s\n", source);
+      return 0;
+    }
+    bytes = mapped.bytes;
+    size = mapped.size;
   }
-  if (o->tile_flag & 0x40) {
-    const int udx = abs(x - q->x);
-    const int udy = abs((y - 1) - q->y);
-    if (udx <= q->radius && udy <= q->radius) return 1;
+  rc = u6_objpack_view(&view, bytes, size);
+  if (rc == U6_OBJPACK_OK) {
+    *out_objects = (U6BridgeObject *)calloc(view.count > 0u ? view.count : 1u, sizeof(U6BridgeObject));
+    if (*out_objects == NULL) {
+      rc = U6_OBJPACK_ERR_ALLOC;
+    } else {
+      for (size_t i = 0; i < view.count; i++) {
+        u6_objpack_get(&view, i, &(*out_objects)[i]);
+      }
+      *out_count = view.count;
+    }
   }
-  if ((o->tile_flag & 0xc0) == 0xc0) {
-    const int cdx = abs((x - 1) - q->x);
-    const int cdy = abs((y - 1) - q->y);
-    if (cdx <= q->radius && cdy <= q->radius) return 1;
+  free(stream);
+  u6_objblk_unmap_file(&mapped);
+  if (rc != U6_OBJPACK_OK) {
+    fprintf(stderr, "invalid packed table (%d)\n", rc);
+    return 0;
   }
-  return 0;
+  return 1;
 }
 
-static int object_matches(const QueryObject *o, const QuerySpec *q) {
-  if (q->has_z && o->z != q->z) return 0;
-  if (q->has_x && q->has_y) {
-    if (q->projection_footprint) {
-      return footprint_hits(o, q);
+/* Answers straight from the live shared-memory table (filter in place). */
+static int query_shm(const char *path, const U6BridgeQuery *q) {
+  U6ObjShm shm;
+  U6BridgeObject *matches = NULL;
+  size_t count = 0;
+  int rc = U6_OBJSHM_ERR_RETIRED;
+
+  /* A retired segment was replaced by a larger one at the same path. */
+  for (int attempt = 0; attempt < 4 && rc == U6_OBJSHM_ERR_RETIRED; attempt++) {
+    rc = u6_objshm_open(&shm, path);
+    if (rc != U6_OBJSHM_OK) {
+      break;
     }
-    if (abs(o->x - q->x) > q->radius) return 0;
-    if (abs(o->y - q->y) > q->radius) return 0;
+    rc = u6_objshm_query(&shm, q, &matches, &count);
+    u6_objshm_close(&shm);
   }
-  return 1;
+  if (rc != U6_OBJSHM_OK) {
+    fprintf(stderr, "failed to query shared table %s (%d)\n", path, rc);
+    return 2;
+  }
+  printf("keys=");
+  for (size_t i = 0; i < count; i++) {
+    if (i > 0u) putchar(',');
+    fputs(matches[i].key, stdout);
+  }
+  putchar('\n');
+  free(matches);
+  return 0;
 }
 
 int main(int argc, char **argv) {
-  QuerySpec q;
-  QueryObject *objects;
+  U6BridgeQuery q;
+  U6BridgeObject *objects;
+  U6ObjSelect select;
   size_t count;
   size_t i;
-  int emitted = 0;
 
   if (argc < 11) {
-    fprintf(stderr, "usage: %s <has_x> <x> <has_y> <y> <has_z> <z> <radius> <projection:anchor|footprint> <limit> <obj...>\n", argv[0]);
+    fprintf(stderr, "usage: %s <has_x> <x> <has_y> <y> <has_z> <z> <radius> <projection:anchor|footprint> <limit> (<obj...> | --table <path|-> | --shm <path>)\n", argv[0]);
     return 2;
   }
 
@@ -142,32 +166,50 @@ int main(int argc, char **argv) {
   q.limit = parse_int(argv[9]);
   if (q.limit <= 0) q.limit = 1;
 
-  count = (size_t)(argc - 10);
-  objects = (QueryObject *)calloc(count, sizeof(QueryObject));
-  if (objects == NULL) {
-    fprintf(stderr, "allocation failure\n");
-    return 2;
+  if (strcmp(argv[10], "--shm") == 0) {
+    if (argc != 12) {
+      fprintf(stderr, "--shm takes one path\n");
+      return 2;
+    }
+    return query_shm(argv[11], &q);
   }
-  for (i = 0; i < count; i++) {
-    if (!parse_obj_arg(argv[i + 10], &objects[i])) {
-      free(objects);
-      fprintf(stderr, "invalid obj format: %s\n", argv[i + 10]);
+  if (strcmp(argv[10], "--table") == 0) {
+    if (argc != 12 || !load_table(argv[11], &objects, &count)) {
+      return 2;
+    }
+  } else {
+    count = (size_t)(argc - 10);
+    objects = (U6BridgeObject *)calloc(count, sizeof(U6BridgeObject));
+    if (objects == NULL) {
+      fprintf(stderr, "allocation failure\n");
       return 2;
     }
+    for (i = 0; i < count; i++) {
+      if (!parse_obj_arg(argv[i + 10], &objects[i])) {
+        free(objects);
+        fprintf(stderr, "invalid obj format: %s\n", argv[i + 10]);
+        return 2;
+      }
+    }
   }
 
-  qsort(objects, count, sizeof(QueryObject), cmp_objects);
+  /* Only matches are kept, and only the first `limit` of them are sorted. */
+  u6_objselect_init(&select, (size_t)q.limit);
+  if (u6_objselect_query(&select, objects, count, &q) != U6_OBJSELECT_OK) {
+    u6_objselect_free(&select);
+    free(objects);
+    fprintf(stderr, "allocation failure\n");
+    return 2;
+  }
 
   printf("keys=");
-  for (i = 0; i < count; i++) {
-    if (!object_matches(&objects[i], &q)) continue;
-    if (emitted > 0) putchar(',');
-    fputs(objects[i].key, stdout);
-    emitted += 1;
-    if (emitted >= q.limit) break;
+  for (i = 0; i < select.count; i++) {
+    if (i > 0) putchar(',');
+    fputs(select.items[i].key, stdout);
   }
   putchar('\n');
 
+  u6_objselect_free(&select);
   free(objects);
   return 0;
 }
@@ -27,8 +27,8 @@ validate_csv() {
       return tolower(v)
     }
     NR == 1 {
-      if (norm($1) != "tick" || norm($2) != "hash") {
-        printf("error: invalid header in %s (expected tick,hash)\n", FILENAME) > "/dev/stderr"
+      if (norm($1) != "tick" || norm($2) != "hash" || (NF > 2 && norm($3) != "world_hash")) {
+        printf("error: invalid header in %s (expected tick,hash[,world_hash])\n", FILENAME) > "/dev/stderr"
         exit 2
       }
       next
@@ -52,16 +52,20 @@ awk -F',' '
 
   NR == FNR {
     if (FNR == 1) {
+      a_world_col = NF > 2
       next
     }
     a_tick[FNR] = $1 + 0
     a_hash[FNR] = norm($2)
+    a_world[FNR] = norm($3)
     a_lines = FNR
     next
   }
 
   {
     if (FNR == 1) {
+      # world_hash is compared only when both peers recorded it.
+      check_world = a_world_col && NF > 2
       next
     }
 
@@ -79,6 +83,12 @@ awk -F',' '
       exit 1
     }
 
+    if (check_world && norm($3) != a_world[FNR]) {
+      printf("DESYNC (world state) at line %d: tick=%d A(world_hash=%s) vs B(world_hash=%s)\n",
+             FNR, b_tick, a_world[FNR], norm($3))
+      exit 1
+    }
+
     b_lines = FNR
   }
 
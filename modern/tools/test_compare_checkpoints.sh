@@ -31,4 +31,25 @@ if "$TOOL" "$TMP_DIR/a.csv" "$TMP_DIR/c.csv" >/dev/null 2>&1; then
   exit 1
 fi
 
+cat > "$TMP_DIR/wa.csv" <<'CSV'
+tick,hash,world_hash
+5,aaaaaaaaaaaaaaaa,1111111111111111
+10,bbbbbbbbbbbbbbbb,2222222222222222
+CSV
+
+cat > "$TMP_DIR/wb.csv" <<'CSV'
+tick,hash,world_hash
+5,aaaaaaaaaaaaaaaa,1111111111111111
+10,bbbbbbbbbbbbbbbb,3333333333333333
+CSV
+
+"$TOOL" "$TMP_DIR/wa.csv" "$TMP_DIR/wa.csv" >/dev/null
+# A peer without world_hash is compared on tick,hash only.
+"$TOOL" "$TMP_DIR/a.csv" "$TMP_DIR/wb.csv" >/dev/null
+
+if "$TOOL" "$TMP_DIR/wa.csv" "$TMP_DIR/wb.csv" >/dev/null 2>&1; then
+  echo "FAIL: expected world_hash mismatch to be reported" >&2
+  exit 1
+fi
+
 echo "PASS: compare checkpoints"